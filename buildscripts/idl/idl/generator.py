@@ -1853,7 +1853,7 @@ class _CppSourceFileWriter(_CppFileWriterBase):
                 self._gen_serializer_methods_common(struct, True)
 
             self._writer.write_line('OpMsgRequest request;')
-            self._writer.write_line('request.body = localBuilder.obj();')
+            self._writer.write_line('request.setBody(localBuilder.obj());')
 
             self._gen_doc_sequence_serializer(struct)
 
@@ -0,0 +1,98 @@
+// Tests that an aggregation which groups the results of a collection scan is split across several
+// threads when internalQueryParallelCollectionScanWorkers is set, and returns the same results as
+// the serial scan. $group stages whose results depend on the order of their input are never split.
+// @tags: [requires_profiling]
+
+(function() {
+"use strict";
+
+load("jstests/libs/profiler.js");
+
+const conn = MongoRunner.runMongod();
+assert.neq(null, conn, "mongod was unable to start up");
+
+const testDB = conn.getDB("test");
+const coll = testDB.parallel_collection_scan_group;
+
+// Each worker needs at least 1000 records to scan, so this collection is split into 4 ranges.
+const bulk = coll.initializeUnorderedBulkOp();
+for (let i = 0; i < 5000; ++i) {
+    bulk.insert({_id: i, g: i % 7, x: i, s: "str" + (i % 3)});
+}
+assert.commandWorked(bulk.execute());
+
+testDB.setProfilingLevel(2);
+
+function setWorkers(numWorkers) {
+    assert.commandWorked(testDB.adminCommand(
+        {setParameter: 1, internalQueryParallelCollectionScanWorkers: numWorkers}));
+}
+
+// Runs 'pipeline' and returns its results along with the plan summary recorded by the profiler.
+function runPipeline(pipeline) {
+    const comment = "parallel_collection_scan_group_" + ObjectId().str;
+    const results = coll.aggregate(pipeline, {comment: comment}).toArray();
+    const profileObj = getLatestProfilerEntry(testDB, {"command.comment": comment});
+    return {results: results, planSummary: profileObj.planSummary};
+}
+
+function sortSets(results) {
+    return results.map(doc => Object.assign(doc, {strings: doc.strings.sort()}));
+}
+
+// A $group whose accumulators do not depend on the order of their input is split across the
+// workers, with or without a $match which the workers' scans apply.
+const orderInsensitivePipelines = [
+    [
+        {
+            $group: {
+                _id: "$g",
+                total: {$sum: "$x"},
+                count: {$sum: 1},
+                avg: {$avg: "$x"},
+                lo: {$min: "$x"},
+                hi: {$max: "$x"},
+                strings: {$addToSet: "$s"}
+            }
+        },
+        {$sort: {_id: 1}}
+    ],
+    [
+        {$match: {x: {$gte: 100}}},
+        {$project: {g: 1, x: 1, s: 1}},
+        {$group: {_id: "$g", total: {$sum: "$x"}, strings: {$addToSet: "$s"}}},
+        {$sort: {_id: 1}}
+    ],
+];
+
+for (let pipeline of orderInsensitivePipelines) {
+    setWorkers(0);
+    const serial = runPipeline(pipeline);
+    assert.eq("COLLSCAN", serial.planSummary, tojson(pipeline));
+
+    setWorkers(4);
+    const parallel = runPipeline(pipeline);
+    assert.eq("PARALLEL_COLLSCAN", parallel.planSummary, tojson(pipeline));
+    assert.eq(sortSets(serial.results), sortSets(parallel.results), tojson(pipeline));
+}
+
+// $first, $last and $push return the documents of each group in the order of the scan, so a
+// $group using them keeps the serial scan.
+const orderSensitivePipelines = [
+    [{$group: {_id: "$g", first: {$first: "$x"}}}, {$sort: {_id: 1}}],
+    [{$group: {_id: "$g", last: {$last: "$x"}}}, {$sort: {_id: 1}}],
+    [{$group: {_id: "$g", total: {$sum: "$x"}, all: {$push: "$x"}}}, {$sort: {_id: 1}}],
+];
+
+for (let pipeline of orderSensitivePipelines) {
+    setWorkers(0);
+    const serial = runPipeline(pipeline);
+
+    setWorkers(4);
+    const parallel = runPipeline(pipeline);
+    assert.eq("COLLSCAN", parallel.planSummary, tojson(pipeline));
+    assert.eq(serial.results, parallel.results, tojson(pipeline));
+}
+
+MongoRunner.stopMongod(conn);
+}());
@@ -308,7 +308,7 @@ Status validateElementInfo(Buffer* buffer,
     }
 }
 
-Status validateBSONIterative(Buffer* buffer) {
+Status validateBSONIterative(Buffer* buffer, std::vector<uint32_t>* topLevelFieldOffsets) {
     std::vector<ValidationObjectFrame> frames;
     frames.reserve(16);
     ValidationObjectFrame* curr = nullptr;
@@ -359,6 +359,10 @@ Status validateBSONIterative(Buffer* buffer) {
                     }
                 }
 
+                if (nextState != ValidationState::EndObj && atTopLevel && topLevelFieldOffsets) {
+                    topLevelFieldOffsets->push_back(elemStartPos);
+                }
+
                 state = nextState;
                 break;
             }
@@ -423,7 +427,19 @@ Status validateBSON(const char* originalBuffer, uint64_t maxLength, BSONVersion
     }
 
     Buffer buf(originalBuffer, maxLength, version);
-    return validateBSONIterative(&buf);
+    return validateBSONIterative(&buf, nullptr);
+}
+
+Status validateBSON(const char* originalBuffer,
+                    uint64_t maxLength,
+                    BSONVersion version,
+                    std::vector<uint32_t>* topLevelFieldOffsets) {
+    if (maxLength < 5) {
+        return Status(ErrorCodes::InvalidBSON, "bson data has to be at least 5 bytes");
+    }
+
+    Buffer buf(originalBuffer, maxLength, version);
+    return validateBSONIterative(&buf, topLevelFieldOffsets);
 }
 
 }  // namespace mongo
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "mongo/base/string_data.h"
 #include "mongo/bson/bsontypes.h"
@@ -46,4 +47,14 @@ class Status;
  */
 Status validateBSON(const char* buf, uint64_t maxLength, BSONVersion version);
 
+/**
+ * Same as above, but also appends the offset from 'buf' of each top-level element, in order, to
+ * 'topLevelFieldOffsets' as it is validated. This saves callers that need to look up top-level
+ * fields a second walk over the object.
+ */
+Status validateBSON(const char* buf,
+                    uint64_t maxLength,
+                    BSONVersion version,
+                    std::vector<uint32_t>* topLevelFieldOffsets);
+
 }  // namespace mongo
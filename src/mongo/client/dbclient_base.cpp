@@ -184,10 +184,10 @@ DBClientBase* DBClientBase::runFireAndForgetCommand(OpMsgRequest request) {
     }
 
     if (_metadataWriter) {
-        BSONObjBuilder metadataBob(std::move(request.body));
+        BSONObjBuilder metadataBob(request.body);
         uassertStatusOK(
             _metadataWriter((haveClient() ? cc().getOperationContext() : nullptr), &metadataBob));
-        request.body = metadataBob.obj();
+        request.setBody(metadataBob.obj());
     }
 
     auto requestMsg = request.serialize();
@@ -207,9 +207,9 @@ std::pair<rpc::UniqueReply, DBClientBase*> DBClientBase::runCommandWithTarget(
 
     auto opCtx = haveClient() ? cc().getOperationContext() : nullptr;
     if (_metadataWriter) {
-        BSONObjBuilder metadataBob(std::move(request.body));
+        BSONObjBuilder metadataBob(request.body);
         uassertStatusOK(_metadataWriter(opCtx, &metadataBob));
-        request.body = metadataBob.obj();
+        request.setBody(metadataBob.obj());
     }
 
     auto requestMsg =
@@ -74,10 +74,10 @@ Message assembleCommandRequest(DBClientBase* cli,
     auto request = rpc::upconvertRequest(database, std::move(legacyQuery), legacyQueryOptions);
 
     if (cli->getRequestMetadataWriter()) {
-        BSONObjBuilder bodyBob(std::move(request.body));
+        BSONObjBuilder bodyBob(request.body);
         auto opCtx = (haveClient() ? cc().getOperationContext() : nullptr);
         uassertStatusOK(cli->getRequestMetadataWriter()(opCtx, &bodyBob));
-        request.body = bodyBob.obj();
+        request.setBody(bodyBob.obj());
     }
 
     return rpc::messageFromOpMsgRequest(
@@ -33,6 +33,7 @@
 
 #include "mongo/db/catalog/index_catalog_impl.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/base/init.h"
@@ -94,6 +95,49 @@ using IndexVersion = IndexDescriptor::IndexVersion;
 
 const BSONObj IndexCatalogImpl::_idObj = BSON("_id" << 1);
 
+namespace {
+
+/**
+ * Adds the multikey paths of one document to those accumulated for a batch of documents.
+ */
+void mergeMultikeyPaths(const MultikeyPaths& multikeyPaths,
+                        boost::optional<MultikeyPaths>* batchMultikeyPaths) {
+    if (!*batchMultikeyPaths || (*batchMultikeyPaths)->empty()) {
+        *batchMultikeyPaths = multikeyPaths;
+        return;
+    }
+    if (multikeyPaths.empty()) {
+        return;
+    }
+
+    invariant(multikeyPaths.size() == (*batchMultikeyPaths)->size());
+    for (size_t i = 0; i < multikeyPaths.size(); ++i) {
+        (**batchMultikeyPaths)[i].insert(multikeyPaths[i].begin(), multikeyPaths[i].end());
+    }
+}
+
+/**
+ * Returns true if every record in 'bsonRecords' is written at the same timestamp, so that the
+ * index keys of all of them may be inserted under a single timestamp.
+ */
+bool haveSameTimestamp(const std::vector<BsonRecord>& bsonRecords) {
+    return std::all_of(bsonRecords.begin(), bsonRecords.end(), [&](const BsonRecord& bsonRecord) {
+        return bsonRecord.ts == bsonRecords.front().ts;
+    });
+}
+
+/**
+ * Returns true if every record in 'bsonRecords' has a timestamp, so that each index key can be
+ * written at the timestamp of its record.
+ */
+bool haveTimestamps(const std::vector<BsonRecord>& bsonRecords) {
+    return std::none_of(bsonRecords.begin(), bsonRecords.end(), [](const BsonRecord& bsonRecord) {
+        return bsonRecord.ts.isNull();
+    });
+}
+
+}  // namespace
+
 // -------------
 
 IndexCatalogImpl::IndexCatalogImpl(Collection* collection) : _collection(collection) {}
@@ -1371,6 +1415,11 @@ Status IndexCatalogImpl::_indexFilteredRecords(OperationContext* opCtx,
     InsertDeleteOptions options;
     prepareInsertDeleteOptions(opCtx, index->descriptor(), &options);
 
+    if (bsonRecords.size() > 1 && !index->isHybridBuilding() &&
+        (haveSameTimestamp(bsonRecords) || haveTimestamps(bsonRecords))) {
+        return _indexFilteredRecordsInBatch(opCtx, index, bsonRecords, options, keysInsertedOut);
+    }
+
     for (auto bsonRecord : bsonRecords) {
         invariant(bsonRecord.id != RecordId());
 
@@ -1410,6 +1459,102 @@ Status IndexCatalogImpl::_indexFilteredRecords(OperationContext* opCtx,
     return Status::OK();
 }
 
+Status IndexCatalogImpl::_indexFilteredRecordsInBatch(OperationContext* opCtx,
+                                                      IndexCatalogEntry* index,
+                                                      const std::vector<BsonRecord>& bsonRecords,
+                                                      const InsertDeleteOptions& options,
+                                                      int64_t* keysInsertedOut) {
+    // Records are in the order of their timestamps, so the first one has the earliest, which is
+    // where the multikey state of the batch is written.
+    const auto& ts = bsonRecords.front().ts;
+    if (!ts.isNull()) {
+        Status status = opCtx->recoveryUnit()->setTimestamp(ts);
+        if (!status.isOK())
+            return status;
+    }
+    const bool sameTimestamp = haveSameTimestamp(bsonRecords);
+
+    auto accessMethod = index->accessMethod();
+    // The keys of the batch, each with the position in 'bsonRecords' of the record it belongs to.
+    std::vector<std::pair<KeyString::Value, size_t>> batchKeys;
+    KeyStringSet batchMultikeyMetadataKeys;
+    boost::optional<MultikeyPaths> batchMultikeyPaths;
+
+    for (size_t i = 0; i < bsonRecords.size(); ++i) {
+        const auto& bsonRecord = bsonRecords[i];
+        invariant(bsonRecord.id != RecordId());
+
+        KeyStringSet keys;
+        KeyStringSet multikeyMetadataKeys;
+        MultikeyPaths multikeyPaths;
+
+        accessMethod->getKeys(*bsonRecord.docPtr,
+                              options.getKeysMode,
+                              IndexAccessMethod::GetKeysContext::kReadOrAddKeys,
+                              &keys,
+                              &multikeyMetadataKeys,
+                              &multikeyPaths,
+                              bsonRecord.id,
+                              IndexAccessMethod::kNoopOnSuppressedErrorFn);
+
+        // Whether the index becomes multikey depends on the keys of each document on its own, not
+        // on the number of keys in the whole batch.
+        if (accessMethod->shouldMarkIndexAsMultikey(
+                keys.size(),
+                {multikeyMetadataKeys.begin(), multikeyMetadataKeys.end()},
+                multikeyPaths)) {
+            mergeMultikeyPaths(multikeyPaths, &batchMultikeyPaths);
+        }
+
+        for (auto&& key : keys) {
+            batchKeys.emplace_back(key, i);
+        }
+        batchMultikeyMetadataKeys.insert(multikeyMetadataKeys.begin(), multikeyMetadataKeys.end());
+    }
+
+    // Every key ends with the RecordId of its document, so keys of different documents never
+    // compare equal. Inserting them in key order walks the index from left to right, rather than
+    // descending from the root to a random leaf for every key.
+    std::sort(batchKeys.begin(), batchKeys.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    // When the records have different timestamps, each key is still written at the timestamp of
+    // its own record, as it is when the records are indexed one at a time.
+    std::vector<KeyString::Value> sortedKeys;
+    std::vector<Timestamp> keyTimestamps;
+    sortedKeys.reserve(batchKeys.size());
+    if (!sameTimestamp) {
+        keyTimestamps.reserve(batchKeys.size());
+    }
+    for (auto&& [key, recordIndex] : batchKeys) {
+        sortedKeys.push_back(std::move(key));
+        if (!sameTimestamp) {
+            keyTimestamps.push_back(bsonRecords[recordIndex].ts);
+        }
+    }
+
+    InsertResult result;
+    Status status = accessMethod->insertKeysForBatch(
+        opCtx,
+        sortedKeys,
+        keyTimestamps,
+        {batchMultikeyMetadataKeys.begin(), batchMultikeyMetadataKeys.end()},
+        batchMultikeyPaths,
+        options,
+        &result);
+    if (keysInsertedOut) {
+        *keysInsertedOut += result.numInserted;
+    }
+    if (!status.isOK() || sameTimestamp) {
+        return status;
+    }
+
+    // Leave the recovery unit at the timestamp of the last record, as indexing the records one at
+    // a time would.
+    return opCtx->recoveryUnit()->setTimestamp(bsonRecords.back().ts);
+}
+
 Status IndexCatalogImpl::_indexRecords(OperationContext* opCtx,
                                        IndexCatalogEntry* index,
                                        const std::vector<BsonRecord>& bsonRecords,
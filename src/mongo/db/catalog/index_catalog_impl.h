@@ -321,6 +321,18 @@ private:
                                  const std::vector<BsonRecord>& bsonRecords,
                                  int64_t* keysInsertedOut);
 
+    /**
+     * Indexes 'bsonRecords' by generating the keys of the whole batch up front and inserting them
+     * in key order, each at the timestamp of its record. The records must either share one
+     * timestamp or all have one. Used by _indexFilteredRecords() for batches which are not being
+     * written to an index build's side table.
+     */
+    Status _indexFilteredRecordsInBatch(OperationContext* opCtx,
+                                        IndexCatalogEntry* index,
+                                        const std::vector<BsonRecord>& bsonRecords,
+                                        const InsertDeleteOptions& options,
+                                        int64_t* keysInsertedOut);
+
     Status _indexRecords(OperationContext* opCtx,
                          IndexCatalogEntry* index,
                          const std::vector<BsonRecord>& bsonRecords,
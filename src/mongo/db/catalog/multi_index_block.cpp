@@ -33,6 +33,7 @@
 
 #include "mongo/db/catalog/multi_index_block.h"
 
+#include <algorithm>
 #include <ostream>
 
 #include "mongo/base/error_codes.h"
@@ -56,6 +57,7 @@
 #include "mongo/logger/redaction.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -390,6 +392,205 @@ void failPointHangDuringBuild(FailPoint* fp, StringData where, const BSONObj& do
         });
 }
 
+/**
+ * The thread running the index build scans the collection and hands the documents it reads to this
+ * class in batches. Each batch is split into contiguous slices that are turned into keys by the
+ * worker threads, each of which owns a private BulkBuilder per index with an equal share of the
+ * index's memory budget. While the workers are busy with one batch the scan fills the next.
+ *
+ * Once the scan is complete, finish() replaces every index's BulkBuilder with one that merges the
+ * sorted output of all of the workers' builders, so dumpInsertsFromBulk() still bulk loads each
+ * index from a single sorted stream.
+ */
+class MultiIndexBlock::ParallelKeyGenerator {
+public:
+    ParallelKeyGenerator(MultiIndexBlock* block,
+                         size_t numWorkers,
+                         size_t eachIndexBuildMaxMemoryUsageBytes)
+        : _block(block), _indexes(&block->_indexes), _workers(numWorkers), _pool([&] {
+              ThreadPool::Options options;
+              options.poolName = "IndexBuildKeyGenerator";
+              options.minThreads = numWorkers;
+              options.maxThreads = numWorkers;
+              return options;
+          }()) {
+        for (auto& worker : _workers) {
+            for (auto& index : *_indexes) {
+                worker.bulks.push_back(
+                    index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes / numWorkers));
+            }
+            worker.skippedRecords.resize(_indexes->size());
+        }
+        _pool.startup();
+    }
+
+    ~ParallelKeyGenerator() {
+        _pool.shutdown();
+        _pool.join();
+    }
+
+    /**
+     * Buffers 'doc' for key generation, dispatching the buffered documents to the workers once the
+     * batch is full. Returns the first error encountered by a worker on a previous batch.
+     */
+    Status add(OperationContext* opCtx, const BSONObj& doc, const RecordId& loc) {
+        if (State::kAborted == _block->_getState()) {
+            return {ErrorCodes::IndexBuildAborted,
+                    str::stream() << "Index build aborted: " << _block->_abortReason};
+        }
+
+        _pendingBytes += doc.objsize();
+        _pending.emplace_back(doc.getOwned(), loc);
+        if (_pending.size() < kMaxBatchDocuments && _pendingBytes < kMaxBatchBytes) {
+            return Status::OK();
+        }
+        return _dispatch(opCtx);
+    }
+
+    /**
+     * Generates keys for the remaining documents and merges the workers' BulkBuilders into those of
+     * the indexes being built.
+     */
+    Status finish(OperationContext* opCtx) {
+        auto status = _dispatch(opCtx);
+        if (!status.isOK()) {
+            return status;
+        }
+        status = _waitForWorkers(opCtx);
+        if (!status.isOK()) {
+            return status;
+        }
+
+        for (size_t i = 0; i < _indexes->size(); i++) {
+            auto& index = (*_indexes)[i];
+            std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;
+            bulks.push_back(std::move(index.bulk));
+            for (auto& worker : _workers) {
+                bulks.push_back(std::move(worker.bulks[i]));
+            }
+            index.bulk = index.real->mergeBulk(std::move(bulks));
+        }
+        return Status::OK();
+    }
+
+private:
+    struct Worker {
+        // One per index, in the same order as '_indexes'.
+        std::vector<std::unique_ptr<IndexAccessMethod::BulkBuilder>> bulks;
+        std::vector<std::vector<RecordId>> skippedRecords;
+
+        Status status = Status::OK();
+    };
+
+    static constexpr size_t kMaxBatchDocuments = 10 * 1000;
+    static constexpr size_t kMaxBatchBytes = 16 * 1024 * 1024;
+
+    /**
+     * Waits for the previous batch to be processed, then hands the pending documents to the
+     * workers without waiting for them.
+     */
+    Status _dispatch(OperationContext* opCtx) {
+        auto status = _waitForWorkers(opCtx);
+        if (!status.isOK() || _pending.empty()) {
+            return status;
+        }
+
+        _inFlight.swap(_pending);
+        _pendingBytes = 0;
+
+        const size_t sliceSize = (_inFlight.size() + _workers.size() - 1) / _workers.size();
+        for (size_t w = 0; w < _workers.size() && w * sliceSize < _inFlight.size(); w++) {
+            const size_t begin = w * sliceSize;
+            const size_t end = std::min(begin + sliceSize, _inFlight.size());
+            _pool.schedule([this, w, begin, end](Status schedStatus) {
+                _workers[w].status =
+                    schedStatus.isOK() ? _generateKeys(&_workers[w], begin, end) : schedStatus;
+            });
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Waits for the workers to go idle, and records the documents whose key generation errors they
+     * suppressed with the skipped record tracker of the corresponding index, which needs an
+     * OperationContext to do so.
+     */
+    Status _waitForWorkers(OperationContext* opCtx) {
+        _pool.waitForIdle();
+        _inFlight.clear();
+
+        for (auto& worker : _workers) {
+            if (!worker.status.isOK()) {
+                return worker.status;
+            }
+        }
+
+        try {
+            WriteUnitOfWork wunit(opCtx);
+            for (auto& worker : _workers) {
+                for (size_t i = 0; i < _indexes->size(); i++) {
+                    auto& skippedRecords = worker.skippedRecords[i];
+                    if (skippedRecords.empty()) {
+                        continue;
+                    }
+                    auto tracker = (*_indexes)[i]
+                                       .block->getEntry()
+                                       ->indexBuildInterceptor()
+                                       ->getSkippedRecordTracker();
+                    for (const auto& loc : skippedRecords) {
+                        tracker->record(opCtx, loc);
+                    }
+                    skippedRecords.clear();
+                }
+            }
+            wunit.commit();
+        } catch (...) {
+            return exceptionToStatus();
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Runs on a worker thread. Inserts the documents in '_inFlight[begin, end)' into the worker's
+     * BulkBuilders.
+     */
+    Status _generateKeys(Worker* worker, size_t begin, size_t end) {
+        for (size_t d = begin; d < end; d++) {
+            const auto& doc = _inFlight[d].first;
+            const auto& loc = _inFlight[d].second;
+            for (size_t i = 0; i < _indexes->size(); i++) {
+                const auto& index = (*_indexes)[i];
+                if (index.filterExpression && !index.filterExpression->matchesBSON(doc)) {
+                    continue;
+                }
+
+                // BulkBuilderImpl's Sorter performs file I/O that may result in an exception.
+                try {
+                    auto status = worker->bulks[i]->insert(
+                        doc, loc, index.options, &worker->skippedRecords[i]);
+                    if (!status.isOK()) {
+                        return status;
+                    }
+                } catch (...) {
+                    return exceptionToStatus();
+                }
+            }
+        }
+        return Status::OK();
+    }
+
+    MultiIndexBlock* const _block;
+    std::vector<IndexToBuild>* const _indexes;
+    std::vector<Worker> _workers;
+
+    // Documents buffered by the scan, and the batch currently being processed by the workers.
+    std::vector<std::pair<BSONObj, RecordId>> _pending;
+    size_t _pendingBytes = 0;
+    std::vector<std::pair<BSONObj, RecordId>> _inFlight;
+
+    ThreadPool _pool;
+};
+
 Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
                                                        Collection* collection) {
     invariant(opCtx->lockState()->isNoop() || !opCtx->lockState()->inAWriteUnitOfWork());
@@ -454,6 +655,22 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
         _method != IndexBuildMethod::kBackground && useReadOnceCursorsForIndexBuilds.load();
     opCtx->recoveryUnit()->setReadOnce(readOnce);
 
+    // Background builds insert keys directly into the index and so cannot hand key generation off
+    // to other threads. Otherwise, the scan stays on this thread, which is required for yielding
+    // and for reading at the build's snapshot, but keys may be generated and sorted elsewhere.
+    std::unique_ptr<ParallelKeyGenerator> keyGenerator;
+    const auto parallelism = static_cast<size_t>(indexBuildParallelism.load());
+    if (parallelism > 1 && _method != IndexBuildMethod::kBackground && !_indexes.empty() &&
+        std::all_of(_indexes.begin(), _indexes.end(), [](const auto& index) {
+            return static_cast<bool>(index.bulk);
+        })) {
+        keyGenerator = std::make_unique<ParallelKeyGenerator>(
+            this,
+            parallelism,
+            static_cast<std::size_t>(maxIndexBuildMemoryUsageMegabytes.load()) * 1024 * 1024 /
+                _indexes.size());
+    }
+
     Snapshotted<BSONObj> objToIndex;
     RecordId loc;
     PlanExecutor::ExecState state;
@@ -484,7 +701,8 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
             failPointHangDuringBuild(&hangBeforeIndexBuildOf, "before", objToIndex.value());
 
             WriteUnitOfWork wunit(opCtx);
-            Status ret = insert(opCtx, objToIndex.value(), loc);
+            Status ret = keyGenerator ? keyGenerator->add(opCtx, objToIndex.value(), loc)
+                                      : insert(opCtx, objToIndex.value(), loc);
             if (_method == IndexBuildMethod::kBackground)
                 exec->saveState();
             if (!ret.isOK()) {
@@ -531,6 +749,13 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
         return exec->getMemberObjectStatus(objToIndex.value());
     }
 
+    if (keyGenerator) {
+        Status status = keyGenerator->finish(opCtx);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
     if (MONGO_unlikely(leaveIndexBuildUnfinishedForShutdown.shouldFail())) {
         LOGV2(20389,
               "Index build interrupted due to 'leaveIndexBuildUnfinishedForShutdown' failpoint. "
@@ -338,6 +338,12 @@ private:
         InsertDeleteOptions options;
     };
 
+    /**
+     * Generates and sorts index keys on a pool of worker threads while the collection scan in
+     * insertAllDocumentsInCollection() runs on the calling thread.
+     */
+    class ParallelKeyGenerator;
+
     /**
      * Returns the current state.
      */
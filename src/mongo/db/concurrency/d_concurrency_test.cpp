@@ -82,7 +82,7 @@ public:
 
 private:
     OperationContext* _opCtx;
-    TicketHolder _holder;
+    SemaphoreTicketHolder _holder;
 };
 
 
@@ -35,7 +35,9 @@
 
 #include <vector>
 
+#include "mongo/db/client.h"
 #include "mongo/db/concurrency/flow_control_ticketholder.h"
+#include "mongo/db/concurrency/ticket_admission_gen.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/flow_control.h"
@@ -253,6 +255,35 @@ void CondVarLockGrantNotification::notify(ResourceId resId, LockResult result) {
 
 namespace {
 TicketHolder* ticketHolders[LockModesCount] = {};
+
+/**
+ * Picks the admission class for an operation queueing for a ticket. Unless the locker says
+ * otherwise, work on behalf of the server or other cluster members is internal, and user
+ * operations count as batch work once they have been running for long enough.
+ */
+AdmissionContext::Priority deriveAdmissionPriority(OperationContext* opCtx,
+                                                   const Locker* locker) {
+    if (auto priority = locker->getAdmissionPriority()) {
+        return *priority;
+    }
+
+    auto client = opCtx ? opCtx->getClient() : nullptr;
+    if (!client) {
+        return AdmissionContext::Priority::kInteractive;
+    }
+
+    const auto& session = client->session();
+    if (!client->isFromUserConnection() ||
+        (session && (session->getTags() & transport::Session::kInternalClient))) {
+        return AdmissionContext::Priority::kInternal;
+    }
+
+    const auto batchThreshold = Milliseconds(gTicketAdmissionBatchThresholdMillis.load());
+    if (batchThreshold > Milliseconds(0) && opCtx->getElapsedTime() >= batchThreshold) {
+        return AdmissionContext::Priority::kBatch;
+    }
+    return AdmissionContext::Priority::kInteractive;
+}
 }  // namespace
 
 
@@ -267,6 +298,11 @@ void Locker::setGlobalThrottling(class TicketHolder* reading, class TicketHolder
     ticketHolders[MODE_IX] = writing;
 }
 
+/* static */
+TicketHolder* Locker::getGlobalThrottling(LockMode mode) {
+    return ticketHolders[mode];
+}
+
 LockerImpl::LockerImpl()
     : _id(idCounter.addAndFetch(1)), _wuowNestingLevel(0), _threadId(stdx::this_thread::get_id()) {}
 
@@ -338,10 +374,11 @@ bool LockerImpl::_acquireTicket(OperationContext* opCtx, LockMode mode, Date_t d
         // If the ticket wait is interrupted, restore the state of the client.
         auto restoreStateOnErrorGuard = makeGuard([&] { _clientState.store(kInactive); });
 
+        const AdmissionContext admCtx(deriveAdmissionPriority(opCtx, this), getAdmissionTenant());
         OperationContext* interruptible = _uninterruptibleLocksRequested ? nullptr : opCtx;
         if (deadline == Date_t::max()) {
-            holder->waitForTicket(interruptible);
-        } else if (!holder->waitForTicketUntil(interruptible, deadline)) {
+            holder->waitForTicket(interruptible, admCtx);
+        } else if (!holder->waitForTicketUntil(interruptible, deadline, admCtx)) {
             return false;
         }
         restoreStateOnErrorGuard.dismiss();
@@ -37,6 +37,7 @@
 #include "mongo/db/concurrency/lock_stats.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
 
@@ -76,6 +77,12 @@ public:
      */
     static void setGlobalThrottling(class TicketHolder* reading, class TicketHolder* writing);
 
+    /**
+     * Returns the TicketHolder that global lock attempts in 'mode' obtain tickets from, or nullptr
+     * if they are not throttled.
+     */
+    static TicketHolder* getGlobalThrottling(LockMode mode);
+
     /**
      * State for reporting the number of active and queued reader and writer clients.
      */
@@ -492,6 +499,29 @@ public:
         return _shouldAcquireTicket;
     }
 
+    /**
+     * Fixes the class this locker's operation queues in when it waits for a storage ticket,
+     * instead of deriving it from the operation's client. Used by replication so that applying the
+     * oplog is not held back by user load.
+     */
+    void setAdmissionPriority(AdmissionContext::Priority priority) {
+        _admissionPriority = priority;
+    }
+    boost::optional<AdmissionContext::Priority> getAdmissionPriority() const {
+        return _admissionPriority;
+    }
+
+    /**
+     * Names who this locker's operation is acting for, usually the authenticated user, so that
+     * storage tickets are shared fairly between tenants of the same admission class.
+     */
+    void setAdmissionTenant(std::string tenant) {
+        _admissionTenant = std::move(tenant);
+    }
+    const std::string& getAdmissionTenant() const {
+        return _admissionTenant;
+    }
+
     /**
      * Acquire a flow control admission ticket into the system. Flow control is used as a
      * backpressure mechanism to limit replication majority point lag.
@@ -540,6 +570,8 @@ protected:
 private:
     bool _shouldConflictWithSecondaryBatchApplication = true;
     bool _shouldAcquireTicket = true;
+    boost::optional<AdmissionContext::Priority> _admissionPriority;
+    std::string _admissionTenant;
     std::string _debugInfo;  // Extra info about this locker for debugging purpose
 };
 
@@ -102,8 +102,10 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/periodic_runner_job_abort_expired_transactions.h"
 #include "mongo/db/periodic_runner_job_decrease_snapshot_cache_pressure.h"
+#include "mongo/db/periodic_runner_job_persist_plan_cache.h"
 #include "mongo/db/pipeline/process_interface/replica_set_node_process_interface.h"
 #include "mongo/db/query/internal_plans.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/read_write_concern_defaults_cache_lookup_mongod.h"
 #include "mongo/db/repair_database_and_check_version.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
@@ -145,6 +147,7 @@
 #include "mongo/db/storage/storage_engine_lock_file.h"
 #include "mongo/db/storage/storage_options.h"
 #include "mongo/db/storage/storage_parameters_gen.h"
+#include "mongo/db/storage/ticket_concurrency_controller.h"
 #include "mongo/db/system_index.h"
 #include "mongo/db/transaction_participant.h"
 #include "mongo/db/ttl.h"
@@ -335,6 +338,9 @@ ExitCode _initAndListen(int listenPort) {
                      std::make_unique<FlowControl>(
                          serviceContext, repl::ReplicationCoordinator::get(serviceContext)));
 
+    TicketConcurrencyController::set(serviceContext,
+                                     std::make_unique<TicketConcurrencyController>(serviceContext));
+
     initializeStorageEngine(serviceContext, StorageEngineInitFlags::kNone);
 
 #ifdef MONGO_CONFIG_WIREDTIGER_ENABLED
@@ -685,6 +691,12 @@ ExitCode _initAndListen(int listenPort) {
         }
     }
 
+    // Start up a background task to periodically persist the plan caches and to warm them up from
+    // the persisted entries at startup.
+    if (internalQueryCachePersistenceIntervalSecs.load() > 0) {
+        PeriodicThreadToPersistPlanCache::get(serviceContext)->start();
+    }
+
     // Set up the logical session cache
     LogicalSessionCacheServer kind = LogicalSessionCacheServer::kStandalone;
     if (serverGlobalParams.clusterRole == ClusterRole::ShardServer) {
@@ -1072,6 +1084,10 @@ void shutdownTask(const ShutdownTaskArgs& shutdownArgs) {
             PeriodicThreadToDecreaseSnapshotHistoryCachePressure::get(serviceContext)->stop();
         }
 
+        if (internalQueryCachePersistenceIntervalSecs.load() > 0) {
+            PeriodicThreadToPersistPlanCache::get(serviceContext)->stop();
+        }
+
         ServiceContext::UniqueOperationContext uniqueOpCtx;
         OperationContext* opCtx = client->getOperationContext();
         if (!opCtx) {
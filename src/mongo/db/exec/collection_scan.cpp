@@ -86,6 +86,18 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
         invariant(params.direction == CollectionScanParams::FORWARD);
     }
 
+    if (params.minRecord || params.maxRecord) {
+        // Range-restricted scans are used to partition a forward scan across several cursors.
+        invariant(params.direction == CollectionScanParams::FORWARD);
+        invariant(!params.tailable);
+        invariant(!params.minTs && !params.maxTs);
+        invariant(!params.resumeAfterRecordId);
+    }
+
+    if (supportsBatchedWork()) {
+        _batchFilter = BatchFilter::compile(_filter);
+    }
+
     // Set early stop condition.
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte"_sd << *(params.maxTs));
@@ -180,7 +192,10 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
             }
         }
 
-        if (!record) {
+        if (_lastSeenId.isNull() && _params.minRecord) {
+            // Position the cursor at the start of this scan's RecordId range.
+            record = _cursor->seekAtOrAfter(*_params.minRecord);
+        } else if (!record) {
             record = _cursor->next();
         }
     } catch (const WriteConflictException&) {
@@ -204,6 +219,11 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_params.maxRecord && record->id > *_params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
     if (_params.shouldTrackLatestOplogTimestamp) {
         auto status = setLatestOplogEntryTimestamp(*record);
@@ -223,6 +243,116 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) {
+    if (!supportsBatchedWork() || !_cursor || _commonStats.isEOF ||
+        (_params.minRecord && _lastSeenId.isNull())) {
+        // Cursor creation, positioning and the end of the scan are handled one record at a time.
+        return PlanStage::doWorkBatch(batch, out);
+    }
+
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    const auto snapshotId = getOpCtx()->recoveryUnit()->getSnapshotId();
+    const size_t initialSize = batch->size();
+    // Bound the number of records examined so that a selective filter still returns control to
+    // the caller, which is responsible for yielding and checking for interrupt.
+    const size_t maxRecords = batch->capacity() - initialSize;
+    size_t examined = 0;
+    bool needYield = false;
+
+    auto appendToBatch = [&](const RecordId& recordId, const BSONObj& obj) {
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->recordId = recordId;
+        member->resetDocument(snapshotId, obj.getOwned());
+        _workingSet->transitionToRecordIdAndObj(id);
+        batch->append(id);
+    };
+
+    // Evaluates '_batchFilter' over the block of records copied so far, appends the matching ones
+    // to 'batch' and empties the block.
+    auto filterBlock = [&]() {
+        if (_blockRecords.empty()) {
+            return;
+        }
+
+        // The block buffer no longer moves, so the documents in it can now be addressed.
+        _blockDocs.clear();
+        for (auto&& blockRecord : _blockRecords) {
+            _blockDocs.emplace_back(_blockBuffer.buf() + blockRecord.second);
+        }
+
+        _batchFilter->evaluate(_blockDocs, &_blockSelected);
+        for (size_t i = 0; i < _blockDocs.size(); ++i) {
+            if (_blockSelected[i]) {
+                appendToBatch(_blockRecords[i].first, _blockDocs[i]);
+            }
+        }
+
+        _blockBuffer.reset();
+        _blockRecords.clear();
+    };
+
+    _blockBuffer.reset();
+    _blockRecords.clear();
+
+    try {
+        while (examined < maxRecords) {
+            boost::optional<Record> record = _cursor->next();
+            if (!record || (_params.maxRecord && record->id > *_params.maxRecord)) {
+                _commonStats.isEOF = true;
+                break;
+            }
+
+            ++examined;
+            ++_specificStats.docsTested;
+            _lastSeenId = record->id;
+
+            // The record data may point into the cursor's buffer and is only valid until the
+            // cursor is advanced, so it must be filtered or copied right away.
+            if (_batchFilter) {
+                // Bound the size of the block, since a BufBuilder cannot grow past 64MB.
+                if (_blockBuffer.len() + record->data.size() > BSONObjMaxUserSize) {
+                    filterBlock();
+                }
+                _blockRecords.emplace_back(record->id, _blockBuffer.len());
+                _blockBuffer.appendBuf(record->data.data(), record->data.size());
+                continue;
+            }
+
+            BSONObj obj = record->data.releaseToBson();
+            if (_filter && !_filter->matchesBSON(obj)) {
+                continue;
+            }
+            appendToBatch(record->id, obj);
+        }
+    } catch (const WriteConflictException&) {
+        needYield = true;
+    }
+
+    filterBlock();
+
+    const size_t advanced = batch->size() - initialSize;
+    _commonStats.works += examined;
+    _commonStats.advanced += advanced;
+    _commonStats.needTime += examined - advanced;
+
+    if (needYield) {
+        ++_commonStats.needYield;
+        if (advanced > 0) {
+            return deferBatchState(PlanStage::NEED_YIELD, WorkingSet::INVALID_ID);
+        }
+        *out = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (advanced > 0) {
+        return PlanStage::ADVANCED;
+    }
+
+    *out = WorkingSet::INVALID_ID;
+    return _commonStats.isEOF ? PlanStage::IS_EOF : PlanStage::NEED_TIME;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -33,6 +33,7 @@
 
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/requires_collection_stage.h"
+#include "mongo/db/matcher/batch_filter.h"
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
 
@@ -62,6 +63,17 @@ public:
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
 
+    /**
+     * Batched collection scans are only supported for plain scans. Scans which seek or stop based
+     * on oplog timestamps, report a resume token or tail a capped collection must see each record
+     * through doWork().
+     */
+    bool supportsBatchedWork() const final {
+        return !_params.tailable && !_params.minTs && !_params.maxTs &&
+            !_params.requestResumeToken && !_params.shouldTrackLatestOplogTimestamp &&
+            !_params.stopApplyingFilterAfterFirstMatch;
+    }
+
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
 
@@ -82,6 +94,13 @@ public:
     const SpecificStats* getSpecificStats() const final;
 
 protected:
+    /**
+     * Reads records from the cursor in a tight loop, evaluating the filter against each record
+     * before the cursor is advanced again. A WorkingSetMember is only allocated, and the document
+     * only copied, for records which pass the filter.
+     */
+    StageState doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) final;
+
     void doSaveStateRequiresCollection() final;
 
     void doRestoreStateRequiresCollection() final;
@@ -106,6 +125,19 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // A compiled form of '_filter' which doWorkBatch() evaluates over a block of records at a time.
+    // Null if there is no filter or it cannot be compiled.
+    std::unique_ptr<BatchFilter> _batchFilter;
+
+    // Scratch space used by doWorkBatch() to hold the block of records being evaluated by
+    // '_batchFilter'. Records are copied into '_blockBuffer', and '_blockRecords' holds the
+    // RecordId and buffer offset of each one. A block is filtered as soon as adding another record
+    // would take it past BSONObjMaxUserSize bytes.
+    BufBuilder _blockBuffer;
+    std::vector<std::pair<RecordId, int>> _blockRecords;
+    std::vector<BSONObj> _blockDocs;
+    std::vector<uint8_t> _blockSelected;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
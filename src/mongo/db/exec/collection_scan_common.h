@@ -61,6 +61,14 @@ struct CollectionScanParams {
     // This field cannot be used in conjunction with 'minTs' or 'maxTs'.
     boost::optional<RecordId> resumeAfterRecordId;
 
+    // If present, the collection scan will begin at the first record whose RecordId is greater
+    // than or equal to 'minRecord' and will return EOF upon reaching a record whose RecordId is
+    // greater than 'maxRecord'. Used to divide a collection scan into disjoint RecordId ranges.
+    // Must only be set on forward, non-tailable collection scans.
+    // These fields cannot be used in conjunction with 'minTs', 'maxTs' or 'resumeAfterRecordId'.
+    boost::optional<RecordId> minRecord;
+    boost::optional<RecordId> maxRecord;
+
     Direction direction = FORWARD;
 
     // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
@@ -64,7 +64,7 @@ FetchStage::FetchStage(OperationContext* opCtx,
 FetchStage::~FetchStage() {}
 
 bool FetchStage::isEOF() {
-    if (WorkingSet::INVALID_ID != _idRetrying) {
+    if (WorkingSet::INVALID_ID != _idRetrying || !_batchRetrying.empty()) {
         // We have a working set member that we need to retry.
         return false;
     }
@@ -77,6 +77,11 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_idRetrying == WorkingSet::INVALID_ID && !_batchRetrying.empty()) {
+        _idRetrying = _batchRetrying.front();
+        _batchRetrying.erase(_batchRetrying.begin());
+    }
+
     // Either retry the last WSM we worked on or get a new one from our child.
     WorkingSetID id;
     StageState status;
@@ -131,6 +136,107 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) {
+    // A member left over by a write conflict in doWork() is retried one document at a time.
+    if (WorkingSet::INVALID_ID != _idRetrying) {
+        return PlanStage::doWorkBatch(batch, out);
+    }
+
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    ++_commonStats.works;
+
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    const size_t initialSize = batch->size();
+    if (!_batchRetrying.empty()) {
+        size_t retried = 0;
+        while (retried < _batchRetrying.size() && !batch->full()) {
+            batch->append(_batchRetrying[retried++]);
+        }
+        _batchRetrying.erase(_batchRetrying.begin(), _batchRetrying.begin() + retried);
+    } else {
+        const StageState status = child()->workBatch(batch, out);
+        if (PlanStage::ADVANCED != status) {
+            if (PlanStage::NEED_TIME == status) {
+                ++_commonStats.needTime;
+            } else if (PlanStage::NEED_YIELD == status) {
+                ++_commonStats.needYield;
+            } else if (PlanStage::FAILURE == status) {
+                _commonStats.failed = true;
+            }
+            return status;
+        }
+    }
+
+    _batchFetched.assign(batch->size() - initialSize, true);
+    size_t fetched = 0;
+    bool needYield = false;
+    try {
+        for (; initialSize + fetched < batch->size(); ++fetched) {
+            const WorkingSetID id = batch->get(initialSize + fetched);
+            WorkingSetMember* member = _ws->get(id);
+
+            // If there's an obj there, there is no fetching to perform.
+            if (member->hasObj()) {
+                ++_specificStats.alreadyHasObj;
+                continue;
+            }
+
+            // We need a valid RecordId to fetch from and this is the only state that has one.
+            verify(WorkingSetMember::RID_AND_IDX == member->getState());
+            verify(member->hasRecordId());
+
+            if (!_cursor)
+                _cursor = collection()->getCursor(getOpCtx());
+
+            if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor, collection()->ns())) {
+                _batchFetched[fetched] = false;
+                continue;
+            }
+
+            // The batch outlives the cursor position the record was read from.
+            member->makeObjOwnedIfNeeded();
+        }
+    } catch (const WriteConflictException&) {
+        // Ensure that the BSONObj underlying the WorkingSetMember is owned because it may be freed
+        // when we yield. Keep what has been fetched so far, and fetch the rest after the yield.
+        _ws->get(batch->get(initialSize + fetched))->makeObjOwnedIfNeeded();
+        batch->removeFrom(initialSize + fetched, &_batchRetrying);
+        needYield = true;
+    }
+
+    // See returnIfMatches() for what counts as examining a document.
+    size_t position = 0;
+    batch->select(initialSize, [&](WorkingSetID id) {
+        if (!_batchFetched[position++]) {
+            return false;
+        }
+        ++_specificStats.docsExamined;
+        return Filter::passes(_ws->get(id), _filter);
+    });
+
+    const size_t advanced = batch->size() - initialSize;
+    _commonStats.advanced += advanced;
+
+    if (needYield) {
+        ++_commonStats.needYield;
+        if (advanced > 0) {
+            return deferBatchState(PlanStage::NEED_YIELD, WorkingSet::INVALID_ID);
+        }
+        *out = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (advanced == 0) {
+        ++_commonStats.needTime;
+        *out = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_TIME;
+    }
+    return PlanStage::ADVANCED;
+}
+
 void FetchStage::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->saveUnpositioned();
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/db/exec/requires_collection_stage.h"
 #include "mongo/db/jsobj.h"
@@ -61,6 +62,14 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    /**
+     * A batch fetches the records of a whole block of index entries at once, so it is worthwhile
+     * even when the child produces its results one at a time.
+     */
+    bool supportsBatchedWork() const final {
+        return true;
+    }
+
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
 
@@ -75,6 +84,12 @@ public:
     static const char* kStageType;
 
 protected:
+    /**
+     * Pulls a batch from the child, fetches the records of its members with a single cursor and
+     * deselects the members whose record is gone or which fail the filter.
+     */
+    StageState doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) final;
+
     void doSaveStateRequiresCollection() final;
 
     void doRestoreStateRequiresCollection() final;
@@ -98,6 +113,13 @@ private:
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Members of a batch which had not been fetched when a write conflict ended it. They are
+    // fetched before anything else is asked of the child.
+    std::vector<WorkingSetID> _batchRetrying;
+
+    // Scratch space used by doWorkBatch(), recording whether each member of the batch was fetched.
+    std::vector<char> _batchFetched;
+
     // Stats
     FetchStats _specificStats;
 };
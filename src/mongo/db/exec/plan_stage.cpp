@@ -59,6 +59,42 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) {
+    // Bound the number of calls to work() so that a stage which mostly returns NEED_TIME still
+    // gives the caller a chance to yield.
+    for (size_t attempts = 0; attempts < batch->capacity() && !batch->full(); ++attempts) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const StageState state = work(&id);
+
+        switch (state) {
+            case ADVANCED: {
+                batch->workingSet()->get(id)->makeObjOwnedIfNeeded();
+                batch->append(id);
+                break;
+            }
+            case NEED_TIME:
+                break;
+            case IS_EOF:
+            case NEED_YIELD:
+                if (!batch->empty()) {
+                    return deferBatchState(state, id);
+                }
+                *out = id;
+                return state;
+            case FAILURE:
+                batch->release();
+                *out = id;
+                return state;
+        }
+    }
+
+    if (batch->empty()) {
+        *out = WorkingSet::INVALID_ID;
+        return NEED_TIME;
+    }
+    return ADVANCED;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -29,11 +29,13 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 #include <vector>
 
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_batch.h"
 
 namespace mongo {
 
@@ -193,6 +195,36 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Performs several units of work at once, appending results to 'batch' rather than returning
+     * them one at a time. Returns ADVANCED if 'batch' holds at least one result. Otherwise returns
+     * the state which ended the batch, and sets *out exactly as work() would for that state.
+     *
+     * IS_EOF and NEED_YIELD end a batch early; if results have already been appended they are
+     * returned as ADVANCED and the same state is reported by the next call, before any more work
+     * is done. On FAILURE any partial results are released.
+     *
+     * Stages which have no batched implementation fall back to repeated calls to work().
+     */
+    StageState workBatch(WorkingSetBatch* batch, WorkingSetID* out) {
+        invariant(_opCtx);
+        if (_deferredBatchState) {
+            const StageState state = *_deferredBatchState;
+            _deferredBatchState = boost::none;
+            *out = _deferredBatchId;
+            return state;
+        }
+        return doWorkBatch(batch, out);
+    }
+
+    /**
+     * Returns true if this stage can produce batches more cheaply than by repeated calls to
+     * work(). Callers should only prefer workBatch() over work() when this is true.
+     */
+    virtual bool supportsBatchedWork() const {
+        return false;
+    }
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -341,6 +373,25 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Fills 'batch' with results. See comment at workBatch() above.
+     *
+     * The default implementation calls work() until the batch is full, making each result's BSON
+     * owned. Stages which override this are responsible for maintaining their own CommonStats.
+     */
+    virtual StageState doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out);
+
+    /**
+     * Used by doWorkBatch() when 'state' ends a batch which already holds results. Records 'state'
+     * and 'id' to be returned by the next call to workBatch(), and returns ADVANCED.
+     */
+    StageState deferBatchState(StageState state, WorkingSetID id) {
+        invariant(state == IS_EOF || state == NEED_YIELD);
+        _deferredBatchState = state;
+        _deferredBatchId = id;
+        return ADVANCED;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -386,6 +437,10 @@ protected:
 
 private:
     OperationContext* _opCtx;
+
+    // The state which ended the last batch, if it still has to be returned by workBatch().
+    boost::optional<StageState> _deferredBatchState;
+    WorkingSetID _deferredBatchId = WorkingSet::INVALID_ID;
 };
 
 }  // namespace mongo
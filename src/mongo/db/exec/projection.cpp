@@ -159,6 +159,38 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) {
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    ++_commonStats.works;
+
+    const size_t initialSize = batch->size();
+    StageState status = child()->workBatch(batch, out);
+    if (PlanStage::ADVANCED != status) {
+        if (PlanStage::NEED_TIME == status) {
+            ++_commonStats.needTime;
+        } else if (PlanStage::NEED_YIELD == status) {
+            ++_commonStats.needYield;
+        } else if (PlanStage::FAILURE == status) {
+            _commonStats.failed = true;
+        }
+        return status;
+    }
+
+    for (size_t i = initialSize; i < batch->size(); ++i) {
+        Status projStatus = transform(_ws.get(batch->get(i)));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+            batch->release();
+            *out = WorkingSetCommon::allocateStatusMember(&_ws, projStatus);
+            _commonStats.failed = true;
+            return PlanStage::FAILURE;
+        }
+    }
+
+    _commonStats.advanced += batch->size() - initialSize;
+    return PlanStage::ADVANCED;
+}
+
 std::unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     auto ret = std::make_unique<PlanStageStats>(_commonStats, stageType());
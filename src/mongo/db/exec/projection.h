@@ -53,6 +53,10 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    bool supportsBatchedWork() const final {
+        return child()->supportsBatchedWork();
+    }
+
     std::unique_ptr<PlanStageStats> getStats() final;
 
     const SpecificStats* getSpecificStats() const final {
@@ -62,6 +66,11 @@ public:
 protected:
     using FieldSet = StringSet;
 
+    /**
+     * Pulls a batch from the child and projects each member of it in place.
+     */
+    StageState doWorkBatch(WorkingSetBatch* batch, WorkingSetID* out) final;
+
     // The raw BSON projection used to populate projection stats. Optional, since it is required
     // only in explain mode.
     boost::optional<BSONObj> _projObj;
@@ -37,6 +37,7 @@
 #include <memory>
 
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_batch.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/unittest/unittest.h"
@@ -123,4 +124,37 @@ TEST_F(QueuedDataStageTest, validateStats) {
     unique_ptr<PlanStageStats> allStats(mock->getStats());
     ASSERT_TRUE(stats->isEOF);
 }
+
+//
+// Test that a NEED_YIELD which ends a batch holding results is returned by the next batch.
+//
+TEST_F(QueuedDataStageTest, workBatchDefersNeedYield) {
+    WorkingSet ws;
+    auto mock = std::make_unique<QueuedDataStage>(getOpCtx(), &ws);
+    const WorkingSetID firstId = ws.allocate();
+    const WorkingSetID secondId = ws.allocate();
+    mock->pushBack(firstId);
+    mock->pushBack(PlanStage::NEED_YIELD);
+    mock->pushBack(secondId);
+
+    WorkingSetBatch batch(&ws, 4);
+    WorkingSetID out = WorkingSet::INVALID_ID;
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(&batch, &out));
+    ASSERT_EQUALS(1U, batch.size());
+    ASSERT_EQUALS(firstId, batch.next());
+
+    // The yield is reported before the stage does any more work.
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::NEED_YIELD, mock->workBatch(&batch, &out));
+    ASSERT_TRUE(batch.empty());
+    ASSERT_EQUALS(2U, mock->getCommonStats()->works);
+
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(&batch, &out));
+    ASSERT_EQUALS(1U, batch.size());
+    ASSERT_EQUALS(secondId, batch.next());
+
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::IS_EOF, mock->workBatch(&batch, &out));
+    ASSERT_TRUE(batch.empty());
+}
 }  // namespace
@@ -32,6 +32,7 @@
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/query/query_knobs_gen.h"
 
 namespace mongo {
 
@@ -45,6 +46,13 @@ SortStage::SortStage(boost::intrusive_ptr<ExpressionContext> expCtx,
       _sortKeyGen(sortPattern, expCtx->getCollator()),
       _addSortKeyMetadata(addSortKeyMetadata) {
     _children.emplace_back(std::move(child));
+
+    // The sort consumes its whole input before producing anything, so it can pull the input from
+    // its child a batch at a time regardless of how its own results are consumed.
+    const auto batchSize = internalQueryExecBatchedWorkSize.load();
+    if (batchSize > 1 && child()->supportsBatchedWork()) {
+        _inputBatch = std::make_unique<WorkingSetBatch>(_ws, batchSize);
+    }
 }
 
 PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
@@ -54,14 +62,25 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
 
     if (!_populated) {
         WorkingSetID id = WorkingSet::INVALID_ID;
-        const StageState code = child()->work(&id);
+        const StageState code =
+            _inputBatch ? child()->workBatch(_inputBatch.get(), &id) : child()->work(&id);
 
         if (code == PlanStage::ADVANCED) {
             // The plan must be structured such that a previous stage has attached the sort key
             // metadata.
             try {
-                spool(id);
+                if (_inputBatch) {
+                    while (!_inputBatch->empty()) {
+                        spool(_inputBatch->next());
+                    }
+                    _inputBatch->clear();
+                } else {
+                    spool(id);
+                }
             } catch (const AssertionException&) {
+                if (_inputBatch) {
+                    _inputBatch->release();
+                }
                 // Propagate runtime errors using the FAILED status code.
                 *out = WorkingSetCommon::allocateStatusMember(_ws, exceptionToStatus());
                 return PlanStage::FAILURE;
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -37,6 +38,7 @@
 #include "mongo/db/exec/sort_key_comparator.h"
 #include "mongo/db/exec/sort_key_generator.h"
 #include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_batch.h"
 #include "mongo/db/record_id.h"
 
 namespace mongo {
@@ -98,6 +100,9 @@ protected:
 private:
     // Whether or not we have finished loading data into '_sortExecutor'.
     bool _populated = false;
+
+    // Set when the input is pulled from the child with workBatch() rather than work().
+    std::unique_ptr<WorkingSetBatch> _inputBatch;
 };
 
 /**
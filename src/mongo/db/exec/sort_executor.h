@@ -29,11 +29,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <boost/optional.hpp>
+#include <numeric>
+#include <string>
+#include <vector>
+
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/plan_stats.h"
 #include "mongo/db/exec/sort_key_comparator.h"
+#include "mongo/db/exec/sort_key_string.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/sorter/sorter.h"
 
@@ -47,6 +55,12 @@ namespace mongo {
  * The template parameter is the type of data being sorted. In DocumentSource execution, we sort
  * Document objects directly, but in the PlanStage layer we may sort WorkingSetMembers. The type of
  * the sort key, on the other hand, is always Value.
+ *
+ * Sorts which fit in memory order KeyString encodings of their sort keys, which compare with
+ * memcmp. A sort with a small limit keeps its top-k documents in a bounded heap, and a sort
+ * without a limit buffers its documents and orders them with a radix sort. If the documents
+ * outgrow the memory limit, or a sort key cannot be encoded, the executor hands its documents
+ * over to a Sorter which uses SortKeyComparator and may spill to disk.
  */
 template <typename T>
 class SortExecutor {
@@ -123,18 +137,26 @@ public:
      * Should only be called before 'loadingDone()' is called.
      */
     void add(const Value& sortKey, const T& data) {
+        _stats.totalDataSizeBytes += data.memUsageForSorter();
+        if (!_sorter && addToKeyStringSort(sortKey, data)) {
+            return;
+        }
+
         if (!_sorter) {
             _sorter.reset(DocumentSorter::make(makeSortOptions(), Comparator(_sortPattern)));
         }
         _sorter->add(sortKey, data);
-
-        _stats.totalDataSizeBytes += data.memUsageForSorter();
     }
 
     /**
      * Signals to the sort executor that there will be no more input documents.
      */
     void loadingDone() {
+        if (!_sorter && isKeyStringSortActive()) {
+            keyStringSortLoadingDone();
+            return;
+        }
+
         // This conditional should only pass if no documents were added to the sorter.
         if (!_sorter) {
             _sorter.reset(DocumentSorter::make(makeSortOptions(), Comparator(_sortPattern)));
@@ -153,8 +175,11 @@ public:
             return false;
         }
 
-        if (!_output->more()) {
+        const bool more =
+            _output ? _output->more() : _keyStringOutputPos < _keyStringOutput.size();
+        if (!more) {
             _output.reset();
+            _keyStringOutput.clear();
             _isEOF = true;
             return false;
         }
@@ -168,10 +193,157 @@ public:
      * end-of-stream must be detected with 'hasNext()'.
      */
     std::pair<Value, T> getNext() {
-        return _output->next();
+        if (_output) {
+            return _output->next();
+        }
+        return std::move(_keyStringOutput[_keyStringOutputPos++]);
     }
 
 private:
+    enum class KeyStringSort { kUndecided, kNone, kTopK, kFullSort };
+
+    /**
+     * A document buffered by the KeyString sort. 'order' is the position at which the document was
+     * added, which breaks ties between equal keys so that the earliest document sorts first.
+     */
+    struct KeyStringEntry {
+        std::string keyString;
+        uint64_t order;
+        Value sortKey;
+        T data;
+
+        size_t memUsage() const {
+            return keyString.size() + sortKey.memUsageForSorter() + data.memUsageForSorter();
+        }
+
+        bool operator<(const KeyStringEntry& other) const {
+            const int cmp = keyString.compare(other.keyString);
+            return cmp < 0 || (cmp == 0 && order < other.order);
+        }
+    };
+
+    bool isKeyStringSortActive() const {
+        return _keyStringSort == KeyStringSort::kTopK || _keyStringSort == KeyStringSort::kFullSort;
+    }
+
+    void chooseKeyStringSort() {
+        _keyStringSort = KeyStringSort::kNone;
+        if (!SortKeyStringEncoder::canEncode(_sortPattern)) {
+            return;
+        }
+
+        if (hasLimit()) {
+            if (_stats.limit <= static_cast<uint64_t>(internalQuerySortTopKHeapMaxLimit.load())) {
+                _keyStringSort = KeyStringSort::kTopK;
+            }
+        } else if (internalQuerySortRadixSortMinDocuments.load() > 0) {
+            _keyStringSort = KeyStringSort::kFullSort;
+        }
+
+        if (isKeyStringSortActive()) {
+            _keyStringEncoder.emplace(_sortPattern);
+        }
+    }
+
+    /**
+     * Adds the document to the KeyString sort if it is in use. Returns false if the caller should
+     * add the document to '_sorter' instead.
+     */
+    bool addToKeyStringSort(const Value& sortKey, const T& data) {
+        if (_keyStringSort == KeyStringSort::kUndecided) {
+            chooseKeyStringSort();
+        }
+        if (!isKeyStringSortActive()) {
+            return false;
+        }
+
+        auto keyString = _keyStringEncoder->encode(sortKey);
+        if (!keyString) {
+            switchToSorter();
+            return false;
+        }
+
+        const uint64_t order = _numKeyStringEntriesAdded++;
+        if (_keyStringSort == KeyStringSort::kTopK && _keyStringEntries.size() == _stats.limit) {
+            // The front of the heap is the worst of the documents kept so far. A document whose
+            // key ties with it arrived later, and so loses the tie.
+            auto& worst = _keyStringEntries.front();
+            if (keyString->compare(worst.keyString) >= 0) {
+                return true;
+            }
+
+            _keyStringMemUsed -= worst.memUsage();
+            std::pop_heap(_keyStringEntries.begin(), _keyStringEntries.end());
+            _keyStringEntries.pop_back();
+        }
+
+        _keyStringEntries.push_back(
+            {keyString->toString(), order, sortKey.getOwned(), data.getOwned()});
+        _keyStringMemUsed += _keyStringEntries.back().memUsage();
+        if (_keyStringSort == KeyStringSort::kTopK) {
+            std::push_heap(_keyStringEntries.begin(), _keyStringEntries.end());
+        }
+
+        if (_keyStringMemUsed > _stats.maxMemoryUsageBytes) {
+            switchToSorter();
+        }
+        return true;
+    }
+
+    /**
+     * Abandons the KeyString sort, handing every buffered document to a new '_sorter'.
+     */
+    void switchToSorter() {
+        auto entries = std::move(_keyStringEntries);
+        _keyStringEntries.clear();
+        _keyStringMemUsed = 0;
+        _keyStringEncoder.reset();
+
+        // Add the documents in their original order, so that the Sorter breaks ties as it would
+        // have if it had seen every document.
+        if (_keyStringSort == KeyStringSort::kTopK) {
+            std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.order < rhs.order;
+            });
+        }
+        _keyStringSort = KeyStringSort::kNone;
+
+        _sorter.reset(DocumentSorter::make(makeSortOptions(), Comparator(_sortPattern)));
+        for (auto&& entry : entries) {
+            _sorter->add(entry.sortKey, entry.data);
+        }
+    }
+
+    void keyStringSortLoadingDone() {
+        std::vector<size_t> sortedOrder;
+        const auto radixSortMinDocuments = internalQuerySortRadixSortMinDocuments.load();
+        if (_keyStringSort == KeyStringSort::kFullSort && radixSortMinDocuments > 0 &&
+            _keyStringEntries.size() >= static_cast<size_t>(radixSortMinDocuments)) {
+            std::vector<StringData> keys;
+            keys.reserve(_keyStringEntries.size());
+            for (auto&& entry : _keyStringEntries) {
+                keys.emplace_back(entry.keyString);
+            }
+            sortedOrder = radixSortKeyStrings(keys);
+        } else {
+            sortedOrder.resize(_keyStringEntries.size());
+            std::iota(sortedOrder.begin(), sortedOrder.end(), 0);
+            std::sort(sortedOrder.begin(), sortedOrder.end(), [&](size_t lhs, size_t rhs) {
+                return _keyStringEntries[lhs] < _keyStringEntries[rhs];
+            });
+        }
+
+        _keyStringOutput.reserve(sortedOrder.size());
+        for (auto index : sortedOrder) {
+            auto& entry = _keyStringEntries[index];
+            _keyStringOutput.emplace_back(std::move(entry.sortKey), std::move(entry.data));
+        }
+
+        _keyStringEntries = {};
+        _keyStringMemUsed = 0;
+        _keyStringEncoder.reset();
+    }
+
     SortOptions makeSortOptions() const {
         SortOptions opts;
         if (_stats.limit) {
@@ -194,6 +366,16 @@ private:
     std::unique_ptr<DocumentSorter> _sorter;
     std::unique_ptr<typename DocumentSorter::Iterator> _output;
 
+    // State for sorting by KeyString-encoded sort keys. Whether to do so is decided when the first
+    // document is added, by which time the limit is known.
+    KeyStringSort _keyStringSort = KeyStringSort::kUndecided;
+    boost::optional<SortKeyStringEncoder> _keyStringEncoder;
+    std::vector<KeyStringEntry> _keyStringEntries;
+    uint64_t _numKeyStringEntriesAdded = 0;
+    uint64_t _keyStringMemUsed = 0;
+    std::vector<std::pair<Value, T>> _keyStringOutput;
+    size_t _keyStringOutputPos = 0;
+
     SortStats _stats;
 
     bool _isEOF = false;
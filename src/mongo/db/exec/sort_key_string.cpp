@@ -0,0 +1,211 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/sort_key_string.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "mongo/bson/bsonobjbuilder.h"
+
+namespace mongo {
+namespace {
+
+// The number of leading bytes of each key ordered by the radix passes.
+constexpr size_t kRadixSortPrefixBytes = sizeof(uint64_t);
+
+Ordering makeOrdering(const SortPattern& sortPattern) {
+    BSONObjBuilder orderingBuilder;
+    for (auto&& part : sortPattern) {
+        orderingBuilder.append("", part.isAscending ? 1 : -1);
+    }
+    return Ordering::make(orderingBuilder.obj());
+}
+
+/**
+ * Returns the first kRadixSortPrefixBytes of 'key' as a big-endian integer, padding short keys
+ * with zero bytes.
+ */
+uint64_t loadPrefix(StringData key) {
+    unsigned char bytes[kRadixSortPrefixBytes] = {};
+    std::memcpy(bytes, key.rawData(), std::min(key.size(), kRadixSortPrefixBytes));
+
+    uint64_t prefix = 0;
+    for (auto byte : bytes) {
+        prefix = (prefix << 8) | byte;
+    }
+    return prefix;
+}
+
+}  // namespace
+
+bool SortKeyStringEncoder::canEncode(const SortPattern& sortPattern) {
+    return !sortPattern.empty() && sortPattern.size() < Ordering::kMaxCompoundIndexKeys;
+}
+
+SortKeyStringEncoder::SortKeyStringEncoder(const SortPattern& sortPattern)
+    : _numComponents(sortPattern.size()),
+      _ordering(makeOrdering(sortPattern)),
+      _builder(KeyString::Version::kLatestVersion, _ordering) {}
+
+boost::optional<StringData> SortKeyStringEncoder::encode(const Value& sortKey) {
+    _builder.resetToEmpty(_ordering);
+
+    // As in SortKeyComparator, a compound sort key is an array holding one value per component.
+    if (_numComponents == 1) {
+        if (sortKey.missing()) {
+            return boost::none;
+        }
+        appendComponent(sortKey);
+    } else {
+        if (sortKey.getType() != BSONType::Array || sortKey.getArrayLength() != _numComponents) {
+            return boost::none;
+        }
+        for (auto&& component : sortKey.getArray()) {
+            if (component.missing()) {
+                return boost::none;
+            }
+            appendComponent(component);
+        }
+    }
+
+    _builder.appendDiscriminator(KeyString::Discriminator::kInclusive);
+    return StringData(_builder.getBuffer(), _builder.getSize());
+}
+
+void SortKeyStringEncoder::appendComponent(const Value& component) {
+    // Append the common scalar types directly. Every numeric type is encoded by value, so numbers
+    // which compare equal encode identically regardless of their type.
+    switch (component.getType()) {
+        case BSONType::NumberDouble:
+            _builder.appendNumberDouble(component.getDouble());
+            return;
+        case BSONType::NumberInt:
+            _builder.appendNumberLong(component.getInt());
+            return;
+        case BSONType::NumberLong:
+            _builder.appendNumberLong(component.getLong());
+            return;
+        case BSONType::String:
+            _builder.appendString(component.getStringData());
+            return;
+        case BSONType::Date:
+            _builder.appendDate(component.getDate());
+            return;
+        case BSONType::bsonTimestamp:
+            _builder.appendTimestamp(component.getTimestamp());
+            return;
+        case BSONType::jstOID:
+            _builder.appendOID(component.getOid());
+            return;
+        case BSONType::Bool:
+            _builder.appendBool(component.getBool());
+            return;
+        case BSONType::jstNULL:
+            _builder.appendNull();
+            return;
+        case BSONType::Undefined:
+            _builder.appendUndefined();
+            return;
+        default: {
+            BSONObjBuilder bob;
+            component.addToBsonObj(&bob, ""_sd);
+            _builder.appendBSONElement(bob.done().firstElement());
+            return;
+        }
+    }
+}
+
+std::vector<size_t> radixSortKeyStrings(const std::vector<StringData>& keys) {
+    struct Entry {
+        uint64_t prefix;
+        size_t index;
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        entries.push_back({loadPrefix(keys[i]), i});
+    }
+
+    // Each pass is a stable counting sort on one byte of the prefix, starting from the least
+    // significant byte.
+    std::vector<Entry> scratch(entries.size());
+    for (size_t pass = 0; pass < kRadixSortPrefixBytes && !entries.empty(); ++pass) {
+        const auto shift = pass * 8;
+        std::array<size_t, 256> offsets{};
+        for (auto&& entry : entries) {
+            ++offsets[(entry.prefix >> shift) & 0xff];
+        }
+
+        // Skip the pass if every key has the same byte here, as is common for the type byte and
+        // the high-order bytes of numbers and dates.
+        if (offsets[(entries.front().prefix >> shift) & 0xff] == entries.size()) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto&& count : offsets) {
+            const auto bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (auto&& entry : entries) {
+            scratch[offsets[(entry.prefix >> shift) & 0xff]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+
+    // Order each run of keys which share a prefix by the remainder of the keys. The radix passes
+    // left every run in input order, so a stable sort keeps equal keys in input order.
+    for (auto runBegin = entries.begin(); runBegin != entries.end();) {
+        auto runEnd = std::find_if(runBegin, entries.end(), [&](const Entry& entry) {
+            return entry.prefix != runBegin->prefix;
+        });
+        if (std::distance(runBegin, runEnd) > 1) {
+            std::stable_sort(runBegin, runEnd, [&](const Entry& lhs, const Entry& rhs) {
+                return keys[lhs.index].compare(keys[rhs.index]) < 0;
+            });
+        }
+        runBegin = runEnd;
+    }
+
+    std::vector<size_t> order;
+    order.reserve(entries.size());
+    for (auto&& entry : entries) {
+        order.push_back(entry.index);
+    }
+    return order;
+}
+
+}  // namespace mongo
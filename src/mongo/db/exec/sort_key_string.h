@@ -0,0 +1,86 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/ordering.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/query/sort_pattern.h"
+#include "mongo/db/storage/key_string.h"
+
+namespace mongo {
+
+/**
+ * Encodes the sort keys produced for a SortPattern as KeyStrings. The binary order of the encoded
+ * keys is the order which SortKeyComparator imposes on the sort keys, so that sorts can compare
+ * keys with memcmp. Keys which compare equal under SortKeyComparator encode to identical bytes.
+ *
+ * Only the KeyString itself is produced; the TypeBits needed to decode it are not, since the
+ * caller retains the original sort key.
+ */
+class SortKeyStringEncoder {
+public:
+    /**
+     * Returns true if the sort keys for 'sortPattern' can be encoded.
+     */
+    static bool canEncode(const SortPattern& sortPattern);
+
+    explicit SortKeyStringEncoder(const SortPattern& sortPattern);
+
+    /**
+     * Encodes 'sortKey', returning a view of the encoded bytes which remains valid until the next
+     * call to encode(). Returns boost::none if a component of the key is missing, since KeyString
+     * has no representation for a missing value.
+     */
+    boost::optional<StringData> encode(const Value& sortKey);
+
+private:
+    void appendComponent(const Value& component);
+
+    const size_t _numComponents;
+    const Ordering _ordering;
+    KeyString::HeapBuilder _builder;
+};
+
+/**
+ * Returns the permutation of indexes into 'keys' which orders the keys by their bytes, keeping
+ * equal keys in their original relative order.
+ *
+ * This is an LSD radix sort over a fixed-width prefix of each key, followed by a comparison sort
+ * of each run of keys sharing a prefix. Sort keys usually differ within the first few bytes, so
+ * those runs are short.
+ */
+std::vector<size_t> radixSortKeyStrings(const std::vector<StringData>& keys);
+
+}  // namespace mongo
@@ -39,11 +39,13 @@
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/collation/collator_factory_mock.h"
 #include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/scopeguard.h"
 
 using namespace mongo;
 
@@ -304,4 +306,69 @@ TEST_F(SortStageDefaultTest, SortDescendingWithCollation) {
              "{input: [{a: 'ba'}, {a: 'aa'}, {a: 'ab'}]}",
              "{output: [{a: 'ab'}, {a: 'ba'}, {a: 'aa'}]}");
 }
+
+//
+// Sorting by KeyString-encoded sort keys
+// Results should match those of the comparator-based Sorter, with ties kept in input order.
+//
+
+TEST_F(SortStageDefaultTest, SortCompoundWithLimitUsingTopKHeap) {
+    const auto oldMaxLimit = internalQuerySortTopKHeapMaxLimit.load();
+    internalQuerySortTopKHeapMaxLimit.store(10);
+    ON_BLOCK_EXIT([&] { internalQuerySortTopKHeapMaxLimit.store(oldMaxLimit); });
+
+    testWork("{a: 1, b: -1}",
+             nullptr,
+             3,
+             "{input: [{a: 1, b: 1}, {a: 2, b: 5}, {a: 1, b: 3}, {a: 0, b: 0}, {a: 1, b: 2}]}",
+             "{output: [{a: 0, b: 0}, {a: 1, b: 3}, {a: 1, b: 2}]}");
+    testWork("{a: 1}",
+             nullptr,
+             2,
+             "{input: [{a: 2, b: 1}, {a: 1, b: 2}, {a: 2, b: 3}, {a: 1, b: 4}]}",
+             "{output: [{a: 1, b: 2}, {a: 1, b: 4}]}");
+}
+
+TEST_F(SortStageDefaultTest, SortMixedTypesUsingRadixSort) {
+    const auto oldMinDocuments = internalQuerySortRadixSortMinDocuments.load();
+    internalQuerySortRadixSortMinDocuments.store(1);
+    ON_BLOCK_EXIT([&] { internalQuerySortRadixSortMinDocuments.store(oldMinDocuments); });
+
+    testWork("{a: 1}",
+             nullptr,
+             0,
+             "{input: [{a: 'x'}, {a: 2.5}, {a: null}, {a: 2}, {a: NumberLong(1)}, {b: 1}, "
+             "{a: {c: 1}}, {a: true}]}",
+             "{output: [{a: null}, {b: 1}, {a: NumberLong(1)}, {a: 2}, {a: 2.5}, {a: 'x'}, "
+             "{a: {c: 1}}, {a: true}]}");
+    testWork("{a: -1, b: 1}",
+             nullptr,
+             0,
+             "{input: [{a: 'abcdefghij0', b: 2}, {a: 'abcdefghij1', b: 1}, "
+             "{a: 'abcdefghij0', b: 1}, {a: 'abc', b: 1}]}",
+             "{output: [{a: 'abcdefghij1', b: 1}, {a: 'abcdefghij0', b: 1}, "
+             "{a: 'abcdefghij0', b: 2}, {a: 'abc', b: 1}]}");
+}
+
+TEST_F(SortStageDefaultTest, SortWithoutKeyStringSorting) {
+    const auto oldMaxLimit = internalQuerySortTopKHeapMaxLimit.load();
+    const auto oldMinDocuments = internalQuerySortRadixSortMinDocuments.load();
+    internalQuerySortTopKHeapMaxLimit.store(0);
+    internalQuerySortRadixSortMinDocuments.store(0);
+    ON_BLOCK_EXIT([&] {
+        internalQuerySortTopKHeapMaxLimit.store(oldMaxLimit);
+        internalQuerySortRadixSortMinDocuments.store(oldMinDocuments);
+    });
+
+    testWork("{a: 1, b: -1}",
+             nullptr,
+             3,
+             "{input: [{a: 1, b: 1}, {a: 2, b: 5}, {a: 1, b: 3}, {a: 0, b: 0}, {a: 1, b: 2}]}",
+             "{output: [{a: 0, b: 0}, {a: 1, b: 3}, {a: 1, b: 2}]}");
+    testWork("{a: -1}",
+             nullptr,
+             0,
+             "{input: [{a: 2}, {a: 1}, {a: 3}]}",
+             "{output: [{a: 3}, {a: 2}, {a: 1}]}");
+}
 }  // namespace
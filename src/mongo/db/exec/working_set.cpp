@@ -39,7 +39,8 @@ using std::string;
 
 namespace dps = ::mongo::dotted_path_support;
 
-WorkingSet::WorkingSet() : _freeList(INVALID_ID) {}
+WorkingSet::WorkingSet(OperationArena* arena)
+    : _data(OperationArenaAllocator<MemberHolder>(arena)), _freeList(INVALID_ID) {}
 
 WorkingSetID WorkingSet::allocate() {
     if (_freeList == INVALID_ID) {
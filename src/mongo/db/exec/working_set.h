@@ -35,6 +35,7 @@
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/document_metadata_fields.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/snapshot.h"
 #include "mongo/stdx/unordered_set.h"
@@ -306,7 +307,11 @@ class WorkingSet {
 public:
     static const WorkingSetID INVALID_ID = WorkingSetID(-1);
 
-    WorkingSet();
+    /**
+     * If 'arena' is given, the members are stored in it, so the working set must not outlive the
+     * arena's current Scope.
+     */
+    explicit WorkingSet(OperationArena* arena = nullptr);
 
     ~WorkingSet() = default;
 
@@ -399,7 +404,7 @@ private:
 
     // All WorkingSetIDs are indexes into this, except for INVALID_ID.
     // Elements are added to _freeList rather than removed when freed.
-    std::vector<MemberHolder> _data;
+    std::vector<MemberHolder, OperationArenaAllocator<MemberHolder>> _data;
 
     // Index into _data, forming a linked-list using MemberHolder::nextFreeOrSelf as the next
     // link. INVALID_ID is the list terminator since 0 is a valid index.
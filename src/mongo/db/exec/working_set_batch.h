@@ -0,0 +1,181 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A block of WorkingSetMembers passed between stages by PlanStage::workBatch().
+ *
+ * Members are appended in the order in which a stage produces them. Alongside the ids, the batch
+ * keeps a selection vector of positions which are still live. A stage which consumes a batch from
+ * its child can drop members (for instance because they fail a filter) by deselecting them,
+ * without having to compact the block.
+ *
+ * All members of a batch must own their BSON, since the batch as a whole outlives the storage
+ * cursor position from which each member was read.
+ */
+class WorkingSetBatch {
+public:
+    WorkingSetBatch(WorkingSet* ws, size_t capacity) : _ws(ws), _capacity(capacity) {
+        invariant(_capacity > 0);
+        _ids.reserve(_capacity);
+        _selection.reserve(_capacity);
+    }
+
+    WorkingSet* workingSet() const {
+        return _ws;
+    }
+
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    bool full() const {
+        return _ids.size() >= _capacity;
+    }
+
+    /**
+     * Returns the number of selected members which have not yet been consumed with next().
+     */
+    size_t size() const {
+        return _selection.size() - _readPos;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Adds 'id' to the block and marks it selected. The batch must not be full.
+     */
+    void append(WorkingSetID id) {
+        invariant(!full());
+        _selection.push_back(_ids.size());
+        _ids.push_back(id);
+    }
+
+    /**
+     * Returns the 'i'th selected member which has not yet been consumed.
+     */
+    WorkingSetID get(size_t i) const {
+        dassert(i < size());
+        return _ids[_selection[_readPos + i]];
+    }
+
+    /**
+     * Removes and returns the first selected member. Ownership of the member passes to the caller,
+     * which is responsible for freeing it from the WorkingSet.
+     */
+    WorkingSetID next() {
+        invariant(!empty());
+        return _ids[_selection[_readPos++]];
+    }
+
+    /**
+     * Narrows the selection vector to the members from the 'first'th selected member which has not
+     * yet been consumed onward, for which 'pred(id)' returns true. Members which are deselected are
+     * freed from the WorkingSet. 'pred' is called on the members in order. Deselecting does not
+     * move the ids of the remaining members.
+     */
+    template <typename Predicate>
+    void select(size_t first, Predicate&& pred) {
+        size_t out = _readPos + first;
+        for (size_t i = out; i < _selection.size(); ++i) {
+            const auto id = _ids[_selection[i]];
+            if (pred(id)) {
+                _selection[out++] = _selection[i];
+            } else {
+                _ws->free(id);
+            }
+        }
+        _selection.resize(out);
+    }
+
+    /**
+     * Removes the selected members from the 'first'th one which has not yet been consumed onward,
+     * and appends their ids to 'out' in order. Ownership of those members passes to the caller.
+     */
+    void removeFrom(size_t first, std::vector<WorkingSetID>* out) {
+        const size_t begin = _readPos + first;
+        if (begin >= _selection.size()) {
+            return;
+        }
+        for (size_t i = begin; i < _selection.size(); ++i) {
+            out->push_back(_ids[_selection[i]]);
+        }
+        // Deselected members past the first removed one have already been freed.
+        _ids.resize(_selection[begin]);
+        _selection.resize(begin);
+    }
+
+    /**
+     * Frees every member which has not been consumed and resets the batch so it can be refilled.
+     */
+    void release() {
+        while (!empty()) {
+            _ws->free(next());
+        }
+        clear();
+    }
+
+    /**
+     * Resets the batch so that it can be refilled. Members which have not been consumed are not
+     * freed; use release() for that.
+     */
+    void clear() {
+        _ids.clear();
+        _selection.clear();
+        _readPos = 0;
+    }
+
+private:
+    // Not owned. All members of the batch are allocated from this WorkingSet.
+    WorkingSet* const _ws;
+
+    const size_t _capacity;
+
+    // The ids of all members in the block, in the order they were produced.
+    std::vector<WorkingSetID> _ids;
+
+    // Positions in '_ids' of the members which are still selected.
+    std::vector<size_t> _selection;
+
+    // Position in '_selection' of the next member to be returned by next().
+    size_t _readPos = 0;
+};
+
+}  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/json.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/storage/snapshot.h"
 #include "mongo/unittest/bson_test_util.h"
 #include "mongo/unittest/unittest.h"
@@ -313,4 +314,17 @@ TEST_F(WorkingSetFixture, WsmCanBeExtractedAndReinserted) {
     ASSERT_FALSE(emplacedWsm->metadata());
 }
 
+TEST(WorkingSetTest, MembersComeFromTheArenaWhenGivenOne) {
+    OperationArena arena;
+    {
+        OperationArena::Scope scope(&arena);
+        WorkingSet ws(&arena);
+        WorkingSetID id = ws.allocate();
+        ws.get(id)->recordId = RecordId{1};
+        ws.transitionToRecordIdAndIdx(id);
+        ASSERT_GT(arena.bytesAllocated(), 0u);
+    }
+    ASSERT_EQ(arena.bytesAllocated(), 0u);
+}
+
 }  // namespace mongo
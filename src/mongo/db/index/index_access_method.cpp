@@ -33,9 +33,11 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
+#include "mongo/base/checked_cast.h"
 #include "mongo/base/error_codes.h"
 #include "mongo/base/status.h"
 #include "mongo/db/catalog/index_catalog.h"
@@ -160,27 +162,85 @@ Status AbstractIndexAccessMethod::insertKeys(OperationContext* opCtx,
                                              const RecordId& loc,
                                              const InsertDeleteOptions& options,
                                              InsertResult* result) {
+    Status status = _insertKeysWithoutMultikey(opCtx, keys, multikeyMetadataKeys, options, result);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    if (shouldMarkIndexAsMultikey(keys.size(), multikeyMetadataKeys, multikeyPaths)) {
+        _indexCatalogEntry->setMultikey(opCtx, multikeyPaths);
+    }
+    return Status::OK();
+}
+
+Status AbstractIndexAccessMethod::insertKeysForBatch(
+    OperationContext* opCtx,
+    const vector<KeyString::Value>& keys,
+    const vector<Timestamp>& keyTimestamps,
+    const vector<KeyString::Value>& multikeyMetadataKeys,
+    const boost::optional<MultikeyPaths>& multikeyPaths,
+    const InsertDeleteOptions& options,
+    InsertResult* result) {
+    if (keyTimestamps.empty()) {
+        Status status =
+            _insertKeysWithoutMultikey(opCtx, keys, multikeyMetadataKeys, options, result);
+        if (!status.isOK()) {
+            return status;
+        }
+
+        if (multikeyPaths) {
+            _indexCatalogEntry->setMultikey(opCtx, *multikeyPaths);
+        }
+        return Status::OK();
+    }
+
+    invariant(keyTimestamps.size() == keys.size());
+
+    // The index must be multikey as of the earliest document which makes it so, so the multikey
+    // state is written first, at the timestamp set by the caller.
+    Status status = _insertKeysWithoutMultikey(opCtx, {}, multikeyMetadataKeys, options, result);
+    if (!status.isOK()) {
+        return status;
+    }
+    if (multikeyPaths) {
+        _indexCatalogEntry->setMultikey(opCtx, *multikeyPaths);
+    }
+
+    // Keys in sorted order mostly belong to different documents, but the timestamp only needs to
+    // be set again when it changes from one key to the next.
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (i == 0 || keyTimestamps[i] != keyTimestamps[i - 1]) {
+            status = opCtx->recoveryUnit()->setTimestamp(keyTimestamps[i]);
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+
+        status = _insertKey(opCtx, keys[i], options, result);
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    if (result) {
+        result->numInserted += keys.size();
+    }
+    return Status::OK();
+}
+
+Status AbstractIndexAccessMethod::_insertKeysWithoutMultikey(
+    OperationContext* opCtx,
+    const vector<KeyString::Value>& keys,
+    const vector<KeyString::Value>& multikeyMetadataKeys,
+    const InsertDeleteOptions& options,
+    InsertResult* result) {
     // Add all new data keys, and all new multikey metadata keys, into the index. When iterating
     // over the data keys, each of them should point to the doc's RecordId. When iterating over
     // the multikey metadata keys, they should point to the reserved 'kMultikeyMetadataKeyId'.
     for (const auto keyVec : {&keys, &multikeyMetadataKeys}) {
         for (const auto& keyString : *keyVec) {
-            bool unique = _descriptor->unique();
-            Status status = _newInterface->insert(opCtx, keyString, !unique /* dupsAllowed */);
-
-            // When duplicates are encountered and allowed, retry with dupsAllowed. Add the
-            // key to the output vector so callers know which duplicate keys were inserted.
-            if (ErrorCodes::DuplicateKey == status.code() && options.dupsAllowed) {
-                invariant(unique);
-                status = _newInterface->insert(opCtx, keyString, true /* dupsAllowed */);
-
-                if (status.isOK() && result) {
-                    auto key =
-                        KeyString::toBson(keyString, getSortedDataInterface()->getOrdering());
-                    result->dupsInserted.push_back(key);
-                }
-            }
-            if (isFatalError(opCtx, status, keyString)) {
+            Status status = _insertKey(opCtx, keyString, options, result);
+            if (!status.isOK()) {
                 return status;
             }
         }
@@ -189,9 +249,29 @@ Status AbstractIndexAccessMethod::insertKeys(OperationContext* opCtx,
     if (result) {
         result->numInserted += keys.size() + multikeyMetadataKeys.size();
     }
+    return Status::OK();
+}
 
-    if (shouldMarkIndexAsMultikey(keys.size(), multikeyMetadataKeys, multikeyPaths)) {
-        _indexCatalogEntry->setMultikey(opCtx, multikeyPaths);
+Status AbstractIndexAccessMethod::_insertKey(OperationContext* opCtx,
+                                             const KeyString::Value& keyString,
+                                             const InsertDeleteOptions& options,
+                                             InsertResult* result) {
+    bool unique = _descriptor->unique();
+    Status status = _newInterface->insert(opCtx, keyString, !unique /* dupsAllowed */);
+
+    // When duplicates are encountered and allowed, retry with dupsAllowed. Add the key to the
+    // output vector so callers know which duplicate keys were inserted.
+    if (ErrorCodes::DuplicateKey == status.code() && options.dupsAllowed) {
+        invariant(unique);
+        status = _newInterface->insert(opCtx, keyString, true /* dupsAllowed */);
+
+        if (status.isOK() && result) {
+            auto key = KeyString::toBson(keyString, getSortedDataInterface()->getOrdering());
+            result->dupsInserted.push_back(key);
+        }
+    }
+    if (isFatalError(opCtx, status, keyString)) {
+        return status;
     }
     return Status::OK();
 }
@@ -463,6 +543,11 @@ public:
                   const RecordId& loc,
                   const InsertDeleteOptions& options) final;
 
+    Status insert(const BSONObj& obj,
+                  const RecordId& loc,
+                  const InsertDeleteOptions& options,
+                  std::vector<RecordId>* skippedRecords) final;
+
     const MultikeyPaths& getMultikeyPaths() const final;
 
     bool isMultikey() const final;
@@ -475,7 +560,18 @@ public:
 
     int64_t getKeysInserted() const final;
 
+    /**
+     * Moves the multikey metadata keys cached by this builder into 'other', so that keys generated
+     * by several builders for the same index are only added to a single sorter.
+     */
+    void transferMultikeyMetadataKeysTo(BulkBuilderImpl* other);
+
 private:
+    Status _insert(const BSONObj& obj,
+                   const RecordId& loc,
+                   const InsertDeleteOptions& options,
+                   OnSuppressedErrorFn onSuppressedError);
+
     std::unique_ptr<Sorter> _sorter;
     IndexCatalogEntry* _indexCatalogEntry;
     int64_t _keysInserted = 0;
@@ -516,33 +612,62 @@ Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(OperationContext* opCt
                                                           const BSONObj& obj,
                                                           const RecordId& loc,
                                                           const InsertDeleteOptions& options) {
+    return _insert(
+        obj, loc, options, [&](Status status, const BSONObj&, boost::optional<RecordId>) {
+            // If a key generation error was suppressed, record the document as "skipped" so the
+            // index builder can retry at a point when data is consistent.
+            auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+            if (interceptor && interceptor->getSkippedRecordTracker()) {
+                LOGV2_DEBUG(20684,
+                            1,
+                            "Recording suppressed key generation error to retry later: "
+                            "{status} on {loc}: {obj}",
+                            "status"_attr = status,
+                            "loc"_attr = loc,
+                            "obj"_attr = redact(obj));
+                interceptor->getSkippedRecordTracker()->record(opCtx, loc);
+            }
+        });
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(const BSONObj& obj,
+                                                          const RecordId& loc,
+                                                          const InsertDeleteOptions& options,
+                                                          std::vector<RecordId>* skippedRecords) {
+    return _insert(
+        obj, loc, options, [&](Status status, const BSONObj&, boost::optional<RecordId>) {
+            // The skipped record tracker needs an OperationContext to write to its temporary
+            // table, so hand the document back to the caller to record instead.
+            auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+            if (interceptor && interceptor->getSkippedRecordTracker()) {
+                LOGV2_DEBUG(51809,
+                            1,
+                            "Deferring suppressed key generation error to retry later: "
+                            "{status} on {loc}: {obj}",
+                            "status"_attr = status,
+                            "loc"_attr = loc,
+                            "obj"_attr = redact(obj));
+                skippedRecords->push_back(loc);
+            }
+        });
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::_insert(const BSONObj& obj,
+                                                           const RecordId& loc,
+                                                           const InsertDeleteOptions& options,
+                                                           OnSuppressedErrorFn onSuppressedError) {
     KeyStringSet keys;
     MultikeyPaths multikeyPaths;
 
     try {
-        _indexCatalogEntry->accessMethod()->getKeys(
-            obj,
-            options.getKeysMode,
-            GetKeysContext::kReadOrAddKeys,
-            &keys,
-            &_multikeyMetadataKeys,
-            &multikeyPaths,
-            loc,
-            [&](Status status, const BSONObj&, boost::optional<RecordId>) {
-                // If a key generation error was suppressed, record the document as "skipped" so the
-                // index builder can retry at a point when data is consistent.
-                auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
-                if (interceptor && interceptor->getSkippedRecordTracker()) {
-                    LOGV2_DEBUG(20684,
-                                1,
-                                "Recording suppressed key generation error to retry later: "
-                                "{status} on {loc}: {obj}",
-                                "status"_attr = status,
-                                "loc"_attr = loc,
-                                "obj"_attr = redact(obj));
-                    interceptor->getSkippedRecordTracker()->record(opCtx, loc);
-                }
-            });
+        _indexCatalogEntry->accessMethod()->getKeys(obj,
+                                                    options.getKeysMode,
+                                                    GetKeysContext::kReadOrAddKeys,
+                                                    &keys,
+                                                    &_multikeyMetadataKeys,
+                                                    &multikeyPaths,
+                                                    loc,
+                                                    std::move(onSuppressedError));
     } catch (...) {
         return exceptionToStatus();
     }
@@ -593,6 +718,112 @@ int64_t AbstractIndexAccessMethod::BulkBuilderImpl::getKeysInserted() const {
     return _keysInserted;
 }
 
+void AbstractIndexAccessMethod::BulkBuilderImpl::transferMultikeyMetadataKeysTo(
+    BulkBuilderImpl* other) {
+    other->_multikeyMetadataKeys.insert(_multikeyMetadataKeys.begin(),
+                                        _multikeyMetadataKeys.end());
+    _multikeyMetadataKeys.clear();
+}
+
+/**
+ * Presents several BulkBuilderImpls for the same index, each holding the keys of a disjoint set of
+ * documents, as a single BulkBuilder whose output is the merge of their sorted runs.
+ */
+class AbstractIndexAccessMethod::MergedBulkBuilderImpl : public IndexAccessMethod::BulkBuilder {
+public:
+    explicit MergedBulkBuilderImpl(std::vector<std::unique_ptr<BulkBuilderImpl>> bulks)
+        : _bulks(std::move(bulks)) {
+        invariant(!_bulks.empty());
+    }
+
+    Status insert(OperationContext* opCtx,
+                  const BSONObj& obj,
+                  const RecordId& loc,
+                  const InsertDeleteOptions& options) final {
+        return _bulks.front()->insert(opCtx, obj, loc, options);
+    }
+
+    Status insert(const BSONObj& obj,
+                  const RecordId& loc,
+                  const InsertDeleteOptions& options,
+                  std::vector<RecordId>* skippedRecords) final {
+        return _bulks.front()->insert(obj, loc, options, skippedRecords);
+    }
+
+    const MultikeyPaths& getMultikeyPaths() const final {
+        _multikeyPaths.clear();
+        for (const auto& bulk : _bulks) {
+            const auto& paths = bulk->getMultikeyPaths();
+            if (paths.empty()) {
+                continue;
+            }
+            if (_multikeyPaths.empty()) {
+                _multikeyPaths = paths;
+                continue;
+            }
+            invariant(_multikeyPaths.size() == paths.size());
+            for (size_t i = 0; i < paths.size(); ++i) {
+                _multikeyPaths[i].insert(paths[i].begin(), paths[i].end());
+            }
+        }
+        return _multikeyPaths;
+    }
+
+    bool isMultikey() const final {
+        return std::any_of(_bulks.begin(), _bulks.end(), [](const auto& bulk) {
+            return bulk->isMultikey();
+        });
+    }
+
+    /**
+     * Funnels the multikey metadata keys of every builder through the first one, so that a key
+     * generated from documents handled by different builders is only emitted once, then merges
+     * the finalized sorters.
+     */
+    Sorter::Iterator* done() final {
+        for (size_t i = 1; i < _bulks.size(); ++i) {
+            _bulks[i]->transferMultikeyMetadataKeysTo(_bulks.front().get());
+        }
+
+        std::vector<std::shared_ptr<Sorter::Iterator>> iters;
+        iters.reserve(_bulks.size());
+        for (const auto& bulk : _bulks) {
+            iters.emplace_back(bulk->done());
+        }
+        return Sorter::Iterator::merge(iters, "", SortOptions(), BtreeExternalSortComparison());
+    }
+
+    int64_t getKeysInserted() const final {
+        int64_t keysInserted = 0;
+        for (const auto& bulk : _bulks) {
+            keysInserted += bulk->getKeysInserted();
+        }
+        return keysInserted;
+    }
+
+private:
+    std::vector<std::unique_ptr<BulkBuilderImpl>> _bulks;
+
+    // Union of the multikey paths of every builder, recomputed by getMultikeyPaths().
+    mutable MultikeyPaths _multikeyPaths;
+};
+
+std::unique_ptr<IndexAccessMethod::BulkBuilder> AbstractIndexAccessMethod::mergeBulk(
+    std::vector<std::unique_ptr<BulkBuilder>> bulks) {
+    invariant(!bulks.empty());
+    if (bulks.size() == 1) {
+        return std::move(bulks.front());
+    }
+
+    std::vector<std::unique_ptr<BulkBuilderImpl>> impls;
+    impls.reserve(bulks.size());
+    for (auto& bulk : bulks) {
+        invariant(bulk);
+        impls.emplace_back(checked_cast<BulkBuilderImpl*>(bulk.release()));
+    }
+    return std::make_unique<MergedBulkBuilderImpl>(std::move(impls));
+}
+
 Status AbstractIndexAccessMethod::commitBulk(OperationContext* opCtx,
                                              BulkBuilder* bulk,
                                              bool dupsAllowed,
@@ -32,6 +32,7 @@
 #include <atomic>
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/field_ref.h"
@@ -98,6 +99,30 @@ public:
                               const InsertDeleteOptions& options,
                               InsertResult* result) = 0;
 
+    /**
+     * Inserts the keys generated for a batch of documents. Each key must already end with the
+     * RecordId of the document it was generated for, and 'keys' should be sorted so that
+     * consecutive inserts land on the same or neighbouring index pages.
+     *
+     * If the documents are written at different timestamps, 'keyTimestamps' holds the timestamp of
+     * the document of each key, and each key is written at that timestamp. Otherwise it is empty,
+     * and all keys are written at the timestamp the recovery unit was given by the caller. The
+     * multikey metadata keys and the multikey flag are always written at the latter, which must
+     * then be no later than the timestamp of any document in the batch.
+     *
+     * Unlike insertKeys(), this does not infer multikeyness from the number of keys, since a batch
+     * has many keys even for a non-multikey index. 'multikeyPaths' must instead be the union of
+     * the multikey paths of every document that makes the index multikey, or boost::none if there
+     * is no such document.
+     */
+    virtual Status insertKeysForBatch(OperationContext* opCtx,
+                                      const std::vector<KeyString::Value>& keys,
+                                      const std::vector<Timestamp>& keyTimestamps,
+                                      const std::vector<KeyString::Value>& multikeyMetadataKeys,
+                                      const boost::optional<MultikeyPaths>& multikeyPaths,
+                                      const InsertDeleteOptions& options,
+                                      InsertResult* result) = 0;
+
     /**
      * Analogous to insertKeys above, but remove the keys instead of inserting them.
      * 'numDeleted' will be set to the number of keys removed from the index for the provided keys.
@@ -210,6 +235,17 @@ public:
                               const RecordId& loc,
                               const InsertDeleteOptions& options) = 0;
 
+        /**
+         * Same as above, but may be called without an OperationContext, e.g. from a key generation
+         * worker thread. Instead of being recorded in the index build's skipped record tracker,
+         * the RecordIds of documents whose key generation errors were suppressed are appended to
+         * 'skippedRecords' so that the caller can record them on the thread owning the build.
+         */
+        virtual Status insert(const BSONObj& obj,
+                              const RecordId& loc,
+                              const InsertDeleteOptions& options,
+                              std::vector<RecordId>* skippedRecords) = 0;
+
         virtual const MultikeyPaths& getMultikeyPaths() const = 0;
 
         virtual bool isMultikey() const = 0;
@@ -238,6 +274,15 @@ public:
      */
     virtual std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes) = 0;
 
+    /**
+     * Combines BulkBuilders that were each created by initiateBulk() on this index and filled from
+     * disjoint sets of documents into a single BulkBuilder. The returned builder's done() performs
+     * a k-way merge of the sorted output of every builder in 'bulks', so it can be passed to
+     * commitBulk() in their place. All of 'bulks' must be non-null.
+     */
+    virtual std::unique_ptr<BulkBuilder> mergeBulk(
+        std::vector<std::unique_ptr<BulkBuilder>> bulks) = 0;
+
     /**
      * Call this when you are ready to finish your bulk work.
      * Pass in the BulkBuilder returned from initiateBulk.
@@ -463,6 +508,14 @@ public:
                       const InsertDeleteOptions& options,
                       InsertResult* result) final;
 
+    Status insertKeysForBatch(OperationContext* opCtx,
+                              const std::vector<KeyString::Value>& keys,
+                              const std::vector<Timestamp>& keyTimestamps,
+                              const std::vector<KeyString::Value>& multikeyMetadataKeys,
+                              const boost::optional<MultikeyPaths>& multikeyPaths,
+                              const InsertDeleteOptions& options,
+                              InsertResult* result) final;
+
     Status removeKeys(OperationContext* opCtx,
                       const std::vector<KeyString::Value>& keys,
                       const RecordId& loc,
@@ -506,6 +559,8 @@ public:
 
     std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes) final;
 
+    std::unique_ptr<BulkBuilder> mergeBulk(std::vector<std::unique_ptr<BulkBuilder>> bulks) final;
+
     Status commitBulk(OperationContext* opCtx,
                       BulkBuilder* bulk,
                       bool dupsAllowed,
@@ -554,6 +609,7 @@ protected:
 
 private:
     class BulkBuilderImpl;
+    class MergedBulkBuilderImpl;
 
     /**
      * Determine whether the given Status represents an exception that should cause the indexing
@@ -563,6 +619,26 @@ private:
      */
     bool isFatalError(OperationContext* opCtx, Status status, KeyString::Value key);
 
+    /**
+     * Inserts 'keys' and 'multikeyMetadataKeys' without updating the index's multikey state.
+     *
+     * Used by insertKeys() and insertKeysForBatch() only.
+     */
+    Status _insertKeysWithoutMultikey(OperationContext* opCtx,
+                                      const std::vector<KeyString::Value>& keys,
+                                      const std::vector<KeyString::Value>& multikeyMetadataKeys,
+                                      const InsertDeleteOptions& options,
+                                      InsertResult* result);
+
+    /**
+     * Inserts a single key, retrying with duplicates allowed if 'options' allows for it. Does not
+     * count the key in 'result->numInserted'.
+     */
+    Status _insertKey(OperationContext* opCtx,
+                      const KeyString::Value& keyString,
+                      const InsertDeleteOptions& options,
+                      InsertResult* result);
+
     /**
      * Removes a single key from the index.
      *
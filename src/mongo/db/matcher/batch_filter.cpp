@@ -0,0 +1,400 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/batch_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "mongo/db/matcher/expression_leaf.h"
+#include "mongo/db/matcher/expression_type.h"
+
+namespace mongo {
+
+namespace {
+
+// Doubles represent every integer in this range exactly.
+constexpr long long kMaxExactDouble = 1LL << 53;
+
+/**
+ * Returns true and sets 'out' if 'elem' is a number which a double represents exactly, so that
+ * comparing doubles gives the same result as comparing the BSON values.
+ */
+bool toExactDouble(const BSONElement& elem, double* out) {
+    switch (elem.type()) {
+        case NumberInt:
+            *out = elem._numberInt();
+            return true;
+        case NumberLong: {
+            const long long value = elem._numberLong();
+            if (value < -kMaxExactDouble || value > kMaxExactDouble) {
+                return false;
+            }
+            *out = static_cast<double>(value);
+            return true;
+        }
+        case NumberDouble: {
+            const double value = elem._numberDouble();
+            if (std::isnan(value)) {
+                return false;
+            }
+            *out = value;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool isTopLevelField(StringData path) {
+    return !path.empty() && path.find('.') == std::string::npos;
+}
+
+/**
+ * Clears 'selected[i]' unless the i'th value is of kind 'kind' and satisfies 'cmp', or must be
+ * evaluated by the fallback matcher. Written without branches so that the compiler can vectorize
+ * the loop.
+ */
+template <typename T, typename Cmp>
+void compareKernelImpl(const uint8_t* kinds,
+                   const T* values,
+                   uint8_t kind,
+                   T operand,
+                   size_t n,
+                   uint8_t* selected,
+                   Cmp cmp) {
+    for (size_t i = 0; i < n; ++i) {
+        const bool passes = (kinds[i] == kind) & cmp(values[i], operand);
+        const bool fallback = kinds[i] == BatchFilter::kFallback;
+        selected[i] &= static_cast<uint8_t>(passes | fallback);
+    }
+}
+
+template <typename T>
+void compareKernel(MatchExpression::MatchType op,
+                   const uint8_t* kinds,
+                   const T* values,
+                   uint8_t kind,
+                   T operand,
+                   size_t n,
+                   uint8_t* selected) {
+    switch (op) {
+        case MatchExpression::EQ:
+            compareKernelImpl(kinds, values, kind, operand, n, selected, std::equal_to<T>());
+            return;
+        case MatchExpression::LT:
+            compareKernelImpl(kinds, values, kind, operand, n, selected, std::less<T>());
+            return;
+        case MatchExpression::LTE:
+            compareKernelImpl(kinds, values, kind, operand, n, selected, std::less_equal<T>());
+            return;
+        case MatchExpression::GT:
+            compareKernelImpl(kinds, values, kind, operand, n, selected, std::greater<T>());
+            return;
+        case MatchExpression::GTE:
+            compareKernelImpl(kinds, values, kind, operand, n, selected, std::greater_equal<T>());
+            return;
+        default:
+            MONGO_UNREACHABLE;
+    }
+}
+
+template <typename T>
+bool sortedContains(const std::vector<T>& set, const T& value) {
+    return std::binary_search(set.begin(), set.end(), value);
+}
+
+bool sortedContains(const std::vector<std::string>& set, StringData value) {
+    auto it = std::lower_bound(
+        set.begin(), set.end(), value, [](const std::string& a, StringData b) {
+            return StringData(a) < b;
+        });
+    return it != set.end() && StringData(*it) == value;
+}
+
+}  // namespace
+
+std::unique_ptr<BatchFilter> BatchFilter::compile(const MatchExpression* filter) {
+    if (!filter) {
+        return nullptr;
+    }
+
+    std::unique_ptr<BatchFilter> batchFilter(new BatchFilter(filter));
+    if (filter->matchType() == MatchExpression::AND) {
+        if (filter->numChildren() == 0) {
+            return nullptr;
+        }
+        for (size_t i = 0; i < filter->numChildren(); ++i) {
+            if (!batchFilter->addPredicate(filter->getChild(i))) {
+                return nullptr;
+            }
+        }
+    } else if (!batchFilter->addPredicate(filter)) {
+        return nullptr;
+    }
+
+    return batchFilter;
+}
+
+size_t BatchFilter::columnFor(StringData fieldName) {
+    for (size_t i = 0; i < _columns.size(); ++i) {
+        if (_columns[i].fieldName == fieldName) {
+            return i;
+        }
+    }
+    _columns.emplace_back(fieldName);
+    return _columns.size() - 1;
+}
+
+bool BatchFilter::addPredicate(const MatchExpression* expr) {
+    if (expr->matchType() == MatchExpression::NOT) {
+        // {$exists: false} is parsed as the negation of {$exists: true}.
+        if (expr->numChildren() != 1 || expr->getChild(0)->matchType() != MatchExpression::EXISTS ||
+            !isTopLevelField(expr->getChild(0)->path())) {
+            return false;
+        }
+        Predicate pred;
+        pred.type = PredicateType::kNotExists;
+        pred.column = columnFor(expr->getChild(0)->path());
+        _predicates.push_back(std::move(pred));
+        return true;
+    }
+
+    if (!isTopLevelField(expr->path())) {
+        return false;
+    }
+
+    Predicate pred;
+    switch (expr->matchType()) {
+        case MatchExpression::EQ:
+        case MatchExpression::LT:
+        case MatchExpression::LTE:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            auto cmp = static_cast<const ComparisonMatchExpression*>(expr);
+            const BSONElement& rhs = cmp->getData();
+            pred.compareOp = expr->matchType();
+            if (toExactDouble(rhs, &pred.number)) {
+                pred.type = PredicateType::kNumberCompare;
+            } else if (rhs.type() == BSONType::Date) {
+                pred.type = PredicateType::kDateCompare;
+                pred.date = rhs.date().toMillisSinceEpoch();
+            } else if (rhs.type() == BSONType::String && expr->matchType() == MatchExpression::EQ &&
+                       !cmp->getCollator()) {
+                pred.type = PredicateType::kStringEquals;
+                pred.string = rhs.str();
+            } else {
+                return false;
+            }
+            break;
+        }
+        case MatchExpression::MATCH_IN: {
+            auto in = static_cast<const InMatchExpression*>(expr);
+            if (!in->getRegexes().empty() || in->hasNull() || in->hasEmptyArray()) {
+                return false;
+            }
+            pred.type = PredicateType::kIn;
+            for (auto&& elem : in->getEqualities()) {
+                double number;
+                if (toExactDouble(elem, &number)) {
+                    pred.numberSet.push_back(number);
+                } else if (elem.type() == BSONType::Date) {
+                    pred.dateSet.push_back(elem.date().toMillisSinceEpoch());
+                } else if (elem.type() == BSONType::String && !in->getCollator()) {
+                    pred.stringSet.push_back(elem.str());
+                } else {
+                    return false;
+                }
+            }
+            std::sort(pred.numberSet.begin(), pred.numberSet.end());
+            std::sort(pred.dateSet.begin(), pred.dateSet.end());
+            std::sort(pred.stringSet.begin(), pred.stringSet.end());
+            break;
+        }
+        case MatchExpression::EXISTS:
+            pred.type = PredicateType::kExists;
+            break;
+        case MatchExpression::TYPE_OPERATOR:
+            pred.type = PredicateType::kType;
+            pred.typeSet = static_cast<const TypeMatchExpression*>(expr)->typeSet();
+            break;
+        default:
+            return false;
+    }
+
+    pred.column = columnFor(expr->path());
+    _predicates.push_back(std::move(pred));
+    return true;
+}
+
+void BatchFilter::Column::resize(size_t n) {
+    kinds.assign(n, kMissing);
+    types.assign(n, static_cast<uint8_t>(BSONType::EOO));
+    numbers.assign(n, 0);
+    dates.assign(n, 0);
+    strings.assign(n, StringData());
+}
+
+void BatchFilter::extractColumns(const std::vector<BSONObj>& docs) {
+    const size_t n = docs.size();
+    for (auto&& column : _columns) {
+        column.resize(n);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t remaining = _columns.size();
+        for (auto&& elem : docs[i]) {
+            const StringData fieldName = elem.fieldNameStringData();
+            for (auto&& column : _columns) {
+                // Like the matcher, only consider the first occurrence of a duplicated field.
+                if (column.kinds[i] != kMissing || column.fieldName != fieldName) {
+                    continue;
+                }
+
+                column.types[i] = static_cast<uint8_t>(elem.type());
+                if (toExactDouble(elem, &column.numbers[i])) {
+                    column.kinds[i] = kNumber;
+                } else if (elem.type() == BSONType::Date) {
+                    column.kinds[i] = kDate;
+                    column.dates[i] = elem.date().toMillisSinceEpoch();
+                } else if (elem.type() == BSONType::String) {
+                    column.kinds[i] = kString;
+                    column.strings[i] = elem.valueStringData();
+                } else if (elem.type() == BSONType::Array || elem.isNumber()) {
+                    // Arrays match if any of their elements match, and numbers which a double
+                    // cannot represent need an exact comparison.
+                    column.kinds[i] = kFallback;
+                } else {
+                    column.kinds[i] = kOther;
+                }
+                --remaining;
+                break;
+            }
+            if (remaining == 0) {
+                break;
+            }
+        }
+    }
+}
+
+void BatchFilter::applyPredicate(const Predicate& pred, size_t n, uint8_t* selected) const {
+    const Column& column = _columns[pred.column];
+    const uint8_t* kinds = column.kinds.data();
+
+    switch (pred.type) {
+        case PredicateType::kNumberCompare:
+            compareKernel(
+                pred.compareOp, kinds, column.numbers.data(), kNumber, pred.number, n, selected);
+            return;
+        case PredicateType::kDateCompare:
+            compareKernel(pred.compareOp, kinds, column.dates.data(), kDate, pred.date, n, selected);
+            return;
+        case PredicateType::kStringEquals:
+            for (size_t i = 0; i < n; ++i) {
+                if (selected[i] && kinds[i] != kFallback) {
+                    selected[i] = kinds[i] == kString && column.strings[i] == pred.string;
+                }
+            }
+            return;
+        case PredicateType::kIn:
+            for (size_t i = 0; i < n; ++i) {
+                if (!selected[i]) {
+                    continue;
+                }
+                switch (kinds[i]) {
+                    case kNumber:
+                        selected[i] = sortedContains(pred.numberSet, column.numbers[i]);
+                        break;
+                    case kDate:
+                        selected[i] = sortedContains(pred.dateSet, column.dates[i]);
+                        break;
+                    case kString:
+                        selected[i] = sortedContains(pred.stringSet, column.strings[i]);
+                        break;
+                    case kFallback:
+                        break;
+                    default:
+                        selected[i] = 0;
+                }
+            }
+            return;
+        case PredicateType::kExists:
+            for (size_t i = 0; i < n; ++i) {
+                selected[i] &= static_cast<uint8_t>(kinds[i] != kMissing);
+            }
+            return;
+        case PredicateType::kNotExists:
+            for (size_t i = 0; i < n; ++i) {
+                selected[i] &= static_cast<uint8_t>(kinds[i] == kMissing);
+            }
+            return;
+        case PredicateType::kType:
+            for (size_t i = 0; i < n; ++i) {
+                if (!selected[i] || kinds[i] == kFallback) {
+                    // Arrays also match if any of their elements has a matching type, which is
+                    // left to the fallback matcher.
+                    continue;
+                }
+                selected[i] = kinds[i] != kMissing &&
+                    pred.typeSet.hasType(static_cast<BSONType>(column.types[i]));
+            }
+            return;
+    }
+    MONGO_UNREACHABLE;
+}
+
+void BatchFilter::evaluate(const std::vector<BSONObj>& docs, std::vector<uint8_t>* selected) {
+    const size_t n = docs.size();
+    selected->assign(n, 1);
+    _fallback.assign(n, 0);
+
+    extractColumns(docs);
+    for (auto&& column : _columns) {
+        for (size_t i = 0; i < n; ++i) {
+            _fallback[i] |= static_cast<uint8_t>(column.kinds[i] == kFallback);
+        }
+    }
+
+    for (auto&& pred : _predicates) {
+        applyPredicate(pred, n, selected->data());
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if ((*selected)[i] && _fallback[i]) {
+            ++_numFallbackEvaluations;
+            (*selected)[i] = _filter->matchesBSON(docs[i]);
+        }
+    }
+}
+
+}  // namespace mongo
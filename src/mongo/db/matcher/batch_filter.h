@@ -0,0 +1,160 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/matcher/matcher_type_set.h"
+
+namespace mongo {
+
+/**
+ * A compiled form of a filter which evaluates a block of documents at a time.
+ *
+ * Only filters which are a conjunction of predicates over top-level (non-dotted) fields can be
+ * compiled. The supported predicates are comparisons against numbers and dates, equality against
+ * strings, $in over numbers, dates and strings, $exists, and $type. Each referenced field is
+ * extracted from every document in the block in a single pass over the top-level fields, into a
+ * column of typed scalars. Each predicate is then evaluated over a whole column by a branch-free
+ * kernel.
+ *
+ * Documents whose values cannot be represented exactly in a column (for instance arrays, which
+ * match if any of their elements match, or NumberDecimal values) are evaluated against the
+ * original MatchExpression instead.
+ */
+class BatchFilter {
+public:
+    /**
+     * Returns a BatchFilter equivalent to 'filter', or nullptr if 'filter' has a form which cannot
+     * be compiled. 'filter' must outlive the returned BatchFilter.
+     */
+    static std::unique_ptr<BatchFilter> compile(const MatchExpression* filter);
+
+    /**
+     * Sets (*selected)[i] to 1 if docs[i] matches the filter and to 0 otherwise.
+     */
+    void evaluate(const std::vector<BSONObj>& docs, std::vector<uint8_t>* selected);
+
+    /**
+     * Returns the number of documents which had to be evaluated by the original MatchExpression
+     * over the lifetime of this BatchFilter.
+     */
+    size_t numFallbackEvaluations() const {
+        return _numFallbackEvaluations;
+    }
+
+    /**
+     * How the value of a field in a given document is represented in its column.
+     */
+    enum ValueKind : uint8_t {
+        kMissing,
+        kNumber,
+        kDate,
+        kString,
+        // The value must be evaluated against the original MatchExpression.
+        kFallback,
+        // Any other value. Its type is recorded, but it cannot satisfy a comparison.
+        kOther,
+    };
+
+private:
+    struct Column {
+        explicit Column(StringData fieldName) : fieldName(fieldName.toString()) {}
+
+        void resize(size_t n);
+
+        std::string fieldName;
+
+        // One entry per document in the block being evaluated.
+        std::vector<uint8_t> kinds;
+        std::vector<uint8_t> types;
+        std::vector<double> numbers;
+        std::vector<int64_t> dates;
+        std::vector<StringData> strings;
+    };
+
+    enum class PredicateType {
+        kNumberCompare,
+        kDateCompare,
+        kStringEquals,
+        kIn,
+        kExists,
+        kNotExists,
+        kType,
+    };
+
+    struct Predicate {
+        PredicateType type;
+        size_t column;
+
+        // For comparisons, the kind of comparison and the operand.
+        MatchExpression::MatchType compareOp = MatchExpression::EQ;
+        double number = 0;
+        int64_t date = 0;
+        std::string string;
+
+        // For $in, the sorted sets of operands of each supported kind.
+        std::vector<double> numberSet;
+        std::vector<int64_t> dateSet;
+        std::vector<std::string> stringSet;
+
+        // For $type.
+        MatcherTypeSet typeSet;
+    };
+
+    explicit BatchFilter(const MatchExpression* filter) : _filter(filter) {}
+
+    bool addPredicate(const MatchExpression* expr);
+    size_t columnFor(StringData fieldName);
+
+    void extractColumns(const std::vector<BSONObj>& docs);
+    void applyPredicate(const Predicate& pred, size_t n, uint8_t* selected) const;
+
+    // The original filter, used for documents with values which cannot be evaluated on columns.
+    const MatchExpression* const _filter;
+
+    std::vector<Column> _columns;
+    std::vector<Predicate> _predicates;
+
+    // Scratch space reused between calls to evaluate(). '_fallback[i]' is set if document 'i' has
+    // a value which must be evaluated by '_filter'.
+    std::vector<uint8_t> _fallback;
+
+    size_t _numFallbackEvaluations = 0;
+};
+
+}  // namespace mongo
@@ -0,0 +1,191 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/matcher/batch_filter.h"
+
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+std::unique_ptr<MatchExpression> parseFilter(const BSONObj& query,
+                                             const CollatorInterface* collator = nullptr) {
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    expCtx->setCollator(collator);
+    auto statusWithMatcher = MatchExpressionParser::parse(query, expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    return MatchExpression::optimize(std::move(statusWithMatcher.getValue()));
+}
+
+std::vector<BSONObj> testDocuments() {
+    const Date_t date = Date_t::fromMillisSinceEpoch(1000);
+    return {
+        BSONObj(),
+        BSON("a" << 1),
+        BSON("a" << 2.5),
+        BSON("a" << 3LL),
+        BSON("a" << 5),
+        BSON("a" << std::numeric_limits<double>::quiet_NaN()),
+        BSON("a" << (1LL << 60)),
+        BSON("a" << Decimal128(3)),
+        BSON("a" << BSON_ARRAY(0 << 3)),
+        BSON("a" << BSONArray()),
+        BSON("a"
+             << "foo"),
+        BSON("a"
+             << "bar"),
+        BSON("a" << BSONNULL),
+        BSON("a" << MINKEY),
+        BSON("a" << BSON("b" << 1)),
+        BSON("a" << date),
+        BSON("a" << Date_t::fromMillisSinceEpoch(2000)),
+        BSON("a" << Timestamp(1, 1)),
+        BSON("a" << true),
+        BSON("a" << 3 << "a" << 10),
+        BSON("b" << 3),
+        BSON("b" << 3 << "a" << 3),
+        BSON("a" << 3 << "b"
+                 << "foo"),
+        BSON("a" << 4 << "b" << BSON_ARRAY("foo"
+                                            << "bar")),
+    };
+}
+
+/**
+ * Asserts that 'query' compiles to a BatchFilter which agrees with the MatchExpression on every
+ * test document.
+ */
+void assertAgreesWithMatcher(const BSONObj& query) {
+    auto expr = parseFilter(query);
+    auto batchFilter = BatchFilter::compile(expr.get());
+    ASSERT(batchFilter) << query;
+
+    auto docs = testDocuments();
+    std::vector<uint8_t> selected;
+    batchFilter->evaluate(docs, &selected);
+    ASSERT_EQ(docs.size(), selected.size());
+    for (size_t i = 0; i < docs.size(); ++i) {
+        ASSERT_EQ(expr->matchesBSON(docs[i]), static_cast<bool>(selected[i]))
+            << "query: " << query << " document: " << docs[i];
+    }
+}
+
+TEST(BatchFilterTest, NumericComparisons) {
+    assertAgreesWithMatcher(BSON("a" << 3));
+    assertAgreesWithMatcher(BSON("a" << BSON("$lt" << 3)));
+    assertAgreesWithMatcher(BSON("a" << BSON("$lte" << 3LL)));
+    assertAgreesWithMatcher(BSON("a" << BSON("$gt" << 2.5)));
+    assertAgreesWithMatcher(BSON("a" << BSON("$gte" << 1 << "$lt" << 5)));
+}
+
+TEST(BatchFilterTest, DateComparisons) {
+    const Date_t date = Date_t::fromMillisSinceEpoch(1000);
+    assertAgreesWithMatcher(BSON("a" << date));
+    assertAgreesWithMatcher(BSON("a" << BSON("$gte" << date)));
+    assertAgreesWithMatcher(BSON("a" << BSON("$gt" << date << "$lte"
+                                               << Date_t::fromMillisSinceEpoch(2000))));
+}
+
+TEST(BatchFilterTest, StringEquality) {
+    assertAgreesWithMatcher(BSON("a"
+                                 << "foo"));
+    assertAgreesWithMatcher(BSON("b"
+                                 << "foo"));
+}
+
+TEST(BatchFilterTest, In) {
+    assertAgreesWithMatcher(fromjson("{a: {$in: [1, 3, 'foo']}}"));
+    assertAgreesWithMatcher(BSON("a" << BSON("$in" << BSON_ARRAY(Date_t::fromMillisSinceEpoch(1000)
+                                                                 << 2.5))));
+}
+
+TEST(BatchFilterTest, ExistsAndType) {
+    assertAgreesWithMatcher(fromjson("{a: {$exists: true}}"));
+    assertAgreesWithMatcher(fromjson("{a: {$exists: false}}"));
+    assertAgreesWithMatcher(fromjson("{a: {$type: 'number'}}"));
+    assertAgreesWithMatcher(fromjson("{a: {$type: 'array'}}"));
+    assertAgreesWithMatcher(fromjson("{a: {$type: 'string'}}"));
+}
+
+TEST(BatchFilterTest, Conjunctions) {
+    assertAgreesWithMatcher(fromjson("{a: {$gte: 1, $lt: 5}, b: {$in: ['foo', 'baz']}}"));
+    assertAgreesWithMatcher(fromjson("{a: 3, b: {$exists: false}}"));
+    assertAgreesWithMatcher(fromjson("{b: 3, a: {$type: 'number'}}"));
+}
+
+TEST(BatchFilterTest, OnlyArraysAndInexactNumbersUseFallbackMatcher) {
+    auto expr = parseFilter(fromjson("{a: {$gte: 0}}"));
+    auto batchFilter = BatchFilter::compile(expr.get());
+    ASSERT(batchFilter);
+
+    std::vector<BSONObj> docs{BSON("a" << 1),
+                              BSON("a" << BSON_ARRAY(1 << 2)),
+                              BSON("a" << Decimal128(1)),
+                              BSON("a"
+                                   << "foo")};
+    std::vector<uint8_t> selected;
+    batchFilter->evaluate(docs, &selected);
+    ASSERT_EQ(2U, batchFilter->numFallbackEvaluations());
+    ASSERT_EQ(4U, selected.size());
+    ASSERT_TRUE(selected[0]);
+    ASSERT_TRUE(selected[1]);
+    ASSERT_TRUE(selected[2]);
+    ASSERT_FALSE(selected[3]);
+}
+
+TEST(BatchFilterTest, UnsupportedFiltersDoNotCompile) {
+    ASSERT_FALSE(BatchFilter::compile(nullptr));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{'a.b': 1}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{a: null}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{a: {$in: [1, null]}}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{a: {$in: [1, /foo/]}}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{a: {$lt: 'foo'}}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{$or: [{a: 1}, {b: 1}]}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(fromjson("{a: 1, b: {$size: 1}}")).get()));
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(BSON("a" << (1LL << 60))).get()));
+}
+
+TEST(BatchFilterTest, StringPredicatesWithCollatorDoNotCompile) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    ASSERT_FALSE(BatchFilter::compile(parseFilter(BSON("a"
+                                                       << "foo"),
+                                                  &collator)
+                                          .get()));
+    ASSERT(BatchFilter::compile(parseFilter(BSON("a" << 1), &collator).get()));
+}
+
+}  // namespace
+}  // namespace mongo
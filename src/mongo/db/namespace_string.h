@@ -110,6 +110,9 @@ public:
     // Namespace for balancer settings and default read and write concerns.
     static const NamespaceString kConfigSettingsNamespace;
 
+    // Namespace for persisted plan cache entries.
+    static const NamespaceString kPlanCacheNamespace;
+
     /**
      * Constructs an empty NamespaceString.
      */
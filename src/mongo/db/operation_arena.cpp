@@ -0,0 +1,129 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/operation_arena.h"
+
+#include <algorithm>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+const auto getOperationArena = OperationContext::declareDecoration<OperationArena>();
+
+// The arena does not reserve any memory until it is first used, so that operations which never
+// use it pay nothing for it. Blocks then grow geometrically, so that a small operation wastes
+// little memory while a large one needs only a few blocks.
+constexpr size_t kMinBlockSize = 4 * 1024;
+constexpr size_t kMaxBlockSize = 64 * 1024;
+
+}  // namespace
+
+OperationArena& OperationArena::get(OperationContext* opCtx) {
+    return getOperationArena(opCtx);
+}
+
+OperationArena::~OperationArena() {
+    for (auto it = _destructors.rbegin(); it != _destructors.rend(); ++it) {
+        it->destroy(it->obj);
+    }
+}
+
+OperationArena::Mark OperationArena::_mark() const {
+    return {_blocks.size(),
+            _destructors.size(),
+            _cursor,
+            _end,
+            _nextBlockSize,
+            _bytesAllocated,
+            _bytesReserved};
+}
+
+void OperationArena::_rollBackTo(const Mark& mark) {
+    invariant(mark.numBlocks <= _blocks.size() && mark.numDestructors <= _destructors.size());
+
+    while (_destructors.size() > mark.numDestructors) {
+        auto destructor = _destructors.back();
+        _destructors.pop_back();
+        destructor.destroy(destructor.obj);
+    }
+
+    // Blocks allocated since the mark are freed, and whatever was carved out of the block that was
+    // current at the time of the mark is reused by bumping the pointer from where it was.
+    _blocks.resize(mark.numBlocks);
+    _cursor = mark.cursor;
+    _end = mark.end;
+    _nextBlockSize = mark.nextBlockSize;
+    _bytesAllocated = mark.bytesAllocated;
+    _bytesReserved = mark.bytesReserved;
+}
+
+void* OperationArena::allocate(size_t size, size_t alignment) {
+    dassert(alignment && (alignment & (alignment - 1)) == 0);
+    dassert(alignment <= alignof(std::max_align_t));
+
+    const auto address = reinterpret_cast<uintptr_t>(_cursor);
+    const auto padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+    if (_cursor && padding + size <= static_cast<size_t>(_end - _cursor)) {
+        void* ptr = _cursor + padding;
+        _cursor += padding + size;
+        _bytesAllocated += size;
+        return ptr;
+    }
+    return _allocateFromNewBlock(size, alignment);
+}
+
+void* OperationArena::_allocateFromNewBlock(size_t size, size_t alignment) {
+    _bytesAllocated += size;
+
+    // An allocation too large to share a block with others gets a block of its own, leaving the
+    // current block to serve the allocations that come after it. Memory from operator new[] is
+    // suitably aligned for any fundamental type, so it needs no padding.
+    if (size > kMaxBlockSize / 4) {
+        _blocks.emplace_back(new char[size]);
+        _bytesReserved += size;
+        return _blocks.back().get();
+    }
+
+    _nextBlockSize = std::min(std::max(_nextBlockSize * 2, kMinBlockSize), kMaxBlockSize);
+    const size_t blockSize = std::max(_nextBlockSize, size);
+    _blocks.emplace_back(new char[blockSize]);
+    _bytesReserved += blockSize;
+
+    char* block = _blocks.back().get();
+    _cursor = block + size;
+    _end = block + blockSize;
+    return block;
+}
+
+}  // namespace mongo
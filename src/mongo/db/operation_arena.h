@@ -0,0 +1,230 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/operation_context.h"
+
+namespace mongo {
+
+/**
+ * A monotonic arena for short-lived allocations made on behalf of a single operation.
+ *
+ * Allocations are carved out of a short list of blocks by bumping a pointer, and are never freed
+ * individually. All of the arena's memory is released at once when the OperationContext which
+ * owns the arena is destroyed. Objects created through make() have their destructors run at that
+ * point, in the reverse order of their creation.
+ *
+ * A long-running operation should not let the arena grow for its whole life, so a phase of the
+ * operation which uses the arena should do so within a Scope, which releases everything allocated
+ * during the phase when it ends.
+ *
+ * Only memory which is certain not to outlive the operation may come from the arena. In
+ * particular, nothing which can be stashed in a ClientCursor and used by a later getMore may be
+ * allocated here. Like the OperationContext itself, an arena must only be used by one thread at a
+ * time.
+ *
+ * Code which can't tell how long its operation will keep running, such as one write of a batch,
+ * should only use the arena while a caller has opened a Scope on it.
+ */
+class OperationArena {
+    OperationArena(const OperationArena&) = delete;
+    OperationArena& operator=(const OperationArena&) = delete;
+
+public:
+    class Scope;
+
+    static OperationArena& get(OperationContext* opCtx);
+
+    OperationArena() = default;
+    ~OperationArena();
+
+    /**
+     * Returns 'size' bytes of uninitialized memory aligned to 'alignment', which must be a power of
+     * two no greater than alignof(std::max_align_t).
+     */
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Constructs a T in the arena. The arena owns the returned object and destroys it when the
+     * arena itself is destroyed.
+     */
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        void* storage = allocate(sizeof(T), alignof(T));
+        T* obj = new (storage) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            _destructors.push_back({[](void* ptr) { static_cast<T*>(ptr)->~T(); }, obj});
+        }
+        return obj;
+    }
+
+    /**
+     * Returns whether a Scope is currently open on the arena.
+     */
+    bool inScope() const {
+        return _numScopes > 0;
+    }
+
+    /**
+     * Returns the total number of bytes handed out by allocate() over the life of the arena.
+     */
+    size_t bytesAllocated() const {
+        return _bytesAllocated;
+    }
+
+    /**
+     * Returns the number of bytes the arena currently holds from the system allocator.
+     */
+    size_t bytesReserved() const {
+        return _bytesReserved;
+    }
+
+private:
+    struct Destructor {
+        void (*destroy)(void*);
+        void* obj;
+    };
+
+    /**
+     * The state of the arena at a point in time, to which it can be rolled back.
+     */
+    struct Mark {
+        size_t numBlocks;
+        size_t numDestructors;
+        char* cursor;
+        char* end;
+        size_t nextBlockSize;
+        size_t bytesAllocated;
+        size_t bytesReserved;
+    };
+
+    Mark _mark() const;
+
+    /**
+     * Destroys the objects made and frees the memory allocated since 'mark' was taken.
+     */
+    void _rollBackTo(const Mark& mark);
+
+    void* _allocateFromNewBlock(size_t size, size_t alignment);
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    std::vector<Destructor> _destructors;
+
+    // The unused part of the most recently allocated block.
+    char* _cursor = nullptr;
+    char* _end = nullptr;
+
+    // The size of the next block to allocate. Doubles with each block up to a fixed maximum.
+    size_t _nextBlockSize = 0;
+
+    size_t _bytesAllocated = 0;
+    size_t _bytesReserved = 0;
+
+    int _numScopes = 0;
+};
+
+/**
+ * Releases everything allocated from an arena during the lifetime of the Scope when it is
+ * destroyed. Nothing allocated within the scope may be used once it ends; scopes must be nested.
+ */
+class OperationArena::Scope {
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+public:
+    explicit Scope(OperationArena* arena) : _arena(arena), _mark(arena->_mark()) {
+        ++_arena->_numScopes;
+    }
+
+    ~Scope() {
+        --_arena->_numScopes;
+        _arena->_rollBackTo(_mark);
+    }
+
+private:
+    OperationArena* const _arena;
+    const Mark _mark;
+};
+
+/**
+ * An allocator for standard library containers which takes its memory from an OperationArena.
+ * Deallocation is a no-op: the memory is returned when the arena is destroyed. Without an arena it
+ * allocates from the heap, so that whether a container uses an arena can be decided at runtime.
+ */
+template <typename T>
+class OperationArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit OperationArenaAllocator(OperationArena* arena) : _arena(arena) {}
+
+    template <typename U>
+    OperationArenaAllocator(const OperationArenaAllocator<U>& other) : _arena(other.arena()) {}
+
+    T* allocate(size_t n) {
+        if (!_arena) {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) {
+        if (!_arena) {
+            std::allocator<T>().deallocate(ptr, n);
+        }
+    }
+
+    OperationArena* arena() const {
+        return _arena;
+    }
+
+    template <typename U>
+    bool operator==(const OperationArenaAllocator<U>& other) const {
+        return _arena == other.arena();
+    }
+
+    template <typename U>
+    bool operator!=(const OperationArenaAllocator<U>& other) const {
+        return _arena != other.arena();
+    }
+
+private:
+    OperationArena* _arena;
+};
+
+}  // namespace mongo
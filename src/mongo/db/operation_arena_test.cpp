@@ -0,0 +1,183 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/db/client.h"
+#include "mongo/db/operation_arena.h"
+#include "mongo/db/service_context.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+bool isAligned(const void* ptr, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST(OperationArenaTest, ReservesNothingUntilFirstUse) {
+    OperationArena arena;
+    ASSERT_EQ(arena.bytesAllocated(), 0U);
+    ASSERT_EQ(arena.bytesReserved(), 0U);
+}
+
+TEST(OperationArenaTest, AllocationsAreAlignedAndDoNotOverlap) {
+    OperationArena arena;
+    auto first = static_cast<char*>(arena.allocate(3, 1));
+    auto second = static_cast<char*>(arena.allocate(sizeof(double), alignof(double)));
+    auto third = static_cast<char*>(arena.allocate(1, 1));
+    ASSERT_TRUE(isAligned(second, alignof(double)));
+    ASSERT_TRUE(second >= first + 3);
+    ASSERT_TRUE(third >= second + sizeof(double));
+    ASSERT_EQ(arena.bytesAllocated(), 3U + sizeof(double) + 1U);
+}
+
+TEST(OperationArenaTest, LargeAllocationsGetTheirOwnBlock) {
+    OperationArena arena;
+    auto small = static_cast<char*>(arena.allocate(16));
+    auto large = static_cast<char*>(arena.allocate(1024 * 1024));
+    auto next = static_cast<char*>(arena.allocate(16));
+
+    // The allocation after the large one is still served from the first block.
+    ASSERT_TRUE(next == small + 16);
+    ASSERT_TRUE(large < small || large >= small + 4096);
+    ASSERT_GTE(arena.bytesReserved(), 1024U * 1024U);
+}
+
+TEST(OperationArenaTest, MakeRunsDestructorsWhenArenaIsDestroyed) {
+    std::vector<int> destroyed;
+    struct Tracked {
+        Tracked(std::vector<int>* destroyed, int id) : destroyed(destroyed), id(id) {}
+        ~Tracked() {
+            destroyed->push_back(id);
+        }
+        std::vector<int>* destroyed;
+        int id;
+    };
+
+    {
+        OperationArena arena;
+        arena.make<Tracked>(&destroyed, 1);
+        arena.make<Tracked>(&destroyed, 2);
+        ASSERT_TRUE(destroyed.empty());
+    }
+
+    // Objects are destroyed in the reverse order of their creation.
+    ASSERT_EQ(destroyed, (std::vector<int>{2, 1}));
+}
+
+TEST(OperationArenaTest, ScopeReleasesWhatWasAllocatedWithinIt) {
+    std::vector<int> destroyed;
+    struct Tracked {
+        Tracked(std::vector<int>* destroyed, int id) : destroyed(destroyed), id(id) {}
+        ~Tracked() {
+            destroyed->push_back(id);
+        }
+        std::vector<int>* destroyed;
+        int id;
+    };
+
+    OperationArena arena;
+    arena.make<Tracked>(&destroyed, 1);
+    const auto bytesAllocated = arena.bytesAllocated();
+    const auto bytesReserved = arena.bytesReserved();
+    auto next = static_cast<char*>(arena.allocate(16));
+
+    for (int i = 0; i < 2; ++i) {
+        OperationArena::Scope scope(&arena);
+        arena.make<Tracked>(&destroyed, 2);
+        arena.allocate(1024 * 1024);
+        for (int j = 0; j < 100; ++j) {
+            arena.allocate(1024);
+        }
+        ASSERT_GT(arena.bytesReserved(), bytesReserved);
+    }
+
+    // Only the object made within the scope is destroyed, and the memory of the first block which
+    // was used within the scope is handed out again.
+    ASSERT_EQ(destroyed, (std::vector<int>{2, 2}));
+    ASSERT_EQ(arena.bytesAllocated(), bytesAllocated + 16);
+    ASSERT_EQ(arena.bytesReserved(), bytesReserved);
+    ASSERT_TRUE(static_cast<char*>(arena.allocate(16)) == next + 16);
+}
+
+TEST(OperationArenaTest, AllocatorBacksStandardContainers) {
+    OperationArena arena;
+    std::vector<int, OperationArenaAllocator<int>> values{OperationArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 10000; ++i) {
+        values.push_back(i);
+    }
+    ASSERT_EQ(values.size(), 10000U);
+    ASSERT_EQ(values.back(), 9999);
+    ASSERT_GTE(arena.bytesAllocated(), 10000U * sizeof(int));
+}
+
+TEST(OperationArenaTest, AllocatorWithoutArenaUsesTheHeap) {
+    std::vector<int, OperationArenaAllocator<int>> values{OperationArenaAllocator<int>(nullptr)};
+    for (int i = 0; i < 10000; ++i) {
+        values.push_back(i);
+    }
+    ASSERT_EQ(values.size(), 10000U);
+    ASSERT_EQ(values.back(), 9999);
+}
+
+TEST(OperationArenaTest, ScopesNest) {
+    OperationArena arena;
+    ASSERT_FALSE(arena.inScope());
+    {
+        OperationArena::Scope outer(&arena);
+        {
+            OperationArena::Scope inner(&arena);
+            ASSERT_TRUE(arena.inScope());
+        }
+        ASSERT_TRUE(arena.inScope());
+    }
+    ASSERT_FALSE(arena.inScope());
+}
+
+TEST(OperationArenaTest, EachOperationHasItsOwnArena) {
+    auto serviceCtx = ServiceContext::make();
+    auto client = serviceCtx->makeClient("OperationArenaTest");
+    auto opCtx = client->makeOperationContext();
+    auto& arena = OperationArena::get(opCtx.get());
+    ASSERT_EQ(&arena, &OperationArena::get(opCtx.get()));
+    arena.allocate(64);
+    ASSERT_EQ(arena.bytesAllocated(), 64U);
+    opCtx.reset();
+
+    auto otherOpCtx = client->makeOperationContext();
+    ASSERT_EQ(OperationArena::get(otherOpCtx.get()).bytesAllocated(), 0U);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -49,7 +49,7 @@ TEST(WriteOpsDocSeq, InsertDocStreamWorks) {
     ASSERT_EQ(conn->count(ns), 0u);
 
     OpMsgRequest request;
-    request.body = BSON("insert" << ns.coll() << "$db" << ns.db());
+    request.setBody(BSON("insert" << ns.coll() << "$db" << ns.db()));
     request.sequences = {{"documents",
                           {
                               BSON("_id" << 1),
@@ -51,6 +51,7 @@
 #include "mongo/db/introspect.h"
 #include "mongo/db/lasterror.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/ops/delete_request.h"
 #include "mongo/db/ops/insert.h"
 #include "mongo/db/ops/parsed_delete.h"
@@ -611,6 +612,10 @@ static SingleWriteResult performSingleUpdateOp(OperationContext* opCtx,
                                                const NamespaceString& ns,
                                                StmtId stmtId,
                                                const UpdateRequest& updateRequest) {
+    // Everything the update allocates from the operation's arena, such as its working set, is
+    // released before the next write of the batch.
+    OperationArena::Scope arenaScope(&OperationArena::get(opCtx));
+
     const ExtensionsCallbackReal extensionsCallback(opCtx, &updateRequest.getNamespaceString());
     ParsedUpdate parsedUpdate(opCtx, &updateRequest, extensionsCallback);
     uassertStatusOK(parsedUpdate.parseRequest());
@@ -847,6 +852,10 @@ static SingleWriteResult performSingleDeleteOp(OperationContext* opCtx,
             "Cannot use (or request) retryable writes with limit=0",
             opCtx->inMultiDocumentTransaction() || !opCtx->getTxnNumber() || !op.getMulti());
 
+    // Everything the delete allocates from the operation's arena, such as its working set, is
+    // released before the next write of the batch.
+    OperationArena::Scope arenaScope(&OperationArena::get(opCtx));
+
     globalOpCounters.gotDelete();
     ServerWriteConcernMetrics::get(opCtx)->recordWriteConcernForDelete(opCtx->getWriteConcern());
     auto& curOp = *CurOp::get(opCtx);
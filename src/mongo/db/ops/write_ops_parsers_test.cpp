@@ -103,10 +103,10 @@ TEST(CommandWriteOpsParsers, ErrorOnDuplicateCommonField) {
 
 TEST(CommandWriteOpsParsers, ErrorOnDuplicateCommonFieldBetweenBodyAndSequence) {
     OpMsgRequest request;
-    request.body = BSON("insert"
-                        << "bar"
-                        << "documents" << BSON_ARRAY(BSONObj()) << "$db"
-                        << "foo");
+    request.setBody(BSON("insert"
+                         << "bar"
+                         << "documents" << BSON_ARRAY(BSONObj()) << "$db"
+                         << "foo"));
     request.sequences = {{"documents",
                           {
                               BSONObj(),
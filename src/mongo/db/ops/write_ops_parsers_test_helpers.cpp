@@ -52,7 +52,7 @@ OpMsgRequest toOpMsg(StringData db, const BSONObj& cmd, bool useDocSequence) {
         }
     }
     body.append("$db", db);
-    request.body = body.obj();
+    request.setBody(body.obj());
     return request;
 }
 
@@ -0,0 +1,142 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/periodic_runner_job_persist_plan_cache.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/query/plan_cache_persistence.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/db/service_context.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/periodic_runner.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * State carried between runs of the job. Only the job's own thread touches it.
+ */
+struct PersistPlanCacheState {
+    bool restored = false;
+};
+
+/**
+ * Restores the persisted entries on the job's first run and persists the plan caches on every
+ * later one. Every member of a replica set does both, whatever its state: the plan caches are
+ * local to each member and local.system.plancache is not replicated, so a secondary's entries are
+ * only ever written by that secondary.
+ */
+void persistOrRestorePlanCache(OperationContext* opCtx, PersistPlanCacheState* state) {
+    if (!state->restored) {
+        // Whatever happens, don't restore twice, and don't overwrite the persisted entries with the
+        // still cold plan caches until the next run.
+        state->restored = true;
+        auto swNumRestored = plan_cache_persistence::restorePlanCaches(opCtx);
+        if (swNumRestored.isOK()) {
+            LOGV2(51802,
+                  "Restored {numEntries} persisted plan cache entries",
+                  "numEntries"_attr = swNumRestored.getValue());
+        } else {
+            LOGV2(51803,
+                  "Failed to restore persisted plan cache entries: {error}",
+                  "error"_attr = swNumRestored.getStatus());
+        }
+        return;
+    }
+
+    // An arbiter holds no data, so it has no plan caches worth persisting.
+    auto replCoord = repl::ReplicationCoordinator::get(opCtx);
+    if (replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet &&
+        replCoord->getMemberState().arbiter()) {
+        return;
+    }
+
+    auto swNumPersisted = plan_cache_persistence::persistPlanCaches(opCtx);
+    if (!swNumPersisted.isOK()) {
+        LOGV2(51804,
+              "Failed to persist plan cache entries: {error}",
+              "error"_attr = swNumPersisted.getStatus());
+    }
+}
+
+}  // namespace
+
+auto PeriodicThreadToPersistPlanCache::get(ServiceContext* serviceContext)
+    -> PeriodicThreadToPersistPlanCache& {
+    auto& jobContainer = _serviceDecoration(serviceContext);
+    jobContainer._init(serviceContext);
+
+    return jobContainer;
+}
+
+auto PeriodicThreadToPersistPlanCache::operator*() const noexcept -> PeriodicJobAnchor& {
+    stdx::lock_guard lk(_mutex);
+    return *_anchor;
+}
+
+auto PeriodicThreadToPersistPlanCache::operator-> () const noexcept -> PeriodicJobAnchor* {
+    stdx::lock_guard lk(_mutex);
+    return _anchor.get();
+}
+
+void PeriodicThreadToPersistPlanCache::_init(ServiceContext* serviceContext) {
+    stdx::lock_guard lk(_mutex);
+    if (_anchor) {
+        return;
+    }
+
+    auto periodicRunner = serviceContext->getPeriodicRunner();
+    invariant(periodicRunner);
+
+    PeriodicRunner::PeriodicJob job("persistPlanCache",
+                                    [state = std::make_shared<PersistPlanCacheState>()](
+                                        Client* client) {
+                                        auto opCtx = client->makeOperationContext();
+                                        try {
+                                            persistOrRestorePlanCache(opCtx.get(), state.get());
+                                        } catch (const DBException& ex) {
+                                            LOGV2(51805,
+                                                  "Failed to persist or restore plan cache "
+                                                  "entries: {error}",
+                                                  "error"_attr = ex.toStatus());
+                                        }
+                                    },
+                                    Seconds(internalQueryCachePersistenceIntervalSecs.load()));
+
+    _anchor = std::make_shared<PeriodicJobAnchor>(periodicRunner->makeJob(std::move(job)));
+}
+
+}  // namespace mongo
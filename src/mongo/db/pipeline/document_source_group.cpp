@@ -29,7 +29,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
+#include <limits>
 #include <memory>
 
 #include "mongo/db/exec/document_value/document.h"
@@ -41,7 +43,9 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -61,6 +65,66 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+// A spill partition which is too large to be merged in memory is split into at most this many
+// sub-partitions, which bounds the number of partition files open for writing at once.
+const size_t kMaxSpillRepartitionFanOut = 16;
+
+// Partitions at this depth are merged in memory whatever their size. Splitting them further is
+// unlikely to help, since their groups are either few but large or share a single hash.
+const size_t kMaxSpillPartitionDepth = 4;
+
+/**
+ * Maps the hash of a group's _id to one of 'numPartitions' spill partitions at the given 'depth'.
+ * The hash is mixed first so that the partition does not correlate with the bucket the group
+ * occupies in the partition's own hash table when it is merged, nor with the partition it was
+ * assigned to at a lower depth.
+ */
+size_t partitionForHash(size_t hash, size_t numPartitions, size_t depth) {
+    const uint64_t seeded = static_cast<uint64_t>(hash) ^ (depth * 0xC2B2AE3D27D4EB4FULL);
+    const uint64_t mixed = seeded * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(mixed >> 32) % numPartitions;
+}
+
+/**
+ * Serializes the partial state of a group's accumulators for spilling. This mirrors the format
+ * used by DocumentSourceGroup::spill().
+ */
+Value serializeAccumulators(const DocumentSourceGroup::Accumulators& accums) {
+    switch (accums.size()) {
+        case 0:
+            return Value();
+        case 1:
+            return accums[0]->getValue(/*toBeMerged=*/true);
+        default: {
+            std::vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(states));
+        }
+    }
+}
+
+/**
+ * Merges spilled accumulator state produced by serializeAccumulators() into 'accums'.
+ */
+void mergeAccumulators(const Value& state, const DocumentSourceGroup::Accumulators& accums) {
+    switch (accums.size()) {
+        case 0:
+            break;
+        case 1:
+            accums[0]->process(state, true);
+            break;
+        default: {
+            const std::vector<Value>& states = state.getArray();
+            for (size_t i = 0; i < accums.size(); i++) {
+                accums[i]->process(states[i], true);
+            }
+        }
+    }
+}
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -144,7 +208,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
+    if (_spilledToPartitions) {
+        return getNextPartitioned();
+    } else if (_spilled) {
         return getNextSpilled();
     } else {
         return getNextStandard();
@@ -198,7 +264,175 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     return std::move(out);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // We aren't streaming, and we have spilled to hash partitions on disk.
+    while (groupsIterator == _groups->end()) {
+        if (!loadNextPartition()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
+}
+
+bool DocumentSourceGroup::loadNextPartition() {
+    while (true) {
+        size_t partition;
+        boost::optional<GroupsMap> groups;
+        if (!_mergePool) {
+            if (_nextPartitionToSchedule >= _spillPartitions.size()) {
+                return false;
+            }
+            partition = _nextPartitionToSchedule++;
+            groups = mergeSpilledPartition(_spillPartitions[partition],
+                                           _partitionMaxMemoryUsageBytes);
+        } else {
+            // Keep every merge thread busy, while bounding the number of merged partitions which
+            // are held in memory at once.
+            while (_pendingPartitions.size() < _numMergeThreads &&
+                   _nextPartitionToSchedule < _spillPartitions.size()) {
+                const size_t nextPartition = _nextPartitionToSchedule++;
+                const SpillPartition* spillPartition = &_spillPartitions[nextPartition];
+                auto pf = makePromiseFuture<boost::optional<GroupsMap>>();
+                _mergePool->schedule([this, spillPartition, promise = std::move(pf.promise)](
+                                         Status status) mutable {
+                    if (!status.isOK()) {
+                        promise.setError(status);
+                        return;
+                    }
+                    promise.setWith([&] {
+                        return mergeSpilledPartition(*spillPartition,
+                                                     _partitionMaxMemoryUsageBytes);
+                    });
+                });
+                _pendingPartitions.emplace_back(nextPartition, std::move(pf.future));
+            }
+
+            if (_pendingPartitions.empty()) {
+                return false;
+            }
+
+            auto pending = std::move(_pendingPartitions.front());
+            _pendingPartitions.pop_front();
+            partition = pending.first;
+            groups = std::move(pending.second).get(pExpCtx->opCtx);
+        }
+
+        if (groups) {
+            _groups = std::move(*groups);
+            groupsIterator = _groups->begin();
+            return true;
+        }
+        repartitionSpilledPartition(partition);
+    }
+}
+
+DocumentSourceGroup::SpillPartition& DocumentSourceGroup::addSpillPartition(size_t depth) {
+    _spillPartitions.emplace_back();
+    auto& partition = _spillPartitions.back();
+    partition.fileName = _fileName + ".part" + std::to_string(_numSpillPartitionFiles++);
+    partition.depth = depth;
+    return partition;
+}
+
+boost::optional<DocumentSourceGroup::GroupsMap> DocumentSourceGroup::mergeSpilledPartition(
+    const SpillPartition& partition, size_t maxMemoryUsageBytes) const {
+    if (partition.depth >= kMaxSpillPartitionDepth) {
+        maxMemoryUsageBytes = std::numeric_limits<size_t>::max();
+    }
+
+    GroupsMap groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+    size_t memoryUsageBytes = 0;
+    for (auto&& run : partition.runs) {
+        run->openSource();
+        while (run->more()) {
+            auto data = run->next();
+            const size_t oldSize = groups.size();
+            Accumulators& group = groups[data.first];
+            if (groups.size() != oldSize) {
+                memoryUsageBytes += data.first.getApproximateSize();
+                group.reserve(_accumulatedFields.size());
+                for (auto&& accumulatedField : _accumulatedFields) {
+                    group.push_back(accumulatedField.makeAccumulator());
+                }
+            } else {
+                for (auto&& accum : group) {
+                    memoryUsageBytes -= accum->memUsageForSorter();
+                }
+            }
+
+            mergeAccumulators(data.second, group);
+            for (auto&& accum : group) {
+                memoryUsageBytes += accum->memUsageForSorter();
+            }
+
+            if (memoryUsageBytes > maxMemoryUsageBytes) {
+                run->closeSource();
+                return boost::none;
+            }
+        }
+        run->closeSource();
+    }
+    return std::move(groups);
+}
+
+void DocumentSourceGroup::repartitionSpilledPartition(size_t partition) {
+    // References to elements of the deque stay valid as sub-partitions are appended.
+    SpillPartition& source = _spillPartitions[partition];
+    const size_t depth = source.depth + 1;
+    const size_t numSubPartitions =
+        std::max<size_t>(2, std::min(_numSpillPartitions, kMaxSpillRepartitionFanOut));
+
+    std::vector<SpillPartition*> subPartitions;
+    std::vector<std::unique_ptr<SortedFileWriter<Value, Value>>> writers;
+    std::vector<size_t> numGroups(numSubPartitions, 0);
+    for (size_t i = 0; i < numSubPartitions; ++i) {
+        subPartitions.push_back(&addSpillPartition(depth));
+        writers.push_back(std::make_unique<SortedFileWriter<Value, Value>>(
+            SortOptions().TempDir(pExpCtx->tempDir), subPartitions.back()->fileName, 0));
+    }
+
+    const auto& valueComparator = pExpCtx->getValueComparator();
+    for (auto&& run : source.runs) {
+        run->openSource();
+        while (run->more()) {
+            auto data = run->next();
+            const size_t i =
+                partitionForHash(valueComparator.hash(data.first), numSubPartitions, depth);
+            writers[i]->addAlreadySorted(data.first, data.second);
+            ++numGroups[i];
+        }
+        run->closeSource();
+    }
+
+    for (size_t i = 0; i < numSubPartitions; ++i) {
+        if (numGroups[i] == 0) {
+            // A run must not be empty, since it could not be read back.
+            continue;
+        }
+        subPartitions[i]->runs.emplace_back(writers[i]->done());
+        subPartitions[i]->nextOffset = writers[i]->getFileEndOffset();
+    }
+
+    // The groups of 'source' have all been copied, so its file is no longer needed.
+    source.runs.clear();
+    boost::system::error_code ec;
+    boost::filesystem::remove(source.fileName, ec);
+}
+
 void DocumentSourceGroup::doDispose() {
+    // Merge threads refer to this stage, so they must finish before anything is freed.
+    if (_mergePool) {
+        _mergePool->shutdown();
+        _mergePool->join();
+        _mergePool.reset();
+    }
+    _pendingPartitions.clear();
+    _spillPartitions.clear();
+
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
@@ -332,7 +566,8 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
       _spilled(false),
-      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
+      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos),
+      _numSpillPartitions(_allowDiskUse ? internalDocumentSourceGroupSpillPartitions.load() : 0) {
     if (!pExpCtx->inMongos && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
         _fileName = pExpCtx->tempDir + "/" + nextFileName();
@@ -340,9 +575,18 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
 }
 
 DocumentSourceGroup::~DocumentSourceGroup() {
+    if (_mergePool) {
+        _mergePool->shutdown();
+        _mergePool->join();
+    }
+
     if (_ownsFileDeletion) {
         DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
     }
+
+    for (size_t i = 0; i < _numSpillPartitionFiles; ++i) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName + ".part" + std::to_string(i)));
+    }
 }
 
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
@@ -472,7 +716,11 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
+            if (_numSpillPartitions > 0) {
+                spillToPartitions();
+            } else {
+                _sortedFiles.push_back(spill());
+            }
             _memoryUsageBytes = 0;
         }
 
@@ -535,7 +783,34 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (_spilledToPartitions) {
+                if (!_groups->empty()) {
+                    spillToPartitions();
+                }
+
+                // Each partition is re-aggregated in turn into '_groups' as results are returned.
+                _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
+                groupsIterator = _groups->end();
+
+                _numMergeThreads = canMergePartitionsInParallel()
+                    ? std::min<size_t>(internalDocumentSourceGroupSpillMergeThreads.load(),
+                                       _numSpillPartitions)
+                    : 1;
+
+                // The partition being returned and every partition being merged in the background
+                // may be held in memory at once.
+                _partitionMaxMemoryUsageBytes = _numMergeThreads > 1
+                    ? _maxMemoryUsageBytes / (_numMergeThreads + 1)
+                    : _maxMemoryUsageBytes;
+                if (_numMergeThreads > 1) {
+                    ThreadPool::Options options;
+                    options.poolName = "GroupSpillMerge";
+                    options.minThreads = 0;
+                    options.maxThreads = _numMergeThreads;
+                    _mergePool = std::make_unique<ThreadPool>(options);
+                    _mergePool->startup();
+                }
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -621,6 +896,64 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
     return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
 }
 
+void DocumentSourceGroup::spillToPartitions() {
+    _usedDisk = true;
+    _spilledToPartitions = true;
+    if (_spillPartitions.empty()) {
+        for (size_t i = 0; i < _numSpillPartitions; ++i) {
+            addSpillPartition(0);
+        }
+    }
+
+    // Bucket the groups by partition first, so that only one partition file is open for writing at
+    // a time. Unlike spill(), nothing needs to be sorted.
+    const auto& valueComparator = pExpCtx->getValueComparator();
+    vector<vector<const GroupsMap::value_type*>> groupsByPartition(_numSpillPartitions);
+    for (auto&& group : *_groups) {
+        const size_t partition =
+            partitionForHash(valueComparator.hash(group.first), _numSpillPartitions, 0);
+        groupsByPartition[partition].push_back(&group);
+    }
+
+    for (size_t i = 0; i < _numSpillPartitions; ++i) {
+        if (groupsByPartition[i].empty()) {
+            // A run must not be empty, since it could not be read back.
+            continue;
+        }
+
+        auto& partition = _spillPartitions[i];
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), partition.fileName, partition.nextOffset);
+        for (auto&& group : groupsByPartition[i]) {
+            writer.addAlreadySorted(group->first, serializeAccumulators(group->second));
+        }
+        partition.runs.emplace_back(writer.done());
+        partition.nextOffset = writer.getFileEndOffset();
+    }
+
+    _groups->clear();
+}
+
+bool DocumentSourceGroup::canMergePartitionsInParallel() const {
+    static const StringDataSet kParallelMergeableAccumulators{"$addToSet",
+                                                              "$avg",
+                                                              "$first",
+                                                              "$last",
+                                                              "$max",
+                                                              "$mergeObjects",
+                                                              "$min",
+                                                              "$push",
+                                                              "$stdDevPop",
+                                                              "$stdDevSamp",
+                                                              "$sum"};
+    return std::all_of(_accumulatedFields.begin(),
+                       _accumulatedFields.end(),
+                       [](const AccumulationStatement& accumulatedField) {
+                           return kParallelMergeableAccumulators.count(
+                               accumulatedField.makeAccumulator()->getOpName());
+                       });
+}
+
 Value DocumentSourceGroup::computeId(const Document& root) {
     // If only one expression, return result directly
     if (_idExpressions.size() == 1) {
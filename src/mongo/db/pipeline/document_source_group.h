@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -37,6 +38,8 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/transformer_interface.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/future.h"
 
 namespace mongo {
 
@@ -182,6 +185,16 @@ protected:
     void doDispose() final;
 
 private:
+    // A hash partition of the spilled groups. Each spill appends at most one run to each partition
+    // file. A partition which is too large to be re-aggregated in memory is split into
+    // sub-partitions of the next 'depth'.
+    struct SpillPartition {
+        std::string fileName;
+        std::streampos nextOffset = 0;
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+        size_t depth = 0;
+    };
+
     explicit DocumentSourceGroup(const boost::intrusive_ptr<ExpressionContext>& pExpCtx,
                                  boost::optional<size_t> maxMemoryUsageBytes = boost::none);
 
@@ -194,6 +207,7 @@ private:
      */
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
+    GetNextResult getNextPartitioned();
 
     /**
      * Before returning anything, this source must prepare itself. In a streaming $group,
@@ -214,6 +228,48 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * Alternative to spill() used when hash-partitioned spilling is enabled. Writes each group in
+     * the groups map, unsorted, to the spill partition selected by the hash of its _id.
+     */
+    void spillToPartitions();
+
+    /**
+     * Appends a new, empty spill partition of the given depth and returns it.
+     */
+    SpillPartition& addSpillPartition(size_t depth);
+
+    /**
+     * Reads every group spilled to 'partition' and re-aggregates them into a new groups map.
+     * Returns boost::none, without reading the rest of the partition, as soon as the map uses more
+     * than 'maxMemoryUsageBytes'. Only reads state which is immutable once initialization is
+     * complete, so may be called concurrently for different partitions.
+     */
+    boost::optional<GroupsMap> mergeSpilledPartition(const SpillPartition& partition,
+                                                     size_t maxMemoryUsageBytes) const;
+
+    /**
+     * Splits the spill partition at index 'partition', which was too large to be re-aggregated in
+     * memory, into new partitions by a different hash of each group's _id. Groups are copied from
+     * one file to the other without being aggregated, so this does not depend on their size.
+     */
+    void repartitionSpilledPartition(size_t partition);
+
+    /**
+     * Replaces the contents of '_groups' with the next re-aggregated spill partition, scheduling
+     * further partitions to be merged in the background if there are merge threads. Partitions
+     * which exceed their share of the memory limit are split and merged later. Returns false if
+     * there are no partitions left.
+     */
+    bool loadNextPartition();
+
+    /**
+     * Returns true if every accumulator can merge partial results without touching state shared
+     * with other accumulators, such as a JavaScript scope, so that partitions can be merged on
+     * separate threads.
+     */
+    bool canMergePartitionsInParallel() const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -266,6 +322,29 @@ private:
     const bool _allowDiskUse;
 
     std::pair<Value, Value> _firstPartOfNextGroup;
+
+    // The number of partitions to spill to when hash-partitioned spilling is enabled, or zero if
+    // spilled groups are sorted instead.
+    const size_t _numSpillPartitions;
+
+    // A deque, so that partitions being merged on other threads are not moved when partitions are
+    // split and new ones appended. '_numSpillPartitionFiles' counts every partition file created,
+    // including those of partitions which have since been disposed of.
+    std::deque<SpillPartition> _spillPartitions;
+    size_t _numSpillPartitionFiles = 0;
+    bool _spilledToPartitions = false;
+
+    // Only used when '_spilledToPartitions' is true. Partitions are merged on '_mergePool' if it
+    // exists, and inline otherwise. '_pendingPartitions' holds the index and result of partitions
+    // which have been scheduled but not yet returned, in partition order.
+    //
+    // Each merged partition may use '_partitionMaxMemoryUsageBytes', a share of the memory limit
+    // such that all the partitions which can be held at once stay within the limit.
+    std::unique_ptr<ThreadPool> _mergePool;
+    size_t _numMergeThreads = 0;
+    size_t _partitionMaxMemoryUsageBytes = 0;
+    std::deque<std::pair<size_t, Future<boost::optional<GroupsMap>>>> _pendingPartitions;
+    size_t _nextPartitionToSchedule = 0;
 };
 
 }  // namespace mongo
@@ -29,6 +29,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
 #include <boost/intrusive_ptr.hpp>
 #include <deque>
 #include <map>
@@ -49,11 +51,13 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -147,6 +151,87 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+/**
+ * Groups 100 keys with a memory limit which forces them to be spilled to hash partitions, checks
+ * the results, and returns the number of spill partition files which were created.
+ */
+size_t assertPartitionedSpillProducesCorrectGroups(const intrusive_ptr<ExpressionContext>& expCtx,
+                                                   int numPartitions,
+                                                   int numMergeThreads) {
+    const auto oldPartitions = internalDocumentSourceGroupSpillPartitions.load();
+    const auto oldThreads = internalDocumentSourceGroupSpillMergeThreads.load();
+    internalDocumentSourceGroupSpillPartitions.store(numPartitions);
+    internalDocumentSourceGroupSpillMergeThreads.store(numMergeThreads);
+    ON_BLOCK_EXIT([&] {
+        internalDocumentSourceGroupSpillPartitions.store(oldPartitions);
+        internalDocumentSourceGroupSpillMergeThreads.store(oldThreads);
+    });
+
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+    const size_t maxMemoryUsageBytes = 1000;
+
+    auto&& parser = AccumulationStatement::getParser("$sum");
+    auto accumulatorArg = BSON(""
+                               << "$n");
+    auto [expression, factory] =
+        parser(expCtx, accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement sumStatement{"total", expression, factory};
+    auto groupByExpression =
+        ExpressionFieldPath::parse(expCtx, "$key", expCtx->variablesParseState);
+    auto group =
+        DocumentSourceGroup::create(expCtx, groupByExpression, {sumStatement}, maxMemoryUsageBytes);
+
+    // Each key appears once in every round, so each key is spilled several times over.
+    const int numKeys = 100;
+    const int numRounds = 5;
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int round = 0; round < numRounds; ++round) {
+        for (int key = 0; key < numKeys; ++key) {
+            inputs.emplace_back(Document{{"key", key}, {"n", round + 1}});
+        }
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    map<int, long long> totals;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_TRUE(totals.emplace(doc["_id"].coerceToInt(), doc["total"].coerceToLong()).second);
+    }
+    ASSERT_TRUE(group->usedDisk());
+
+    ASSERT_EQ(totals.size(), static_cast<size_t>(numKeys));
+    for (auto&& [key, total] : totals) {
+        ASSERT_EQ(total, numRounds * (numRounds + 1) / 2) << "key: " << key;
+    }
+
+    return std::count_if(boost::filesystem::directory_iterator(tempDir.path()),
+                         boost::filesystem::directory_iterator(),
+                         [](const boost::filesystem::directory_entry& entry) {
+                             return entry.path().string().find(".part") != std::string::npos;
+                         });
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldMergeHashPartitionedSpillsSerially) {
+    assertPartitionedSpillProducesCorrectGroups(getExpCtx(), 4, 1);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldMergeHashPartitionedSpillsInParallel) {
+    assertPartitionedSpillProducesCorrectGroups(getExpCtx(), 4, 4);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSplitSpillPartitionWhichExceedsMemoryLimit) {
+    // All 100 groups are spilled to a single partition, which is too large to be merged within the
+    // memory limit, so it is split into more partitions.
+    ASSERT_GT(assertPartitionedSpillProducesCorrectGroups(getExpCtx(), 1, 1), 1U);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSplitSpillPartitionsWhichExceedMemoryLimitInParallel) {
+    ASSERT_GT(assertPartitionedSpillProducesCorrectGroups(getExpCtx(), 2, 4), 2U);
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
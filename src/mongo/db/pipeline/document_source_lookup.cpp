@@ -31,6 +31,7 @@
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/base/init.h"
@@ -38,6 +39,7 @@
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/path.h"
 #include "mongo/db/pipeline/document_path_support.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
@@ -266,22 +268,13 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
-        auto matchStage =
-            makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
-        // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-        _resolvedPipeline.back() = matchStage;
-    }
-
-    auto pipeline = buildPipeline(inputDoc);
-
     std::vector<Value> results;
     long long objsize = 0;
     const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
 
-    while (auto result = pipeline->getNext()) {
+    auto appendResult = [&](Document&& result) {
         long long safeSum = 0;
-        bool hasOverflowed = overflow::add(objsize, result->getApproximateSize(), &safeSum);
+        bool hasOverflowed = overflow::add(objsize, result.getApproximateSize(), &safeSum);
         uassert(4568,
                 str::stream() << "Total size of documents in " << _fromNs.coll()
                               << " matching pipeline's $lookup stage exceeds " << maxBytes
@@ -289,15 +282,150 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
 
                 !hasOverflowed && objsize <= maxBytes);
         objsize = safeSum;
-        results.emplace_back(std::move(*result));
+        results.emplace_back(std::move(result));
+    };
+
+    if (auto matches = probeHashJoinTable(inputDoc)) {
+        for (auto&& match : *matches) {
+            appendResult(std::move(match));
+        }
+    } else {
+        if (!wasConstructedWithPipelineSyntax()) {
+            auto matchStage = makeMatchStageFromInput(
+                inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
+            _resolvedPipeline.back() = matchStage;
+        }
+
+        auto pipeline = buildPipeline(inputDoc);
+
+        while (auto result = pipeline->getNext()) {
+            appendResult(std::move(*result));
+        }
+        _usedDisk = _usedDisk || pipeline->usedDisk();
     }
-    _usedDisk = _usedDisk || pipeline->usedDisk();
 
     MutableDocument output(std::move(inputDoc));
     output.setNestedField(_as, Value(std::move(results)));
     return output.freeze();
 }
 
+bool DocumentSourceLookUp::canUseHashJoin() const {
+    return !wasConstructedWithPipelineSyntax() && internalLookupStageHashJoinEnabled.load();
+}
+
+void DocumentSourceLookUp::buildHashJoinTable() {
+    invariant(_hashJoinState == HashJoinState::kUninitialized);
+    if (!canUseHashJoin()) {
+        _hashJoinState = HashJoinState::kAbandoned;
+        return;
+    }
+
+    // Only attempt the build when the foreign collection is known to fit within the memory limit,
+    // so that a large collection is never partially scanned only to abandon the hash table.
+    const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    const auto foreignDataSize =
+        pExpCtx->mongoProcessInterface->getCollectionDataSize(pExpCtx->opCtx, _resolvedNs);
+    if (!foreignDataSize || *foreignDataSize > maxBytes) {
+        _hashJoinState = HashJoinState::kAbandoned;
+        return;
+    }
+
+    // The build side is the foreign collection filtered only by the uncorrelated predicates which
+    // this stage may have absorbed from a subsequent $match.
+    _resolvedPipeline.back() = BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+
+    // Index each foreign document under every element an {$eq: <value>} predicate on
+    // 'foreignField' would examine, so that a probe finds exactly the documents the per-document
+    // sub-pipeline would have returned.
+    const ElementPath foreignPath(_foreignField->fullPath(),
+                                  ElementPath::LeafArrayBehavior::kTraverse,
+                                  ElementPath::NonLeafArrayBehavior::kTraverse);
+    long long buildBytes = 0;
+
+    _hashJoinTable.emplace(
+        _fromExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>());
+
+    while (auto next = pipeline->getNext()) {
+        buildBytes += next->getApproximateSize();
+        if (buildBytes > maxBytes) {
+            // The foreign collection is too large to hold in memory. Revert to a sub-pipeline per
+            // input document, which only ever holds the documents matching that input.
+            _usedDisk = _usedDisk || pipeline->usedDisk();
+            _hashJoinTable.reset();
+            _hashJoinBuildDocs.clear();
+            _hashJoinBuildDocs.shrink_to_fit();
+            _hashJoinState = HashJoinState::kAbandoned;
+            return;
+        }
+
+        const size_t docIndex = _hashJoinBuildDocs.size();
+        const BSONObj foreignObj = next->toBson();
+        BSONElementIterator it(&foreignPath, foreignObj);
+        while (it.more()) {
+            auto elem = it.next().element();
+            if (elem.eoo()) {
+                continue;
+            }
+            auto& bucket = (*_hashJoinTable)[Value(elem)];
+            // A document may reach the same value more than once, e.g. through repeated array
+            // elements. Since documents are indexed in order, any repeat is at the bucket's end.
+            if (bucket.empty() || bucket.back() != docIndex) {
+                bucket.push_back(docIndex);
+            }
+        }
+        _hashJoinBuildDocs.emplace_back(std::move(*next));
+    }
+
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+    _hashJoinState = HashJoinState::kActive;
+}
+
+boost::optional<std::vector<Document>> DocumentSourceLookUp::probeHashJoinTable(
+    const Document& input) {
+    if (_hashJoinState == HashJoinState::kUninitialized) {
+        buildHashJoinTable();
+    }
+    if (_hashJoinState != HashJoinState::kActive) {
+        return boost::none;
+    }
+
+    std::vector<size_t> matchingIndexes;
+    bool canProbe = true;
+    bool foundLocalValue = false;
+    document_path_support::visitAllValuesAtPath(input, *_localField, [&](const Value& localValue) {
+        foundLocalValue = true;
+        // An equality to null also matches documents missing 'foreignField', and a regular
+        // expression is compared by pattern rather than by hash. Leave these to the sub-pipeline.
+        if (!canProbe || localValue.nullish() || localValue.getType() == BSONType::RegEx) {
+            canProbe = false;
+            return;
+        }
+        auto it = _hashJoinTable->find(localValue);
+        if (it != _hashJoinTable->end()) {
+            matchingIndexes.insert(matchingIndexes.end(), it->second.begin(), it->second.end());
+        }
+    });
+
+    if (!canProbe || !foundLocalValue) {
+        return boost::none;
+    }
+
+    // A foreign document may match several local values. Return each match once, in the order in
+    // which the foreign collection produced it.
+    std::sort(matchingIndexes.begin(), matchingIndexes.end());
+    matchingIndexes.erase(std::unique(matchingIndexes.begin(), matchingIndexes.end()),
+                          matchingIndexes.end());
+
+    std::vector<Document> matches;
+    matches.reserve(matchingIndexes.size());
+    for (auto index : matchingIndexes) {
+        matches.push_back(_hashJoinBuildDocs[index]);
+    }
+    return matches;
+}
+
 std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     const Document& inputDoc) {
     // Copy all 'let' variables into the foreign pipeline's expression context.
@@ -496,6 +624,12 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashJoinMatches.reset();
+    _hashJoinTable.reset();
+    _hashJoinBuildDocs.clear();
+    if (_hashJoinState == HashJoinState::kActive) {
+        _hashJoinState = HashJoinState::kAbandoned;
+    }
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -588,7 +722,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     // Loop until we get a document that has at least one match.
     // Note we may return early from this loop if our source stage is exhausted or if the unwind
     // source was asked to return empty arrays and we get a document without a match.
-    while (!_pipeline || !_nextValue) {
+    while ((!_pipeline && !_hashJoinMatches) || !_nextValue) {
         auto nextInput = pSource->getNext();
         if (!nextInput.isAdvanced()) {
             return nextInput;
@@ -596,28 +730,35 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
-            BSONObj filter = _additionalFilter.value_or(BSONObj());
-            auto matchStage =
-                makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
-            // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
-            _resolvedPipeline.back() = matchStage;
-        }
-
         if (_pipeline) {
             _usedDisk = _usedDisk || _pipeline->usedDisk();
             _pipeline->dispose(pExpCtx->opCtx);
+            _pipeline.reset();
         }
 
-        _pipeline = buildPipeline(*_input);
+        _hashJoinMatches = probeHashJoinTable(*_input);
+        _hashJoinMatchPos = 0;
+
+        if (!_hashJoinMatches) {
+            if (!wasConstructedWithPipelineSyntax()) {
+                BSONObj filter = _additionalFilter.value_or(BSONObj());
+                auto matchStage = makeMatchStageFromInput(
+                    *_input, *_localField, _foreignField->fullPath(), filter);
+                // We've already allocated space for the trailing $match stage in
+                // '_resolvedPipeline'.
+                _resolvedPipeline.back() = matchStage;
+            }
+
+            _pipeline = buildPipeline(*_input);
 
-        // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
-        // potentially be used by multiple OperationContexts, and the $lookup stage is part of an
-        // outer Pipeline that will propagate dispose() calls before being destroyed.
-        _pipeline.get_deleter().dismissDisposal();
+            // The $lookup stage takes responsibility for disposing of its Pipeline, since it will
+            // potentially be used by multiple OperationContexts, and the $lookup stage is part of
+            // an outer Pipeline that will propagate dispose() calls before being destroyed.
+            _pipeline.get_deleter().dismissDisposal();
+        }
 
         _cursorIndex = 0;
-        _nextValue = _pipeline->getNext();
+        _nextValue = getNextUnwindMatch();
 
         if (_unwindSrc->preserveNullAndEmptyArrays() && !_nextValue) {
             // There were no results for this cursor, but the $unwind was asked to preserve empty
@@ -635,7 +776,7 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
     invariant(bool(_input) && bool(_nextValue));
     auto currentValue = *_nextValue;
-    _nextValue = _pipeline->getNext();
+    _nextValue = getNextUnwindMatch();
 
     // Move input document into output if this is the last or only result, otherwise perform a copy.
     MutableDocument output(_nextValue ? *_input : std::move(*_input));
@@ -649,6 +790,16 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
     return output.freeze();
 }
 
+boost::optional<Document> DocumentSourceLookUp::getNextUnwindMatch() {
+    if (_hashJoinMatches) {
+        if (_hashJoinMatchPos < _hashJoinMatches->size()) {
+            return (*_hashJoinMatches)[_hashJoinMatchPos++];
+        }
+        return boost::none;
+    }
+    return _pipeline->getNext();
+}
+
 void DocumentSourceLookUp::copyVariablesToExpCtx(const Variables& vars,
                                                  const VariablesParseState& vps,
                                                  ExpressionContext* expCtx) {
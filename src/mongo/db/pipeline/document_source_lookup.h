@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <vector>
 
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -239,6 +240,36 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Returns the next foreign document to unwind for the current input document, drawn either
+     * from the hash join matches or from the per-document sub-pipeline.
+     */
+    boost::optional<Document> getNextUnwindMatch();
+
+    /**
+     * Returns true if this $lookup is eligible to execute as a hash join, i.e. it uses the
+     * localField/foreignField syntax and hash joins are enabled.
+     */
+    bool canUseHashJoin() const;
+
+    /**
+     * Reads the foreign collection once, applying any absorbed $match, and builds a hash table
+     * mapping each value reachable at 'foreignField' to the documents which hold it. Abandons the
+     * hash join if the foreign documents exceed the
+     * internalLookupStageIntermediateDocumentMaxSizeBytes limit, in which case every input document
+     * falls back to running its own sub-pipeline.
+     */
+    void buildHashJoinTable();
+
+    /**
+     * Returns the foreign documents joining with 'input' using the hash table, in the order in
+     * which they were read from the foreign collection. Returns boost::none if the hash join is not
+     * in use or if 'input' joins on values whose query semantics the hash table does not model
+     * (null, missing, undefined or regular expressions), in which case the caller must run the
+     * sub-pipeline instead.
+     */
+    boost::optional<std::vector<Document>> probeHashJoinTable(const Document& input);
+
     /**
      * Copies 'vars' and 'vps' to the Variables and VariablesParseState objects in 'expCtx'. These
      * copies provide access to 'let' defined variables in sub-pipeline execution.
@@ -321,6 +352,18 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    // State for executing a localField/foreignField $lookup as a hash join. The table is built
+    // lazily upon receiving the first input document, and maps each value at 'foreignField' to the
+    // indexes in '_hashJoinBuildDocs' of the documents holding it.
+    enum class HashJoinState { kUninitialized, kActive, kAbandoned };
+    HashJoinState _hashJoinState = HashJoinState::kUninitialized;
+    std::vector<Document> _hashJoinBuildDocs;
+    boost::optional<ValueUnorderedMap<std::vector<size_t>>> _hashJoinTable;
+
+    // When unwinding a hash join, the matches for '_input' and the position of '_nextValue'.
+    boost::optional<std::vector<Document>> _hashJoinMatches;
+    size_t _hashJoinMatchPos = 0;
 };
 
 }  // namespace mongo
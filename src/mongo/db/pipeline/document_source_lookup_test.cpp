@@ -48,6 +48,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -509,12 +510,28 @@ public:
         }
 
         pipeline->addInitialSource(DocumentSourceMock::createForTest(_mockResults));
+        ++_numPipelinesAttached;
         return pipeline;
     }
 
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const final {
+        return _collectionDataSize;
+    }
+
+    int numPipelinesAttached() const {
+        return _numPipelinesAttached;
+    }
+
+    void setCollectionDataSize(boost::optional<long long> dataSize) {
+        _collectionDataSize = dataSize;
+    }
+
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    int _numPipelinesAttached = 0;
+    boost::optional<long long> _collectionDataSize = 0LL;
 };
 
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
@@ -623,6 +640,193 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldJoinAgainstHashTableWhenHashJoinEnabled) {
+    const bool originalHashJoinEnabled = internalLookupStageHashJoinEnabled.load();
+    internalLookupStageHashJoinEnabled.store(true);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinEnabled.store(originalHashJoinEnabled); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    // Mock out the foreign collection, including array values and a document missing the field.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}, {"key", 1}},
+        Document{{"_id", 1}, {"key", vector<Value>{Value(1), Value(2), Value(1)}}},
+        Document{{"_id", 2}, {"key", 3LL}},
+        Document{{"_id", 3}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {Document{{"local", 1}},
+         Document{{"local", vector<Value>{Value(2.0), Value(3)}}},
+         Document{{"local", 4}},
+         Document{{"local", BSONNULL}}});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    auto joinedIds = [](const Document& doc) {
+        std::vector<int> ids;
+        for (auto&& joined : doc["joined"].getArray()) {
+            ids.push_back(joined["_id"].getInt());
+        }
+        return ids;
+    };
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    auto ids = joinedIds(next.releaseDocument());
+    ASSERT_EQ(ids.size(), 2U);
+    ASSERT_EQ(ids[0], 0);
+    ASSERT_EQ(ids[1], 1);
+
+    // Numeric values of different types join with one another, and each foreign document is
+    // returned once even if it matches several local values.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ids = joinedIds(next.releaseDocument());
+    ASSERT_EQ(ids.size(), 2U);
+    ASSERT_EQ(ids[0], 1);
+    ASSERT_EQ(ids[1], 2);
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_EQ(joinedIds(next.releaseDocument()).size(), 0U);
+
+    // The foreign collection was only read once to build the hash table.
+    ASSERT_EQ(mongoInterface->numPipelinesAttached(), 1);
+
+    // A null local value also matches foreign documents which lack the field, so it is joined using
+    // a sub-pipeline.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ids = joinedIds(next.releaseDocument());
+    ASSERT_EQ(ids.size(), 1U);
+    ASSERT_EQ(ids[0], 3);
+    ASSERT_EQ(mongoInterface->numPipelinesAttached(), 2);
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUnwindHashJoinResults) {
+    const bool originalHashJoinEnabled = internalLookupStageHashJoinEnabled.load();
+    internalLookupStageHashJoinEnabled.store(true);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinEnabled.store(originalHashJoinEnabled); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}, {"key", 1}},
+                                                             Document{{"_id", 1}, {"key", 1}}};
+    auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    const bool preserveNullAndEmptyArrays = true;
+    const boost::optional<std::string> includeArrayIndex = std::string("idx");
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "joined", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"local", 1}}, Document{{"local", 2}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"local", 1}, {"joined", Document{{"_id", 0}, {"key", 1}}}, {"idx", 0LL}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"local", 1}, {"joined", Document{{"_id", 1}, {"key", 1}}}, {"idx", 1LL}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"local", 2}, {"idx", BSONNULL}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT_EQ(mongoInterface->numPipelinesAttached(), 1);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotBuildHashTableWhenForeignCollectionMayNotFit) {
+    const bool originalHashJoinEnabled = internalLookupStageHashJoinEnabled.load();
+    internalLookupStageHashJoinEnabled.store(true);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinEnabled.store(originalHashJoinEnabled); });
+
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "local"_sd},
+                                         {"foreignField", "key"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+
+    // Neither a foreign collection larger than the memory limit nor one whose size is unknown is
+    // scanned to build a hash table; each input document runs its own sub-pipeline instead.
+    const std::vector<boost::optional<long long>> foreignDataSizes{
+        internalLookupStageIntermediateDocumentMaxSizeBytes.load() + 1, boost::none};
+    for (auto&& foreignDataSize : foreignDataSizes) {
+        deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}, {"key", 1}},
+                                                                 Document{{"_id", 1}, {"key", 2}}};
+        auto mongoInterface = std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+        mongoInterface->setCollectionDataSize(foreignDataSize);
+        expCtx->mongoProcessInterface = mongoInterface;
+
+        auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+        auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+        auto mockLocalSource =
+            DocumentSourceMock::createForTest({Document{{"local", 1}}, Document{{"local", 2}}});
+        lookup->setSource(mockLocalSource.get());
+
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(
+            next.releaseDocument(),
+            (Document{{"local", 1},
+                      {"joined", vector<Value>{Value(Document{{"_id", 0}, {"key", 1}})}}}));
+
+        next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(
+            next.releaseDocument(),
+            (Document{{"local", 2},
+                      {"joined", vector<Value>{Value(Document{{"_id", 1}, {"key", 2}})}}}));
+
+        ASSERT_TRUE(lookup->getNext().isEOF());
+        ASSERT_EQ(mongoInterface->numPipelinesAttached(), 2);
+        lookup->dispose();
+    }
+}
+
 TEST_F(DocumentSourceLookUpTest, LookupReportsAsFieldIsModified) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
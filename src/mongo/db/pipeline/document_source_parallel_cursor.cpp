@@ -0,0 +1,295 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_cursor.h"
+
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/service_context.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+boost::intrusive_ptr<DocumentSourceParallelCursor> DocumentSourceParallelCursor::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    NamespaceString nss,
+    UUID uuid,
+    BSONObj query,
+    std::vector<BSONObj> workerPipeline,
+    std::vector<RecordIdRange> ranges) {
+    return new DocumentSourceParallelCursor(expCtx,
+                                            std::move(nss),
+                                            std::move(uuid),
+                                            std::move(query),
+                                            std::move(workerPipeline),
+                                            std::move(ranges));
+}
+
+DocumentSourceParallelCursor::DocumentSourceParallelCursor(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    NamespaceString nss,
+    UUID uuid,
+    BSONObj query,
+    std::vector<BSONObj> workerPipeline,
+    std::vector<RecordIdRange> ranges)
+    : DocumentSource(kStageName, expCtx),
+      _nss(std::move(nss)),
+      _uuid(std::move(uuid)),
+      _query(query.getOwned()),
+      _workerPipeline(std::move(workerPipeline)),
+      _ranges(std::move(ranges)) {
+    invariant(!_ranges.empty());
+}
+
+DocumentSourceParallelCursor::~DocumentSourceParallelCursor() {
+    stopWorkers();
+}
+
+Value DocumentSourceParallelCursor::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    std::vector<Value> workerPipeline(_workerPipeline.begin(), _workerPipeline.end());
+    return Value(Document{{kStageName,
+                           Document{{"query", _query},
+                                    {"pipeline", std::move(workerPipeline)},
+                                    {"numWorkers", static_cast<long long>(_ranges.size())}}}});
+}
+
+bool DocumentSourceParallelCursor::usedDisk() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _usedDisk;
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelCursor::doGetNext() {
+    if (!_workerPool && !_stopping) {
+        startWorkers();
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    pExpCtx->opCtx->waitForConditionOrInterrupt(_stateChanged, lk, [&] {
+        return !_buffer.empty() || !_workerStatus.isOK() || _stopping ||
+            _numFinishedWorkers == _ranges.size();
+    });
+    uassertStatusOK(_workerStatus);
+
+    if (_buffer.empty()) {
+        return GetNextResult::makeEOF();
+    }
+
+    auto doc = std::move(_buffer.front());
+    _buffer.pop_front();
+    if (_buffer.size() == kMaxBufferedDocuments - 1) {
+        // A worker may be waiting for space to become available.
+        _stateChanged.notify_all();
+    }
+    return doc;
+}
+
+void DocumentSourceParallelCursor::doDispose() {
+    stopWorkers();
+}
+
+void DocumentSourceParallelCursor::startWorkers() {
+    invariant(!_workerPool);
+
+    // Each worker runs its own copy of the worker pipeline. Its accumulators must produce partial
+    // results for the merging stage which follows this one, exactly as if it were running on a
+    // shard.
+    for (size_t i = 0; i < _ranges.size(); ++i) {
+        auto workerExpCtx = pExpCtx->copyWith(_nss, _uuid);
+        workerExpCtx->needsMerge = true;
+        _workerExpCtxs.push_back(std::move(workerExpCtx));
+    }
+    _workerOpCtxs.assign(_ranges.size(), nullptr);
+    _deadline = pExpCtx->opCtx->getDeadline();
+    _timeoutError = pExpCtx->opCtx->getTimeoutError();
+
+    ThreadPool::Options options;
+    options.poolName = "ParallelCollectionScan";
+    options.minThreads = 0;
+    options.maxThreads = _ranges.size();
+    options.onCreateThread = [](const std::string& threadName) {
+        Client::initThread(threadName);
+    };
+    _workerPool = std::make_unique<ThreadPool>(options);
+    _workerPool->startup();
+
+    for (size_t i = 0; i < _ranges.size(); ++i) {
+        _workerPool->schedule([this, i](Status status) {
+            if (!status.isOK()) {
+                stdx::lock_guard<Latch> lk(_mutex);
+                if (_workerStatus.isOK()) {
+                    _workerStatus = status;
+                }
+                ++_numFinishedWorkers;
+                _stateChanged.notify_all();
+                return;
+            }
+            runWorker(i);
+        });
+    }
+}
+
+void DocumentSourceParallelCursor::stopWorkers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopping = true;
+        _buffer.clear();
+
+        // Interrupt any worker blocked in the storage engine or in the worker pipeline. The
+        // remaining workers notice '_stopping' when they next hand over a document.
+        for (auto workerOpCtx : _workerOpCtxs) {
+            if (workerOpCtx) {
+                stdx::lock_guard<Client> clientLock(*workerOpCtx->getClient());
+                workerOpCtx->getServiceContext()->killOperation(
+                    clientLock, workerOpCtx, ErrorCodes::Interrupted);
+            }
+        }
+        _stateChanged.notify_all();
+    }
+
+    if (_workerPool) {
+        _workerPool->shutdown();
+        _workerPool->join();
+        _workerPool.reset();
+    }
+}
+
+void DocumentSourceParallelCursor::runWorker(size_t workerIndex) {
+    Status status = Status::OK();
+    try {
+        scanRange(workerIndex);
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!status.isOK() && !_stopping && _workerStatus.isOK()) {
+        _workerStatus = status.withContext("Parallel collection scan worker failed");
+    }
+    ++_numFinishedWorkers;
+    _stateChanged.notify_all();
+}
+
+void DocumentSourceParallelCursor::scanRange(size_t workerIndex) {
+    auto opCtxHolder = cc().makeOperationContext();
+    auto opCtx = opCtxHolder.get();
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_stopping) {
+            return;
+        }
+        _workerOpCtxs[workerIndex] = opCtx;
+    }
+    ON_BLOCK_EXIT([&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _workerOpCtxs[workerIndex] = nullptr;
+    });
+
+    if (_deadline != Date_t::max()) {
+        opCtx->setDeadlineByDate(_deadline, _timeoutError);
+    }
+
+    const auto& expCtx = _workerExpCtxs[workerIndex];
+    expCtx->opCtx = opCtx;
+    auto pipeline = uassertStatusOK(Pipeline::parse(_workerPipeline, expCtx));
+
+    {
+        // Build the range-restricted collection scan under the collection lock, as PipelineD does
+        // for the serial case. The $cursor stage reacquires the lock for each batch it reads.
+        AutoGetCollectionForRead autoColl(opCtx,
+                                          NamespaceStringOrUUID(_nss.db().toString(), _uuid));
+        auto collection = autoColl.getCollection();
+        uassert(ErrorCodes::QueryPlanKilled,
+                str::stream() << "Collection " << _nss
+                              << " was dropped during a parallel collection scan",
+                collection);
+
+        const auto& range = _ranges[workerIndex];
+        auto qr = std::make_unique<QueryRequest>(autoColl.getNss());
+        qr->setFilter(_query);
+        qr->setHint(BSON("$natural" << 1));
+        qr->setCollation(expCtx->getCollatorBSON());
+        qr->setRecordIdRange(range.first, range.second);
+
+        const ExtensionsCallbackReal extensionsCallback(opCtx, &autoColl.getNss());
+        auto cq = uassertStatusOK(
+            CanonicalQuery::canonicalize(opCtx,
+                                         std::move(qr),
+                                         expCtx,
+                                         extensionsCallback,
+                                         Pipeline::kAllowedMatcherFeatures,
+                                         ProjectionPolicies::aggregateProjectionPolicies()));
+
+        const bool permitYield = true;
+        auto exec = uassertStatusOK(getExecutorFind(
+            opCtx, collection, std::move(cq), permitYield, QueryPlannerParams::DEFAULT));
+        pipeline->addInitialSource(
+            DocumentSourceCursor::create(collection, std::move(exec), expCtx));
+    }
+
+    while (auto next = pipeline->getNext()) {
+        if (!pushDocument(opCtx, std::move(*next))) {
+            return;
+        }
+    }
+
+    if (pipeline->usedDisk()) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _usedDisk = true;
+    }
+}
+
+bool DocumentSourceParallelCursor::pushDocument(OperationContext* opCtx, Document doc) {
+    stdx::unique_lock<Latch> lk(_mutex);
+    opCtx->waitForConditionOrInterrupt(_stateChanged, lk, [&] {
+        return _stopping || _buffer.size() < kMaxBufferedDocuments;
+    });
+    if (_stopping) {
+        return false;
+    }
+
+    _buffer.push_back(std::move(doc));
+    if (_buffer.size() == 1) {
+        // The consumer may be waiting for a document.
+        _stateChanged.notify_all();
+    }
+    return true;
+}
+
+}  // namespace mongo
@@ -0,0 +1,185 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+
+/**
+ * Produces the input of a pipeline by scanning a collection on several threads at once. The
+ * collection is divided into disjoint RecordId ranges, and each range is read by a worker thread
+ * with its own Client and OperationContext. Every worker applies 'query' during its collection
+ * scan, then runs the partial pipeline 'workerPipeline' over the results; the documents output by
+ * the workers are gathered into a single stream in no particular order.
+ *
+ * The worker pipeline is typically a prefix of streaming stages ending in the shard-side half of
+ * a $group, in which case this stage must be followed by the merging half of that $group.
+ *
+ * The workers do not share a storage snapshot: each reads its range as of its own, like a serial
+ * collection scan which yields between ranges would.
+ */
+class DocumentSourceParallelCursor final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$parallelCursor"_sd;
+
+    using RecordIdRange = std::pair<RecordId, RecordId>;
+
+    /**
+     * Creates a stage which scans the collection 'nss' with UUID 'uuid', assigning each inclusive
+     * range in 'ranges' to its own worker.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelCursor> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        NamespaceString nss,
+        UUID uuid,
+        BSONObj query,
+        std::vector<BSONObj> workerPipeline,
+        std::vector<RecordIdRange> ranges);
+
+    ~DocumentSourceParallelCursor();
+
+    const char* getSourceName() const final {
+        return kStageName.rawData();
+    }
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kWritesTmpData,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed,
+                                     LookupRequirement::kNotAllowed,
+                                     UnionRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+    bool usedDisk() final;
+
+    size_t numWorkers() const {
+        return _ranges.size();
+    }
+
+    /**
+     * Returns the plan summary reported for the aggregation in the logs and the profiler.
+     */
+    std::string getPlanSummaryStr() const {
+        return "PARALLEL_COLLSCAN";
+    }
+
+protected:
+    GetNextResult doGetNext() final;
+
+    void doDispose() final;
+
+private:
+    // The maximum number of documents produced by the workers which may await the consumer.
+    static constexpr size_t kMaxBufferedDocuments = 1024;
+
+    DocumentSourceParallelCursor(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                 NamespaceString nss,
+                                 UUID uuid,
+                                 BSONObj query,
+                                 std::vector<BSONObj> workerPipeline,
+                                 std::vector<RecordIdRange> ranges);
+
+    /**
+     * Starts one worker per RecordId range. Called upon the first request for a document.
+     */
+    void startWorkers();
+
+    /**
+     * Interrupts the workers and waits for them to exit. Safe to call more than once.
+     */
+    void stopWorkers();
+
+    /**
+     * Entry point of a worker thread. Records any error encountered by the worker.
+     */
+    void runWorker(size_t workerIndex);
+
+    /**
+     * Scans the RecordId range with index 'workerIndex' and passes the output of the worker
+     * pipeline to the consumer.
+     */
+    void scanRange(size_t workerIndex);
+
+    /**
+     * Hands 'doc' to the consumer, waiting for buffer space if necessary. Returns false if the
+     * stage is being torn down and the worker should stop.
+     */
+    bool pushDocument(OperationContext* opCtx, Document doc);
+
+    const NamespaceString _nss;
+    const UUID _uuid;
+    const BSONObj _query;
+    const std::vector<BSONObj> _workerPipeline;
+    const std::vector<RecordIdRange> _ranges;
+
+    // One ExpressionContext per worker, copied from the parent's when the workers start. The
+    // workers also inherit the parent operation's deadline.
+    std::vector<boost::intrusive_ptr<ExpressionContext>> _workerExpCtxs;
+    Date_t _deadline = Date_t::max();
+    ErrorCodes::Error _timeoutError = ErrorCodes::ExceededTimeLimit;
+    std::unique_ptr<ThreadPool> _workerPool;
+
+    // Protects the members below, which are shared between the consumer and the workers.
+    Mutex _mutex = MONGO_MAKE_LATCH("DocumentSourceParallelCursor::_mutex");
+    stdx::condition_variable _stateChanged;
+    std::deque<Document> _buffer;
+    std::vector<OperationContext*> _workerOpCtxs;
+    Status _workerStatus = Status::OK();
+    size_t _numFinishedWorkers = 0;
+    bool _usedDisk = false;
+    bool _stopping = false;
+};
+
+}  // namespace mongo
@@ -31,6 +31,8 @@
 
 #include "mongo/db/pipeline/document_source_plan_cache_stats.h"
 
+#include <algorithm>
+
 namespace mongo {
 
 REGISTER_DOCUMENT_SOURCE(planCacheStats,
@@ -44,27 +46,38 @@ boost::intrusive_ptr<DocumentSource> DocumentSourcePlanCacheStats::createFromBso
                           << " value must be an object. Found: " << typeName(spec.type()),
             spec.type() == BSONType::Object);
 
-    uassert(ErrorCodes::FailedToParse,
-            str::stream() << kStageName
-                          << " parameters object must be empty. Found: " << typeName(spec.type()),
-            spec.embeddedObject().isEmpty());
+    bool cacheShards = false;
+    for (auto&& elem : spec.embeddedObject()) {
+        uassert(ErrorCodes::FailedToParse,
+                str::stream() << kStageName << " parameters object may only contain the '"
+                              << kCacheShardsFieldName << "' option. Found: " << elem.fieldName(),
+                elem.fieldNameStringData() == kCacheShardsFieldName);
+        uassert(ErrorCodes::FailedToParse,
+                str::stream() << kStageName << " '" << kCacheShardsFieldName
+                              << "' option must be a boolean. Found: " << typeName(elem.type()),
+                elem.type() == BSONType::Bool);
+        cacheShards = elem.boolean();
+    }
 
-    return new DocumentSourcePlanCacheStats(pExpCtx);
+    return new DocumentSourcePlanCacheStats(pExpCtx, cacheShards);
 }
 
 DocumentSourcePlanCacheStats::DocumentSourcePlanCacheStats(
-    const boost::intrusive_ptr<ExpressionContext>& expCtx)
-    : DocumentSource(kStageName, expCtx) {}
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, bool cacheShards)
+    : DocumentSource(kStageName, expCtx), _cacheShards(cacheShards) {}
 
 void DocumentSourcePlanCacheStats::serializeToArray(
     std::vector<Value>& array, boost::optional<ExplainOptions::Verbosity> explain) const {
+    const auto cacheShards = _cacheShards ? Value{true} : Value{};
     if (explain) {
         array.push_back(Value{
             Document{{kStageName,
-                      Document{{"match"_sd,
+                      Document{{kCacheShardsFieldName, cacheShards},
+                               {"match"_sd,
                                 _absorbedMatch ? Value{_absorbedMatch->getQuery()} : Value{}}}}}});
     } else {
-        array.push_back(Value{Document{{kStageName, Document{}}}});
+        array.push_back(
+            Value{Document{{kStageName, Document{{kCacheShardsFieldName, cacheShards}}}}});
         if (_absorbedMatch) {
             _absorbedMatch->serializeToArray(array);
         }
@@ -90,8 +103,21 @@ Pipeline::SourceContainer::iterator DocumentSourcePlanCacheStats::doOptimizeAt(
 DocumentSource::GetNextResult DocumentSourcePlanCacheStats::doGetNext() {
     if (!_haveRetrievedStats) {
         const auto matchExpr = _absorbedMatch ? _absorbedMatch->getMatchExpression() : nullptr;
-        _results = pExpCtx->mongoProcessInterface->getMatchingPlanCacheEntryStats(
-            pExpCtx->opCtx, pExpCtx->ns, matchExpr);
+        if (_cacheShards) {
+            _results = pExpCtx->mongoProcessInterface->getPlanCacheShardStats(pExpCtx->opCtx,
+                                                                              pExpCtx->ns);
+            if (matchExpr) {
+                _results.erase(std::remove_if(_results.begin(),
+                                              _results.end(),
+                                              [&](const BSONObj& obj) {
+                                                  return !matchExpr->matchesBSON(obj);
+                                              }),
+                               _results.end());
+            }
+        } else {
+            _results = pExpCtx->mongoProcessInterface->getMatchingPlanCacheEntryStats(
+                pExpCtx->opCtx, pExpCtx->ns, matchExpr);
+        }
 
         _resultsIter = _results.begin();
         _haveRetrievedStats = true;
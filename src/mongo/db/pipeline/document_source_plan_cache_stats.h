@@ -37,6 +37,7 @@ namespace mongo {
 class DocumentSourcePlanCacheStats final : public DocumentSource {
 public:
     static constexpr StringData kStageName = "$planCacheStats"_sd;
+    static constexpr StringData kCacheShardsFieldName = "cacheShards"_sd;
 
     class LiteParsed final : public LiteParsedDocumentSource {
     public:
@@ -118,7 +119,8 @@ public:
         boost::optional<ExplainOptions::Verbosity> explain = boost::none) const override;
 
 private:
-    DocumentSourcePlanCacheStats(const boost::intrusive_ptr<ExpressionContext>& expCtx);
+    DocumentSourcePlanCacheStats(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                 bool cacheShards);
 
     GetNextResult doGetNext() final;
 
@@ -127,6 +129,9 @@ private:
         MONGO_UNREACHABLE;  // Should call serializeToArray instead.
     }
 
+    // Whether to return the counters of each partition of the plan cache instead of its entries.
+    bool _cacheShards;
+
     // If running through mongos in a sharded cluster, stores the shard name so that it can be
     // appended to each plan cache entry document.
     std::string _shardName;
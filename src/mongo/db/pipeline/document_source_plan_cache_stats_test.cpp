@@ -46,8 +46,10 @@ using DocumentSourcePlanCacheStatsTest = AggregationContextFixture;
  */
 class PlanCacheStatsMongoProcessInterface final : public StubMongoProcessInterface {
 public:
-    PlanCacheStatsMongoProcessInterface(std::vector<BSONObj> planCacheStats)
-        : _planCacheStats(std::move(planCacheStats)) {}
+    PlanCacheStatsMongoProcessInterface(std::vector<BSONObj> planCacheStats,
+                                        std::vector<BSONObj> planCacheShardStats = {})
+        : _planCacheStats(std::move(planCacheStats)),
+          _planCacheShardStats(std::move(planCacheShardStats)) {}
 
     std::vector<BSONObj> getMatchingPlanCacheEntryStats(
         OperationContext* opCtx,
@@ -65,6 +67,11 @@ public:
         return filteredStats;
     }
 
+    std::vector<BSONObj> getPlanCacheShardStats(OperationContext* opCtx,
+                                                const NamespaceString& nss) const override {
+        return _planCacheShardStats;
+    }
+
     std::string getShardName(OperationContext* opCtx) const override {
         return "testShardName";
     }
@@ -75,6 +82,7 @@ public:
 
 private:
     std::vector<BSONObj> _planCacheStats;
+    std::vector<BSONObj> _planCacheShardStats;
 };
 
 TEST_F(DocumentSourcePlanCacheStatsTest, ShouldFailToParseIfSpecIsNotObject) {
@@ -93,6 +101,23 @@ TEST_F(DocumentSourcePlanCacheStatsTest, ShouldFailToParseIfSpecIsANonEmptyObjec
         ErrorCodes::FailedToParse);
 }
 
+TEST_F(DocumentSourcePlanCacheStatsTest, ShouldFailToParseIfCacheShardsIsNotBoolean) {
+    const auto specObj = fromjson("{$planCacheStats: {cacheShards: 1}}");
+    ASSERT_THROWS_CODE(
+        DocumentSourcePlanCacheStats::createFromBson(specObj.firstElement(), getExpCtx()),
+        AssertionException,
+        ErrorCodes::FailedToParse);
+}
+
+TEST_F(DocumentSourcePlanCacheStatsTest, CanParseAndSerializeCacheShardsSuccessfully) {
+    const auto specObj = fromjson("{$planCacheStats: {cacheShards: true}}");
+    auto stage = DocumentSourcePlanCacheStats::createFromBson(specObj.firstElement(), getExpCtx());
+    std::vector<Value> serialized;
+    stage->serializeToArray(serialized);
+    ASSERT_EQ(1u, serialized.size());
+    ASSERT_BSONOBJ_EQ(specObj, serialized[0].getDocument().toBson());
+}
+
 TEST_F(DocumentSourcePlanCacheStatsTest, CanParseAndSerializeSuccessfully) {
     const auto specObj = fromjson("{$planCacheStats: {}}");
     auto stage = DocumentSourcePlanCacheStats::createFromBson(specObj.firstElement(), getExpCtx());
@@ -186,6 +211,26 @@ TEST_F(DocumentSourcePlanCacheStatsTest, ReturnsOnlyMatchingStatsAfterAbsorbingM
     ASSERT(!pipeline->getNext());
 }
 
+TEST_F(DocumentSourcePlanCacheStatsTest, ReturnsOnlyMatchingShardStatsWhenCacheShardsIsSet) {
+    std::vector<BSONObj> shardStats{BSON("cacheShard" << 0 << "hits" << 5),
+                                    BSON("cacheShard" << 1 << "hits" << 0)};
+    std::vector<BSONObj> entryStats{BSON("foo" << 1)};
+    getExpCtx()->mongoProcessInterface =
+        std::make_shared<PlanCacheStatsMongoProcessInterface>(entryStats, shardStats);
+
+    const auto specObj = fromjson("{$planCacheStats: {cacheShards: true}}");
+    auto planCacheStats =
+        DocumentSourcePlanCacheStats::createFromBson(specObj.firstElement(), getExpCtx());
+    auto match = DocumentSourceMatch::create(fromjson("{hits: {$gt: 0}}"), getExpCtx());
+    auto pipeline = unittest::assertGet(Pipeline::create({planCacheStats, match}, getExpCtx()));
+    pipeline->optimizePipeline();
+
+    ASSERT_BSONOBJ_EQ(pipeline->getNext()->toBson(),
+                      BSON("cacheShard" << 0 << "hits" << 5 << "host"
+                                        << "testHostName"));
+    ASSERT(!pipeline->getNext());
+}
+
 TEST_F(DocumentSourcePlanCacheStatsTest, ReturnsHostNameWhenNotFromMongos) {
     std::vector<BSONObj> stats{BSON("foo"
                                     << "bar"),
@@ -63,6 +63,7 @@
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_parallel_cursor.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
@@ -71,8 +72,11 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/sort_pattern.h"
+#include "mongo/db/repl/read_concern_args.h"
+#include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/operation_sharding_state.h"
 #include "mongo/db/service_context.h"
@@ -251,6 +255,81 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> attemptToGetExe
         expCtx->opCtx, collection, std::move(cq.getValue()), permitYield, plannerOpts);
 }
 
+/**
+ * A parallel collection scan is not worthwhile unless each of its RecordId ranges holds at least
+ * this many records on average.
+ */
+constexpr long long kMinRecordsPerParallelScanRange = 1000;
+
+/**
+ * Returns true if the plan rooted at 'root' is a collection scan, possibly beneath projections.
+ */
+bool isCollectionScanPlan(const PlanStage* root) {
+    const PlanStage* stage = root;
+    while (stage->stageType() == STAGE_PROJECTION_DEFAULT ||
+           stage->stageType() == STAGE_PROJECTION_SIMPLE) {
+        stage = stage->getChildren()[0].get();
+    }
+    return stage->stageType() == STAGE_COLLSCAN;
+}
+
+/**
+ * Returns true if every accumulator of 'group' produces the same result whatever the order of its
+ * input. Accumulators like $push, $first and $last depend on the order in which a serial scan
+ * returns documents, which a parallel scan does not preserve.
+ */
+bool hasOnlyOrderInsensitiveAccumulators(const DocumentSourceGroup& group) {
+    static const StringData kOrderInsensitiveAccumulators[] = {
+        "$addToSet", "$avg", "$max", "$min", "$stdDevPop", "$stdDevSamp", "$sum"};
+
+    return std::all_of(group.getAccumulatedFields().begin(),
+                       group.getAccumulatedFields().end(),
+                       [](const AccumulationStatement& stmt) {
+                           const StringData opName = stmt.makeAccumulator()->getOpName();
+                           return std::find(std::begin(kOrderInsensitiveAccumulators),
+                                            std::end(kOrderInsensitiveAccumulators),
+                                            opName) != std::end(kOrderInsensitiveAccumulators);
+                       });
+}
+
+/**
+ * Divides the RecordIds of 'collection' into at most 'maxRanges' contiguous, disjoint ranges of
+ * roughly equal width. The first and last ranges are unbounded below and above respectively, so
+ * that together the ranges cover every possible RecordId. Returns fewer than two ranges if the
+ * collection is too small to be worth dividing.
+ */
+std::vector<DocumentSourceParallelCursor::RecordIdRange> partitionRecordIdRanges(
+    OperationContext* opCtx, Collection* collection, long long maxRanges) {
+    const long long numRecords = collection->getRecordStore()->numRecords(opCtx);
+    const long long numRanges = std::min(maxRanges, numRecords / kMinRecordsPerParallelScanRange);
+    if (numRanges < 2) {
+        return {};
+    }
+
+    auto first = collection->getCursor(opCtx, true /* forward */)->next();
+    auto last = collection->getCursor(opCtx, false /* forward */)->next();
+    if (!first || !last) {
+        return {};
+    }
+
+    const int64_t base = first->id.repr();
+    const uint64_t span = static_cast<uint64_t>(last->id.repr()) - static_cast<uint64_t>(base);
+    const uint64_t width = span / numRanges + 1;
+
+    std::vector<DocumentSourceParallelCursor::RecordIdRange> ranges;
+    for (uint64_t offset = 0; offset <= span; offset += width) {
+        const bool isFirst = offset == 0;
+        const bool isLast = span - offset < width;
+        ranges.emplace_back(
+            isFirst ? RecordId::min() : RecordId(base + static_cast<int64_t>(offset)),
+            isLast ? RecordId::max() : RecordId(base + static_cast<int64_t>(offset + width - 1)));
+        if (isLast) {
+            break;
+        }
+    }
+    return ranges;
+}
+
 /**
  * Examines the indexes in 'collection' and returns the field name of a geo-indexed field suitable
  * for use in $geoNear. 2d indexes are given priority over 2dsphere indexes.
@@ -488,6 +567,13 @@ PipelineD::buildInnerQueryExecutorGeneric(Collection* collection,
     Pipeline::SourceContainer& sources = pipeline->_sources;
     auto expCtx = pipeline->getContext();
 
+    // Remember the stages as they were before any pushdown, in case we later decide to divide the
+    // collection scan between several threads.
+    boost::optional<Pipeline::SourceContainer> originalSources;
+    if (internalQueryParallelCollectionScanWorkers.load() > 1) {
+        originalSources = sources;
+    }
+
     // Look for an initial match. This works whether we got an initial query or not. If not, it
     // results in a "{}" query, which will be what we want in that case.
     const BSONObj queryObj = pipeline->getInitialQuery();
@@ -546,6 +632,12 @@ PipelineD::buildInnerQueryExecutorGeneric(Collection* collection,
                                                 Pipeline::kAllowedMatcherFeatures,
                                                 &shouldProduceEmptyDocs));
 
+    if (originalSources &&
+        attemptToParallelizeCollectionScan(
+            collection, aggRequest, pipeline, *originalSources, queryObj, *exec)) {
+        // The pipeline now begins with a $parallelCursor stage and needs no executor of its own.
+        return {};
+    }
 
     // If this is a change stream pipeline, make sure that we tell DSCursor to track the oplog time.
     const bool trackOplogTS =
@@ -739,6 +831,100 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
                                 matcherFeatures);
 }
 
+bool PipelineD::attemptToParallelizeCollectionScan(Collection* collection,
+                                                   const AggregationRequest* aggRequest,
+                                                   Pipeline* pipeline,
+                                                   const Pipeline::SourceContainer& originalSources,
+                                                   const BSONObj& queryObj,
+                                                   const PlanExecutor& exec) {
+    auto expCtx = pipeline->getContext();
+    auto opCtx = expCtx->opCtx;
+
+    // The workers read using their own operations, each with its own storage snapshot and without
+    // this operation's shard version or transaction. Only divide top-level aggregations whose read
+    // semantics these operations can reproduce: local reads on a primary or standalone, which do
+    // not promise a single snapshot either once the serial scan yields. Since every RecordId
+    // belongs to exactly one range, each document is still returned at most once.
+    if (!collection || expCtx->explain || expCtx->inMongos || expCtx->needsMerge ||
+        expCtx->subPipelineDepth > 0 || expCtx->tailableMode != TailableModeEnum::kNormal ||
+        (aggRequest && aggRequest->getExchangeSpec()) || opCtx->inMultiDocumentTransaction() ||
+        OperationShardingState::isOperationVersioned(opCtx) || collection->ns().isOplog()) {
+        return false;
+    }
+
+    const auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
+    const auto readConcernLevel = readConcernArgs.getLevel();
+    if ((readConcernLevel != repl::ReadConcernLevel::kLocalReadConcern &&
+         readConcernLevel != repl::ReadConcernLevel::kAvailableReadConcern) ||
+        readConcernArgs.getArgsAtClusterTime() || readConcernArgs.getArgsAfterClusterTime() ||
+        !repl::ReplicationCoordinator::get(opCtx)->canAcceptWritesFor(opCtx, collection->ns())) {
+        return false;
+    }
+
+    // Only replace a plan which the query planner would have executed as a collection scan anyway.
+    if (!isCollectionScanPlan(exec.getRootStage())) {
+        return false;
+    }
+
+    // Look for a $group preceded only by stages which transform one document at a time. Those
+    // stages and the shard-side half of the $group run on every worker. A leading $match is not
+    // among them, as it is applied by the workers' collection scans.
+    auto workerBegin = originalSources.begin();
+    if (!queryObj.isEmpty()) {
+        ++workerBegin;
+    }
+    auto groupIt = workerBegin;
+    for (; groupIt != originalSources.end(); ++groupIt) {
+        if (dynamic_cast<DocumentSourceGroup*>(groupIt->get())) {
+            break;
+        }
+        if (!dynamic_cast<DocumentSourceMatch*>(groupIt->get()) &&
+            !dynamic_cast<DocumentSourceSingleDocumentTransformation*>(groupIt->get())) {
+            return false;
+        }
+    }
+    if (groupIt == originalSources.end()) {
+        return false;
+    }
+
+    auto groupStage = static_cast<DocumentSourceGroup*>(groupIt->get());
+    if (groupStage->doingMerge() || !hasOnlyOrderInsensitiveAccumulators(*groupStage)) {
+        return false;
+    }
+
+    auto ranges = partitionRecordIdRanges(
+        opCtx, collection, internalQueryParallelCollectionScanWorkers.load());
+    if (ranges.size() < 2) {
+        return false;
+    }
+
+    std::vector<Value> serializedStages;
+    for (auto it = workerBegin; it != std::next(groupIt); ++it) {
+        (*it)->serializeToArray(serializedStages);
+    }
+    std::vector<BSONObj> workerPipeline;
+    for (auto&& stage : serializedStages) {
+        workerPipeline.push_back(stage.getDocument().toBson());
+    }
+
+    auto splitGroup = groupStage->distributedPlanLogic();
+    invariant(splitGroup && splitGroup->mergingStage);
+
+    Pipeline::SourceContainer parallelSources;
+    parallelSources.push_back(DocumentSourceParallelCursor::create(expCtx,
+                                                                   collection->ns(),
+                                                                   collection->uuid(),
+                                                                   queryObj,
+                                                                   std::move(workerPipeline),
+                                                                   std::move(ranges)));
+    parallelSources.push_back(splitGroup->mergingStage);
+    parallelSources.insert(parallelSources.end(), std::next(groupIt), originalSources.end());
+
+    pipeline->_sources = std::move(parallelSources);
+    pipeline->stitch();
+    return true;
+}
+
 void PipelineD::addCursorSource(Pipeline* pipeline,
                                 boost::intrusive_ptr<DocumentSourceCursor> cursor,
                                 bool shouldProduceEmptyDocs) {
@@ -764,6 +950,10 @@ std::string PipelineD::getPlanSummaryStr(const Pipeline* pipeline) {
             dynamic_cast<DocumentSourceCursor*>(pipeline->_sources.front().get())) {
         return docSourceCursor->getPlanSummaryStr();
     }
+    if (auto parallelCursor =
+            dynamic_cast<DocumentSourceParallelCursor*>(pipeline->_sources.front().get())) {
+        return parallelCursor->getPlanSummaryStr();
+    }
 
     return "";
 }
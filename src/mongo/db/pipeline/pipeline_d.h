@@ -191,6 +191,24 @@ private:
         const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
         bool* hasNoRequirements);
 
+    /**
+     * Replaces the collection scan planned for 'pipeline' by 'exec' with a
+     * DocumentSourceParallelCursor if the scan and the stages consuming it can be divided across
+     * several threads. This is the case when 'exec' is a plain collection scan whose results pass
+     * through streaming per-document stages into a $group, which can then be computed partially by
+     * each thread and merged afterwards. 'originalSources' are the pipeline's stages before any
+     * were pushed down into 'exec', and 'queryObj' is the filter pushed down from a leading $match.
+     *
+     * Returns true and rewrites the stages of 'pipeline' if the scan was parallelized, in which
+     * case 'exec' is no longer needed. Otherwise leaves 'pipeline' untouched and returns false.
+     */
+    static bool attemptToParallelizeCollectionScan(Collection* collection,
+                                                   const AggregationRequest* aggRequest,
+                                                   Pipeline* pipeline,
+                                                   const Pipeline::SourceContainer& originalSources,
+                                                   const BSONObj& queryObj,
+                                                   const PlanExecutor& exec);
+
     /**
      * Adds 'cursor' to the front of 'pipeline'. If 'shouldProduceEmptyDocs' is true, then we inform
      * 'cursor' that this is a count scenario -- the dependency set is fully known and is empty. In
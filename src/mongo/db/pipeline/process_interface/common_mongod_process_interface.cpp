@@ -219,6 +219,13 @@ Status CommonMongodProcessInterface::appendRecordCount(OperationContext* opCtx,
     return appendCollectionRecordCount(opCtx, nss, builder);
 }
 
+boost::optional<long long> CommonMongodProcessInterface::getCollectionDataSize(
+    OperationContext* opCtx, const NamespaceString& nss) const {
+    AutoGetCollectionForRead autoColl(opCtx, nss);
+    Collection* collection = autoColl.getCollection();
+    return collection ? static_cast<long long>(collection->dataSize(opCtx)) : 0LL;
+}
+
 Status CommonMongodProcessInterface::appendQueryExecStats(OperationContext* opCtx,
                                                           const NamespaceString& nss,
                                                           BSONObjBuilder* builder) const {
@@ -416,6 +423,28 @@ std::vector<BSONObj> CommonMongodProcessInterface::getMatchingPlanCacheEntryStat
     return planCache->getMatchingStats(serializer, predicate);
 }
 
+std::vector<BSONObj> CommonMongodProcessInterface::getPlanCacheShardStats(
+    OperationContext* opCtx, const NamespaceString& nss) const {
+    AutoGetCollection autoColl(opCtx, nss, MODE_IS);
+    const auto collection = autoColl.getCollection();
+    uassert(
+        51806, str::stream() << "collection '" << nss.toString() << "' does not exist", collection);
+
+    const auto planCache = CollectionQueryInfo::get(collection).getPlanCache();
+    invariant(planCache);
+
+    std::vector<BSONObj> results;
+    const auto shardStats = planCache->getShardStats();
+    for (size_t i = 0; i < shardStats.size(); ++i) {
+        results.push_back(BSON("cacheShard" << static_cast<int>(i) << "entries"
+                                            << static_cast<long long>(shardStats[i].entries)
+                                            << "hits" << shardStats[i].hits << "misses"
+                                            << shardStats[i].misses << "evictions"
+                                            << shardStats[i].evictions));
+    }
+    return results;
+}
+
 bool CommonMongodProcessInterface::fieldsHaveSupportingUniqueIndex(
     const boost::intrusive_ptr<ExpressionContext>& expCtx,
     const NamespaceString& nss,
@@ -71,6 +71,8 @@ public:
     Status appendRecordCount(OperationContext* opCtx,
                              const NamespaceString& nss,
                              BSONObjBuilder* builder) const final;
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const final;
     Status appendQueryExecStats(OperationContext* opCtx,
                                 const NamespaceString& nss,
                                 BSONObjBuilder* builder) const final override;
@@ -99,6 +101,9 @@ public:
                                                         const NamespaceString&,
                                                         const MatchExpression*) const final;
 
+    std::vector<BSONObj> getPlanCacheShardStats(OperationContext*,
+                                                const NamespaceString&) const final;
+
     bool fieldsHaveSupportingUniqueIndex(const boost::intrusive_ptr<ExpressionContext>& expCtx,
                                          const NamespaceString& nss,
                                          const std::set<FieldPath>& fieldPaths) const;
@@ -197,6 +197,15 @@ public:
     virtual Status appendRecordCount(OperationContext* opCtx,
                                      const NamespaceString& nss,
                                      BSONObjBuilder* builder) const = 0;
+
+    /**
+     * Returns the size in bytes of the uncompressed data held by collection 'nss', or boost::none
+     * if this process cannot read the collection locally. A collection which does not exist has a
+     * size of zero.
+     */
+    virtual boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                             const NamespaceString& nss) const = 0;
+
     /**
      * Appends the exec stats for the collection 'nss' to 'builder'.
      */
@@ -373,6 +382,14 @@ public:
                                                                 const NamespaceString&,
                                                                 const MatchExpression*) const = 0;
 
+    /**
+     * Returns a vector of BSON objects, one for each partition of the plan cache for the given
+     * namespace, describing the number of entries and the hit, miss and eviction counters of that
+     * partition.
+     */
+    virtual std::vector<BSONObj> getPlanCacheShardStats(OperationContext*,
+                                                        const NamespaceString&) const = 0;
+
     /**
      * Returns true if there is an index on 'nss' with properties that will guarantee that a
      * document with non-array values for each of 'fieldPaths' will have at most one matching
@@ -114,6 +114,15 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    /**
+     * The foreign collection of a $lookup executed on mongos is read remotely, so its size is
+     * unknown here.
+     */
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const final {
+        return boost::none;
+    }
+
     Status appendQueryExecStats(OperationContext* opCtx,
                                 const NamespaceString& nss,
                                 BSONObjBuilder* builder) const final {
@@ -203,6 +212,11 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    std::vector<BSONObj> getPlanCacheShardStats(OperationContext*,
+                                                const NamespaceString&) const final {
+        MONGO_UNREACHABLE;
+    }
+
     bool fieldsHaveSupportingUniqueIndex(const boost::intrusive_ptr<ExpressionContext>&,
                                          const NamespaceString&,
                                          const std::set<FieldPath>& fieldPaths) const;
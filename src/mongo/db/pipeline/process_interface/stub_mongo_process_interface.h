@@ -106,6 +106,11 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    boost::optional<long long> getCollectionDataSize(OperationContext* opCtx,
+                                                     const NamespaceString& nss) const override {
+        MONGO_UNREACHABLE;
+    }
+
     Status appendQueryExecStats(OperationContext* opCtx,
                                 const NamespaceString& nss,
                                 BSONObjBuilder* builder) const override {
@@ -219,6 +224,11 @@ public:
         MONGO_UNREACHABLE;
     }
 
+    std::vector<BSONObj> getPlanCacheShardStats(OperationContext*,
+                                                const NamespaceString&) const override {
+        MONGO_UNREACHABLE;
+    }
+
     bool fieldsHaveSupportingUniqueIndex(const boost::intrusive_ptr<ExpressionContext>& expCtx,
                                          const NamespaceString& nss,
                                          const std::set<FieldPath>& fieldPaths) const override {
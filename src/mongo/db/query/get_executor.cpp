@@ -61,6 +61,7 @@
 #include "mongo/db/index_names.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/canonical_query_encoder.h"
 #include "mongo/db/query/collation/collator_factory_interface.h"
@@ -709,6 +710,16 @@ StatusWith<unique_ptr<PlanStage>> applyProjection(OperationContext* opCtx,
         cq->getExpCtx(), projObj, &proj, ws, std::unique_ptr<PlanStage>(root.release()))};
 }
 
+/**
+ * Makes the working set for a write's executor. Write executors are never saved in a
+ * ClientCursor, so the working set comes from the operation's arena whenever the caller has
+ * scoped the arena to the write.
+ */
+std::unique_ptr<WorkingSet> makeWriteWorkingSet(OperationContext* opCtx) {
+    auto& arena = OperationArena::get(opCtx);
+    return std::make_unique<WorkingSet>(arena.inScope() ? &arena : nullptr);
+}
+
 }  // namespace
 
 //
@@ -752,7 +763,7 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorDelete(
     deleteStageParams->opDebug = opDebug;
     deleteStageParams->stmtId = request->getStmtId();
 
-    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<WorkingSet> ws = makeWriteWorkingSet(opCtx);
     const PlanExecutor::YieldPolicy policy = parsedDelete->yieldPolicy();
 
     if (!collection) {
@@ -905,7 +916,7 @@ StatusWith<unique_ptr<PlanExecutor, PlanExecutor::Deleter>> getExecutorUpdate(
 
     const PlanExecutor::YieldPolicy policy = parsedUpdate->yieldPolicy();
 
-    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<WorkingSet> ws = makeWriteWorkingSet(opCtx);
     UpdateStageParams updateStageParams(request, driver, opDebug);
 
     // If the collection doesn't exist, then return a PlanExecutor for a no-op EOF plan. We have
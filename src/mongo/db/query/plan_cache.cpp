@@ -63,6 +63,20 @@ namespace {
 ServerStatusMetricField<Counter64> totalPlanCacheSizeEstimateBytesMetric(
     "query.planCacheTotalSizeEstimateBytes", &PlanCacheEntry::planCacheTotalSizeEstimateBytes);
 
+// Totals of the per-shard counters over every plan cache on this node.
+Counter64 planCacheHits;
+Counter64 planCacheMisses;
+Counter64 planCacheEvictions;
+ServerStatusMetricField<Counter64> planCacheHitsMetric("query.planCache.hits", &planCacheHits);
+ServerStatusMetricField<Counter64> planCacheMissesMetric("query.planCache.misses",
+                                                         &planCacheMisses);
+ServerStatusMetricField<Counter64> planCacheEvictionsMetric("query.planCache.evictions",
+                                                            &planCacheEvictions);
+
+// Smallest number of entries worth giving its own plan cache shard. Smaller caches use fewer
+// shards, so that splitting them up does not noticeably change which entries LRU eviction picks.
+const size_t kMinEntriesPerShard = 64;
+
 // Delimiters for cache key encoding.
 const char kEncodeDiscriminatorsBegin = '<';
 const char kEncodeDiscriminatorsEnd = '>';
@@ -431,7 +445,16 @@ std::string SolutionCacheData::toString() const {
 
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size) : PlanCache(size, internalQueryCacheNumShards.load()) {}
+
+PlanCache::PlanCache(size_t size, size_t numShards) {
+    numShards = std::max<size_t>(1, std::min(numShards, size / kMinEntriesPerShard));
+    _shards.reserve(numShards);
+    for (size_t i = 0; i < numShards; ++i) {
+        // Spread the remainder over the first shards so the capacities add up to 'size'.
+        _shards.push_back(std::make_unique<Shard>(size / numShards + (i < size % numShards)));
+    }
+}
 
 PlanCache::~PlanCache() {}
 
@@ -597,7 +620,8 @@ Status PlanCache::set(const CanonicalQuery& query,
 
     const auto key = computeKey(query);
     const size_t newWorks = why->stats[0]->common.works;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
     bool isNewEntryActive = false;
     uint32_t queryHash;
     uint32_t planCacheKey;
@@ -608,7 +632,7 @@ Status PlanCache::set(const CanonicalQuery& query,
         queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
     } else {
         PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
+        Status cacheStatus = shard.cache.get(key, &oldEntry);
         invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
         if (oldEntry) {
             queryHash = oldEntry->queryHash;
@@ -634,10 +658,56 @@ Status PlanCache::set(const CanonicalQuery& query,
 
     auto newEntry(PlanCacheEntry::create(
         solns, std::move(why), query, queryHash, planCacheKey, now, isNewEntryActive, newWorks));
+    _addEntry(cacheLock, &shard, key, std::move(newEntry), query);
+
+    return Status::OK();
+}
+
+bool PlanCache::restore(const CanonicalQuery& query,
+                        std::unique_ptr<SolutionCacheData> plannerData,
+                        size_t works,
+                        Date_t now) {
+    invariant(plannerData);
+
+    // There was no trial period, so the decision records only the works of the winning plan.
+    auto decision = std::make_unique<PlanRankingDecision>();
+    CommonStats commonStats("RESTORED_PLAN");
+    commonStats.works = works;
+    decision->stats.push_back(std::make_unique<PlanStageStats>(commonStats, STAGE_UNKNOWN));
+    decision->scores.push_back(0);
+    decision->candidateOrder.push_back(0);
+
+    QuerySolution solution;
+    solution.cacheData = std::move(plannerData);
+
+    const auto key = computeKey(query);
+    const uint32_t planCacheKey = canonical_query_encoder::computeHash(key.stringData());
+    const uint32_t queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
+    if (shard.cache.hasKey(key)) {
+        return false;
+    }
+
+    auto newEntry(PlanCacheEntry::create(
+        {&solution}, std::move(decision), query, queryHash, planCacheKey, now, true, works));
+    _addEntry(cacheLock, &shard, key, std::move(newEntry), query);
+    return true;
+}
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+PlanCache::Shard& PlanCache::_getShard(const PlanCacheKey& key) const {
+    return *_shards[PlanCacheKeyHasher{}(key) % _shards.size()];
+}
 
+void PlanCache::_addEntry(WithLock,
+                          Shard* shard,
+                          const PlanCacheKey& key,
+                          std::unique_ptr<PlanCacheEntry> entry,
+                          const CanonicalQuery& query) {
+    std::unique_ptr<PlanCacheEntry> evictedEntry = shard->cache.add(key, entry.release());
     if (nullptr != evictedEntry.get()) {
+        ++shard->evictions;
+        planCacheEvictions.increment();
         LOGV2_DEBUG(20942,
                     1,
                     "{query_nss}: plan cache maximum size exceeded - removed least recently used "
@@ -645,8 +715,6 @@ Status PlanCache::set(const CanonicalQuery& query,
                     "query_nss"_attr = query.nss(),
                     "evictedEntry"_attr = redact(evictedEntry->toString()));
     }
-
-    return Status::OK();
 }
 
 void PlanCache::deactivate(const CanonicalQuery& query) {
@@ -656,9 +724,10 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
     }
 
     PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = shard.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -673,14 +742,19 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = shard.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
+        ++shard.misses;
+        planCacheMisses.increment();
         return {CacheEntryState::kNotPresent, nullptr};
     }
     invariant(entry);
+    ++shard.hits;
+    planCacheHits.increment();
 
     auto state =
         entry->isActive ? CacheEntryState::kPresentActive : CacheEntryState::kPresentInactive;
@@ -690,9 +764,10 @@ PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
 Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& shard = _getShard(ck);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = shard.cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -707,13 +782,17 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheKey key = computeKey(canonicalQuery);
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
+    return shard.cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<Latch> cacheLock(shard->mutex);
+        shard->cache.clear();
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -727,9 +806,10 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
     PlanCacheKey key = computeKey(query);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& shard = _getShard(key);
+    stdx::lock_guard<Latch> cacheLock(shard.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = shard.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -739,20 +819,26 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<Latch> cacheLock(shard->mutex);
+        for (auto&& cacheEntry : shard->cache) {
+            auto entry = cacheEntry.second;
+            entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<Latch> cacheLock(shard->mutex);
+        size += shard->cache.size();
+    }
+    return size;
 }
 
 void PlanCache::notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores) {
@@ -763,17 +849,31 @@ std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
-        if (filterFunc(serializedEntry)) {
-            results.push_back(serializedEntry);
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<Latch> cacheLock(shard->mutex);
+        for (auto&& cacheEntry : shard->cache) {
+            const auto entry = cacheEntry.second;
+            auto serializedEntry = serializationFunc(*entry);
+            if (filterFunc(serializedEntry)) {
+                results.push_back(serializedEntry);
+            }
         }
     }
 
     return results;
 }
 
+std::vector<PlanCache::ShardStats> PlanCache::getShardStats() const {
+    std::vector<ShardStats> stats;
+    stats.reserve(_shards.size());
+
+    for (auto&& shard : _shards) {
+        stdx::lock_guard<Latch> cacheLock(shard->mutex);
+        stats.push_back({shard->cache.size(), shard->hits, shard->misses, shard->evictions});
+    }
+
+    return stats;
+}
+
 }  // namespace mongo
@@ -40,6 +40,7 @@
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/container_size_helper.h"
 
 namespace mongo {
@@ -456,6 +457,17 @@ public:
      */
     static bool shouldCacheQuery(const CanonicalQuery& query);
 
+    /**
+     * Counters kept for one partition of the cache. A lookup which finds an entry, active or not,
+     * counts as a hit.
+     */
+    struct ShardStats {
+        size_t entries = 0;
+        long long hits = 0;
+        long long misses = 0;
+        long long evictions = 0;
+    };
+
     /**
      * If omitted, namespace set to empty string.
      */
@@ -463,6 +475,14 @@ public:
 
     PlanCache(size_t size);
 
+    /**
+     * Creates a cache holding up to 'size' entries, split into at most 'numShards' partitions.
+     * Each partition has its own mutex and LRU list, so the cache evicts in approximate rather than
+     * exact LRU order. Fewer partitions are used if 'size' is too small to give each partition a
+     * useful share of the entries.
+     */
+    PlanCache(size_t size, size_t numShards);
+
     ~PlanCache();
 
     /**
@@ -485,6 +505,19 @@ public:
                Date_t now,
                boost::optional<double> worksGrowthCoefficient = boost::none);
 
+    /**
+     * Adds an active entry for 'query' whose winning plan is described by 'plannerData', as
+     * recorded by an earlier call to set(). 'works' is the number of works the winning plan needed
+     * when it was originally cached. Used to warm the cache with plans persisted before a restart
+     * or failover, without repeating the trial period which picked them.
+     *
+     * Returns false without modifying the cache if it already has an entry for the query's shape.
+     */
+    bool restore(const CanonicalQuery& query,
+                 std::unique_ptr<SolutionCacheData> plannerData,
+                 size_t works,
+                 Date_t now);
+
     /**
      * Set a cache entry back to the 'inactive' state. Rather than completely evicting an entry
      * when the associated plan starts to perform poorly, we deactivate it, so that plans which
@@ -588,6 +621,11 @@ public:
         const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
         const std::function<bool(const BSONObj&)>& filterFunc) const;
 
+    /**
+     * Returns the counters of each partition of the cache, in partition order.
+     */
+    std::vector<ShardStats> getShardStats() const;
+
 private:
     struct NewEntryState {
         bool shouldBeCreated = false;
@@ -601,10 +639,36 @@ private:
                                    size_t newWorks,
                                    double growthCoefficient);
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> _cache;
+    /**
+     * One partition of the cache. Every key is owned by exactly one shard, chosen by hashing the
+     * key, so operations on different query shapes rarely contend on the same mutex.
+     */
+    struct Shard {
+        explicit Shard(size_t size) : cache(size) {}
+
+        // Protects all members below.
+        mutable Mutex mutex = MONGO_MAKE_LATCH("PlanCache::Shard::mutex");
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> cache;
+
+        mutable long long hits = 0;
+        mutable long long misses = 0;
+        long long evictions = 0;
+    };
+
+    Shard& _getShard(const PlanCacheKey& key) const;
+
+    /**
+     * Adds 'entry' under 'key' to 'shard', which must be locked by the caller, and logs any entry
+     * evicted to make room for it.
+     */
+    void _addEntry(WithLock,
+                   Shard* shard,
+                   const PlanCacheKey& key,
+                   std::unique_ptr<PlanCacheEntry> entry,
+                   const CanonicalQuery& query);
 
-    // Protects _cache.
-    mutable Mutex _cacheMutex = MONGO_MAKE_LATCH("PlanCache::_cacheMutex");
+    std::vector<std::unique_ptr<Shard>> _shards;
 
     // Holds computed information about the collection's indexes.  Used for generating plan
     // cache keys.
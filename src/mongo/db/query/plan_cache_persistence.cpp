@@ -0,0 +1,435 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_persistence.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/logical_session_id.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/canonical_query_encoder.h"
+#include "mongo/db/query/collection_query_info.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/index_bounds.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/storage/write_unit_of_work.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace plan_cache_persistence {
+namespace {
+
+// Fields of a persisted plan cache entry.
+constexpr StringData kIdField = "_id"_sd;
+constexpr StringData kNsField = "ns"_sd;
+constexpr StringData kUUIDField = "uuid"_sd;
+constexpr StringData kIndexCatalogVersionField = "indexCatalogVersion"_sd;
+constexpr StringData kPlanCacheKeyField = "planCacheKey"_sd;
+constexpr StringData kQueryHashField = "queryHash"_sd;
+constexpr StringData kQueryField = "query"_sd;
+constexpr StringData kSortField = "sort"_sd;
+constexpr StringData kProjectionField = "projection"_sd;
+constexpr StringData kCollationField = "collation"_sd;
+constexpr StringData kWorksField = "works"_sd;
+constexpr StringData kPlannerDataField = "plannerData"_sd;
+
+// Fields of a serialized SolutionCacheData and its PlanCacheIndexTree.
+constexpr StringData kSolutionTypeField = "solutionType"_sd;
+constexpr StringData kWholeIXSolnDirField = "wholeIXSolnDir"_sd;
+constexpr StringData kIndexFilterAppliedField = "indexFilterApplied"_sd;
+constexpr StringData kTreeField = "tree"_sd;
+constexpr StringData kIndexField = "index"_sd;
+constexpr StringData kIndexNameField = "name"_sd;
+constexpr StringData kIndexDisambiguatorField = "disambiguator"_sd;
+constexpr StringData kPositionField = "position"_sd;
+constexpr StringData kCanCombineBoundsField = "canCombineBounds"_sd;
+constexpr StringData kOrPushdownsField = "orPushdowns"_sd;
+constexpr StringData kRouteField = "route"_sd;
+constexpr StringData kChildrenField = "children"_sd;
+
+void appendIndexIdentifier(BSONObjBuilder* builder, const IndexEntry::Identifier& identifier) {
+    BSONObjBuilder indexBuilder(builder->subobjStart(kIndexField));
+    indexBuilder.append(kIndexNameField, identifier.catalogName);
+    indexBuilder.append(kIndexDisambiguatorField, identifier.disambiguator);
+}
+
+IndexEntry::Identifier parseIndexIdentifier(const BSONObj& obj) {
+    return {obj[kIndexNameField].String(), obj[kIndexDisambiguatorField].String()};
+}
+
+size_t parsePosition(const BSONElement& elem) {
+    const auto position = elem.safeNumberLong();
+    uassert(ErrorCodes::FailedToParse,
+            str::stream() << "Invalid index position: " << elem,
+            elem.isNumber() && position >= 0);
+    return static_cast<size_t>(position);
+}
+
+/**
+ * Returns the entry in 'indexes' for the index named by 'identifier'. The planner expands a
+ * wildcard index into one entry per path, told apart by the disambiguator, so this matches on the
+ * catalog name alone and gives the returned entry the persisted identifier.
+ */
+IndexEntry findIndexEntry(const IndexEntry::Identifier& identifier,
+                          const std::vector<IndexEntry>& indexes) {
+    auto it = std::find_if(indexes.begin(), indexes.end(), [&](const IndexEntry& index) {
+        return index.identifier.catalogName == identifier.catalogName;
+    });
+    uassert(ErrorCodes::IndexNotFound,
+            str::stream() << "Index " << identifier.catalogName << " no longer exists",
+            it != indexes.end());
+
+    IndexEntry entry(*it);
+    entry.identifier = identifier;
+    return entry;
+}
+
+BSONObj serializeIndexTree(const PlanCacheIndexTree& tree) {
+    BSONObjBuilder builder;
+    if (tree.entry) {
+        appendIndexIdentifier(&builder, tree.entry->identifier);
+    }
+    builder.append(kPositionField, static_cast<long long>(tree.index_pos));
+    builder.append(kCanCombineBoundsField, tree.canCombineBounds);
+
+    BSONArrayBuilder orPushdownsBuilder(builder.subarrayStart(kOrPushdownsField));
+    for (auto&& orPushdown : tree.orPushdowns) {
+        BSONObjBuilder orPushdownBuilder(orPushdownsBuilder.subobjStart());
+        appendIndexIdentifier(&orPushdownBuilder, orPushdown.indexEntryId);
+        orPushdownBuilder.append(kPositionField, static_cast<long long>(orPushdown.position));
+        orPushdownBuilder.append(kCanCombineBoundsField, orPushdown.canCombineBounds);
+        BSONArrayBuilder routeBuilder(orPushdownBuilder.subarrayStart(kRouteField));
+        for (auto step : orPushdown.route) {
+            routeBuilder.append(static_cast<long long>(step));
+        }
+    }
+    orPushdownsBuilder.doneFast();
+
+    BSONArrayBuilder childrenBuilder(builder.subarrayStart(kChildrenField));
+    for (auto&& child : tree.children) {
+        childrenBuilder.append(serializeIndexTree(*child));
+    }
+    childrenBuilder.doneFast();
+    return builder.obj();
+}
+
+std::unique_ptr<PlanCacheIndexTree> parseIndexTree(const BSONObj& obj,
+                                                   const std::vector<IndexEntry>& indexes) {
+    auto tree = std::make_unique<PlanCacheIndexTree>();
+    if (auto indexElem = obj[kIndexField]) {
+        tree->setIndexEntry(findIndexEntry(parseIndexIdentifier(indexElem.Obj()), indexes));
+    }
+    tree->index_pos = parsePosition(obj[kPositionField]);
+    tree->canCombineBounds = obj[kCanCombineBoundsField].trueValue();
+
+    for (auto&& orPushdownElem : obj[kOrPushdownsField].Obj()) {
+        const auto orPushdownObj = orPushdownElem.Obj();
+        auto identifier = parseIndexIdentifier(orPushdownObj[kIndexField].Obj());
+        findIndexEntry(identifier, indexes);
+
+        PlanCacheIndexTree::OrPushdown orPushdown{std::move(identifier),
+                                                  parsePosition(orPushdownObj[kPositionField]),
+                                                  orPushdownObj[kCanCombineBoundsField].trueValue(),
+                                                  {}};
+        for (auto&& stepElem : orPushdownObj[kRouteField].Obj()) {
+            orPushdown.route.push_back(parsePosition(stepElem));
+        }
+        tree->orPushdowns.push_back(std::move(orPushdown));
+    }
+
+    for (auto&& childElem : obj[kChildrenField].Obj()) {
+        tree->children.push_back(parseIndexTree(childElem.Obj(), indexes).release());
+    }
+    return tree;
+}
+
+BSONObj makePersistedEntry(const NamespaceString& nss,
+                           const UUID& uuid,
+                           long long indexCatalogVersion,
+                           const PlanCacheEntry& entry) {
+    BSONObjBuilder builder;
+    builder.append(kIdField, OID::gen());
+    builder.append(kNsField, nss.ns());
+    uuid.appendToBuilder(&builder, kUUIDField);
+    builder.append(kIndexCatalogVersionField, indexCatalogVersion);
+    builder.append(kPlanCacheKeyField, static_cast<long long>(entry.planCacheKey));
+    builder.append(kQueryHashField, static_cast<long long>(entry.queryHash));
+    builder.append(kQueryField, entry.query);
+    builder.append(kSortField, entry.sort);
+    builder.append(kProjectionField, entry.projection);
+    builder.append(kCollationField, entry.collation);
+    builder.append(kWorksField, static_cast<long long>(entry.works));
+    builder.append(kPlannerDataField, serializeSolutionCacheData(*entry.plannerData[0]));
+    return builder.obj();
+}
+
+/**
+ * Restores a single persisted entry. Returns false if the entry no longer applies to its
+ * collection or the plan cache already has an entry for its query shape.
+ */
+bool restoreEntry(OperationContext* opCtx, const BSONObj& persistedEntry) {
+    const NamespaceString nss(persistedEntry[kNsField].String());
+    const auto uuid = uassertStatusOK(UUID::parse(persistedEntry[kUUIDField]));
+    AutoGetCollectionForRead autoColl(opCtx, NamespaceStringOrUUID(nss.db().toString(), uuid));
+    auto collection = autoColl.getCollection();
+    if (!collection ||
+        computeIndexCatalogVersion(opCtx, collection) !=
+            persistedEntry[kIndexCatalogVersionField].numberLong()) {
+        return false;
+    }
+
+    auto qr = std::make_unique<QueryRequest>(autoColl.getNss());
+    qr->setFilter(persistedEntry[kQueryField].Obj().getOwned());
+    qr->setSort(persistedEntry[kSortField].Obj().getOwned());
+    qr->setProj(persistedEntry[kProjectionField].Obj().getOwned());
+    qr->setCollation(persistedEntry[kCollationField].Obj().getOwned());
+
+    const boost::intrusive_ptr<ExpressionContext> expCtx;
+    const ExtensionsCallbackReal extensionsCallback(opCtx, &autoColl.getNss());
+    auto cq = uassertStatusOK(
+        CanonicalQuery::canonicalize(opCtx,
+                                     std::move(qr),
+                                     expCtx,
+                                     extensionsCallback,
+                                     MatchExpressionParser::kAllowAllSpecialFeatures));
+    if (!PlanCache::shouldCacheQuery(*cq)) {
+        return false;
+    }
+
+    // The plan cache key also encodes which indexes are eligible for the query, so a matching key
+    // means the persisted index assignments still make sense for this query.
+    auto planCache = CollectionQueryInfo::get(collection).getPlanCache();
+    const auto key = planCache->computeKey(*cq);
+    if (static_cast<long long>(canonical_query_encoder::computeHash(key.stringData())) !=
+        persistedEntry[kPlanCacheKeyField].numberLong()) {
+        return false;
+    }
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(opCtx, collection, cq.get(), &plannerParams);
+    if (plannerParams.indexFiltersApplied) {
+        return false;
+    }
+
+    auto plannerData = uassertStatusOK(
+        parseSolutionCacheData(persistedEntry[kPlannerDataField].Obj(), plannerParams.indices));
+    return planCache->restore(*cq,
+                              std::move(plannerData),
+                              static_cast<size_t>(persistedEntry[kWorksField].numberLong()),
+                              Date_t::now());
+}
+
+}  // namespace
+
+BSONObj serializeSolutionCacheData(const SolutionCacheData& data) {
+    BSONObjBuilder builder;
+    builder.append(kSolutionTypeField, static_cast<int>(data.solnType));
+    builder.append(kWholeIXSolnDirField, data.wholeIXSolnDir);
+    builder.append(kIndexFilterAppliedField, data.indexFilterApplied);
+    if (data.tree) {
+        builder.append(kTreeField, serializeIndexTree(*data.tree));
+    }
+    return builder.obj();
+}
+
+StatusWith<std::unique_ptr<SolutionCacheData>> parseSolutionCacheData(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexes) try {
+    auto data = std::make_unique<SolutionCacheData>();
+    const auto solnType = obj[kSolutionTypeField].Int();
+    switch (solnType) {
+        case SolutionCacheData::WHOLE_IXSCAN_SOLN:
+        case SolutionCacheData::COLLSCAN_SOLN:
+        case SolutionCacheData::USE_INDEX_TAGS_SOLN:
+            data->solnType = static_cast<SolutionCacheData::SolutionType>(solnType);
+            break;
+        default:
+            uasserted(ErrorCodes::FailedToParse,
+                      str::stream() << "Invalid solution type: " << solnType);
+    }
+    data->wholeIXSolnDir = obj[kWholeIXSolnDirField].Int();
+    data->indexFilterApplied = obj[kIndexFilterAppliedField].trueValue();
+
+    if (auto treeElem = obj[kTreeField]) {
+        data->tree = parseIndexTree(treeElem.Obj(), indexes);
+    }
+    uassert(ErrorCodes::FailedToParse,
+            "Only a collection scan solution may omit its index tree",
+            data->tree || data->solnType == SolutionCacheData::COLLSCAN_SOLN);
+    return {std::move(data)};
+} catch (const DBException& ex) {
+    return ex.toStatus();
+}
+
+long long computeIndexCatalogVersion(OperationContext* opCtx, const Collection* collection) {
+    std::vector<std::pair<std::string, BSONObj>> specs;
+    auto it = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (it->more()) {
+        auto descriptor = it->next()->descriptor();
+        specs.emplace_back(descriptor->indexName(), descriptor->infoObj());
+    }
+    std::sort(specs.begin(), specs.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    BufBuilder specsBuilder;
+    for (auto&& spec : specs) {
+        specsBuilder.appendBuf(spec.second.objdata(), spec.second.objsize());
+    }
+    return canonical_query_encoder::computeHash(StringData(specsBuilder.buf(), specsBuilder.len()));
+}
+
+StatusWith<size_t> persistPlanCaches(OperationContext* opCtx) {
+    std::vector<InsertStatement> persistedEntries;
+    const auto& catalog = CollectionCatalog::get(opCtx);
+    for (auto&& dbName : catalog.getAllDbNames()) {
+        if (dbName == NamespaceString::kLocalDb) {
+            continue;
+        }
+
+        for (auto&& uuid : catalog.getAllCollectionUUIDsFromDb(dbName)) {
+            try {
+                AutoGetCollectionForRead autoColl(opCtx, NamespaceStringOrUUID(dbName, uuid));
+                auto collection = autoColl.getCollection();
+                if (!collection) {
+                    continue;
+                }
+
+                const auto indexCatalogVersion = computeIndexCatalogVersion(opCtx, collection);
+                auto planCache = CollectionQueryInfo::get(collection).getPlanCache();
+                for (auto&& entry : planCache->getAllEntries()) {
+                    // Index filters are not persisted, so neither are plans chosen under them.
+                    if (!entry->isActive || entry->plannerData.empty() ||
+                        entry->plannerData[0]->indexFilterApplied) {
+                        continue;
+                    }
+                    persistedEntries.emplace_back(makePersistedEntry(
+                        autoColl.getNss(), uuid, indexCatalogVersion, *entry));
+                }
+            } catch (const ExceptionFor<ErrorCodes::NamespaceNotFound>&) {
+                // The collection was dropped after we listed it.
+            }
+        }
+    }
+
+    const auto& nss = NamespaceString::kPlanCacheNamespace;
+    auto status =
+        repl::StorageInterface::get(opCtx)->createCollection(opCtx, nss, CollectionOptions());
+    if (!status.isOK() && status.code() != ErrorCodes::NamespaceExists) {
+        return status;
+    }
+
+    // The previous entries are replaced in a single WriteUnitOfWork, so that a failure or a crash
+    // leaves either all of them or all of the new ones.
+    return writeConflictRetry(opCtx, "persistPlanCaches", nss.ns(), [&]() -> StatusWith<size_t> {
+        AutoGetCollection autoColl(opCtx, nss, MODE_IX);
+        auto collection = autoColl.getCollection();
+        if (!collection) {
+            return Status(ErrorCodes::NamespaceNotFound,
+                          str::stream() << "Collection " << nss << " was dropped");
+        }
+
+        std::vector<RecordId> previousEntries;
+        auto cursor = collection->getCursor(opCtx);
+        while (auto record = cursor->next()) {
+            previousEntries.push_back(record->id);
+        }
+        cursor.reset();
+
+        WriteUnitOfWork wuow(opCtx);
+        for (auto&& rid : previousEntries) {
+            collection->deleteDocument(opCtx, kUninitializedStmtId, rid, nullptr);
+        }
+        auto insertStatus = collection->insertDocuments(
+            opCtx, persistedEntries.cbegin(), persistedEntries.cend(), nullptr, false);
+        if (!insertStatus.isOK()) {
+            return insertStatus;
+        }
+        wuow.commit();
+        return persistedEntries.size();
+    });
+}
+
+StatusWith<size_t> restorePlanCaches(OperationContext* opCtx) {
+    auto swPersistedEntries = repl::StorageInterface::get(opCtx)->findDocuments(
+        opCtx,
+        NamespaceString::kPlanCacheNamespace,
+        boost::none,
+        repl::StorageInterface::ScanDirection::kForward,
+        BSONObj(),
+        BoundInclusion::kIncludeStartKeyOnly,
+        std::numeric_limits<std::size_t>::max());
+    if (swPersistedEntries.getStatus() == ErrorCodes::NamespaceNotFound) {
+        return size_t{0};
+    }
+    if (!swPersistedEntries.isOK()) {
+        return swPersistedEntries.getStatus();
+    }
+
+    size_t numRestored = 0;
+    for (auto&& persistedEntry : swPersistedEntries.getValue()) {
+        try {
+            if (restoreEntry(opCtx, persistedEntry)) {
+                ++numRestored;
+            }
+        } catch (const ExceptionForCat<ErrorCategory::Interruption>&) {
+            throw;
+        } catch (const DBException& ex) {
+            LOGV2_DEBUG(51801,
+                        1,
+                        "Not restoring persisted plan cache entry {entry}: {error}",
+                        "entry"_attr = redact(persistedEntry),
+                        "error"_attr = redact(ex.toStatus()));
+        }
+    }
+    return numRestored;
+}
+
+}  // namespace plan_cache_persistence
+}  // namespace mongo
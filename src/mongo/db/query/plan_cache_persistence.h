@@ -0,0 +1,87 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/query/index_entry.h"
+
+namespace mongo {
+
+class Collection;
+class OperationContext;
+struct SolutionCacheData;
+
+/**
+ * Persists the active entries of the plan caches to NamespaceString::kPlanCacheNamespace so that
+ * they survive a restart, and restores them into the plan caches.
+ *
+ * Each persisted entry records the index catalog version of its collection. An entry is restored
+ * only if its collection still has the same index definitions and the entry's query still maps to
+ * the same plan cache key, so the winning plan it describes can still be built.
+ */
+namespace plan_cache_persistence {
+
+/**
+ * Serializes 'data', referring to indexes by their identifiers.
+ */
+BSONObj serializeSolutionCacheData(const SolutionCacheData& data);
+
+/**
+ * Parses the output of serializeSolutionCacheData(), resolving the index identifiers against
+ * 'indexes'. Fails if an index is not among 'indexes'.
+ */
+StatusWith<std::unique_ptr<SolutionCacheData>> parseSolutionCacheData(
+    const BSONObj& obj, const std::vector<IndexEntry>& indexes);
+
+/**
+ * Returns a fingerprint of the definitions of the collection's ready indexes, which changes
+ * whenever an index is created, dropped or modified.
+ */
+long long computeIndexCatalogVersion(OperationContext* opCtx, const Collection* collection);
+
+/**
+ * Replaces the persisted entries with the active entries of every collection's plan cache, in a
+ * single write. Returns the number of entries written.
+ */
+StatusWith<size_t> persistPlanCaches(OperationContext* opCtx);
+
+/**
+ * Adds each persisted entry which is still valid to its collection's plan cache, unless the cache
+ * already has an entry for the same query shape. Returns the number of entries restored.
+ */
+StatusWith<size_t> restorePlanCaches(OperationContext* opCtx);
+
+}  // namespace plan_cache_persistence
+}  // namespace mongo
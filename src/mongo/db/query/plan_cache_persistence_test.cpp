@@ -0,0 +1,272 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/query/plan_cache_persistence.h"
+
+#include <limits>
+
+#include "mongo/db/catalog/catalog_test_fixture.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/collection_query_info.h"
+#include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_planner_params.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/repl/storage_interface.h"
+#include "mongo/db/storage/write_unit_of_work.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class PlanCachePersistenceTest : public CatalogTestFixture {
+protected:
+    void setUp() override {
+        CatalogTestFixture::setUp();
+        repl::StorageInterface::set(getServiceContext(),
+                                    std::make_unique<repl::StorageInterfaceImpl>());
+        ASSERT_OK(storageInterface()->createCollection(operationContext(), _nss, {}));
+        createIndex(BSON("a" << 1), "a_1");
+    }
+
+    void createIndex(const BSONObj& keyPattern, const std::string& indexName) {
+        auto opCtx = operationContext();
+        writeConflictRetry(opCtx, "createIndex", _nss.ns(), [&] {
+            AutoGetCollection autoColl(opCtx, _nss, MODE_X);
+            auto indexSpec = BSON("v" << int(IndexDescriptor::kLatestIndexVersion) << "key"
+                                      << keyPattern << "name" << indexName);
+            WriteUnitOfWork wuow(opCtx);
+            ASSERT_OK(autoColl.getCollection()
+                          ->getIndexCatalog()
+                          ->createIndexOnEmptyCollection(opCtx, indexSpec)
+                          .getStatus());
+            wuow.commit();
+        });
+    }
+
+    std::unique_ptr<CanonicalQuery> canonicalize(const BSONObj& filter) {
+        auto qr = std::make_unique<QueryRequest>(_nss);
+        qr->setFilter(filter);
+        return uassertStatusOK(CanonicalQuery::canonicalize(operationContext(), std::move(qr)));
+    }
+
+    std::vector<IndexEntry> getIndexEntries(CanonicalQuery* cq) {
+        AutoGetCollectionForRead autoColl(operationContext(), _nss);
+        QueryPlannerParams plannerParams;
+        fillOutPlannerParams(operationContext(), autoColl.getCollection(), cq, &plannerParams);
+        return plannerParams.indices;
+    }
+
+    PlanCache* getPlanCache() {
+        AutoGetCollectionForRead autoColl(operationContext(), _nss);
+        return CollectionQueryInfo::get(autoColl.getCollection()).getPlanCache();
+    }
+
+    /**
+     * Returns planner data for a scan of the index named 'indexName'.
+     */
+    std::unique_ptr<SolutionCacheData> makeIndexScanData(const std::vector<IndexEntry>& indexes,
+                                                         const std::string& indexName) {
+        auto data = std::make_unique<SolutionCacheData>();
+        data->solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+        data->tree = std::make_unique<PlanCacheIndexTree>();
+        for (auto&& index : indexes) {
+            if (index.identifier.catalogName == indexName) {
+                data->tree->setIndexEntry(index);
+            }
+        }
+        ASSERT(data->tree->entry);
+        return data;
+    }
+
+    /**
+     * Adds an active entry for a scan of the "a_1" index to the plan cache, as if the query
+     * {a: 1} had been planned.
+     */
+    void cacheIndexScan() {
+        auto cq = canonicalize(BSON("a" << 1));
+        ASSERT_TRUE(getPlanCache()->restore(
+            *cq, makeIndexScanData(getIndexEntries(cq.get()), "a_1"), 10, Date_t::now()));
+    }
+
+    std::vector<BSONObj> findPersistedEntries() {
+        return uassertStatusOK(storageInterface()->findDocuments(
+            operationContext(),
+            NamespaceString::kPlanCacheNamespace,
+            boost::none,
+            repl::StorageInterface::ScanDirection::kForward,
+            BSONObj(),
+            BoundInclusion::kIncludeStartKeyOnly,
+            std::numeric_limits<std::size_t>::max()));
+    }
+
+    const NamespaceString _nss{"test.plan_cache_persistence"};
+};
+
+TEST_F(PlanCachePersistenceTest, SolutionCacheDataRoundTrips) {
+    auto cq = canonicalize(BSON("a" << 1));
+    auto indexes = getIndexEntries(cq.get());
+
+    SolutionCacheData data;
+    data.solnType = SolutionCacheData::USE_INDEX_TAGS_SOLN;
+    data.wholeIXSolnDir = -1;
+    data.tree = std::make_unique<PlanCacheIndexTree>();
+    auto child = std::make_unique<PlanCacheIndexTree>();
+    for (auto&& index : indexes) {
+        if (index.identifier.catalogName == "a_1") {
+            child->setIndexEntry(index);
+        }
+    }
+    child->index_pos = 1;
+    child->canCombineBounds = false;
+    child->orPushdowns.push_back({IndexEntry::Identifier{"_id_"}, 0, true, {0, 2}});
+    data.tree->children.push_back(child.release());
+
+    const auto serialized = plan_cache_persistence::serializeSolutionCacheData(data);
+    auto parsed =
+        uassertStatusOK(plan_cache_persistence::parseSolutionCacheData(serialized, indexes));
+    ASSERT_EQ(SolutionCacheData::USE_INDEX_TAGS_SOLN, parsed->solnType);
+    ASSERT_EQ(-1, parsed->wholeIXSolnDir);
+    ASSERT_FALSE(parsed->indexFilterApplied);
+    ASSERT_FALSE(parsed->tree->entry);
+    ASSERT_EQ(1U, parsed->tree->children.size());
+
+    const auto parsedChild = parsed->tree->children[0];
+    ASSERT_EQ("a_1", parsedChild->entry->identifier.catalogName);
+    ASSERT_EQ(1U, parsedChild->index_pos);
+    ASSERT_FALSE(parsedChild->canCombineBounds);
+    ASSERT_EQ(1U, parsedChild->orPushdowns.size());
+    ASSERT_EQ("_id_", parsedChild->orPushdowns[0].indexEntryId.catalogName);
+    ASSERT_EQ(2U, parsedChild->orPushdowns[0].route.size());
+    ASSERT_EQ(2U, parsedChild->orPushdowns[0].route[1]);
+
+    ASSERT_BSONOBJ_EQ(serialized, plan_cache_persistence::serializeSolutionCacheData(*parsed));
+}
+
+TEST_F(PlanCachePersistenceTest, ParseSolutionCacheDataRejectsMalformedData) {
+    auto cq = canonicalize(BSON("a" << 1));
+    auto indexes = getIndexEntries(cq.get());
+    const auto valid =
+        plan_cache_persistence::serializeSolutionCacheData(*makeIndexScanData(indexes, "a_1"));
+    ASSERT_OK(plan_cache_persistence::parseSolutionCacheData(valid, indexes).getStatus());
+
+    auto parse = [&](const BSONObj& obj) {
+        return plan_cache_persistence::parseSolutionCacheData(obj, indexes).getStatus();
+    };
+    // Returns the valid data with 'field' replaced in its index tree.
+    auto withTreeField = [&](const BSONObj& field) {
+        const auto tree = valid["tree"].Obj().addField(field.firstElement());
+        return valid.addField(BSON("tree" << tree).firstElement());
+    };
+
+    // An unknown solution type.
+    ASSERT_EQ(ErrorCodes::FailedToParse,
+              parse(valid.addField(BSON("solutionType" << 99).firstElement())));
+    // An index scan without its index tree.
+    ASSERT_EQ(ErrorCodes::FailedToParse, parse(valid.removeField("tree")));
+    // A negative index position.
+    ASSERT_EQ(ErrorCodes::FailedToParse, parse(withTreeField(BSON("position" << -1))));
+    // An index which the collection does not have.
+    ASSERT_EQ(ErrorCodes::IndexNotFound,
+              parse(withTreeField(BSON("index" << BSON("name"
+                                                       << "b_1"
+                                                       << "disambiguator"
+                                                       << "")))));
+    // A missing field.
+    ASSERT_NOT_OK(parse(valid.removeField("wholeIXSolnDir")));
+}
+
+TEST_F(PlanCachePersistenceTest, PersistedEntriesAreRestoredIntoAnEmptyPlanCache) {
+    cacheIndexScan();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+
+    getPlanCache()->clear();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::restorePlanCaches(operationContext())));
+
+    auto entry = uassertStatusOK(getPlanCache()->getEntry(*canonicalize(BSON("a" << 1))));
+    ASSERT_TRUE(entry->isActive);
+    ASSERT_EQ(10U, entry->works);
+    ASSERT_EQ("a_1", entry->plannerData[0]->tree->entry->identifier.catalogName);
+
+    // An entry the cache already has is not restored again.
+    ASSERT_EQ(0U, uassertStatusOK(plan_cache_persistence::restorePlanCaches(operationContext())));
+}
+
+TEST_F(PlanCachePersistenceTest, PersistReplacesThePreviouslyPersistedEntries) {
+    cacheIndexScan();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+    ASSERT_EQ(1U, findPersistedEntries().size());
+
+    getPlanCache()->clear();
+    ASSERT_EQ(0U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+    ASSERT_EQ(0U, findPersistedEntries().size());
+}
+
+TEST_F(PlanCachePersistenceTest, RestoreSkipsMalformedEntries) {
+    cacheIndexScan();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+
+    // A persisted entry whose planner data no longer parses, and one missing most of its fields.
+    auto persistedEntry = findPersistedEntries()[0];
+    ASSERT_OK(storageInterface()->insertDocument(
+        operationContext(),
+        NamespaceString::kPlanCacheNamespace,
+        {persistedEntry.addField(BSON("_id" << OID::gen()).firstElement())
+             .addField(BSON("plannerData" << BSON("solutionType" << 99)).firstElement())},
+        repl::OpTime::kUninitializedTerm));
+    ASSERT_OK(storageInterface()->insertDocument(operationContext(),
+                                                 NamespaceString::kPlanCacheNamespace,
+                                                 {BSON("_id" << OID::gen() << "ns" << _nss.ns())},
+                                                 repl::OpTime::kUninitializedTerm));
+
+    getPlanCache()->clear();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::restorePlanCaches(operationContext())));
+    ASSERT_EQ(1U, getPlanCache()->size());
+}
+
+TEST_F(PlanCachePersistenceTest, RestoreSkipsEntriesPersistedBeforeAnIndexChange) {
+    cacheIndexScan();
+    ASSERT_EQ(1U, uassertStatusOK(plan_cache_persistence::persistPlanCaches(operationContext())));
+
+    createIndex(BSON("b" << 1), "b_1");
+    getPlanCache()->clear();
+    ASSERT_EQ(0U, uassertStatusOK(plan_cache_persistence::restorePlanCaches(operationContext())));
+    ASSERT_EQ(0U, getPlanCache()->size());
+}
+
+}  // namespace
+}  // namespace mongo
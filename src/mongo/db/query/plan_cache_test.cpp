@@ -569,6 +569,45 @@ TEST(PlanCacheTest, PlanCacheLRUPolicyRemovesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+TEST(PlanCacheTest, SmallCacheUsesSingleShard) {
+    PlanCache planCache(10, 16);
+    ASSERT_EQ(planCache.getShardStats().size(), 1U);
+}
+
+TEST(PlanCacheTest, ShardStatsCountHitsMissesAndEntries) {
+    PlanCache planCache(1024, 4);
+    QueryTestServiceContext serviceContext;
+    ASSERT_EQ(planCache.getShardStats().size(), 4U);
+
+    // Add entries for a number of distinct shapes, each looked up once before and once after it
+    // is added.
+    std::string queryString = "{a: 1}";
+    const size_t kNumShapes = 20;
+    for (size_t i = 0; i < kNumShapes; ++i) {
+        queryString[1]++;
+        unique_ptr<CanonicalQuery> cq(canonicalize(queryString));
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+        addCacheEntryForShape(*cq, &planCache);
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+    ASSERT_EQ(planCache.size(), kNumShapes);
+
+    PlanCache::ShardStats totals;
+    for (auto&& shardStats : planCache.getShardStats()) {
+        totals.entries += shardStats.entries;
+        totals.hits += shardStats.hits;
+        totals.misses += shardStats.misses;
+        totals.evictions += shardStats.evictions;
+    }
+    ASSERT_EQ(totals.entries, kNumShapes);
+    ASSERT_EQ(totals.hits, static_cast<long long>(kNumShapes));
+    ASSERT_EQ(totals.misses, static_cast<long long>(kNumShapes));
+    ASSERT_EQ(totals.evictions, 0);
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+}
+
 TEST(PlanCacheTest, PlanCacheRemoveDeletesInactiveEntries) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -633,6 +672,27 @@ TEST(PlanCacheTest, AddActiveCacheEntry) {
     ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
 }
 
+TEST(PlanCacheTest, RestoreAddsActiveEntryWithoutOverwriting) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    QueryTestServiceContext serviceContext;
+
+    // A restored entry is active right away, with the works value it was persisted with.
+    auto qs = getQuerySolutionForCaching();
+    std::unique_ptr<SolutionCacheData> plannerData(qs->cacheData->clone());
+    ASSERT_TRUE(planCache.restore(*cq, std::move(plannerData), 10U, Date_t{}));
+    ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentActive);
+    auto entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_EQ(entry->works, 10U);
+
+    // Restoring again must not replace the entry that is already there.
+    plannerData.reset(qs->cacheData->clone());
+    ASSERT_FALSE(planCache.restore(*cq, std::move(plannerData), 20U, Date_t{}));
+    entry = assertGet(planCache.getEntry(*cq));
+    ASSERT_EQ(entry->works, 10U);
+    ASSERT_EQUALS(planCache.size(), 1U);
+}
+
 TEST(PlanCacheTest, WorksValueIncreases) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -261,12 +261,18 @@ PlanEnumerator::PlanEnumerator(const PlanEnumeratorParams& params)
       _indices(params.indices),
       _ixisect(params.intersect),
       _orLimit(params.maxSolutionsPerOr),
-      _intersectLimit(params.maxIntersectPerAnd) {}
+      _intersectLimit(params.maxIntersectPerAnd),
+      _arena(params.arena) {}
 
 PlanEnumerator::~PlanEnumerator() {
     typedef stdx::unordered_map<MemoID, NodeAssignment*> MemoMap;
     for (MemoMap::iterator it = _memo.begin(); it != _memo.end(); ++it) {
-        delete it->second;
+        if (_arena) {
+            // The arena reclaims the memory itself when the operation ends.
+            it->second->~NodeAssignment();
+        } else {
+            delete it->second;
+        }
     }
 }
 
@@ -381,7 +387,9 @@ void PlanEnumerator::allocateAssignment(MatchExpression* expr,
     verify(_nodeToId.end() == _nodeToId.find(expr));
     _nodeToId[expr] = newID;
     verify(_memo.end() == _memo.find(newID));
-    NodeAssignment* newAssignment = new NodeAssignment();
+    NodeAssignment* newAssignment = _arena
+        ? new (_arena->allocate(sizeof(NodeAssignment), alignof(NodeAssignment))) NodeAssignment()
+        : new NodeAssignment();
     _memo[newID] = newAssignment;
     *assign = newAssignment;
     *id = newID;
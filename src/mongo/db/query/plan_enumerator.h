@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "mongo/base/status.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/index_entry.h"
 #include "mongo/db/query/index_tag.h"
@@ -44,7 +45,8 @@ struct PlanEnumeratorParams {
     PlanEnumeratorParams()
         : intersect(false),
           maxSolutionsPerOr(internalQueryEnumerationMaxOrSolutions.load()),
-          maxIntersectPerAnd(internalQueryEnumerationMaxIntersectPerAnd.load()) {}
+          maxIntersectPerAnd(internalQueryEnumerationMaxIntersectPerAnd.load()),
+          arena(nullptr) {}
 
     // Do we provide solutions that use more indices than the minimum required to provide
     // an indexed solution?
@@ -65,6 +67,10 @@ struct PlanEnumeratorParams {
     // all-pairs approach, we could wind up creating a lot of enumeration possibilities for
     // certain inputs.
     size_t maxIntersectPerAnd;
+
+    // If set, the memo's assignments are allocated from this arena rather than the heap. Not owned
+    // here.
+    OperationArena* arena;
 };
 
 /**
@@ -534,6 +540,9 @@ private:
     // Map from MemoID to its precomputed solution info.
     stdx::unordered_map<MemoID, NodeAssignment*> _memo;
 
+    // If set, the NodeAssignments in '_memo' live in this arena. Not owned here.
+    OperationArena* _arena;
+
     // If true, there are no further enumeration states, and getNext should return false.
     // We could be _done immediately after init if we're unable to output an indexed plan.
     bool _done;
@@ -54,6 +54,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/logv2/log.h"
@@ -561,7 +562,7 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         }
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code = _workRoot(&id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -664,9 +665,33 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
     }
 }
 
+PlanStage::StageState PlanExecutorImpl::_workRoot(WorkingSetID* out) {
+    if (_batch && !_batch->empty()) {
+        *out = _batch->next();
+        return PlanStage::ADVANCED;
+    }
+
+    const auto batchSize = internalQueryExecBatchedWorkSize.load();
+    if (batchSize <= 1 || !_root->supportsBatchedWork()) {
+        return _root->work(out);
+    }
+
+    if (!_batch || _batch->capacity() != static_cast<size_t>(batchSize)) {
+        _batch = std::make_unique<WorkingSetBatch>(_workingSet.get(), batchSize);
+    }
+    _batch->clear();
+
+    PlanStage::StageState code = _root->workBatch(_batch.get(), out);
+    if (PlanStage::ADVANCED == code) {
+        *out = _batch->next();
+    }
+    return code;
+}
+
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && (!_batch || _batch->empty()) && _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
@@ -32,6 +32,8 @@
 #include <boost/optional.hpp>
 #include <queue>
 
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/working_set_batch.h"
 #include "mongo/db/query/plan_executor.h"
 
 namespace mongo {
@@ -155,6 +157,13 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<Document>* objOut, RecordId* dlOut);
 
+    /**
+     * Produces the next result from '_root'. If batched execution is enabled and the root stage
+     * supports it, results are pulled from '_root' a batch at a time with workBatch() and handed
+     * out of '_batch' one by one. Otherwise this is equivalent to calling '_root->work()'.
+     */
+    PlanStage::StageState _workRoot(WorkingSetID* out);
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -189,6 +198,10 @@ private:
     // stages.
     std::queue<Document> _stash;
 
+    // Results which '_root' has produced through workBatch() but which have not yet been returned.
+    // Lazily created the first time batched execution is used.
+    std::unique_ptr<WorkingSetBatch> _batch;
+
     // The output document that is used by getNext BSON API. This allows us to avoid constantly
     // allocating and freeing DocumentStorage.
     Document _docOutput;
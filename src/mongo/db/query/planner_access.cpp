@@ -240,6 +240,10 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         csn->resumeAfterRecordId = RecordId(resumeAfterObj["$recordId"].numberLong());
     }
 
+    // Extract and assign the RecordId range to which the scan is restricted, if present.
+    csn->minRecord = query.getQueryRequest().getMinRecord();
+    csn->maxRecord = query.getQueryRequest().getMaxRecord();
+
     if (query.nss().isOplog() && csn->direction == 1) {
         // Optimizes the start and end location parameters for a collection scan for an oplog
         // collection. Not compatible with $_resumeAfter so we do not optimize in that case.
@@ -44,6 +44,7 @@
 #include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/matcher/expression_geo.h"
 #include "mongo/db/matcher/expression_text.h"
+#include "mongo/db/operation_arena.h"
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/collation/collation_index_key.h"
 #include "mongo/db/query/collation/collator_interface.h"
@@ -825,6 +826,14 @@ StatusWith<std::vector<std::unique_ptr<QuerySolution>>> QueryPlanner::plan(
         enumParams.root = query.root();
         enumParams.indices = &relevantIndices;
 
+        // The memo only lives as long as the enumerator, so its memory is handed back to the
+        // operation's arena as soon as planning is done.
+        boost::optional<OperationArena::Scope> arenaScope;
+        if (auto opCtx = query.getExpCtx()->opCtx) {
+            enumParams.arena = &OperationArena::get(opCtx);
+            arenaScope.emplace(enumParams.arena);
+        }
+
         PlanEnumerator isp(enumParams);
         isp.init().transitional_ignore();
 
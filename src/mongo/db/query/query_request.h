@@ -38,6 +38,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/pipeline/runtime_constants_gen.h"
 #include "mongo/db/query/tailable_mode.h"
+#include "mongo/db/record_id.h"
 
 namespace mongo {
 
@@ -450,6 +451,23 @@ public:
         _resumeAfter = resumeAfter;
     }
 
+    const boost::optional<RecordId>& getMinRecord() const {
+        return _minRecord;
+    }
+
+    const boost::optional<RecordId>& getMaxRecord() const {
+        return _maxRecord;
+    }
+
+    /**
+     * Restricts a collection scan to the records whose RecordIds lie in ['minRecord', 'maxRecord'].
+     * Only settable internally; the range is neither parsed from nor serialized to a command.
+     */
+    void setRecordIdRange(RecordId minRecord, RecordId maxRecord) {
+        _minRecord = std::move(minRecord);
+        _maxRecord = std::move(maxRecord);
+    }
+
     bool use44SortKeys() const {
         return _use44SortKeys;
     }
@@ -544,6 +562,10 @@ private:
     // field.
     BSONObj _resumeAfter;
 
+    // If set, the bounds of the RecordId range to which a collection scan is restricted.
+    boost::optional<RecordId> _minRecord;
+    boost::optional<RecordId> _maxRecord;
+
     bool _wantMore = true;
 
     // Must be either unset or positive. Negative skip is illegal and a skip of zero received from
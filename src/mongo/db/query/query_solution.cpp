@@ -255,6 +255,8 @@ QuerySolutionNode* CollectionScanNode::clone() const {
     copy->direction = this->direction;
     copy->shouldTrackLatestOplogTimestamp = this->shouldTrackLatestOplogTimestamp;
     copy->shouldWaitForOplogVisibility = this->shouldWaitForOplogVisibility;
+    copy->minRecord = this->minRecord;
+    copy->maxRecord = this->maxRecord;
 
     return copy;
 }
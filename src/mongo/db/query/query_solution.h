@@ -360,6 +360,11 @@ struct CollectionScanNode : public QuerySolutionNode {
     // This field cannot be used in conjunction with 'minTs' or 'maxTs'.
     boost::optional<RecordId> resumeAfterRecordId;
 
+    // If present, the collection scan is restricted to the records whose RecordIds lie within
+    // ['minRecord', 'maxRecord']. Must only be set on forward collection scans.
+    boost::optional<RecordId> minRecord;
+    boost::optional<RecordId> maxRecord;
+
     // Should we make a tailable cursor?
     bool tailable;
 
@@ -87,6 +87,8 @@ std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
             params.maxTs = csn->maxTs;
             params.requestResumeToken = csn->requestResumeToken;
             params.resumeAfterRecordId = csn->resumeAfterRecordId;
+            params.minRecord = csn->minRecord;
+            params.maxRecord = csn->maxRecord;
             params.stopApplyingFilterAfterFirstMatch = csn->stopApplyingFilterAfterFirstMatch;
             return std::make_unique<CollectionScan>(
                 opCtx, collection, params, ws, csn->filter.get());
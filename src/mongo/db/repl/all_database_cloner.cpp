@@ -31,8 +31,6 @@
 
 #include "mongo/platform/basic.h"
 
-#include <algorithm>
-
 #include "mongo/base/string_data.h"
 #include "mongo/db/repl/all_database_cloner.h"
 #include "mongo/logv2/log.h"
@@ -54,34 +52,6 @@ BaseCloner::ClonerStages AllDatabaseCloner::getStages() {
     return {&_connectStage, &_listDatabasesStage};
 }
 
-Status AllDatabaseCloner::ensurePrimaryOrSecondary(
-    const executor::RemoteCommandResponse& isMasterReply) {
-    if (!isMasterReply.isOK()) {
-        LOGV2(21054, "Cannot reconnect because isMaster command failed.");
-        return isMasterReply.status;
-    }
-    if (isMasterReply.data["ismaster"].trueValue() || isMasterReply.data["secondary"].trueValue())
-        return Status::OK();
-
-    // There is a window during startup where a node has an invalid configuration and will have
-    // an isMaster response the same as a removed node.  So we must check to see if the node is
-    // removed by checking local configuration.
-    auto otherNodes =
-        ReplicationCoordinator::get(getGlobalServiceContext())->getOtherNodesInReplSet();
-    if (std::find(otherNodes.begin(), otherNodes.end(), getSource()) == otherNodes.end()) {
-        Status status(ErrorCodes::NotMasterOrSecondary,
-                      str::stream() << "Sync source " << getSource()
-                                    << " has been removed from the replication configuration.");
-        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
-        // Setting the status in the shared data will cancel the initial sync.
-        getSharedData()->setInitialSyncStatusIfOK(lk, status);
-        return status;
-    }
-    return Status(ErrorCodes::NotMasterOrSecondary,
-                  str::stream() << "Cannot connect because sync source " << getSource()
-                                << " is neither primary nor secondary.");
-}
-
 BaseCloner::AfterStageBehavior AllDatabaseCloner::connectStage() {
     auto* client = getClient();
     // If the client already has the address (from a previous attempt), we must allow it to
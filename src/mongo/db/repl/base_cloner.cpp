@@ -31,7 +31,10 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+
 #include "mongo/db/repl/base_cloner.h"
+#include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
@@ -201,6 +204,33 @@ Status BaseCloner::checkRollBackIdIsUnchanged() {
     return Status::OK();
 }
 
+Status BaseCloner::ensurePrimaryOrSecondary(const executor::RemoteCommandResponse& isMasterReply) {
+    if (!isMasterReply.isOK()) {
+        LOGV2(21054, "Cannot reconnect because isMaster command failed.");
+        return isMasterReply.status;
+    }
+    if (isMasterReply.data["ismaster"].trueValue() || isMasterReply.data["secondary"].trueValue())
+        return Status::OK();
+
+    // There is a window during startup where a node has an invalid configuration and will have
+    // an isMaster response the same as a removed node.  So we must check to see if the node is
+    // removed by checking local configuration.
+    auto otherNodes =
+        ReplicationCoordinator::get(getGlobalServiceContext())->getOtherNodesInReplSet();
+    if (std::find(otherNodes.begin(), otherNodes.end(), getSource()) == otherNodes.end()) {
+        Status status(ErrorCodes::NotMasterOrSecondary,
+                      str::stream() << "Sync source " << getSource()
+                                    << " has been removed from the replication configuration.");
+        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+        // Setting the status in the shared data will cancel the initial sync.
+        getSharedData()->setInitialSyncStatusIfOK(lk, status);
+        return status;
+    }
+    return Status(ErrorCodes::NotMasterOrSecondary,
+                  str::stream() << "Cannot connect because sync source " << getSource()
+                                << " is neither primary nor secondary.");
+}
+
 BaseCloner::AfterStageBehavior BaseCloner::runStageWithRetries(BaseClonerStage* stage) {
     ON_BLOCK_EXIT([this] { clearRetryingState(); });
     Status lastError = Status::OK();
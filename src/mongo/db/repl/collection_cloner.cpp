@@ -32,13 +32,17 @@
 #include "mongo/platform/basic.h"
 
 #include "mongo/base/string_data.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
+#include "mongo/db/client.h"
 #include "mongo/db/commands/list_collections_filter.h"
 #include "mongo/db/repl/collection_bulk_loader.h"
 #include "mongo/db/repl/collection_cloner.h"
 #include "mongo/db/repl/database_cloner_gen.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
+#include "mongo/db/repl/replication_auth.h"
 #include "mongo/db/wire_version.h"
 #include "mongo/logv2/log.h"
+#include "mongo/rpc/get_status_from_command_result.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -53,6 +57,13 @@ MONGO_FAIL_POINT_DEFINE(initialSyncHangDuringCollectionClone);
 // DBClientConnection, optionally limited to a specific collection.
 MONGO_FAIL_POINT_DEFINE(initialSyncHangCollectionClonerAfterHandlingBatchResponse);
 
+namespace {
+
+// Number of _id values sampled from the sync source for each range of a partitioned query.
+const int kSampledIdsPerPartition = 64;
+
+}  // namespace
+
 CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
                                    const CollectionOptions& collectionOptions,
                                    InitialSyncSharedData* sharedData,
@@ -88,6 +99,8 @@ CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
           _dbWorkTaskRunner.schedule(std::move(task));
           return executor::TaskExecutor::CallbackHandle();
       }),
+      _createClientFn(
+          [] { return std::make_unique<DBClientConnection>(true /* autoReconnect */); }),
       _dbWorkTaskRunner(dbPool) {
     invariant(sourceNss.isValid());
     invariant(collectionOptions.uuid);
@@ -194,7 +207,15 @@ BaseCloner::AfterStageBehavior CollectionCloner::createCollectionStage() {
 BaseCloner::AfterStageBehavior CollectionCloner::queryStage() {
     // Attempt to clean up cursor from the last retry (if applicable).
     killOldQueryCursor();
-    runQuery();
+    if (!_partitionsChosen) {
+        _partitions = makeQueryPartitions();
+        _partitionsChosen = true;
+    }
+    if (_partitions.empty()) {
+        runQuery();
+    } else {
+        runPartitionedQuery();
+    }
     waitForDatabaseWorkToComplete();
     // We want to free the _collLoader regardless of whether the commit succeeds.
     std::unique_ptr<CollectionBulkLoader> loader = std::move(_collLoader);
@@ -272,6 +293,228 @@ void CollectionCloner::runQuery() {
     }
 }
 
+std::vector<CollectionCloner::QueryPartition> CollectionCloner::makeQueryPartitions() {
+    const int numPartitions = collectionClonerPartitions.load();
+    // Ranges are only resumable through the _id index, which must order keys the same way as the
+    // sampled _id values are sorted. Capped collections must be cloned in insertion order.
+    if (numPartitions < 2 || !_resumeSupported || _idIndexSpec.isEmpty() ||
+        _collectionOptions.capped || !_collectionOptions.collation.isEmpty()) {
+        return {};
+    }
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_stats.documentToCopy <
+            static_cast<size_t>(collectionClonerPartitionMinDocuments.load())) {
+            return {};
+        }
+    }
+
+    const int sampleSize = numPartitions * kSampledIdsPerPartition;
+    std::vector<BSONObj> sampledIds;
+    try {
+        BSONObj res;
+        getClient()->runCommand(
+            _sourceNss.db().toString(),
+            BSON("aggregate" << _sourceNss.coll() << "pipeline"
+                             << BSON_ARRAY(BSON("$sample" << BSON("size" << sampleSize))
+                                           << BSON("$project" << BSON("_id" << 1))
+                                           << BSON("$sort" << BSON("_id" << 1)))
+                             << "cursor" << BSON("batchSize" << sampleSize)),
+            res,
+            QueryOption_SlaveOk);
+        uassertStatusOK(getStatusFromCommandResult(res));
+        for (auto&& elem : res["cursor"]["firstBatch"].Obj()) {
+            sampledIds.push_back(elem.Obj().getOwned());
+        }
+    } catch (const DBException& e) {
+        LOGV2(51807,
+              "Cloning collection {nss} with a single query because sampling its _id values "
+              "failed: {error}",
+              "nss"_attr = _sourceNss,
+              "error"_attr = redact(e));
+        return {};
+    }
+    if (sampledIds.empty()) {
+        return {};
+    }
+
+    std::vector<QueryPartition> partitions(1);
+    for (int i = 1; i < numPartitions; i++) {
+        const auto& splitId = sampledIds[i * sampledIds.size() / numPartitions];
+        // Sampling may return the same document more than once.
+        if (SimpleBSONObjComparator::kInstance.evaluate(splitId == partitions.back().min)) {
+            continue;
+        }
+        partitions.back().max = splitId;
+        partitions.emplace_back();
+        partitions.back().min = splitId;
+    }
+    if (partitions.size() < 2) {
+        return {};
+    }
+
+    LOGV2(51808,
+          "Cloning collection {nss} in {numPartitions} _id ranges",
+          "nss"_attr = _sourceNss,
+          "numPartitions"_attr = partitions.size());
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stats.partitions = partitions.size();
+    }
+    return partitions;
+}
+
+void CollectionCloner::runPartitionedQuery() {
+    // The ranges block on the network and on the insertion of each other's documents, so they run
+    // on a pool of their own rather than on the database worker pool which inserts the documents.
+    ThreadPool::Options options;
+    options.poolName = "CollectionClonerPartitions";
+    options.minThreads = 0;
+    options.maxThreads = _partitions.size();
+    options.onCreateThread = [](const std::string& threadName) {
+        Client::initThread(threadName);
+    };
+    ThreadPool pool(std::move(options));
+    pool.startup();
+
+    std::vector<Status> statuses(_partitions.size(), Status::OK());
+    for (size_t i = 0; i < _partitions.size(); i++) {
+        if (_partitions[i].done) {
+            continue;
+        }
+        pool.schedule([this, partition = &_partitions[i], &status = statuses[i]](
+                          Status scheduleStatus) {
+            if (!scheduleStatus.isOK()) {
+                status = scheduleStatus;
+                return;
+            }
+            try {
+                auto client = _createClientFn();
+                client->setHandshakeValidationHook(
+                    [this](const executor::RemoteCommandResponse& isMasterReply) {
+                        return ensurePrimaryOrSecondary(isMasterReply);
+                    });
+                uassertStatusOK(client->connect(getSource(), StringData()));
+                uassertStatusOK(replAuthenticate(client.get())
+                                    .withContext(str::stream() << "Failed to authenticate to "
+                                                               << getSource()));
+                runPartitionQuery(client.get(), partition);
+            } catch (...) {
+                status = exceptionToStatus();
+            }
+        });
+    }
+    pool.shutdown();
+    pool.join();
+    for (const auto& status : statuses) {
+        uassertStatusOK(status);
+    }
+}
+
+void CollectionCloner::runPartitionQuery(DBClientConnection* client, QueryPartition* partition) {
+    Query query = QUERY("query" << BSONObj() << "$readOnce" << true);
+    query.hint(BSON("_id" << 1));
+
+    // The lower bound is inclusive, so a resumed range receives its last document again and
+    // skips it.
+    bool skipLastId = !partition->lastId.isEmpty();
+    const auto& min = skipLastId ? partition->lastId : partition->min;
+    if (!min.isEmpty()) {
+        query.minKey(min);
+    }
+    if (!partition->max.isEmpty()) {
+        query.maxKey(partition->max);
+    }
+
+    // Unlike the single query, a failed range is resumed with a new cursor, so its cursor is left
+    // to time out on the sync source rather than being killed.
+    client->query(
+        [&](DBClientCursorBatchIterator& iter) {
+            handlePartitionBatch(partition, &skipLastId, iter);
+        },
+        _sourceDbAndUuid,
+        query,
+        nullptr /* fieldsToReturn */,
+        QueryOption_SlaveOk | (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
+        _collectionClonerBatchSize);
+    partition->done = true;
+}
+
+void CollectionCloner::handlePartitionBatch(QueryPartition* partition,
+                                            bool* skipLastId,
+                                            DBClientCursorBatchIterator& iter) {
+    if (mustExit()) {
+        uasserted(ErrorCodes::CallbackCanceled,
+                  "Collection cloning cancelled due to initial sync failure");
+    }
+
+    std::vector<BSONObj> docs;
+    size_t bytes = 0;
+    while (iter.moreInCurrentBatch()) {
+        auto doc = iter.nextSafe();
+        if (*skipLastId) {
+            *skipLastId = false;
+            if (SimpleBSONObjComparator::kInstance.evaluate(doc["_id"].wrap() ==
+                                                            partition->lastId)) {
+                continue;
+            }
+        }
+        bytes += doc.objsize();
+        docs.push_back(std::move(doc));
+    }
+    if (docs.empty()) {
+        return;
+    }
+    partition->lastId = docs.back()["_id"].wrap();
+
+    // While the inserts hang on this fail point, the ranges stop reading from the sync source
+    // rather than buffering documents up to collectionClonerPartitionMaxBytesToInsert.
+    initialSyncHangDuringCollectionClone.executeIf(
+        [&](const BSONObj&) {
+            while (MONGO_unlikely(initialSyncHangDuringCollectionClone.shouldFail(
+                       [&](const BSONObj& data) { return isHangDuringCloneFailPoint(data); })) &&
+                   !mustExit()) {
+                sleepmillis(100);
+            }
+        },
+        [&](const BSONObj& data) { return isHangDuringCloneFailPoint(data); });
+
+    const size_t maxBytesToInsert = collectionClonerPartitionMaxBytesToInsert.load();
+    bool mustScheduleInsert;
+    {
+        stdx::unique_lock<Latch> lk(_mutex);
+        while (_partitionBytesToInsert >= maxBytesToInsert) {
+            lk.unlock();
+            if (mustExit()) {
+                uasserted(ErrorCodes::CallbackCanceled,
+                          "Collection cloning cancelled due to initial sync failure");
+            }
+            lk.lock();
+            _documentsInsertedCondition.wait_for(lk, Milliseconds(100).toSystemDuration(), [&] {
+                return _partitionBytesToInsert < maxBytesToInsert;
+            });
+        }
+        _stats.receivedBatches++;
+        // An insertion that is already scheduled also takes the documents added here.
+        mustScheduleInsert = _documentsToInsert.empty();
+        _documentsToInsert.insert(_documentsToInsert.end(),
+                                  std::make_move_iterator(docs.begin()),
+                                  std::make_move_iterator(docs.end()));
+        _partitionBytesToInsert += bytes;
+    }
+
+    if (mustScheduleInsert) {
+        auto&& scheduleResult = _scheduleDbWorkFn(
+            [=](const executor::TaskExecutor::CallbackArgs& cbd) { insertDocumentsCallback(cbd); });
+        if (!scheduleResult.isOK()) {
+            uassertStatusOK(scheduleResult.getStatus().withContext(
+                str::stream() << "Error cloning collection '" << _sourceNss.ns() << "'"));
+        }
+    }
+
+    hangAfterHandlingBatchResponse();
+}
+
 void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
     {
         stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
@@ -322,6 +565,10 @@ void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
         _resumeToken = iter.getPostBatchResumeToken();
     }
 
+    hangAfterHandlingBatchResponse();
+}
+
+void CollectionCloner::hangAfterHandlingBatchResponse() {
     initialSyncHangCollectionClonerAfterHandlingBatchResponse.executeIf(
         [&](const BSONObj&) {
             while (MONGO_unlikely(
@@ -354,6 +601,8 @@ void CollectionCloner::insertDocumentsCallback(const executor::TaskExecutor::Cal
             return;
         }
         _documentsToInsert.swap(docs);
+        _partitionBytesToInsert = 0;
+        _documentsInsertedCondition.notify_all();
         _stats.documentsCopied += docs.size();
         ++_stats.fetchedBatches;
         _progressMeter.hit(int(docs.size()));
@@ -374,10 +623,13 @@ void CollectionCloner::insertDocumentsCallback(const executor::TaskExecutor::Cal
                 mongo::sleepsecs(1);
             }
         },
-        [&](const BSONObj& data) {
-            return data["namespace"].String() == _sourceNss.ns() &&
-                static_cast<int>(_stats.documentsCopied) >= data["numDocsToClone"].numberInt();
-        });
+        [&](const BSONObj& data) { return isHangDuringCloneFailPoint(data); });
+}
+
+bool CollectionCloner::isHangDuringCloneFailPoint(const BSONObj& data) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return data["namespace"].String() == _sourceNss.ns() &&
+        static_cast<int>(_stats.documentsCopied) >= data["numDocsToClone"].numberInt();
 }
 
 bool CollectionCloner::isMyFailPoint(const BSONObj& data) const {
@@ -456,6 +708,9 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
         }
     }
     builder->appendNumber("receivedBatches", receivedBatches);
+    if (partitions > 1) {
+        builder->appendNumber("partitions", partitions);
+    }
 }
 
 }  // namespace repl
@@ -29,11 +29,13 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 #include "mongo/db/repl/base_cloner.h"
 #include "mongo/db/repl/task_runner.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
@@ -58,6 +60,7 @@ public:
         size_t indexes{0};
         size_t fetchedBatches{0};  // This is actually inserted batches.
         size_t receivedBatches{0};
+        size_t partitions{0};  // Number of _id ranges cloned concurrently, if more than one.
 
         std::string toString() const;
         BSONObj toBSON() const;
@@ -72,6 +75,12 @@ public:
     using ScheduleDbWorkFn = unique_function<StatusWith<executor::TaskExecutor::CallbackHandle>(
         executor::TaskExecutor::CallbackFn)>;
 
+    /**
+     * Type of function to create the additional connections used to clone a collection in
+     * several _id ranges at once.
+     */
+    using CreateClientFn = std::function<std::unique_ptr<DBClientConnection>()>;
+
     CollectionCloner(const NamespaceString& ns,
                      const CollectionOptions& collectionOptions,
                      InitialSyncSharedData* sharedData,
@@ -117,6 +126,15 @@ public:
         _scheduleDbWorkFn = std::move(scheduleDbWorkFn);
     }
 
+    /**
+     * Overrides how connections for partitioned queries are created.
+     *
+     * For testing only.
+     */
+    void setCreateClientFn_forTest(CreateClientFn createClientFn) {
+        _createClientFn = std::move(createClientFn);
+    }
+
 protected:
     ClonerStages getStages() final;
 
@@ -125,6 +143,19 @@ protected:
 private:
     friend class CollectionClonerTest;
 
+    /**
+     * A range of the source collection's _id index that is queried over its own connection.
+     */
+    struct QueryPartition {
+        BSONObj min;  // Inclusive lower bound, or empty for the first range.
+        BSONObj max;  // Exclusive upper bound, or empty for the last range.
+
+        // The _id of the last document received, from which the range resumes after an error.
+        // Only accessed by the thread querying this range while the query stage runs.
+        BSONObj lastId;
+        bool done = false;
+    };
+
     class CollectionClonerStage : public ClonerStage<CollectionCloner> {
     public:
         CollectionClonerStage(std::string name, CollectionCloner* cloner, ClonerRunFn stageFunc)
@@ -204,6 +235,45 @@ private:
      */
     void handleNextBatch(DBClientCursorBatchIterator& iter);
 
+    /**
+     * Splits the source collection into _id ranges of roughly equal document counts by sampling
+     * its _id values. Returns no ranges if the collection should be cloned with a single query.
+     */
+    std::vector<QueryPartition> makeQueryPartitions();
+
+    /**
+     * Queries every range in _partitions that is not done yet concurrently on a thread pool of
+     * their own, each over a new connection to the sync source, and waits for all of them. Throws
+     * the first error.
+     */
+    void runPartitionedQuery();
+
+    /**
+     * Queries the documents of 'partition' over 'client', resuming after the last document
+     * received if an earlier attempt failed.
+     */
+    void runPartitionQuery(DBClientConnection* client, QueryPartition* partition);
+
+    /**
+     * Like handleNextBatch, but for a batch of one range of a partitioned query. Blocks while too
+     * many documents from other ranges are waiting to be inserted.
+     */
+    void handlePartitionBatch(QueryPartition* partition,
+                              bool* skipLastId,
+                              DBClientCursorBatchIterator& iter);
+
+    /**
+     * Blocks while the initialSyncHangCollectionClonerAfterHandlingBatchResponse fail point is
+     * enabled for this collection.
+     */
+    void hangAfterHandlingBatchResponse();
+
+    /**
+     * Returns whether the data of the initialSyncHangDuringCollectionClone fail point names this
+     * collection and no more documents than have already been copied.
+     */
+    bool isHangDuringCloneFailPoint(const BSONObj& data);
+
     /**
      * Called whenever there is a new batch of documents ready from the DBClientConnection.
      *
@@ -261,8 +331,14 @@ private:
     std::unique_ptr<CollectionBulkLoader> _collLoader;  // (X)
     //  Function for scheduling database work using the executor.
     ScheduleDbWorkFn _scheduleDbWorkFn;  // (R)
+    // Function for creating the connections used by partitioned queries.
+    CreateClientFn _createClientFn;  // (R)
     // Documents read from source to insert.
     std::vector<BSONObj> _documentsToInsert;  // (M)
+    // Size of the documents in _documentsToInsert that were read by partitioned queries.
+    size_t _partitionBytesToInsert = 0;  // (M)
+    // Signalled when _documentsToInsert is taken for insertion.
+    stdx::condition_variable _documentsInsertedCondition;  // (S)
     Stats _stats;                             // (M)
     // Putting _dbWorkTaskRunner last ensures anything the database work threads depend on,
     // like _documentsToInsert, is destroyed after those threads exit.
@@ -284,6 +360,11 @@ private:
     // Signifies that there were changes to the collection on the sync source that resulted in
     // our remote cursor getting killed.
     bool _lostNonResumableCursor = false;  // (X)
+
+    // The _id ranges queried concurrently, chosen the first time the query stage runs. Empty if
+    // the collection is cloned with a single query.
+    std::vector<QueryPartition> _partitions;  // (X)
+    bool _partitionsChosen = false;           // (X)
 };
 
 }  // namespace repl
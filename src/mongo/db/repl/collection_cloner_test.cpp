@@ -34,12 +34,15 @@
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/db/repl/cloner_test_fixture.h"
 #include "mongo/db/repl/collection_cloner.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/service_context_test_fixture.h"
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace repl {
@@ -327,6 +330,264 @@ TEST_F(CollectionClonerTest, InsertDocumentsMultipleBatches) {
     ASSERT_EQUALS(2u, stats.receivedBatches);
 }
 
+TEST_F(CollectionClonerTest, PartitionedQueryClonesEachRangeOverItsOwnConnection) {
+    auto oldPartitions = collectionClonerPartitions.load();
+    auto oldMinDocuments = collectionClonerPartitionMinDocuments.load();
+    collectionClonerPartitions.store(2);
+    collectionClonerPartitionMinDocuments.store(1);
+    ON_BLOCK_EXIT([&] {
+        collectionClonerPartitions.store(oldPartitions);
+        collectionClonerPartitionMinDocuments.store(oldMinDocuments);
+    });
+
+    // Set up data for preliminary stages
+    _mockServer->setCommandReply("count", createCountResponse(4));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    // The sampled _id values split the collection at {_id: 3}.
+    _mockServer->setCommandReply(
+        "aggregate",
+        createCursorResponse(_nss.ns(),
+                             BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2) << BSON("_id" << 3)
+                                                         << BSON("_id" << 4))));
+
+    // Each range is served over its own connection. The mock servers do not apply the range
+    // bounds, so each one only holds the documents of one range.
+    std::vector<std::unique_ptr<MockRemoteDBServer>> rangeServers;
+    for (int i = 0; i < 2; i++) {
+        rangeServers.push_back(std::make_unique<MockRemoteDBServer>(_source.toString()));
+        rangeServers.back()->assignCollectionUuid(_nss.ns(), _collUuid);
+        rangeServers.back()->insert(_nss.ns(), BSON("_id" << 2 * i + 1));
+        rangeServers.back()->insert(_nss.ns(), BSON("_id" << 2 * i + 2));
+    }
+
+    auto cloner = makeCollectionCloner();
+    AtomicWord<int> clientsCreated{0};
+    cloner->setCreateClientFn_forTest([&] {
+        auto server = rangeServers[clientsCreated.fetchAndAdd(1)].get();
+        return std::unique_ptr<DBClientConnection>(new MockDBClientConnection(server));
+    });
+
+    ASSERT_OK(cloner->run());
+
+    ASSERT_EQUALS(2, clientsCreated.load());
+    ASSERT_EQUALS(4, _collectionStats->insertCount);
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(2u, stats.partitions);
+    ASSERT_EQUALS(2u, stats.receivedBatches);
+    ASSERT_EQUALS(4u, stats.documentsCopied);
+}
+
+TEST_F(CollectionClonerTest, PartitionedQueryFallsBackToSingleQueryWhenSamplingFails) {
+    auto oldPartitions = collectionClonerPartitions.load();
+    auto oldMinDocuments = collectionClonerPartitionMinDocuments.load();
+    collectionClonerPartitions.store(2);
+    collectionClonerPartitionMinDocuments.store(1);
+    ON_BLOCK_EXIT([&] {
+        collectionClonerPartitions.store(oldPartitions);
+        collectionClonerPartitionMinDocuments.store(oldMinDocuments);
+    });
+
+    // Set up data for preliminary stages
+    _mockServer->setCommandReply("count", createCountResponse(2));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    _mockServer->setCommandReply("aggregate",
+                                 Status(ErrorCodes::OperationFailed, "sampling failed"));
+
+    // Set up documents to be returned from upstream node.
+    _mockServer->insert(_nss.ns(), BSON("_id" << 1));
+    _mockServer->insert(_nss.ns(), BSON("_id" << 2));
+
+    auto cloner = makeCollectionCloner();
+    cloner->setCreateClientFn_forTest([]() -> std::unique_ptr<DBClientConnection> {
+        FAIL("A single query must not open additional connections");
+        MONGO_UNREACHABLE;
+    });
+
+    ASSERT_OK(cloner->run());
+
+    ASSERT_EQUALS(2, _collectionStats->insertCount);
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    ASSERT_EQUALS(0u, cloner->getStats().partitions);
+}
+
+/**
+ * A connection for one _id range of a partitioned query that splits the collection at {_id: 3}.
+ * The mock servers do not apply the range bounds, so queries for the range below the split are
+ * served by 'lowServer' and queries for the range above it by 'highServer'. Each query is passed
+ * to 'onQuery'. If 'failLowRange' is set, the next query for the low range fails with a network
+ * error after its first batch, and clears it.
+ */
+class PartitionConnection : public MockDBClientConnection {
+public:
+    PartitionConnection(MockRemoteDBServer* lowServer,
+                        MockRemoteDBServer* highServer,
+                        std::function<void(const BSONObj&)> onQuery,
+                        AtomicWord<bool>* failLowRange)
+        : MockDBClientConnection(lowServer),
+          _highRangeConnection(highServer),
+          _onQuery(std::move(onQuery)),
+          _failLowRange(failLowRange) {}
+
+    using MockDBClientConnection::query;
+
+    unsigned long long query(std::function<void(DBClientCursorBatchIterator&)> f,
+                             const NamespaceStringOrUUID& nsOrUuid,
+                             Query query,
+                             const BSONObj* fieldsToReturn,
+                             int queryOptions,
+                             int batchSize) override {
+        _onQuery(query.obj.getOwned());
+        if (!query.obj.hasField("$max")) {
+            return _highRangeConnection.query(
+                f, nsOrUuid, query, fieldsToReturn, queryOptions, batchSize);
+        }
+        bool failAfterFirstBatch = _failLowRange->swap(false);
+        return MockDBClientConnection::query(
+            [&](DBClientCursorBatchIterator& iter) {
+                f(iter);
+                uassert(ErrorCodes::HostUnreachable,
+                        "Lost the connection after the first batch",
+                        !failAfterFirstBatch);
+            },
+            nsOrUuid,
+            query,
+            fieldsToReturn,
+            queryOptions,
+            batchSize);
+    }
+
+private:
+    MockDBClientConnection _highRangeConnection;
+    std::function<void(const BSONObj&)> _onQuery;
+    AtomicWord<bool>* _failLowRange;
+};
+
+TEST_F(CollectionClonerTest, PartitionedQueryBoundsEachRangeByTheSampledIds) {
+    auto oldPartitions = collectionClonerPartitions.load();
+    auto oldMinDocuments = collectionClonerPartitionMinDocuments.load();
+    collectionClonerPartitions.store(2);
+    collectionClonerPartitionMinDocuments.store(1);
+    ON_BLOCK_EXIT([&] {
+        collectionClonerPartitions.store(oldPartitions);
+        collectionClonerPartitionMinDocuments.store(oldMinDocuments);
+    });
+
+    // Set up data for preliminary stages
+    _mockServer->setCommandReply("count", createCountResponse(4));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    // The sampled _id values split the collection at {_id: 3}.
+    _mockServer->setCommandReply(
+        "aggregate",
+        createCursorResponse(_nss.ns(),
+                             BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2) << BSON("_id" << 3)
+                                                         << BSON("_id" << 4))));
+
+    MockRemoteDBServer lowServer(_source.toString());
+    MockRemoteDBServer highServer(_source.toString());
+    for (auto server : {&lowServer, &highServer}) {
+        server->assignCollectionUuid(_nss.ns(), _collUuid);
+    }
+    lowServer.insert(_nss.ns(), BSON("_id" << 1));
+    lowServer.insert(_nss.ns(), BSON("_id" << 2));
+    highServer.insert(_nss.ns(), BSON("_id" << 3));
+    highServer.insert(_nss.ns(), BSON("_id" << 4));
+
+    auto queriesMutex = MONGO_MAKE_LATCH();
+    std::vector<BSONObj> queries;
+    AtomicWord<bool> failLowRange{false};
+    auto cloner = makeCollectionCloner();
+    cloner->setCreateClientFn_forTest([&] {
+        return std::unique_ptr<DBClientConnection>(new PartitionConnection(
+            &lowServer,
+            &highServer,
+            [&](const BSONObj& query) {
+                stdx::lock_guard<Latch> lk(queriesMutex);
+                queries.push_back(query);
+            },
+            &failLowRange));
+    });
+
+    ASSERT_OK(cloner->run());
+
+    // The first range has no lower bound and the last range has no upper bound.
+    ASSERT_EQUALS(2u, queries.size());
+    for (const auto& query : queries) {
+        if (query.hasField("$min")) {
+            ASSERT_BSONOBJ_EQ(BSON("_id" << 3), query["$min"].Obj());
+            ASSERT_FALSE(query.hasField("$max"));
+        } else {
+            ASSERT_BSONOBJ_EQ(BSON("_id" << 3), query["$max"].Obj());
+        }
+        ASSERT_BSONOBJ_EQ(BSON("_id" << 1), query["$hint"].Obj());
+    }
+    ASSERT_EQUALS(4, _collectionStats->insertCount);
+    ASSERT_EQUALS(4u, cloner->getStats().documentsCopied);
+}
+
+TEST_F(CollectionClonerTest, PartitionedQueryResumesAFailedRangeAfterItsLastId) {
+    auto oldPartitions = collectionClonerPartitions.load();
+    auto oldMinDocuments = collectionClonerPartitionMinDocuments.load();
+    collectionClonerPartitions.store(2);
+    collectionClonerPartitionMinDocuments.store(1);
+    ON_BLOCK_EXIT([&] {
+        collectionClonerPartitions.store(oldPartitions);
+        collectionClonerPartitionMinDocuments.store(oldMinDocuments);
+    });
+
+    // Set up data for preliminary stages
+    _mockServer->setCommandReply("count", createCountResponse(4));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    // The sampled _id values split the collection at {_id: 3}.
+    _mockServer->setCommandReply(
+        "aggregate",
+        createCursorResponse(_nss.ns(),
+                             BSON_ARRAY(BSON("_id" << 1) << BSON("_id" << 2) << BSON("_id" << 3)
+                                                         << BSON("_id" << 4))));
+
+    MockRemoteDBServer lowServer(_source.toString());
+    MockRemoteDBServer highServer(_source.toString());
+    for (auto server : {&lowServer, &highServer}) {
+        server->assignCollectionUuid(_nss.ns(), _collUuid);
+    }
+    lowServer.insert(_nss.ns(), BSON("_id" << 1));
+    lowServer.insert(_nss.ns(), BSON("_id" << 2));
+    highServer.insert(_nss.ns(), BSON("_id" << 3));
+    highServer.insert(_nss.ns(), BSON("_id" << 4));
+
+    // The low range loses its connection after receiving {_id: 1}.
+    auto queriesMutex = MONGO_MAKE_LATCH();
+    std::vector<BSONObj> queries;
+    AtomicWord<bool> failLowRange{true};
+    auto cloner = makeCollectionCloner();
+    cloner->setBatchSize_forTest(1);
+    cloner->setCreateClientFn_forTest([&] {
+        return std::unique_ptr<DBClientConnection>(new PartitionConnection(
+            &lowServer,
+            &highServer,
+            [&](const BSONObj& query) {
+                stdx::lock_guard<Latch> lk(queriesMutex);
+                queries.push_back(query);
+            },
+            &failLowRange));
+    });
+
+    ASSERT_OK(cloner->run());
+
+    // Only the low range is queried again, from its last _id. The server sends that document
+    // again, and it is not inserted twice.
+    ASSERT_EQUALS(3u, queries.size());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1), queries.back()["$min"].Obj());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 3), queries.back()["$max"].Obj());
+    ASSERT_EQUALS(4, _collectionStats->insertCount);
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    ASSERT_EQUALS(4u, cloner->getStats().documentsCopied);
+}
+
 TEST_F(CollectionClonerTest, InsertDocumentsScheduleDBWorkFailed) {
     // Set up data for preliminary stages
     _mockServer->setCommandReply("count", createCountResponse(2));
@@ -43,6 +43,7 @@
 #include "mongo/db/logical_session_id.h"
 #include "mongo/db/repl/apply_ops.h"
 #include "mongo/db/repl/insert_group.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/transaction_oplog_application.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/logv2/log.h"
@@ -72,6 +73,11 @@ ServerStatusMetricField<Counter64> displayOplogApplicationBatchSize("repl.apply.
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// Time spent waiting for the oplog writes of a batch to finish before its operations are applied.
+TimerStats waitForOplogWritesStats;
+ServerStatusMetricField<TimerStats> displayWaitForOplogWrites("repl.apply.waitForOplogWrites",
+                                                              &waitForOplogWritesStats);
+
 NamespaceString parseUUIDOrNs(OperationContext* opCtx, const OplogEntry& oplogEntry) {
     auto optionalUuid = oplogEntry.getUuid();
     if (!optionalUuid) {
@@ -551,6 +557,7 @@ void scheduleWritesToOplog(OperationContext* opCtx,
             // This code path is only executed on secondaries and initial syncing nodes, so it is
             // safe to exclude any writes from Flow Control.
             opCtx->setShouldParticipateInFlowControl(false);
+            opCtx->lockState()->setAdmissionPriority(AdmissionContext::Priority::kReplication);
 
             UnreplicatedWritesBlock uwb(opCtx.get());
             ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
@@ -645,12 +652,19 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
         //   and create a pseudo oplog.
         std::vector<std::vector<OplogEntry>> derivedOps;
 
+        // Operations are partitioned into more chains than there are writer threads. Every
+        // operation on a given document hashes to the same chain and keeps its oplog order there,
+        // so chains never conflict with each other and may be applied in any order.
+        const size_t numWriters = _writerPool->getStats().numThreads;
         std::vector<std::vector<const OplogEntry*>> writerVectors(
-            _writerPool->getStats().numThreads);
+            numWriters * static_cast<size_t>(replWriterChainsPerThread.load()));
         fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
 
         // Wait for writes to finish before applying ops.
-        _writerPool->waitForIdle();
+        {
+            TimerHolder waitTimer(&waitForOplogWritesStats);
+            _writerPool->waitForIdle();
+        }
 
         // Use this fail point to hold the PBWM lock after we have written the oplog entries but
         // before we have applied them.
@@ -668,18 +682,29 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
         }
 
         {
-            std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
+            // Largest chains are handed out first so that a long chain claimed late does not
+            // leave the rest of the pool idle at the end of the batch.
+            std::vector<std::vector<const OplogEntry*>*> chains;
+            for (auto& writer : writerVectors) {
+                if (!writer.empty())
+                    chains.push_back(&writer);
+            }
+            std::stable_sort(chains.begin(), chains.end(), [](const auto* lhs, const auto* rhs) {
+                return lhs->size() > rhs->size();
+            });
+            AtomicWord<size_t> nextChain{0};
 
-            // Doles out all the work to the writer pool threads. writerVectors is not modified,
-            // but  applyOplogBatchPerWorker will modify the vectors that it contains.
-            invariant(writerVectors.size() == statusVector.size());
-            for (size_t i = 0; i < writerVectors.size(); i++) {
-                if (writerVectors[i].empty())
-                    continue;
+            std::vector<Status> statusVector(std::min(numWriters, chains.size()), Status::OK());
 
+            // Doles out all the work to the writer pool threads. Each worker keeps claiming the
+            // next unapplied chain until none are left. writerVectors is not modified, but
+            // applyOplogBatchPerWorker will modify the vectors that it contains.
+            invariant(statusVector.size() <= multikeyVector.size());
+            for (size_t i = 0; i < statusVector.size(); i++) {
                 _writerPool->schedule(
                     [this,
-                     &writer = writerVectors.at(i),
+                     &chains,
+                     &nextChain,
                      &status = statusVector.at(i),
                      &multikeyVector = multikeyVector.at(i)](auto scheduleStatus) {
                         invariant(scheduleStatus);
@@ -691,7 +716,19 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
                         opCtx->setShouldParticipateInFlowControl(false);
 
                         status = opCtx->runWithoutInterruptionExceptAtGlobalShutdown([&] {
-                            return applyOplogBatchPerWorker(opCtx.get(), &writer, &multikeyVector);
+                            for (auto chain = nextChain.fetchAndAdd(1); chain < chains.size();
+                                 chain = nextChain.fetchAndAdd(1)) {
+                                WorkerMultikeyPathInfo chainMultikeyPathInfo;
+                                auto chainStatus = applyOplogBatchPerWorker(
+                                    opCtx.get(), chains[chain], &chainMultikeyPathInfo);
+                                if (!chainStatus.isOK()) {
+                                    return chainStatus;
+                                }
+                                multikeyVector.insert(multikeyVector.end(),
+                                                      chainMultikeyPathInfo.begin(),
+                                                      chainMultikeyPathInfo.end());
+                            }
+                            return Status::OK();
                         });
                     });
             }
@@ -769,7 +806,7 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
- * writerVectors - Set of operations for each worker thread to apply.
+ * writerVectors - Set of independent operation chains for the worker threads to apply.
  * derivedOps - If provided, this function inserts a decomposition of applyOps operations
  *      and instructions for updating the transactions table.  Required if processing oplogs
  *      with transactions.
@@ -1010,6 +1047,7 @@ Status OplogApplierImpl::applyOplogBatchPerWorker(OperationContext* opCtx,
     // ShouldNotConflictWithSecondaryBatchApplicationBlock will touch the locker that has been
     // destroyed by unstash in its destructor. Thus we set the flag explicitly.
     opCtx->lockState()->setShouldConflictWithSecondaryBatchApplication(false);
+    opCtx->lockState()->setAdmissionPriority(AdmissionContext::Priority::kReplication);
 
     // Explicitly start future read transactions without a timestamp.
     opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kNoTimestamp);
@@ -30,6 +30,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -383,6 +384,87 @@ TEST_F(OplogApplierImplTest,
                                                      createOplogCollectionOptions()));
 }
 
+/**
+ * Test only subclass of OplogApplierImpl that does not apply oplog entries, but records the chain
+ * of operations handed to each applyOplogBatchPerWorker() call.
+ */
+class TrackChainsApplier : public OplogApplierImpl {
+public:
+    using OplogApplierImpl::OplogApplierImpl;
+
+    Status applyOplogBatchPerWorker(OperationContext* opCtx,
+                                    std::vector<const OplogEntry*>* ops,
+                                    WorkerMultikeyPathInfo* workerMultikeyPathInfo) override {
+        stdx::lock_guard<Latch> lock(_mutex);
+        chainsApplied.emplace_back();
+        for (auto&& opPtr : *ops) {
+            chainsApplied.back().push_back(*opPtr);
+        }
+        return Status::OK();
+    }
+
+    std::vector<std::vector<OplogEntry>> chainsApplied;
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("TrackChainsApplier::_mutex");
+};
+
+TEST_F(OplogApplierImplTest, MultiApplyKeepsOperationsOnSameDocumentInOneOrderedChain) {
+    auto writerPool = makeReplWriterPool(4);
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+    createCollection(_opCtx.get(), nss, CollectionOptions());
+
+    const int numDocs = 50;
+    const int numUpdatesPerDoc = 3;
+    std::vector<OplogEntry> ops;
+    long long ts = 1;
+    for (int i = 0; i < numDocs; i++) {
+        ops.push_back(makeInsertDocumentOplogEntry(
+            {Timestamp(Seconds(ts++), 0), 1LL}, nss, BSON("_id" << i << "x" << 0)));
+    }
+    for (int update = 1; update <= numUpdatesPerDoc; update++) {
+        for (int i = 0; i < numDocs; i++) {
+            ops.push_back(makeUpdateDocumentOplogEntry({Timestamp(Seconds(ts++), 0), 1LL},
+                                                       nss,
+                                                       BSON("_id" << i),
+                                                       BSON("$set" << BSON("x" << update))));
+        }
+    }
+
+    NoopOplogApplierObserver observer;
+    TrackChainsApplier oplogApplier(
+        nullptr,  // executor
+        nullptr,  // oplogBuffer
+        &observer,
+        ReplicationCoordinator::get(_opCtx.get()),
+        getConsistencyMarkers(),
+        getStorageInterface(),
+        repl::OplogApplier::Options(repl::OplogApplication::Mode::kSecondary),
+        writerPool.get());
+    ASSERT_EQUALS(ops.back().getOpTime(),
+                  unittest::assertGet(oplogApplier.applyOplogBatch(_opCtx.get(), ops)));
+
+    // Every operation is applied exactly once, and all operations on a document are found in a
+    // single chain in their original oplog order.
+    std::map<int, size_t> chainForDoc;
+    std::map<int, Timestamp> lastTimestampForDoc;
+    size_t numOpsApplied = 0;
+    for (size_t chain = 0; chain < oplogApplier.chainsApplied.size(); chain++) {
+        for (const auto& op : oplogApplier.chainsApplied[chain]) {
+            const int id = op.getIdElement().numberInt();
+            auto inserted = chainForDoc.emplace(id, chain);
+            ASSERT_EQUALS(chain, inserted.first->second);
+            if (!inserted.second) {
+                ASSERT_LT(lastTimestampForDoc[id], op.getTimestamp());
+            }
+            lastTimestampForDoc[id] = op.getTimestamp();
+            numOpsApplied++;
+        }
+    }
+    ASSERT_EQUALS(ops.size(), numOpsApplied);
+    ASSERT_EQUALS(static_cast<size_t>(numDocs), chainForDoc.size());
+}
+
 TEST_F(OplogApplierImplTest,
        OplogApplicationThreadFuncUsesApplyOplogEntryOrGroupedInsertsToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
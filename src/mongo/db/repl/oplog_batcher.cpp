@@ -32,9 +32,11 @@
 #include "mongo/db/repl/oplog_batcher.h"
 
 #include "mongo/db/catalog_raii.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/commands/txn_cmds_gen.h"
 #include "mongo/db/repl/oplog_applier.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
+#include "mongo/db/stats/timer_stats.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/log.h"
 
@@ -42,6 +44,34 @@ namespace mongo {
 namespace repl {
 MONGO_FAIL_POINT_DEFINE(skipOplogBatcherWaitForData);
 
+namespace {
+
+// Each stage of the batcher/applier pipeline records the time it spends stalled on its neighbour.
+// Time the batcher waits for the oplog buffer to receive entries from the fetcher.
+TimerStats batcherWaitForDataStats;
+ServerStatusMetricField<TimerStats> displayBatcherWaitForData("repl.batcher.waitForData",
+                                                              &batcherWaitForDataStats);
+
+// Time a formed batch waits for the applier to finish the previous batch and take it.
+TimerStats batcherWaitForApplierStats;
+ServerStatusMetricField<TimerStats> displayBatcherWaitForApplier("repl.batcher.waitForApplier",
+                                                                 &batcherWaitForApplierStats);
+
+// Time the applier waits for the batcher to form the next batch.
+TimerStats applierWaitForBatchStats;
+ServerStatusMetricField<TimerStats> displayApplierWaitForBatch("repl.apply.waitForBatch",
+                                                               &applierWaitForBatchStats);
+
+}  // namespace
+
+BSONObj OplogBatcher::getStallStatsBSON() {
+    BSONObjBuilder builder;
+    builder.append("batcherWaitForData", batcherWaitForDataStats.getReport());
+    builder.append("batcherWaitForApplier", batcherWaitForApplierStats.getReport());
+    builder.append("applierWaitForBatch", applierWaitForBatchStats.getReport());
+    return builder.obj();
+}
+
 OplogBatcher::OplogBatcher(OplogApplier* oplogApplier, OplogBuffer* oplogBuffer)
     : _oplogApplier(oplogApplier), _oplogBuffer(oplogBuffer), _ops(0) {}
 OplogBatcher::~OplogBatcher() {
@@ -62,6 +92,7 @@ OplogBatch OplogBatcher::getNextBatch(Seconds maxWaitTime) {
     if (_ops.empty() && !_ops.mustShutdown() && !_ops.termWhenExhausted()) {
         // We intentionally don't care about whether this returns due to signaling or timeout
         // since we do the same thing either way: return whatever is in _ops.
+        TimerHolder waitTimer(&applierWaitForBatchStats);
         (void)_cv.wait_for(lk, maxWaitTime.toSystemDuration());
     }
 
@@ -283,8 +314,8 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
 
             auto oplogEntries =
                 fassertNoTrace(31004, getNextApplierBatch(opCtx.get(), batchLimits));
-            for (const auto& oplogEntry : oplogEntries) {
-                ops.emplace_back(oplogEntry);
+            for (auto& oplogEntry : oplogEntries) {
+                ops.emplace_back(std::move(oplogEntry));
             }
 
             // If we don't have anything in the batch, wait a bit for something to appear.
@@ -296,6 +327,7 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
                     if (MONGO_unlikely(skipOplogBatcherWaitForData.shouldFail())) {
                         // do no waiting.
                     } else {
+                        TimerHolder waitTimer(&batcherWaitForDataStats);
                         _oplogBuffer->waitForData(Seconds(1));
                     }
                 }
@@ -330,8 +362,12 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
         }
 
         stdx::unique_lock<Latch> lk(_mutex);
-        // Block until the previous batch has been taken.
-        _cv.wait(lk, [&] { return _ops.empty() && !_ops.termWhenExhausted(); });
+        // Block until the previous batch has been taken. The next batch has already been read and
+        // parsed at this point, so the applier can start on it as soon as it is done.
+        if (!_ops.empty() || _ops.termWhenExhausted()) {
+            TimerHolder waitTimer(&batcherWaitForApplierStats);
+            _cv.wait(lk, [&] { return _ops.empty() && !_ops.termWhenExhausted(); });
+        }
         _ops = std::move(ops);
         _cv.notify_all();
         if (_ops.mustShutdown()) {
@@ -173,6 +173,12 @@ public:
     StatusWith<std::vector<OplogEntry>> getNextApplierBatch(OperationContext* opCtx,
                                                             const BatchLimits& batchLimits);
 
+    /**
+     * Returns the number of times and the total time each stage of the batcher/applier pipeline
+     * has stalled on its neighbour since startup, for replSetGetStatus.
+     */
+    static BSONObj getStallStatsBSON();
+
 private:
     /**
      * If slaveDelay is enabled, this function calculates the most recent timestamp of any oplog
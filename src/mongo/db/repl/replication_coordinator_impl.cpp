@@ -66,6 +66,7 @@
 #include "mongo/db/repl/isself.h"
 #include "mongo/db/repl/last_vote.h"
 #include "mongo/db/repl/local_oplog_info.h"
+#include "mongo/db/repl/oplog_batcher.h"
 #include "mongo/db/repl/read_concern_args.h"
 #include "mongo/db/repl/repl_client_info.h"
 #include "mongo/db/repl/repl_set_config_checks.h"
@@ -2679,6 +2680,7 @@ Status ReplicationCoordinatorImpl::processReplSetGetStatus(
         ReplicationMetrics::get(getServiceContext()).getElectionCandidateMetricsBSON();
     BSONObj electionParticipantMetrics =
         ReplicationMetrics::get(getServiceContext()).getElectionParticipantMetricsBSON();
+    BSONObj oplogApplicationStalls = OplogBatcher::getStallStatsBSON();
 
     stdx::lock_guard<Latch> lk(_mutex);
     Status result(ErrorCodes::InternalError, "didn't set status in prepareStatusResponse");
@@ -2691,7 +2693,8 @@ Status ReplicationCoordinatorImpl::processReplSetGetStatus(
             electionCandidateMetrics,
             electionParticipantMetrics,
             _storage->getLastStableRecoveryTimestamp(_service),
-            _externalState->tooStale()},
+            _externalState->tooStale(),
+            oplogApplicationStalls},
         response,
         &result);
     return result;
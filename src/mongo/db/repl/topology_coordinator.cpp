@@ -1769,6 +1769,10 @@ void TopologyCoordinator::prepareStatusResponse(const ReplSetStatusArgs& rsStatu
         response->append("initialSyncStatus", initialSyncStatus);
     }
 
+    if (!rsStatusArgs.oplogApplicationStalls.isEmpty()) {
+        response->append("oplogApplicationStalls", rsStatusArgs.oplogApplicationStalls);
+    }
+
     if (!electionCandidateMetrics.isEmpty()) {
         response->append("electionCandidateMetrics", electionCandidateMetrics);
     }
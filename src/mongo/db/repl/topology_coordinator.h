@@ -322,6 +322,9 @@ public:
         // engines.
         const boost::optional<Timestamp> lastStableRecoveryTimestamp;
         bool tooStale;
+
+        // How long each stage of oplog application has stalled on its neighbour.
+        const BSONObj oplogApplicationStalls;
     };
 
     // produce a reply to a status request
@@ -1568,6 +1568,7 @@ TEST_F(TopoCoordTest, ReplSetGetStatus) {
     BSONObj initialSyncStatus = BSON("failedInitialSyncAttempts" << 1);
     BSONObj electionCandidateMetrics = BSON("DummyElectionCandidateMetrics" << 1);
     BSONObj electionParticipantMetrics = BSON("DummyElectionParticipantMetrics" << 1);
+    BSONObj oplogApplicationStalls = BSON("DummyOplogApplicationStalls" << 1);
     std::string setName = "mySet";
 
     ReplSetHeartbeatResponse hb;
@@ -1625,7 +1626,9 @@ TEST_F(TopoCoordTest, ReplSetGetStatus) {
             initialSyncStatus,
             electionCandidateMetrics,
             electionParticipantMetrics,
-            lastStableRecoveryTimestamp},
+            lastStableRecoveryTimestamp,
+            false,
+            oplogApplicationStalls},
         &statusBuilder,
         &resultStatus);
     ASSERT_OK(resultStatus);
@@ -1732,6 +1735,7 @@ TEST_F(TopoCoordTest, ReplSetGetStatus) {
     ASSERT_BSONOBJ_EQ(initialSyncStatus, rsStatus["initialSyncStatus"].Obj());
     ASSERT_BSONOBJ_EQ(electionCandidateMetrics, rsStatus["electionCandidateMetrics"].Obj());
     ASSERT_BSONOBJ_EQ(electionParticipantMetrics, rsStatus["electionParticipantMetrics"].Obj());
+    ASSERT_BSONOBJ_EQ(oplogApplicationStalls, rsStatus["oplogApplicationStalls"].Obj());
 
     // Test no lastStableRecoveryTimestamp field.
     BSONObjBuilder statusBuilder2;
@@ -82,9 +82,9 @@ struct ServerGlobalParams {
     bool noUnixSocket = false;    // --nounixsocket
     bool doFork = false;          // --fork
     std::string socket = "/tmp";  // UNIX domain socket directory
-    std::string transportLayer;   // --transportLayer (must be either "asio" or "legacy")
+    std::string transportLayer;   // --transportLayer (must be either "asio" or "io_uring")
 
-    // --serviceExecutor ("adaptive", "synchronous")
+    // --serviceExecutor ("adaptive", "synchronous", "threadPerCore")
     std::string serviceExecutor;
 
     size_t maxConns = DEFAULT_MAX_CONN;  // Maximum number of simultaneous open connections.
@@ -689,7 +689,7 @@ bool runCommandImpl(OperationContext* opCtx,
                  isTransactionCommand(command->getName())) &&
                 (serverGlobalParams.clusterRole == ClusterRole::ShardServer ||
                  serverGlobalParams.clusterRole == ClusterRole::ConfigServer) &&
-                !request.body.hasField(WriteConcernOptions::kWriteConcernField)) {
+                request.getBodyField(WriteConcernOptions::kWriteConcernField).eoo()) {
                 // TODO: Disabled until after SERVER-44539, to avoid log spam.
                 // LOGV2(21959, "Missing writeConcern on {command_getName}", "command_getName"_attr
                 // = command->getName());
@@ -1526,6 +1526,12 @@ DbResponse ServiceEntryPointCommon::handleRequest(OperationContext* opCtx,
         LastError::get(c).startRequest();
         AuthorizationSession::get(c)->startRequest(opCtx);
 
+        // Share storage tickets fairly between the users issuing requests.
+        auto userNames = AuthorizationSession::get(c)->getAuthenticatedUserNames();
+        if (userNames.more()) {
+            opCtx->lockState()->setAdmissionTenant(userNames.next().getFullName());
+        }
+
         // We should not be holding any locks at this point
         invariant(!opCtx->lockState()->isLocked());
     }
@@ -239,10 +239,24 @@ const uint8_t kGreater = 254;
 // some utility functions
 namespace {
 
+/**
+ * Copies 'bytes' bytes from 'src' to 'dst', inverting every bit. 'dst' may be equal to 'src'.
+ *
+ * Inverts a machine word at a time, which the compiler turns into vector instructions, and only
+ * handles the tail a byte at a time. Inverted strings make up most of the bytes of descending
+ * index keys, so this is on the hot path of both encoding and decoding them.
+ */
 void memcpy_flipBits(void* dst, const void* src, size_t bytes) {
     const char* input = static_cast<const char*>(src);
     char* output = static_cast<char*>(dst);
     const char* const end = input + bytes;
+    for (; end - input >= static_cast<std::ptrdiff_t>(sizeof(uint64_t));
+         input += sizeof(uint64_t), output += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, input, sizeof(word));
+        word = ~word;
+        memcpy(output, &word, sizeof(word));
+    }
     while (input != end) {
         *output++ = ~(*input++);
     }
@@ -294,10 +308,8 @@ string readInvertedCString(BufReader* reader) {
     const char* end = static_cast<const char*>(memchr(start, 0xFF, reader->remaining()));
     keyStringAssert(50817, "Failed to find '0xFF' in inverted string.", end);
     size_t actualBytes = end - start;
-    string s(start, actualBytes);
-    for (size_t i = 0; i < s.size(); i++) {
-        s[i] = ~s[i];
-    }
+    string s(actualBytes, '\0');
+    memcpy_flipBits(&s[0], start, actualBytes);
     reader->skip(1 + actualBytes);
     return s;
 }
@@ -324,10 +336,7 @@ string readInvertedCStringWithNuls(BufReader* reader) {
         reader->skip(1 + actualBytes);
     } while (reader->peek<unsigned char>() == 0x00);
 
-    for (size_t i = 0; i < out.size(); i++) {
-        out[i] = ~out[i];
-    }
-
+    memcpy_flipBits(&out[0], out.data(), out.size());
     return out;
 }
 }  // namespace
@@ -361,6 +370,34 @@ void BuilderBase<BufferT>::appendString(StringData val) {
     _elemCount++;
 }
 
+template <class BufferT>
+void BuilderBase<BufferT>::appendBool(bool val) {
+    _verifyAppendingState();
+    _appendBool(val, _shouldInvertOnAppend());
+    _elemCount++;
+}
+
+template <class BufferT>
+void BuilderBase<BufferT>::appendDate(Date_t val) {
+    _verifyAppendingState();
+    _appendDate(val, _shouldInvertOnAppend());
+    _elemCount++;
+}
+
+template <class BufferT>
+void BuilderBase<BufferT>::appendTimestamp(Timestamp val) {
+    _verifyAppendingState();
+    _appendTimestamp(val, _shouldInvertOnAppend());
+    _elemCount++;
+}
+
+template <class BufferT>
+void BuilderBase<BufferT>::appendOID(OID val) {
+    _verifyAppendingState();
+    _appendOID(val, _shouldInvertOnAppend());
+    _elemCount++;
+}
+
 template <class BufferT>
 void BuilderBase<BufferT>::appendNumberDouble(double num) {
     _verifyAppendingState();
@@ -978,14 +1015,20 @@ template <class BufferT>
 void BuilderBase<BufferT>::_appendStringLike(StringData str, bool invert) {
     while (true) {
         size_t firstNul = strnlen(str.rawData(), str.size());
-        // No NULs in string.
-        _appendBytes(str.rawData(), firstNul, invert);
-        if (firstNul == str.size() || firstNul == std::string::npos) {
-            _append(int8_t(0), invert);
+        if (firstNul == str.size()) {
+            // No NULs in the rest of the string, so copy it and its terminator in one go.
+            char* const base = _buffer.skip(firstNul + 1);
+            if (invert) {
+                memcpy_flipBits(base, str.rawData(), firstNul);
+            } else {
+                memcpy(base, str.rawData(), firstNul);
+            }
+            base[firstNul] = invert ? char(0xFF) : char(0);
             break;
         }
 
         // replace "\x00" with "\x00\xFF"
+        _appendBytes(str.rawData(), firstNul, invert);
         _appendBytes("\x00\xFF", 2, invert);
         str = str.substr(firstNul + 1);  // skip over the NUL byte
     }
@@ -2563,6 +2606,26 @@ int compare(const char* leftBuf, const char* rightBuf, size_t leftSize, size_t r
     return leftSize < rightSize ? -1 : 1;
 }
 
+std::vector<Value> encodeBatch(Version version,
+                               const std::vector<BSONObj>& keys,
+                               Ordering ord,
+                               const std::vector<RecordId>& recordIds) {
+    invariant(recordIds.empty() || recordIds.size() == keys.size());
+
+    std::vector<Value> values;
+    values.reserve(keys.size());
+    Builder builder(version, ord);
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (recordIds.empty()) {
+            builder.resetToKey(keys[i], ord);
+        } else {
+            builder.resetToKey(keys[i], ord, recordIds[i]);
+        }
+        values.push_back(builder.getValueCopy());
+    }
+    return values;
+}
+
 template class BuilderBase<BufBuilder>;
 template class BuilderBase<StackBufBuilder>;
 
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <limits>
+#include <vector>
 
 #include <absl/hash/hash.h>
 
@@ -560,6 +561,10 @@ public:
     void appendBSONElement(const BSONElement& elem, const StringTransformFn& f = nullptr);
 
     void appendString(StringData val);
+    void appendBool(bool val);
+    void appendDate(Date_t val);
+    void appendTimestamp(Timestamp val);
+    void appendOID(OID val);
     void appendNumberDouble(double num);
     void appendNumberLong(long long num);
     void appendNull();
@@ -849,6 +854,18 @@ BSONObj toBson(const T& keyString, Ordering ord) noexcept {
     return toBson(keyString.getBuffer(), keyString.getSize(), ord, keyString.getTypeBits());
 }
 
+/**
+ * Encodes every BSONObj in 'keys', all of which must follow the index key pattern described by
+ * 'ord'. If 'recordIds' is not empty, it must have one RecordId per key, which is appended to it.
+ *
+ * Cheaper than building a HeapBuilder per key: one Builder, whose buffer only grows to fit the
+ * largest key, is reused for the whole batch, and each Value is allocated at its final size.
+ */
+std::vector<Value> encodeBatch(Version version,
+                               const std::vector<BSONObj>& keys,
+                               Ordering ord,
+                               const std::vector<RecordId>& recordIds = {});
+
 /**
  * Decodes a RecordId from the end of a buffer.
  */
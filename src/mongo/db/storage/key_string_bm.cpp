@@ -49,6 +49,7 @@ const int kStrLenMultiplier = 100;
 const int kArrLenMultiplier = 40;
 
 const Ordering ALL_ASCENDING = Ordering::make(BSONObj());
+const Ordering ALL_DESCENDING = Ordering::make(BSON("a" << -1));
 
 struct BsonsAndKeyStrings {
     int bsonSize = 0;
@@ -64,6 +65,7 @@ enum BsonValueType {
     INT,
     DOUBLE,
     STRING,
+    STRING_WITH_NULS,
     ARRAY,
     DECIMAL,
 };
@@ -80,6 +82,13 @@ BSONObj generateBson(BsonValueType bsonValueType) {
             return BSON("" << expReal(gen));
         case STRING:
             return BSON("" << std::string(expDist(gen) * kStrLenMultiplier, 'x'));
+        case STRING_WITH_NULS: {
+            std::string str(expDist(gen) * kStrLenMultiplier, 'x');
+            for (size_t i = 0; i < str.size(); i += 16) {
+                str[i] = '\0';
+            }
+            return BSON("" << str);
+        }
         case ARRAY: {
             const int arrLen = expDist(gen) * kArrLenMultiplier;
             BSONArrayBuilder bab;
@@ -98,13 +107,14 @@ BSONObj generateBson(BsonValueType bsonValueType) {
 }
 
 static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType,
-                                                     KeyString::Version version) {
+                                                     KeyString::Version version,
+                                                     Ordering ord = ALL_ASCENDING) {
     BsonsAndKeyStrings result;
     result.bsonSize = 0;
     result.keystringSize = 0;
     for (int i = 0; i < kSampleSize; i++) {
         BSONObj bson = generateBson(bsonValueType);
-        KeyString::Builder ks(version, bson, ALL_ASCENDING);
+        KeyString::Builder ks(version, bson, ord);
         result.bsonSize += bson.objsize();
         result.keystringSize += ks.getSize();
         result.bsons[i] = bson;
@@ -115,7 +125,7 @@ static BsonsAndKeyStrings generateBsonsAndKeyStrings(BsonValueType bsonValueType
 
         result.typebits[i] = SharedBuffer::allocate(ks.getTypeBits().getSize());
         memcpy(result.typebits[i].get(), ks.getTypeBits().getBuffer(), ks.getTypeBits().getSize());
-        result.typebitsLens[i] = ks.getSize();
+        result.typebitsLens[i] = ks.getTypeBits().getSize();
     }
     return result;
 }
@@ -153,6 +163,78 @@ void BM_KeyStringToBSON(benchmark::State& state,
     state.SetItemsProcessed(state.iterations() * kSampleSize);
 }
 
+void BM_BSONToKeyStringDescending(benchmark::State& state,
+                                  const KeyString::Version version,
+                                  BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        for (auto bson : bsonsAndKeyStrings.bsons) {
+            benchmark::DoNotOptimize(KeyString::Builder(version, bson, ALL_DESCENDING));
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
+    state.SetItemsProcessed(state.iterations() * kSampleSize);
+}
+
+void BM_KeyStringToBSONDescending(benchmark::State& state,
+                                  const KeyString::Version version,
+                                  BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings =
+        generateBsonsAndKeyStrings(bsonType, version, ALL_DESCENDING);
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        for (size_t i = 0; i < kSampleSize; i++) {
+            BufReader buf(bsonsAndKeyStrings.typebits[i].get(), bsonsAndKeyStrings.typebitsLens[i]);
+            benchmark::DoNotOptimize(
+                KeyString::toBson(bsonsAndKeyStrings.keystrings[i].get(),
+                                  bsonsAndKeyStrings.keystringLens[i],
+                                  ALL_DESCENDING,
+                                  KeyString::TypeBits::fromBuffer(version, &buf)));
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
+    state.SetItemsProcessed(state.iterations() * kSampleSize);
+}
+
+void BM_KeyStringEncodeBatch(benchmark::State& state,
+                             const KeyString::Version version,
+                             BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+    const std::vector<BSONObj> keys(std::begin(bsonsAndKeyStrings.bsons),
+                                    std::end(bsonsAndKeyStrings.bsons));
+    std::vector<RecordId> recordIds;
+    for (size_t i = 0; i < kSampleSize; i++) {
+        recordIds.emplace_back(i + 1);
+    }
+
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        benchmark::DoNotOptimize(KeyString::encodeBatch(version, keys, ALL_ASCENDING, recordIds));
+    }
+    state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
+    state.SetItemsProcessed(state.iterations() * kSampleSize);
+}
+
+void BM_KeyStringHeapBuilderPerKey(benchmark::State& state,
+                                   const KeyString::Version version,
+                                   BsonValueType bsonType) {
+    const BsonsAndKeyStrings bsonsAndKeyStrings = generateBsonsAndKeyStrings(bsonType, version);
+
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        std::vector<KeyString::Value> values;
+        for (size_t i = 0; i < kSampleSize; i++) {
+            KeyString::HeapBuilder builder(
+                version, bsonsAndKeyStrings.bsons[i], ALL_ASCENDING, RecordId(i + 1));
+            values.push_back(builder.release());
+        }
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetBytesProcessed(state.iterations() * bsonsAndKeyStrings.bsonSize);
+    state.SetItemsProcessed(state.iterations() * kSampleSize);
+}
+
 void BM_KeyStringValueAssign(benchmark::State& state, BsonValueType bsonType) {
     // The KeyString version does not matter for this test.
     const auto version = KeyString::Version::V1;
@@ -235,6 +317,7 @@ BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_BSONToKeyString, V1_StringWithNuls, KeyString::Version::V1, STRING_WITH_NULS);
 
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Int, KeyString::Version::V0, INT);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Int, KeyString::Version::V1, INT);
@@ -245,6 +328,23 @@ BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_String, KeyString::Version::V0, STRING)
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY);
+BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_StringWithNuls, KeyString::Version::V1, STRING_WITH_NULS);
+
+BENCHMARK_CAPTURE(BM_BSONToKeyStringDescending, V1_String, KeyString::Version::V1, STRING);
+BENCHMARK_CAPTURE(BM_BSONToKeyStringDescending,
+                  V1_StringWithNuls,
+                  KeyString::Version::V1,
+                  STRING_WITH_NULS);
+BENCHMARK_CAPTURE(BM_KeyStringToBSONDescending, V1_String, KeyString::Version::V1, STRING);
+BENCHMARK_CAPTURE(BM_KeyStringToBSONDescending,
+                  V1_StringWithNuls,
+                  KeyString::Version::V1,
+                  STRING_WITH_NULS);
+
+BENCHMARK_CAPTURE(BM_KeyStringEncodeBatch, V1_Int, KeyString::Version::V1, INT);
+BENCHMARK_CAPTURE(BM_KeyStringEncodeBatch, V1_String, KeyString::Version::V1, STRING);
+BENCHMARK_CAPTURE(BM_KeyStringHeapBuilderPerKey, V1_Int, KeyString::Version::V1, INT);
+BENCHMARK_CAPTURE(BM_KeyStringHeapBuilderPerKey, V1_String, KeyString::Version::V1, STRING);
 
 }  // namespace
 }  // namespace mongo
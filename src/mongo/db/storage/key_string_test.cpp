@@ -417,6 +417,52 @@ TEST_F(KeyStringBuilderTest, AllTypesSimple) {
     ROUNDTRIP(version, BSON("" << 1235123123123LL));
 }
 
+TEST_F(KeyStringBuilderTest, StringsOfEveryLengthAroundWordSize) {
+    // Covers both the word-at-a-time and the trailing byte-at-a-time parts of inverting strings
+    // for descending keys, with and without NUL bytes in either part.
+    for (size_t len = 0; len <= 3 * sizeof(uint64_t); len++) {
+        std::string str(len, 'x');
+        for (size_t i = 0; i < len; i++) {
+            str[i] = 'a' + i;
+        }
+        ROUNDTRIP(version, BSON("" << str));
+
+        for (size_t nulPos = 0; nulPos < len; nulPos++) {
+            std::string withNul = str;
+            withNul[nulPos] = '\0';
+            ROUNDTRIP(version, BSON("" << withNul));
+        }
+    }
+}
+
+TEST_F(KeyStringBuilderTest, EncodeBatchMatchesBuilder) {
+    const Ordering ord = Ordering::make(BSON("a" << 1 << "b" << -1));
+    const std::vector<BSONObj> keys = {BSON("" << 1 << ""
+                                               << "abc"),
+                                       BSON("" << std::string(100, 'z') << "" << 2.5),
+                                       BSON("" << BSON_ARRAY(1 << 2) << "" << BSONNULL),
+                                       BSON("" << 1LL << ""
+                                               << "")};
+    const std::vector<RecordId> recordIds = {RecordId(1), RecordId(7), RecordId(3), RecordId(2)};
+
+    auto values = KeyString::encodeBatch(version, keys, ord);
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        KeyString::HeapBuilder builder(version, keys[i], ord);
+        ASSERT_EQ(builder.release(), values[i]);
+        ASSERT_BSONOBJ_EQ(keys[i], KeyString::toBson(values[i], ord));
+    }
+
+    values = KeyString::encodeBatch(version, keys, ord, recordIds);
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        KeyString::HeapBuilder builder(version, keys[i], ord, recordIds[i]);
+        ASSERT_EQ(builder.release(), values[i]);
+        ASSERT_EQ(recordIds[i],
+                  KeyString::decodeRecordIdAtEnd(values[i].getBuffer(), values[i].getSize()));
+    }
+}
+
 TEST_F(KeyStringBuilderTest, Array1) {
     BSONObj emptyArray = BSON("" << BSONArray());
 
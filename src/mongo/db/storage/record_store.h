@@ -171,6 +171,23 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Positions a forward cursor at the first Record whose id is greater than or equal to 'id' and
+     * returns it, or boost::none if there is no such Record. Subsequent calls to next() continue
+     * from that position. Must only be called on forward cursors.
+     *
+     * The default implementation advances from the current position with next(), so storage
+     * engines able to seek directly should override it.
+     */
+    virtual boost::optional<Record> seekAtOrAfter(const RecordId& id) {
+        while (auto record = next()) {
+            if (record->id >= id) {
+                return record;
+            }
+        }
+        return boost::none;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
@@ -0,0 +1,283 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/ticket_concurrency_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/storage/ticket_concurrency_controller_gen.h"
+#include "mongo/logv2/log.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+
+namespace {
+const auto getTicketConcurrencyController =
+    ServiceContext::declareDecoration<std::unique_ptr<TicketConcurrencyController>>();
+
+/**
+ * Relative change from 'prev' to 'curr', or 0 if there is nothing to compare against.
+ */
+double relativeChange(double prev, double curr) {
+    if (prev <= 0) {
+        return 0;
+    }
+    return (curr - prev) / prev;
+}
+
+TicketConcurrencyController::Params getParams() {
+    TicketConcurrencyController::Params params;
+    params.minTickets = gTicketConcurrencyControllerMinTickets.load();
+    params.maxTickets =
+        std::max(params.minTickets, gTicketConcurrencyControllerMaxTickets.load());
+    params.increment = gTicketConcurrencyControllerIncrement.load();
+    params.decreaseFactor = gTicketConcurrencyControllerDecreaseFactor.load();
+    params.tolerance = gTicketConcurrencyControllerTolerance.load();
+    return params;
+}
+}  // namespace
+
+TicketConcurrencyController::TicketConcurrencyController()
+    : ServerStatusSection("ticketConcurrencyController") {
+    _pools.emplace_back("read", MODE_IS);
+    _pools.emplace_back("write", MODE_IX);
+}
+
+TicketConcurrencyController::TicketConcurrencyController(ServiceContext* service)
+    : TicketConcurrencyController() {
+    _jobAnchor = service->getPeriodicRunner()->makeJob(
+        {"TicketConcurrencyController",
+         [this](Client* client) { adjust(Date_t::now()); },
+         Milliseconds(gTicketConcurrencyControllerIntervalMillis)});
+    _jobAnchor.start();
+}
+
+TicketConcurrencyController* TicketConcurrencyController::get(ServiceContext* service) {
+    return getTicketConcurrencyController(service).get();
+}
+
+void TicketConcurrencyController::set(ServiceContext* service,
+                                      std::unique_ptr<TicketConcurrencyController> tcc) {
+    getTicketConcurrencyController(service) = std::move(tcc);
+}
+
+TicketConcurrencyController::Action TicketConcurrencyController::decide(const Observation& prev,
+                                                                        const Observation& curr,
+                                                                        Action lastAction,
+                                                                        double tolerance) {
+    // When nobody waits for a ticket, the pool size is not what limits throughput.
+    if (!curr.contended) {
+        return Action::kHold;
+    }
+
+    const double throughputChange = relativeChange(prev.throughput, curr.throughput);
+    const double latencyChange = relativeChange(prev.latencyMicros, curr.latencyMicros);
+
+    switch (lastAction) {
+        case Action::kIncrease:
+            if (throughputChange > tolerance) {
+                return Action::kIncrease;
+            }
+            // More concurrency that only makes operations wait longer inside the storage engine
+            // is contention, not useful work.
+            if (throughputChange < -tolerance || latencyChange > tolerance) {
+                return Action::kDecrease;
+            }
+            return Action::kHold;
+        case Action::kDecrease:
+            if (throughputChange > tolerance) {
+                return Action::kDecrease;
+            }
+            if (throughputChange < -tolerance) {
+                return Action::kIncrease;
+            }
+            return Action::kHold;
+        case Action::kHold:
+            // Keep probing upward so that the size follows changes in the workload.
+            return Action::kIncrease;
+    }
+    MONGO_UNREACHABLE;
+}
+
+int TicketConcurrencyController::applyAction(Action action, int current, const Params& params) {
+    int next = current;
+    switch (action) {
+        case Action::kHold:
+            break;
+        case Action::kIncrease:
+            next = current + params.increment;
+            break;
+        case Action::kDecrease:
+            next = static_cast<int>(std::floor(current * params.decreaseFactor));
+            break;
+    }
+    return std::max(params.minTickets, std::min(params.maxTickets, next));
+}
+
+StringData TicketConcurrencyController::actionName(Action action) {
+    switch (action) {
+        case Action::kHold:
+            return "hold"_sd;
+        case Action::kIncrease:
+            return "increase"_sd;
+        case Action::kDecrease:
+            return "decrease"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
+void TicketConcurrencyController::adjust(Date_t now) {
+    const bool enabled = gTicketConcurrencyControllerEnabled.load();
+    const auto params = getParams();
+    for (auto& pool : _pools) {
+        boost::optional<int> target;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (!enabled) {
+                // Start measuring afresh if the controller is turned back on.
+                pool.holder = nullptr;
+                pool.lastObservation = boost::none;
+                pool.lastAction = Action::kHold;
+                continue;
+            }
+            target = _samplePool(lk, pool, params, now);
+        }
+        if (!target) {
+            continue;
+        }
+
+        // Ticket holders shrink lazily, swallowing outstanding tickets as they are released, so
+        // resizing never waits on the operations holding them.
+        auto status = pool.holder->resize(*target);
+        if (!status.isOK()) {
+            LOGV2_WARNING(51833,
+                          "Failed to resize storage ticket pool",
+                          "pool"_attr = pool.name,
+                          "to"_attr = *target,
+                          "error"_attr = status);
+            stdx::lock_guard<Latch> lk(_mutex);
+            pool.lastAction = Action::kHold;
+        }
+    }
+}
+
+boost::optional<int> TicketConcurrencyController::_samplePool(WithLock,
+                                                              Pool& pool,
+                                                              const Params& params,
+                                                              Date_t now) {
+    auto holder = Locker::getGlobalThrottling(pool.mode);
+    const auto released = holder ? holder->numReleased() : 0;
+    const auto waited = holder ? holder->numWaited() : 0;
+    ON_BLOCK_EXIT([&] {
+        pool.lastSampled = now;
+        pool.lastReleased = released;
+        pool.lastWaited = waited;
+    });
+
+    if (!holder || holder != pool.holder) {
+        pool.holder = holder;
+        pool.lastObservation = boost::none;
+        pool.lastAction = Action::kHold;
+        return boost::none;
+    }
+
+    const auto elapsed = now - pool.lastSampled;
+    if (elapsed <= Milliseconds(0)) {
+        return boost::none;
+    }
+
+    Observation obs;
+    obs.throughput = (released - pool.lastReleased) * 1000.0 / durationCount<Milliseconds>(elapsed);
+    obs.latencyMicros = obs.throughput > 0 ? holder->used() * 1'000'000.0 / obs.throughput : 0;
+    obs.contended = waited > pool.lastWaited;
+
+    // The first contended interval has no baseline to compare with, so it simply probes upward.
+    const auto action = pool.lastObservation
+        ? decide(*pool.lastObservation, obs, pool.lastAction, params.tolerance)
+        : (obs.contended ? Action::kIncrease : Action::kHold);
+    pool.lastObservation = obs;
+    pool.lastAction = action;
+
+    const int current = holder->outof();
+    const int target = applyAction(action, current, params);
+    if (target == current) {
+        // Pinned at a bound; measure again from here rather than keep pushing against it.
+        pool.lastAction = Action::kHold;
+        return boost::none;
+    }
+
+    LOGV2_DEBUG(51832,
+                1,
+                "Resizing storage ticket pool",
+                "pool"_attr = pool.name,
+                "action"_attr = actionName(action),
+                "from"_attr = current,
+                "to"_attr = target,
+                "throughput"_attr = obs.throughput,
+                "latencyMicros"_attr = obs.latencyMicros);
+
+    if (action == Action::kIncrease) {
+        pool.numIncreases++;
+    } else {
+        pool.numDecreases++;
+    }
+    return target;
+}
+
+BSONObj TicketConcurrencyController::generateSection(OperationContext* opCtx,
+                                                     const BSONElement& configElement) const {
+    BSONObjBuilder bob;
+    bob.append("enabled", gTicketConcurrencyControllerEnabled.load());
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (const auto& pool : _pools) {
+        BSONObjBuilder poolBuilder(bob.subobjStart(pool.name));
+        auto holder = Locker::getGlobalThrottling(pool.mode);
+        poolBuilder.append("totalTickets", holder ? holder->outof() : 0);
+        poolBuilder.append("lastAction", actionName(pool.lastAction));
+        // FTDC stores integers, so report rates and latencies rounded.
+        const auto obs = pool.lastObservation.value_or(Observation());
+        poolBuilder.append("throughputPerSec", static_cast<long long>(obs.throughput));
+        poolBuilder.append("latencyMicros", static_cast<long long>(obs.latencyMicros));
+        poolBuilder.append("contended", obs.contended);
+        poolBuilder.append("increases", pool.numIncreases);
+        poolBuilder.append("decreases", pool.numDecreases);
+    }
+    return bob.obj();
+}
+
+}  // namespace mongo
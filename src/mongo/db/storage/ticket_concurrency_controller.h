@@ -0,0 +1,161 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/lock_manager_defs.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/periodic_runner.h"
+
+namespace mongo {
+
+class TicketHolder;
+
+/**
+ * Sizes the storage engine's read and write ticket pools automatically. Every interval, the
+ * controller measures each pool's throughput (tickets released per second) and, by Little's law,
+ * the average time a ticket is held. It then searches for the pool size that maximizes throughput:
+ * additively probing upward while that pays off, and backing off multiplicatively when throughput
+ * drops or latency grows without a matching gain. A pool nobody had to wait for is left alone.
+ *
+ * The controller is a server status section, which also makes its decisions visible in FTDC.
+ */
+class TicketConcurrencyController : public ServerStatusSection {
+public:
+    enum class Action { kHold, kIncrease, kDecrease };
+
+    /**
+     * What one interval looked like for one pool.
+     */
+    struct Observation {
+        double throughput = 0;
+        double latencyMicros = 0;
+
+        // Whether any acquisition had to wait for a ticket during the interval.
+        bool contended = false;
+    };
+
+    struct Params {
+        int minTickets;
+        int maxTickets;
+        int increment;
+        double decreaseFactor;
+        double tolerance;
+    };
+
+    /**
+     * Starts a periodic job adjusting the ticket holders installed by Locker::setGlobalThrottling.
+     */
+    explicit TicketConcurrencyController(ServiceContext* service);
+
+    /**
+     * Constructs a controller without a periodic job, for testing.
+     */
+    TicketConcurrencyController();
+
+    static TicketConcurrencyController* get(ServiceContext* service);
+
+    static void set(ServiceContext* service, std::unique_ptr<TicketConcurrencyController> tcc);
+
+    /**
+     * Picks the next step for a pool given its last two observations and the step that led from
+     * 'prev' to 'curr'.
+     */
+    static Action decide(const Observation& prev,
+                         const Observation& curr,
+                         Action lastAction,
+                         double tolerance);
+
+    /**
+     * Returns the pool size resulting from taking 'action' at 'current' tickets.
+     */
+    static int applyAction(Action action, int current, const Params& params);
+
+    static StringData actionName(Action action);
+
+    /**
+     * Takes one measurement of every pool and resizes those that need it. Public for testing.
+     */
+    void adjust(Date_t now);
+
+    /**
+     * <ServerStatusSection>
+     */
+    bool includeByDefault() const override {
+        return true;
+    }
+
+    /**
+     * <ServerStatusSection>
+     */
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const override;
+
+private:
+    struct Pool {
+        Pool(std::string name, LockMode mode) : name(std::move(name)), mode(mode) {}
+
+        std::string name;
+        LockMode mode;
+
+        // Holder the counters below were last sampled from. The storage engine may install a
+        // different one, in which case sampling starts over.
+        TicketHolder* holder = nullptr;
+        Date_t lastSampled;
+        long long lastReleased = 0;
+        long long lastWaited = 0;
+
+        boost::optional<Observation> lastObservation;
+        Action lastAction = Action::kHold;
+
+        long long numIncreases = 0;
+        long long numDecreases = 0;
+    };
+
+    /**
+     * Samples 'pool' and returns the size it should be resized to, if any.
+     */
+    boost::optional<int> _samplePool(WithLock, Pool& pool, const Params& params, Date_t now);
+
+    // Guards the pools against concurrent reads by serverStatus. Only the periodic job modifies
+    // them, so it may read them without the mutex.
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("TicketConcurrencyController::_mutex");
+    std::vector<Pool> _pools;
+
+    PeriodicJobAnchor _jobAnchor;
+};
+
+}  // namespace mongo
@@ -0,0 +1,144 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/locker.h"
+#include "mongo/db/storage/ticket_concurrency_controller.h"
+#include "mongo/db/storage/ticket_concurrency_controller_gen.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+using Action = TicketConcurrencyController::Action;
+using Observation = TicketConcurrencyController::Observation;
+
+Observation observe(double throughput, double latencyMicros, bool contended = true) {
+    Observation obs;
+    obs.throughput = throughput;
+    obs.latencyMicros = latencyMicros;
+    obs.contended = contended;
+    return obs;
+}
+
+TEST(TicketConcurrencyControllerTest, HoldsWhenUncontended) {
+    for (auto lastAction : {Action::kHold, Action::kIncrease, Action::kDecrease}) {
+        ASSERT(TicketConcurrencyController::decide(
+                   observe(100, 1000), observe(50, 1000, false), lastAction, 0.05) ==
+               Action::kHold);
+    }
+}
+
+TEST(TicketConcurrencyControllerTest, KeepsIncreasingWhileThroughputImproves) {
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(120, 1000), Action::kIncrease, 0.05) ==
+           Action::kIncrease);
+}
+
+TEST(TicketConcurrencyControllerTest, BacksOffWhenIncreaseHurts) {
+    // Throughput dropped.
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(80, 1000), Action::kIncrease, 0.05) ==
+           Action::kDecrease);
+    // Throughput flat, but operations now hold their tickets for longer.
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(101, 1200), Action::kIncrease, 0.05) ==
+           Action::kDecrease);
+    // Within tolerance on both.
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(102, 1020), Action::kIncrease, 0.05) ==
+           Action::kHold);
+}
+
+TEST(TicketConcurrencyControllerTest, FollowsTheGradientAfterDecreasing) {
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(120, 800), Action::kDecrease, 0.05) ==
+           Action::kDecrease);
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(80, 1000), Action::kDecrease, 0.05) ==
+           Action::kIncrease);
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(100, 1000), Action::kDecrease, 0.05) == Action::kHold);
+}
+
+TEST(TicketConcurrencyControllerTest, ProbesUpwardAfterHolding) {
+    ASSERT(TicketConcurrencyController::decide(
+               observe(100, 1000), observe(100, 1000), Action::kHold, 0.05) ==
+           Action::kIncrease);
+}
+
+TEST(TicketConcurrencyControllerTest, ApplyActionStaysWithinBounds) {
+    TicketConcurrencyController::Params params{16, 64, 8, 0.5, 0.05};
+    ASSERT_EQ(TicketConcurrencyController::applyAction(Action::kHold, 32, params), 32);
+    ASSERT_EQ(TicketConcurrencyController::applyAction(Action::kIncrease, 32, params), 40);
+    ASSERT_EQ(TicketConcurrencyController::applyAction(Action::kIncrease, 60, params), 64);
+    ASSERT_EQ(TicketConcurrencyController::applyAction(Action::kDecrease, 40, params), 20);
+    ASSERT_EQ(TicketConcurrencyController::applyAction(Action::kDecrease, 20, params), 16);
+}
+
+TEST(TicketConcurrencyControllerTest, AdjustGrowsContendedPool) {
+    SemaphoreTicketHolder reading(32);
+    SemaphoreTicketHolder writing(32);
+    Locker::setGlobalThrottling(&reading, &writing);
+    ON_BLOCK_EXIT([] { Locker::setGlobalThrottling(nullptr, nullptr); });
+
+    const bool wasEnabled = gTicketConcurrencyControllerEnabled.load();
+    gTicketConcurrencyControllerEnabled.store(true);
+    ON_BLOCK_EXIT([&] { gTicketConcurrencyControllerEnabled.store(wasEnabled); });
+
+    TicketConcurrencyController controller;
+    const auto start = Date_t::now();
+    controller.adjust(start);
+
+    // Exhaust the write pool so that one more acquisition has to wait, then return the tickets.
+    for (int i = 0; i < 32; ++i) {
+        ASSERT(writing.tryAcquire());
+    }
+    ASSERT_FALSE(writing.waitForTicketUntil(Date_t::now()));
+    for (int i = 0; i < 32; ++i) {
+        writing.release();
+    }
+
+    controller.adjust(start + Seconds(1));
+    ASSERT_EQ(reading.outof(), 32);
+    ASSERT_EQ(writing.outof(), 32 + gTicketConcurrencyControllerIncrement.load());
+
+    auto section = controller.generateSection(nullptr, BSONElement());
+    ASSERT_EQ(section["write"]["lastAction"].String(), "increase");
+    ASSERT_EQ(section["write"]["throughputPerSec"].numberLong(), 32);
+    ASSERT_EQ(section["write"]["increases"].numberLong(), 1);
+    ASSERT_EQ(section["read"]["lastAction"].String(), "hold");
+}
+
+}  // namespace
+}  // namespace mongo
@@ -634,17 +634,51 @@ private:
 };
 
 namespace {
-TicketHolder openWriteTransaction(128);
-TicketHolder openReadTransaction(128);
+constexpr auto kTicketAdmissionPolicyFifo = "fifo"_sd;
+constexpr auto kTicketAdmissionPolicyPriority = "priority"_sd;
+
+// The ticket pools are sized by server parameters that may be set before the admission policy is
+// known, so they start out FIFO and are replaced when the storage engine starts up.
+std::unique_ptr<TicketHolder> openWriteTransaction = std::make_unique<SemaphoreTicketHolder>(128);
+std::unique_ptr<TicketHolder> openReadTransaction = std::make_unique<SemaphoreTicketHolder>(128);
+
+/**
+ * Replaces 'holder' with one implementing the configured admission policy, keeping its size. Must
+ * only be called while no tickets are outstanding.
+ */
+void applyTicketAdmissionPolicy(std::unique_ptr<TicketHolder>& holder) {
+    const bool wantPriority = gWiredTigerTicketAdmissionPolicy == kTicketAdmissionPolicyPriority;
+    const bool isPriority = dynamic_cast<PriorityTicketHolder*>(holder.get());
+    if (wantPriority == isPriority) {
+        return;
+    }
+
+    invariant(holder->used() == 0);
+    if (wantPriority) {
+        holder = std::make_unique<PriorityTicketHolder>(holder->outof());
+    } else {
+        holder = std::make_unique<SemaphoreTicketHolder>(holder->outof());
+    }
+}
 }  // namespace
 
+Status WiredTigerKVEngine::validateTicketAdmissionPolicy(const std::string& policy) {
+    if (policy != kTicketAdmissionPolicyFifo && policy != kTicketAdmissionPolicyPriority) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Ticket admission policy must be '" << kTicketAdmissionPolicyFifo
+                              << "' or '" << kTicketAdmissionPolicyPriority << "', given '"
+                              << policy << "'"};
+    }
+    return Status::OK();
+}
+
 OpenWriteTransactionParam::OpenWriteTransactionParam(StringData name, ServerParameterType spt)
     : ServerParameter(name, spt), _data(&openWriteTransaction) {}
 
 void OpenWriteTransactionParam::append(OperationContext* opCtx,
                                        BSONObjBuilder& b,
                                        const std::string& name) {
-    b.append(name, _data->outof());
+    b.append(name, (*_data)->outof());
 }
 
 Status OpenWriteTransactionParam::setFromString(const std::string& str) {
@@ -656,7 +690,7 @@ Status OpenWriteTransactionParam::setFromString(const std::string& str) {
     if (num <= 0) {
         return {ErrorCodes::BadValue, str::stream() << name() << " has to be > 0"};
     }
-    return _data->resize(num);
+    return (*_data)->resize(num);
 }
 
 OpenReadTransactionParam::OpenReadTransactionParam(StringData name, ServerParameterType spt)
@@ -665,7 +699,7 @@ OpenReadTransactionParam::OpenReadTransactionParam(StringData name, ServerParame
 void OpenReadTransactionParam::append(OperationContext* opCtx,
                                       BSONObjBuilder& b,
                                       const std::string& name) {
-    b.append(name, _data->outof());
+    b.append(name, (*_data)->outof());
 }
 
 Status OpenReadTransactionParam::setFromString(const std::string& str) {
@@ -677,7 +711,7 @@ Status OpenReadTransactionParam::setFromString(const std::string& str) {
     if (num <= 0) {
         return {ErrorCodes::BadValue, str::stream() << name() << " has to be > 0"};
     }
-    return _data->resize(num);
+    return (*_data)->resize(num);
 }
 
 namespace {
@@ -937,7 +971,9 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
 
     _sizeStorer = std::make_unique<WiredTigerSizeStorer>(_conn, _sizeStorerUri, _readOnly);
 
-    Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
+    applyTicketAdmissionPolicy(openReadTransaction);
+    applyTicketAdmissionPolicy(openWriteTransaction);
+    Locker::setGlobalThrottling(openReadTransaction.get(), openWriteTransaction.get());
 
     _runTimeConfigParam.reset(new WiredTigerEngineRuntimeConfigParameter(
         "wiredTigerEngineRuntimeConfig", ServerParameterType::kRuntimeOnly));
@@ -976,16 +1012,12 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
     BSONObjBuilder bb(b.subobjStart("concurrentTransactions"));
     {
         BSONObjBuilder bbb(bb.subobjStart("write"));
-        bbb.append("out", openWriteTransaction.used());
-        bbb.append("available", openWriteTransaction.available());
-        bbb.append("totalTickets", openWriteTransaction.outof());
+        openWriteTransaction->appendStats(bbb);
         bbb.done();
     }
     {
         BSONObjBuilder bbb(bb.subobjStart("read"));
-        bbb.append("out", openReadTransaction.used());
-        bbb.append("available", openReadTransaction.available());
-        bbb.append("totalTickets", openReadTransaction.outof());
+        openReadTransaction->appendStats(bbb);
         bbb.done();
     }
     bb.done();
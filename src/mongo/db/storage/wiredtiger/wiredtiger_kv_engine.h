@@ -308,6 +308,11 @@ public:
 
     static void appendGlobalStats(BSONObjBuilder& b);
 
+    /**
+     * Validator for the 'wiredTigerTicketAdmissionPolicy' server parameter.
+     */
+    static Status validateTicketAdmissionPolicy(const std::string& policy);
+
     Timestamp getStableTimestamp() const override;
     Timestamp getOldestTimestamp() const override;
     Timestamp getCheckpointTimestamp() const override;
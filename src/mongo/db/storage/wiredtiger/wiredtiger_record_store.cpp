@@ -2087,6 +2087,48 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+boost::optional<Record> WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& id) {
+    invariant(_hasRestored);
+    invariant(_forward);
+
+    _skipNextAdvance = false;
+    WT_CURSOR* c = _cursor->get();
+    setKey(c, id);
+    // Nothing after the next line can throw WCEs.
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret == 0 && cmp < 0) {
+        // We landed on the record immediately preceding 'id'. Step forward onto the first record
+        // in range.
+        ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->next(c); });
+    }
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return {};
+    }
+    invariantWTOK(ret);
+
+    RecordId foundId;
+    if (hasWrongPrefix(c, &foundId)) {
+        _eof = true;
+        return {};
+    }
+    if (!foundId.isValid()) {
+        foundId = getKey(c);
+    }
+
+    if (_oplogVisibleTs && foundId.repr() > *_oplogVisibleTs) {
+        _eof = true;
+        return {};
+    }
+
+    WT_ITEM value;
+    invariantWTOK(c->get_value(c, &value));
+
+    _lastReturnedId = foundId;
+    _eof = false;
+    return {{foundId, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+}
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
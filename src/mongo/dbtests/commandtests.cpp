@@ -53,7 +53,7 @@ TEST(CommandTests, InputDocumentSequeceWorksEndToEnd) {
     ASSERT_EQ(db.count(nss), 0u);
 
     OpMsgRequest request;
-    request.body = BSON("insert" << nss.coll() << "$db" << nss.db());
+    request.setBody(BSON("insert" << nss.coll() << "$db" << nss.db()));
     request.sequences = {{"documents",
                           {
                               BSON("_id" << 1),
@@ -34,6 +34,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/index_catalog.h"
 #include "mongo/db/catalog/multi_index_block.h"
+#include "mongo/db/catalog/multi_index_block_gen.h"
 #include "mongo/db/catalog/uncommitted_collections.h"
 #include "mongo/db/catalog_raii.h"
 #include "mongo/db/client.h"
@@ -43,6 +44,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/db/storage/storage_engine_init.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 namespace IndexUpdateTests {
 
@@ -535,6 +537,66 @@ protected:
     }
 };
 
+/** Keys generated by several threads are all merged into the index, along with multikey state. */
+class InsertBuildParallelKeyGeneration : public IndexBuildBase {
+public:
+    void run() {
+        const auto oldParallelism = indexBuildParallelism.load();
+        indexBuildParallelism.store(4);
+        ON_BLOCK_EXIT([&] { indexBuildParallelism.store(oldParallelism); });
+
+        AutoGetOrCreateDb dbRaii(_opCtx, _nss.db(), LockMode::MODE_IX);
+        Lock::CollectionLock collLk(_opCtx, _nss, LockMode::MODE_X);
+        Collection* coll = collection();
+        const int numDocs = 1000;
+        {
+            WriteUnitOfWork wunit(_opCtx);
+            OpDebug* const nullOpDebug = nullptr;
+            for (int i = 0; i < numDocs; ++i) {
+                ASSERT_OK(coll->insertDocument(
+                    _opCtx,
+                    InsertStatement(BSON("_id" << i << "a" << BSON_ARRAY(i << -i) << "b" << i)),
+                    nullOpDebug,
+                    true));
+            }
+            wunit.commit();
+        }
+
+        MultiIndexBlock indexer;
+        const std::vector<BSONObj> specs = {
+            BSON("name"
+                 << "a"
+                 << "key" << BSON("a" << 1) << "v" << static_cast<int>(kIndexVersion)),
+            BSON("name"
+                 << "b"
+                 << "key" << BSON("b" << 1) << "v" << static_cast<int>(kIndexVersion) << "unique"
+                 << true)};
+
+        ON_BLOCK_EXIT(
+            [&] { indexer.cleanUpAfterBuild(_opCtx, coll, MultiIndexBlock::kNoopOnCleanUpFn); });
+
+        ASSERT_OK(indexer.init(_opCtx, coll, specs, MultiIndexBlock::kNoopOnInitFn).getStatus());
+        ASSERT_OK(indexer.insertAllDocumentsInCollection(_opCtx, coll));
+        ASSERT_OK(indexer.checkConstraints(_opCtx));
+
+        WriteUnitOfWork wunit(_opCtx);
+        ASSERT_OK(indexer.commit(
+            _opCtx, coll, MultiIndexBlock::kNoopOnCreateEachFn, MultiIndexBlock::kNoopOnCommitFn));
+        wunit.commit();
+
+        auto indexCatalog = coll->getIndexCatalog();
+        auto entryA = indexCatalog->getEntry(indexCatalog->findIndexByName(_opCtx, "a"));
+        ASSERT(entryA->isMultikey());
+        // The array [0, 0] of the first document only generates a single key.
+        ASSERT_EQ(2 * numDocs - 1,
+                  entryA->accessMethod()->getSortedDataInterface()->numEntries(_opCtx));
+
+        auto entryB = indexCatalog->getEntry(indexCatalog->findIndexByName(_opCtx, "b"));
+        ASSERT_FALSE(entryB->isMultikey());
+        ASSERT_EQ(numDocs, entryB->accessMethod()->getSortedDataInterface()->numEntries(_opCtx));
+    }
+};
+
 class IndexCatatalogFixIndexKey : public IndexBuildBase {
 public:
     void run() {
@@ -683,6 +745,7 @@ public:
         add<SameSpecDifferentSparse>();
         add<SameSpecDifferentTTL>();
         add<StorageEngineOptions>();
+        add<InsertBuildParallelKeyGeneration>();
 
         add<IndexCatatalogFixIndexKey>();
 
@@ -214,6 +214,48 @@ TEST_F(MultikeyPathsTest, PathsUpdatedOnDocumentInsert) {
     assertMultikeyPaths(collection, keyPattern, {{0U}, {0U}});
 }
 
+TEST_F(MultikeyPathsTest, PathsUpdatedOnBatchInsert) {
+    AutoGetCollection autoColl(_opCtx.get(), _nss, MODE_X);
+    Collection* collection = autoColl.getCollection();
+    invariant(collection);
+
+    BSONObj keyPattern = BSON("a" << 1 << "b" << 1);
+    createIndex(collection,
+                BSON("name"
+                     << "a_1_b_1"
+                     << "key" << keyPattern << "v" << static_cast<int>(kIndexVersion)))
+        .transitional_ignore();
+
+    // The batch as a whole generates several keys, which must not make the index multikey on its
+    // own.
+    {
+        std::vector<InsertStatement> inserts{InsertStatement(BSON("_id" << 0 << "a" << 5)),
+                                             InsertStatement(BSON("_id" << 1 << "b" << 5)),
+                                             InsertStatement(BSON("_id" << 2 << "a" << 6))};
+        WriteUnitOfWork wuow(_opCtx.get());
+        OpDebug* const nullOpDebug = nullptr;
+        ASSERT_OK(
+            collection->insertDocuments(_opCtx.get(), inserts.begin(), inserts.end(), nullOpDebug));
+        wuow.commit();
+    }
+
+    assertMultikeyPaths(collection, keyPattern, {std::set<size_t>{}, std::set<size_t>{}});
+
+    {
+        std::vector<InsertStatement> inserts{
+            InsertStatement(BSON("_id" << 3 << "a" << 5 << "b" << 5)),
+            InsertStatement(BSON("_id" << 4 << "a" << BSON_ARRAY(1 << 2) << "b" << 5)),
+            InsertStatement(BSON("_id" << 5 << "a" << 6 << "b" << BSON_ARRAY(1 << 2)))};
+        WriteUnitOfWork wuow(_opCtx.get());
+        OpDebug* const nullOpDebug = nullptr;
+        ASSERT_OK(
+            collection->insertDocuments(_opCtx.get(), inserts.begin(), inserts.end(), nullOpDebug));
+        wuow.commit();
+    }
+
+    assertMultikeyPaths(collection, keyPattern, {{0U}, {0U}});
+}
+
 TEST_F(MultikeyPathsTest, PathsUpdatedOnDocumentUpdate) {
     AutoGetCollection autoColl(_opCtx.get(), _nss, MODE_X);
     Collection* collection = autoColl.getCollection();
@@ -47,10 +47,12 @@
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -80,6 +82,10 @@ public:
         _client.dropCollection(nss.ns());
     }
 
+    void insert(const BSONObj& obj) {
+        _client.insert(nss.ns(), obj);
+    }
+
     void remove(const BSONObj& obj) {
         _client.remove(nss.ns(), obj);
     }
@@ -425,4 +431,159 @@ TEST_F(QueryStageCollectionScanTest, QueryTestCollscanResumeAfterRecordIdSeekFai
     ASSERT_EQUALS(PlanStage::FAILURE, ps->work(&id));
 }
 
+// Verify that a batched scan returns the same documents, in the same order, as a scan which is
+// worked one document at a time.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchWithMatch) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+
+    const CollatorInterface* collator = nullptr;
+    const boost::intrusive_ptr<ExpressionContext> expCtx(
+        new ExpressionContext(&_opCtx, collator, nss));
+    auto statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10 << "$lt" << 35)), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    auto scan = std::make_unique<CollectionScan>(
+        &_opCtx, collection, params, &ws, filterExpr.get());
+    ASSERT_TRUE(scan->supportsBatchedWork());
+
+    WorkingSetBatch batch(&ws, 8);
+    int expected = 10;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (PlanStage::IS_EOF != state) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        batch.clear();
+        state = scan->workBatch(&batch, &id);
+        ASSERT_NE(PlanStage::FAILURE, state);
+        ASSERT_NE(PlanStage::NEED_YIELD, state);
+        if (PlanStage::ADVANCED != state) {
+            ASSERT_TRUE(batch.empty());
+            continue;
+        }
+
+        ASSERT_LTE(batch.size(), batch.capacity());
+        while (!batch.empty()) {
+            WorkingSetID memberId = batch.next();
+            WorkingSetMember* member = ws.get(memberId);
+            ASSERT_TRUE(member->hasOwnedObj());
+            ASSERT_EQUALS(expected++, member->doc.value()["foo"].getInt());
+            ws.free(memberId);
+        }
+    }
+
+    ASSERT_EQUALS(35, expected);
+    ASSERT_TRUE(scan->isEOF());
+
+    auto stats = scan->getStats();
+    ASSERT_EQUALS(25U, stats->common.advanced);
+    ASSERT_EQUALS(static_cast<size_t>(numObj()),
+                  static_cast<const CollectionScanStats*>(stats->specific.get())->docsTested);
+}
+
+// Verify that a batched scan with a filter can return large documents whose total size is more than
+// a single buffer can hold.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchLargeDocuments) {
+    const int numLargeObj = 20;
+    const std::string largeString(4 * 1024 * 1024, 'x');
+    {
+        dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+        for (int i = 0; i < numLargeObj; ++i) {
+            insert(BSON("foo" << 1000 + i << "large" << largeString));
+        }
+    }
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+
+    const CollatorInterface* collator = nullptr;
+    const boost::intrusive_ptr<ExpressionContext> expCtx(
+        new ExpressionContext(&_opCtx, collator, nss));
+    auto statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 1000)), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    auto scan = std::make_unique<CollectionScan>(
+        &_opCtx, collection, params, &ws, filterExpr.get());
+    ASSERT_TRUE(scan->supportsBatchedWork());
+
+    WorkingSetBatch batch(&ws, 64);
+    int expected = 1000;
+    PlanStage::StageState state = PlanStage::NEED_TIME;
+    while (PlanStage::IS_EOF != state) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        batch.clear();
+        state = scan->workBatch(&batch, &id);
+        ASSERT_NE(PlanStage::FAILURE, state);
+        while (!batch.empty()) {
+            WorkingSetID memberId = batch.next();
+            WorkingSetMember* member = ws.get(memberId);
+            ASSERT_EQUALS(expected++, member->doc.value()["foo"].getInt());
+            ASSERT_EQUALS(largeString, member->doc.value()["large"].getString());
+            ws.free(memberId);
+        }
+    }
+
+    ASSERT_EQUALS(1000 + numLargeObj, expected);
+}
+
+// Verify that the PlanExecutor returns every result when it pulls batches from the plan.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBatchedExecution) {
+    const auto oldBatchSize = internalQueryExecBatchedWorkSize.load();
+    internalQueryExecBatchedWorkSize.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchedWorkSize.store(oldBatchSize); });
+
+    ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::FORWARD, BSONObj()));
+    ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::BACKWARD, BSONObj()));
+
+    BSONObj obj = BSON("foo" << BSON("$lt" << 25));
+    ASSERT_EQUALS(25, countResults(CollectionScanParams::FORWARD, obj));
+    ASSERT_EQUALS(25, countResults(CollectionScanParams::BACKWARD, obj));
+}
+
+// Verify that a scan bounded by a RecordId range returns exactly the records within the range,
+// even when the lower bound does not name a record in the collection.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRange) {
+    dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+    auto coll = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+
+    // Delete the record at the lower bound so that the scan must seek past it.
+    remove(coll->docFor(&_opCtx, recordIds[10]).value());
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.minRecord = recordIds[10];
+    params.maxRecord = recordIds[29];
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, coll, params, ws.get(), nullptr);
+
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), coll, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    int expected = 11;
+    PlanExecutor::ExecState state;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr));) {
+        ASSERT_EQUALS(expected++, obj["foo"].numberInt());
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(30, expected);
+}
+
 }  // namespace query_stage_collection_scan
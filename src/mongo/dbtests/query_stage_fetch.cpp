@@ -33,7 +33,9 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "mongo/client/dbclient_cursor.h"
 #include "mongo/db/catalog/collection.h"
@@ -44,6 +46,7 @@
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/exec/working_set_batch.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/dbtests/dbtests.h"
@@ -226,6 +229,83 @@ public:
     }
 };
 
+//
+// Test that a batch is fetched with a filter, and that members whose record is gone are dropped.
+//
+class FetchStageBatchFilter : public QueryStageFetchBase {
+public:
+    void run() {
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll =
+            CollectionCatalog::get(&_opCtx).lookupCollectionByNamespace(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        WorkingSet ws;
+
+        for (int i = 0; i < 10; ++i) {
+            insert(BSON("foo" << i));
+        }
+        set<RecordId> recordIds;
+        getRecordIds(&recordIds, coll);
+        ASSERT_EQUALS(size_t(10), recordIds.size());
+
+        // The record of this document is gone by the time it is fetched.
+        remove(BSON("foo" << 7));
+
+        auto mockStage = std::make_unique<QueuedDataStage>(&_opCtx, &ws);
+        for (auto&& recordId : recordIds) {
+            WorkingSetID id = ws.allocate();
+            WorkingSetMember* mockMember = ws.get(id);
+            mockMember->recordId = recordId;
+            ws.transitionToRecordIdAndIdx(id);
+            mockStage->pushBack(id);
+        }
+
+        BSONObj filterObj = BSON("foo" << BSON("$gte" << 5));
+        const CollatorInterface* collator = nullptr;
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, collator, nss()));
+        StatusWithMatchExpression statusWithMatcher =
+            MatchExpressionParser::parse(filterObj, expCtx);
+        verify(statusWithMatcher.isOK());
+        unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+        auto fetchStage = std::make_unique<FetchStage>(
+            &_opCtx, &ws, std::move(mockStage), filterExpr.get(), coll);
+        ASSERT_TRUE(fetchStage->supportsBatchedWork());
+
+        WorkingSetBatch batch(&ws, 4);
+        std::vector<int> results;
+        PlanStage::StageState state = PlanStage::NEED_TIME;
+        while (PlanStage::IS_EOF != state) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            batch.clear();
+            state = fetchStage->workBatch(&batch, &id);
+            ASSERT_NOT_EQUALS(PlanStage::FAILURE, state);
+            ASSERT_NOT_EQUALS(PlanStage::NEED_YIELD, state);
+            while (!batch.empty()) {
+                WorkingSetID memberId = batch.next();
+                WorkingSetMember* member = ws.get(memberId);
+                ASSERT_TRUE(member->hasOwnedObj());
+                results.push_back(member->doc.value()["foo"].getInt());
+                ws.free(memberId);
+            }
+        }
+
+        std::sort(results.begin(), results.end());
+        ASSERT_TRUE((std::vector<int>{5, 6, 8, 9}) == results);
+
+        auto stats = fetchStage->getStats();
+        ASSERT_EQUALS(4U, stats->common.advanced);
+        ASSERT_EQUALS(9U, static_cast<const FetchStats*>(stats->specific.get())->docsExamined);
+    }
+};
+
 class All : public OldStyleSuiteSpecification {
 public:
     All() : OldStyleSuiteSpecification("query_stage_fetch") {}
@@ -233,6 +313,7 @@ public:
     void setupTests() {
         add<FetchStageAlreadyFetched>();
         add<FetchStageFilter>();
+        add<FetchStageBatchFilter>();
     }
 };
 
@@ -38,13 +38,16 @@
 #include "mongo/db/client.h"
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
+#include "mongo/db/exec/collection_scan.h"
 #include "mongo/db/exec/fetch.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/queued_data_stage.h"
 #include "mongo/db/exec/sort.h"
 #include "mongo/db/json.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/dbtests/dbtests.h"
+#include "mongo/util/scopeguard.h"
 
 /**
  * This file tests db/exec/sort.cpp
@@ -599,6 +602,65 @@ public:
     }
 };
 
+// Sort the output of a collection scan which the sort pulls from the scan a batch at a time.
+class QueryStageSortBatchedInput : public QueryStageSortTestBase {
+public:
+    virtual int numObj() {
+        return 100;
+    }
+
+    void run() {
+        const auto oldBatchSize = internalQueryExecBatchedWorkSize.load();
+        internalQueryExecBatchedWorkSize.store(16);
+        ON_BLOCK_EXIT([&] { internalQueryExecBatchedWorkSize.store(oldBatchSize); });
+
+        dbtests::WriteContextForTests ctx(&_opCtx, ns());
+        Database* db = ctx.db();
+        Collection* coll =
+            CollectionCatalog::get(&_opCtx).lookupCollectionByNamespace(&_opCtx, nss());
+        if (!coll) {
+            WriteUnitOfWork wuow(&_opCtx);
+            coll = db->createCollection(&_opCtx, nss());
+            wuow.commit();
+        }
+
+        fillData();
+
+        auto ws = std::make_unique<WorkingSet>();
+        CollectionScanParams params;
+        auto scan = std::make_unique<CollectionScan>(&_opCtx, coll, params, ws.get(), nullptr);
+        ASSERT_TRUE(scan->supportsBatchedWork());
+
+        auto sortPattern = BSON("foo" << -1);
+        auto sortStage = std::make_unique<SortStageSimple>(_expCtx,
+                                                           ws.get(),
+                                                           SortPattern{sortPattern, _expCtx},
+                                                           limit(),
+                                                           maxMemoryUsageBytes(),
+                                                           false,  // addSortKeyMetadata
+                                                           std::move(scan));
+
+        auto statusWithPlanExecutor = PlanExecutor::make(
+            &_opCtx, std::move(ws), std::move(sortStage), coll, PlanExecutor::NO_YIELD);
+        ASSERT_OK(statusWithPlanExecutor.getStatus());
+        auto exec = std::move(statusWithPlanExecutor.getValue());
+
+        BSONObj obj;
+        int expected = numObj();
+        PlanExecutor::ExecState state;
+        while (PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
+            ASSERT_EQUALS(--expected, obj["foo"].numberInt());
+        }
+        ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+        ASSERT_EQUALS(0, expected);
+
+        // Each batch of input is spooled by a single call to work().
+        auto stats = exec->getRootStage()->getStats();
+        ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->children[0]->common.advanced);
+        ASSERT_LT(stats->common.works, static_cast<size_t>(2 * numObj()));
+    }
+};
+
 class All : public OldStyleSuiteSpecification {
 public:
     All() : OldStyleSuiteSpecification("query_stage_sort") {}
@@ -616,6 +678,7 @@ public:
         add<QueryStageSortDeletionInvalidationWithLimit<10>>();
         add<QueryStageSortDeletionInvalidationWithLimit<1>>();
         add<QueryStageSortParallelArrays>();
+        add<QueryStageSortBatchedInput>();
     }
 };
 
@@ -855,6 +855,54 @@ public:
     }
 };
 
+class SecondaryBatchInsertIndexKeyTimes : public StorageTimestampTest {
+public:
+    void run() {
+        // In order for the inserts to keep the timestamps given to them, we must be in
+        // non-replicated mode.
+        repl::UnreplicatedWritesBlock uwb(_opCtx);
+
+        NamespaceString nss("unittests.timestampedBatchInserts");
+        reset(nss);
+
+        AutoGetCollection autoColl(_opCtx, nss, LockMode::MODE_IX);
+        auto indexName = "a_1";
+        auto indexSpec = BSON("name" << indexName << "key" << BSON("a" << 1) << "v"
+                                     << static_cast<int>(kIndexVersion));
+        ASSERT_OK(dbtests::createIndexFromSpec(_opCtx, nss.ns(), indexSpec));
+
+        // Insert a batch whose documents each have their own timestamp, and whose index keys sort
+        // in the opposite order of the documents, so that the keys are not inserted in the order
+        // of their timestamps.
+        const std::int32_t docsToInsert = 10;
+        const LogicalTime firstInsertTime = _clock->reserveTicks(docsToInsert);
+        std::vector<InsertStatement> inserts;
+        for (std::int32_t num = 0; num < docsToInsert; ++num) {
+            inserts.emplace_back(BSON("_id" << num << "a" << docsToInsert - num),
+                                 firstInsertTime.addTicks(num).asTimestamp(),
+                                 0LL);
+        }
+        {
+            WriteUnitOfWork wunit(_opCtx);
+            OpDebug* const nullOpDebug = nullptr;
+            ASSERT_OK(autoColl.getCollection()->insertDocuments(
+                _opCtx, inserts.begin(), inserts.end(), nullOpDebug));
+            wunit.commit();
+        }
+
+        // Each index key becomes visible together with its document.
+        auto indexCatalog = autoColl.getCollection()->getIndexCatalog();
+        auto indexAccessMethod =
+            indexCatalog->getEntry(indexCatalog->findIndexByName(_opCtx, indexName))
+                ->accessMethod();
+        for (std::int32_t num = 0; num < docsToInsert; ++num) {
+            OneOffRead oor(_opCtx, firstInsertTime.addTicks(num).asTimestamp());
+            ASSERT_EQ(num + 1, itCount(autoColl.getCollection()));
+            ASSERT_EQ(num + 1, indexAccessMethod->getSortedDataInterface()->numEntries(_opCtx));
+        }
+    }
+};
+
 class SecondaryUpdateTimes : public StorageTimestampTest {
 public:
     void run() {
@@ -3819,6 +3867,7 @@ public:
         addIf<SecondaryInsertTimes>();
         addIf<SecondaryArrayInsertTimes>();
         addIf<SecondaryDeleteTimes>();
+        addIf<SecondaryBatchInsertIndexKeyTimes>();
         addIf<SecondaryUpdateTimes>();
         addIf<SecondaryInsertToUpsert>();
         addIf<SecondaryAtomicApplyOps>();
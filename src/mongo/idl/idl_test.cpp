@@ -1674,7 +1674,7 @@ TEST(IDLEnum, TestStringEnumNegative) {
 
 OpMsgRequest makeOMR(BSONObj obj) {
     OpMsgRequest request;
-    request.body = obj;
+    request.setBody(obj);
     return request;
 }
 
@@ -2036,7 +2036,7 @@ TEST(IDLDocSequence, TestBasic) {
                             << "objects" << BSON_ARRAY(BSON("foo" << 1)));
 
     OpMsgRequest request;
-    request.body = testTempDoc;
+    request.setBody(testTempDoc);
 
     auto testStruct = DocSequenceCommand::parse(ctxt, request);
     ASSERT_EQUALS(testStruct.getField1(), 3);
@@ -2107,7 +2107,7 @@ TEST(IDLDocSequence, TestMissingDB) {
                             << "objects" << BSON_ARRAY(BSON("foo" << 1)));
 
     OpMsgRequest request;
-    request.body = testTempDoc;
+    request.setBody(testTempDoc);
 
     ASSERT_THROWS(DocSequenceCommand::parse(ctxt, request), AssertionException);
 }
@@ -2390,7 +2390,7 @@ TEST(IDLDocSequence, TestWellKnownFieldsPassthrough) {
                                 << "objects" << BSON_ARRAY(BSON("foo" << 1)));
 
         OpMsgRequest request;
-        request.body = testTempDoc;
+        request.setBody(testTempDoc);
         auto testStruct = DocSequenceCommand::parse(ctxt, request);
         ASSERT_EQUALS(2UL, testStruct.getStructs().size());
 
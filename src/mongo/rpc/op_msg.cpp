@@ -78,8 +78,56 @@ uint32_t calculateChecksum(const Message& message) {
     return wiredtiger_crc32c_func()(message.singleData().view2ptr(), message.size() - kCrc32Size);
 }
 #endif  // MONGO_CONFIG_WIREDTIGER_ENABLED
+
+/**
+ * Reads the body section, validating it if validation is enabled, and fills 'fieldOffsets' with the
+ * offsets of its top-level fields, sorted by field name, using the offsets recorded during
+ * validation.
+ */
+BSONObj readBody(BufReader* reader, std::vector<uint32_t>* fieldOffsets) {
+    fieldOffsets->clear();
+    if (serverGlobalParams.objcheck) {
+        uassertStatusOK(validateBSON(static_cast<const char*>(reader->pos()),
+                                     reader->remaining(),
+                                     Validator<BSONObj>::enabledBSONVersion(),
+                                     fieldOffsets));
+    }
+
+    BSONObj body = reader->read<BSONObj>();
+    if (!serverGlobalParams.objcheck) {
+        for (auto&& elem : body) {
+            fieldOffsets->push_back(elem.rawdata() - body.objdata());
+        }
+    }
+
+    // A stable sort keeps duplicate field names in body order, so lookups find the first one.
+    std::stable_sort(fieldOffsets->begin(), fieldOffsets->end(), [&](uint32_t lhs, uint32_t rhs) {
+        return BSONElement(body.objdata() + lhs).fieldNameStringData() <
+            BSONElement(body.objdata() + rhs).fieldNameStringData();
+    });
+    return body;
+}
 }  // namespace
 
+BSONElement OpMsg::getBodyField(StringData name) const {
+    if (_bodyFieldOffsets.empty()) {
+        return _body[name];
+    }
+
+    auto it = std::lower_bound(
+        _bodyFieldOffsets.begin(),
+        _bodyFieldOffsets.end(),
+        name,
+        [&](uint32_t offset, StringData target) {
+            return BSONElement(_body.objdata() + offset).fieldNameStringData() < target;
+        });
+    if (it == _bodyFieldOffsets.end()) {
+        return BSONElement();
+    }
+    BSONElement elem(_body.objdata() + *it);
+    return elem.fieldNameStringData() == name ? elem : BSONElement();
+}
+
 uint32_t OpMsg::flags(const Message& message) {
     if (message.operation() != dbMsg)
         return 0;  // Other command protocols are the same as no flags set.
@@ -161,7 +209,7 @@ OpMsg OpMsg::parse(const Message& message) try {
             case Section::kBody: {
                 uassert(40430, "Multiple body sections in message", !haveBody);
                 haveBody = true;
-                msg.body = sectionsBuf.read<Validated<BSONObj>>();
+                msg._body = readBody(&sectionsBuf, &msg._bodyFieldOffsets);
                 break;
             }
 
@@ -201,8 +249,9 @@ OpMsg OpMsg::parse(const Message& message) try {
     // Technically this is O(N*M) but N is at most 2.
     for (const auto& docSeq : msg.sequences) {
         const char* name = docSeq.name.c_str();  // Pointer is redirected by next call.
-        auto inBody =
-            !dotted_path_support::extractElementAtPathOrArrayAlongPath(msg.body, name).eoo();
+        auto inBody = docSeq.name.find('.') == std::string::npos
+            ? !msg.getBodyField(docSeq.name).eoo()
+            : !dotted_path_support::extractElementAtPathOrArrayAlongPath(msg.body, name).eoo();
         uassert(40433,
                 str::stream() << "Duplicate field between body and document sequence "
                               << docSeq.name,
@@ -243,8 +292,8 @@ Message OpMsg::serialize() const {
 }
 
 void OpMsg::shareOwnershipWith(const ConstSharedBuffer& buffer) {
-    if (!body.isOwned()) {
-        body.shareOwnershipWith(buffer);
+    if (!_body.isOwned()) {
+        _body.shareOwnershipWith(buffer);
     }
     for (auto&& seq : sequences) {
         for (auto&& obj : seq.objs) {
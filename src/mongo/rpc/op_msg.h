@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "mongo/base/string_data.h"
@@ -45,6 +46,35 @@ struct OpMsg {
         std::vector<BSONObj> objs;
     };
 
+    OpMsg() = default;
+    explicit OpMsg(BSONObj body, std::vector<DocumentSequence> sequences = {})
+        : sequences(std::move(sequences)), _body(std::move(body)) {}
+
+    // 'body' refers to this object's own '_body', so it must not be copied from 'other'.
+    OpMsg(const OpMsg& other)
+        : sequences(other.sequences),
+          _body(other._body),
+          _bodyFieldOffsets(other._bodyFieldOffsets) {}
+    OpMsg(OpMsg&& other) noexcept
+        : sequences(std::move(other.sequences)),
+          _body(std::move(other._body)),
+          _bodyFieldOffsets(std::move(other._bodyFieldOffsets)) {
+        other._bodyFieldOffsets.clear();
+    }
+    OpMsg& operator=(const OpMsg& other) {
+        sequences = other.sequences;
+        _body = other._body;
+        _bodyFieldOffsets = other._bodyFieldOffsets;
+        return *this;
+    }
+    OpMsg& operator=(OpMsg&& other) noexcept {
+        sequences = std::move(other.sequences);
+        _body = std::move(other._body);
+        _bodyFieldOffsets = std::move(other._bodyFieldOffsets);
+        other._bodyFieldOffsets.clear();
+        return *this;
+    }
+
     static constexpr uint32_t kChecksumPresent = 1 << 0;
     static constexpr uint32_t kMoreToCome = 1 << 1;
     static constexpr uint32_t kExhaustSupported = 1 << 16;
@@ -137,8 +167,31 @@ struct OpMsg {
         return it == sequences.end() ? nullptr : &*it;
     }
 
-    BSONObj body;
+    /**
+     * Returns the first top-level field of 'body' named 'name', or an EOO element if there is none.
+     * This is equivalent to body[name], but a body produced by parse() is looked up in the index of
+     * its fields that parse() built while validating it, rather than walked again.
+     */
+    BSONElement getBodyField(StringData name) const;
+
+    /**
+     * Replaces the body. The new body has no field index, so getBodyField() walks it.
+     */
+    void setBody(BSONObj newBody) {
+        _body = std::move(newBody);
+        _bodyFieldOffsets.clear();
+    }
+
+    // Read-only view of '_body'. Use setBody() to replace it, so that its field index is dropped.
+    const BSONObj& body = _body;
     std::vector<DocumentSequence> sequences;
+
+private:
+    BSONObj _body;
+
+    // The offsets into '_body' of its top-level fields, sorted by field name and, for duplicated
+    // names, in body order. Built by parse() and cleared whenever '_body' is replaced.
+    std::vector<uint32_t> _bodyFieldOffsets;
 };
 
 /**
@@ -162,7 +215,7 @@ struct OpMsgRequest : public OpMsg {
                                       BSONObj body,
                                       const BSONObj& extraFields = {}) {
         OpMsgRequest request;
-        request.body = ([&] {
+        request.setBody([&] {
             BSONObjBuilder bodyBuilder(std::move(body));
             bodyBuilder.appendElements(extraFields);
             bodyBuilder.append("$db", db);
@@ -172,7 +225,7 @@ struct OpMsgRequest : public OpMsg {
     }
 
     StringData getDatabase() const {
-        if (auto elem = body["$db"])
+        if (auto elem = getBodyField("$db"))
             return elem.checkAndGetStringData();
         uasserted(40571, "OP_MSG requests require a $db argument");
     }
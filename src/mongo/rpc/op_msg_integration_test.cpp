@@ -782,7 +782,7 @@ TEST(OpMsg, ServerHandlesReallyLargeMessagesGracefully) {
     bob << "ismaster" << 1 << "ignoredField" << bigData << "$db"
         << "admin";
     OpMsgRequest request;
-    request.body = bob.obj<BSONObj::LargeSizeTrait>();
+    request.setBody(bob.obj<BSONObj::LargeSizeTrait>());
     ASSERT_GT(request.body.objsize(), BSONObjMaxInternalSize);
     auto requestMsg = request.serialize();
 
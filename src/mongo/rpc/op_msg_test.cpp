@@ -433,6 +433,42 @@ TEST_F(OpMsgParser, SucceedsIfSequenceAndBodyHaveCommonPrefix) {
     ASSERT_BSONOBJ_EQ(msg.sequences[0].objs[0], fromjson("{_id: 1}"));
 }
 
+TEST_F(OpMsgParser, BodyFieldLookupsMatchBody) {
+    auto msg =
+        OpMsgBytes{
+            kNoFlags,  //
+            kBodySection,
+            fromjson("{insert: 'coll', z: 1, a: {b: 2}, z: 3, $db: 'db'}"),
+        }
+            .parse();
+
+    const OpMsg copy = msg;
+    for (auto name : {"insert", "a", "z", "$db", "b", "missing", ""}) {
+        ASSERT_EQ(static_cast<const void*>(msg.getBodyField(name).rawdata()),
+                  static_cast<const void*>(msg.body[name].rawdata()))
+            << name;
+        ASSERT_EQ(static_cast<const void*>(copy.getBodyField(name).rawdata()),
+                  static_cast<const void*>(copy.body[name].rawdata()))
+            << name;
+    }
+    ASSERT_EQ(msg.getBodyField("z").numberInt(), 1);
+    ASSERT_EQ(OpMsgRequest(std::move(msg)).getDatabase(), "db");
+}
+
+TEST_F(OpMsgParser, BodyFieldLookupsSeeReplacedBody) {
+    auto msg =
+        OpMsgBytes{
+            kNoFlags,  //
+            kBodySection,
+            fromjson("{ping: 1, $db: 'db'}"),
+        }
+            .parse();
+
+    msg.setBody(fromjson("{ping: 1, other: 2, $db: 'otherDb'}"));
+    ASSERT_EQ(msg.getBodyField("other").numberInt(), 2);
+    ASSERT_EQ(msg.getBodyField("$db").checkAndGetStringData(), "otherDb");
+}
+
 TEST_F(OpMsgParser, FailsIfUnknownSectionKind) {
     auto msg = OpMsgBytes{
         kNoFlags,  //
@@ -679,7 +715,7 @@ void testSerializer(const Message& fromSerializer, OpMsgBytes&& expected) {
 
 TEST(OpMsgSerializer, JustBody) {
     OpMsg msg;
-    msg.body = fromjson("{ping: 1}");
+    msg.setBody(fromjson("{ping: 1}"));
 
     testSerializer(msg.serialize(),
                    OpMsgBytes{
@@ -691,7 +727,7 @@ TEST(OpMsgSerializer, JustBody) {
 
 TEST(OpMsgSerializer, BodyAndSequence) {
     OpMsg msg;
-    msg.body = fromjson("{ping: 1}");
+    msg.setBody(fromjson("{ping: 1}"));
     msg.sequences = {{"docs", {fromjson("{a:1}"), fromjson("{a:2}")}}};
 
     testSerializer(msg.serialize(),
@@ -711,7 +747,7 @@ TEST(OpMsgSerializer, BodyAndSequence) {
 
 TEST(OpMsgSerializer, BodyAndEmptySequence) {
     OpMsg msg;
-    msg.body = fromjson("{ping: 1}");
+    msg.setBody(fromjson("{ping: 1}"));
     msg.sequences = {{"docs", {}}};
 
     testSerializer(msg.serialize(),
@@ -729,7 +765,7 @@ TEST(OpMsgSerializer, BodyAndEmptySequence) {
 
 TEST(OpMsgSerializer, BodyAndTwoSequences) {
     OpMsg msg;
-    msg.body = fromjson("{ping: 1}");
+    msg.setBody(fromjson("{ping: 1}"));
     msg.sequences = {
         {"a", {fromjson("{a: 1}")}},  //
         {"b", {fromjson("{b: 1}")}},
@@ -887,28 +923,28 @@ TEST(OpMsgSerializer, SetFlagWorks) {
 
 TEST(OpMsgRequest, GetDatabaseWorks) {
     OpMsgRequest msg;
-    msg.body = fromjson("{$db: 'foo'}");
+    msg.setBody(fromjson("{$db: 'foo'}"));
     ASSERT_EQ(msg.getDatabase(), "foo");
 
-    msg.body = fromjson("{before: 1, $db: 'foo'}");
+    msg.setBody(fromjson("{before: 1, $db: 'foo'}"));
     ASSERT_EQ(msg.getDatabase(), "foo");
 
-    msg.body = fromjson("{before: 1, $db: 'foo', after: 1}");
+    msg.setBody(fromjson("{before: 1, $db: 'foo', after: 1}"));
     ASSERT_EQ(msg.getDatabase(), "foo");
 }
 
 TEST(OpMsgRequest, GetDatabaseThrowsWrongType) {
     OpMsgRequest msg;
-    msg.body = fromjson("{$db: 1}");
+    msg.setBody(fromjson("{$db: 1}"));
     ASSERT_THROWS(msg.getDatabase(), DBException);
 }
 
 TEST(OpMsgRequest, GetDatabaseThrowsMissing) {
     OpMsgRequest msg;
-    msg.body = fromjson("{}");
+    msg.setBody(fromjson("{}"));
     ASSERT_THROWS(msg.getDatabase(), AssertionException);
 
-    msg.body = fromjson("{$notdb: 'foo'}");
+    msg.setBody(fromjson("{$notdb: 'foo'}"));
     ASSERT_THROWS(msg.getDatabase(), AssertionException);
 }
 
@@ -85,7 +85,8 @@ std::shared_ptr<RoutingTableHistory> refreshCollectionRoutingInfo(
     OperationContext* opCtx,
     const NamespaceString& nss,
     std::shared_ptr<RoutingTableHistory> existingRoutingInfo,
-    StatusWith<CatalogCacheLoader::CollectionAndChangedChunks> swCollectionAndChangedChunks) {
+    StatusWith<CatalogCacheLoader::CollectionAndChangedChunks> swCollectionAndChangedChunks,
+    RoutingTableHistory::UpdateStats* updateStats) {
     if (swCollectionAndChangedChunks == ErrorCodes::NamespaceNotFound) {
         return nullptr;
     }
@@ -98,7 +99,8 @@ std::shared_ptr<RoutingTableHistory> refreshCollectionRoutingInfo(
         if (existingRoutingInfo &&
             existingRoutingInfo->getVersion().epoch() == collectionAndChunks.epoch) {
 
-            return existingRoutingInfo->makeUpdated(collectionAndChunks.changedChunks);
+            return existingRoutingInfo->makeUpdated(collectionAndChunks.changedChunks,
+                                                    updateStats);
         }
         auto defaultCollator = [&]() -> std::unique_ptr<CollatorInterface> {
             if (!collectionAndChunks.defaultCollation.isEmpty()) {
@@ -114,7 +116,8 @@ std::shared_ptr<RoutingTableHistory> refreshCollectionRoutingInfo(
                                             std::move(defaultCollator),
                                             collectionAndChunks.shardKeyIsUnique,
                                             collectionAndChunks.epoch,
-                                            collectionAndChunks.changedChunks);
+                                            collectionAndChunks.changedChunks,
+                                            updateStats);
     }();
 
     std::set<ShardId> shardIds;
@@ -660,7 +663,16 @@ void CatalogCache::_scheduleCollectionRefresh(WithLock lk,
 
             LOG_CATALOG_REFRESH(0) << "Refresh for collection " << nss << " took " << t.millis()
                                    << " ms and failed" << causedBy(redact(status));
-        } else if (routingInfoAfterRefresh) {
+            return;
+        }
+
+        if (isIncremental) {
+            _stats.totalIncrementalRefreshTimeMicros.addAndFetch(t.micros());
+        } else {
+            _stats.totalFullRefreshTimeMicros.addAndFetch(t.micros());
+        }
+
+        if (routingInfoAfterRefresh) {
             const int logLevel =
                 (!existingRoutingInfo ||
                  (existingRoutingInfo &&
@@ -704,8 +716,15 @@ void CatalogCache::_scheduleCollectionRefresh(WithLock lk,
             StatusWith<CatalogCacheLoader::CollectionAndChangedChunks> swCollAndChunks) noexcept {
         std::shared_ptr<RoutingTableHistory> newRoutingInfo;
         try {
-            newRoutingInfo = refreshCollectionRoutingInfo(
-                opCtx, nss, std::move(existingRoutingInfo), std::move(swCollAndChunks));
+            Timer buildTimer;
+            RoutingTableHistory::UpdateStats updateStats;
+            newRoutingInfo = refreshCollectionRoutingInfo(opCtx,
+                                                          nss,
+                                                          std::move(existingRoutingInfo),
+                                                          std::move(swCollAndChunks),
+                                                          &updateStats);
+            _stats.totalRoutingTableBuildTimeMicros.addAndFetch(buildTimer.micros());
+            _stats.totalRoutingTableBytesAllocated.addAndFetch(updateStats.bytesAllocated);
 
             onRefreshCompleted(Status::OK(), newRoutingInfo.get());
         } catch (const DBException& ex) {
@@ -806,6 +825,11 @@ void CatalogCache::Stats::report(BSONObjBuilder* builder) const {
     builder->append("countFullRefreshesStarted", countFullRefreshesStarted.load());
 
     builder->append("countFailedRefreshes", countFailedRefreshes.load());
+
+    builder->append("totalIncrementalRefreshTimeMicros", totalIncrementalRefreshTimeMicros.load());
+    builder->append("totalFullRefreshTimeMicros", totalFullRefreshTimeMicros.load());
+    builder->append("totalRoutingTableBuildTimeMicros", totalRoutingTableBuildTimeMicros.load());
+    builder->append("totalRoutingTableBytesAllocated", totalRoutingTableBytesAllocated.load());
 }
 
 CachedDatabaseInfo::CachedDatabaseInfo(DatabaseType dbt, std::shared_ptr<Shard> primaryShard)
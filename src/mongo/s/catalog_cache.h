@@ -463,6 +463,19 @@ private:
         // for whatever reason
         AtomicWord<long long> countFailedRefreshes{0};
 
+        // Cumulative, always-increasing counters of how much time successful incremental and full
+        // refreshes took from being kicked off until completion
+        AtomicWord<long long> totalIncrementalRefreshTimeMicros{0};
+        AtomicWord<long long> totalFullRefreshTimeMicros{0};
+
+        // Cumulative, always-increasing counter of how much of the refresh time was spent building
+        // routing tables out of the refreshed chunks
+        AtomicWord<long long> totalRoutingTableBuildTimeMicros{0};
+
+        // Cumulative, always-increasing counter of the approximate number of bytes allocated for
+        // the parts of refreshed routing tables not shared with their previous versions
+        AtomicWord<long long> totalRoutingTableBytesAllocated{0};
+
         /**
          * Reports the accumulated statistics for serverStatus.
          */
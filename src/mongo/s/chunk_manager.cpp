@@ -59,16 +59,54 @@ void checkAllElementsAreOfType(BSONType type, const BSONObj& o) {
     }
 }
 
-std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering ordering) {
+/**
+ * Returns 'shardKeyValue' with the field names removed, as KeyString encoding requires.
+ */
+BSONObj stripFieldNames(const BSONObj& shardKeyValue) {
     BSONObjBuilder strippedKeyValue;
     for (const auto& elem : shardKeyValue) {
         strippedKeyValue.appendAs(elem, ""_sd);
     }
+    return strippedKeyValue.obj();
+}
 
-    KeyString::Builder ks(KeyString::Version::V1, strippedKeyValue.done(), ordering);
+std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering ordering) {
+    KeyString::Builder ks(KeyString::Version::V1, stripFieldNames(shardKeyValue), ordering);
     return {ks.getBuffer(), ks.getSize()};
 }
 
+/**
+ * Throws ConflictingOperationInProgress unless 'right' starts exactly where 'left' ends.
+ */
+void checkChunksAreAdjacent(const ChunkInfo& left, const ChunkInfo& right) {
+    const int cmp = left.getMax().woCompare(right.getMin());
+    uassert(ErrorCodes::ConflictingOperationInProgress,
+            str::stream() << (cmp < 0 ? "Gap" : "Overlap")
+                          << " exists in the routing table between chunks "
+                          << left.getRange().toString() << " and " << right.getRange().toString(),
+            cmp == 0);
+}
+
+/**
+ * Throws ShardKeyNotFound if 'shardKey' cannot be used to target a single chunk under 'collation',
+ * because it contains collatable values and the collation is not the simple one.
+ */
+void checkCollationAllowsTargeting(const ChunkManager& cm,
+                                   const BSONObj& shardKey,
+                                   const BSONObj& collation) {
+    const bool hasSimpleCollation = (collation.isEmpty() && !cm.getDefaultCollator()) ||
+        SimpleBSONObjComparator::kInstance.evaluate(collation == CollationSpec::kSimpleSpec);
+    if (hasSimpleCollation)
+        return;
+
+    for (BSONElement elt : shardKey) {
+        uassert(ErrorCodes::ShardKeyNotFound,
+                str::stream() << "Cannot target single shard due to collation of key "
+                              << elt.fieldNameStringData() << " for namespace " << cm.getns(),
+                !CollationIndexKey::isCollatableType(elt.type()));
+    }
+}
+
 }  // namespace
 
 ShardVersionTargetingInfo::ShardVersionTargetingInfo(const OID& epoch)
@@ -79,8 +117,9 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
                                          KeyPattern shardKeyPattern,
                                          std::unique_ptr<CollatorInterface> defaultCollator,
                                          bool unique,
-                                         ChunkInfoMap chunkMap,
-                                         ChunkVersion collectionVersion)
+                                         ChunkMap chunkMap,
+                                         ChunkVersion collectionVersion,
+                                         boost::optional<ShardVersionMap> shardVersions)
     : _sequenceNumber(nextCMSequenceNumber.addAndFetch(1)),
       _nss(std::move(nss)),
       _uuid(uuid),
@@ -90,7 +129,7 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
       _unique(unique),
       _chunkMap(std::move(chunkMap)),
       _collectionVersion(collectionVersion),
-      _shardVersions(_constructShardVersionMap()) {}
+      _shardVersions(shardVersions ? std::move(*shardVersions) : _constructShardVersionMap()) {}
 
 void RoutingTableHistory::setShardStale(const ShardId& shardId) {
     auto it = _shardVersions.find(shardId);
@@ -106,37 +145,57 @@ void RoutingTableHistory::setAllShardsRefreshed() {
 }
 
 Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj& collation) const {
-    const bool hasSimpleCollation = (collation.isEmpty() && !_rt->getDefaultCollator()) ||
-        SimpleBSONObjComparator::kInstance.evaluate(collation == CollationSpec::kSimpleSpec);
-    if (!hasSimpleCollation) {
-        for (BSONElement elt : shardKey) {
-            uassert(ErrorCodes::ShardKeyNotFound,
-                    str::stream() << "Cannot target single shard due to collation of key "
-                                  << elt.fieldNameStringData() << " for namespace " << getns(),
-                    !CollationIndexKey::isCollatableType(elt.type()));
-        }
-    }
+    checkCollationAllowsTargeting(*this, shardKey, collation);
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     uassert(ErrorCodes::ShardKeyNotFound,
             str::stream() << "Cannot target single shard using key " << shardKey
                           << " for namespace " << getns(),
-            it != _rt->getChunkMap().end() && it->second->containsKey(shardKey));
+            it != _rt->getChunkMap().end() && (*it)->containsKey(shardKey));
 
-    return Chunk(*(it->second), _clusterTime);
+    return Chunk(**it, _clusterTime);
+}
+
+std::vector<Chunk> ChunkManager::findIntersectingChunks(const std::vector<BSONObj>& shardKeys,
+                                                        const BSONObj& collation) const {
+    for (const auto& shardKey : shardKeys) {
+        checkCollationAllowsTargeting(*this, shardKey, collation);
+    }
+
+    const auto keyStrings = _rt->_extractKeyStrings(shardKeys);
+    std::vector<StringData> keys;
+    keys.reserve(keyStrings.size());
+    for (const auto& keyString : keyStrings) {
+        keys.emplace_back(keyString.getBuffer(), keyString.getSize());
+    }
+
+    const auto its = _rt->getChunkMap().upperBounds(keys);
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(shardKeys.size());
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        const auto& it = its[i];
+        uassert(ErrorCodes::ShardKeyNotFound,
+                str::stream() << "Cannot target single shard using key " << shardKeys[i]
+                              << " for namespace " << getns(),
+                it != _rt->getChunkMap().end() && (*it)->containsKey(shardKeys[i]));
+        chunks.emplace_back(**it, _clusterTime);
+    }
+
+    return chunks;
 }
 
 bool ChunkManager::keyBelongsToShard(const BSONObj& shardKey, const ShardId& shardId) const {
     if (shardKey.isEmpty())
         return false;
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     if (it == _rt->getChunkMap().end())
         return false;
 
-    invariant(it->second->containsKey(shardKey));
+    invariant((*it)->containsKey(shardKey));
 
-    return it->second->getShardIdAt(_clusterTime) == shardId;
+    return (*it)->getShardIdAt(_clusterTime) == shardId;
 }
 
 void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
@@ -200,7 +259,7 @@ void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
     // For now, we satisfy that assumption by adding a shard with no matches rather than returning
     // an empty set of shards.
     if (shardIds->empty()) {
-        shardIds->insert(_rt->getChunkMap().begin()->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*_rt->getChunkMap().begin())->getShardIdAt(_clusterTime));
     }
 }
 
@@ -209,7 +268,7 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
                                        std::set<ShardId>* shardIds) const {
     const auto bounds = _rt->overlappingRanges(min, max, true);
     for (auto it = bounds.first; it != bounds.second; ++it) {
-        shardIds->insert(it->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*it)->getShardIdAt(_clusterTime));
 
         // No need to iterate through the rest of the ranges, because we already know we need to use
         // all shards.
@@ -222,7 +281,7 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
 bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& shardId) const {
     const auto bounds = _rt->overlappingRanges(range.getMin(), range.getMax(), false);
     const auto it = std::find_if(bounds.first, bounds.second, [this, &shardId](const auto& scr) {
-        return scr.second->getShardIdAt(_clusterTime) == shardId;
+        return scr->getShardIdAt(_clusterTime) == shardId;
     });
 
     return it != bounds.second;
@@ -230,10 +289,10 @@ bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& sh
 
 ChunkManager::ConstRangeOfChunks ChunkManager::getNextChunkOnShard(const BSONObj& shardKey,
                                                                    const ShardId& shardId) const {
-    for (auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    for (auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
          it != _rt->getChunkMap().end();
          ++it) {
-        const auto& chunk = it->second;
+        const auto& chunk = *it;
         if (chunk->getShardIdAt(_clusterTime) == shardId) {
             const auto begin = it;
             const auto end = ++it;
@@ -255,15 +314,15 @@ int RoutingTableHistory::getNShardsOwningChunks() const {
     return _shardVersions.size();
 }
 
-std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator>
+std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator>
 RoutingTableHistory::overlappingRanges(const BSONObj& min,
                                        const BSONObj& max,
                                        bool isMaxInclusive) const {
 
-    const auto itMin = _chunkMap.upper_bound(_extractKeyString(min));
+    const auto itMin = _chunkMap.upperBound(_extractKeyString(min));
     const auto itMax = [this, &max, isMaxInclusive]() {
-        auto it = isMaxInclusive ? _chunkMap.upper_bound(_extractKeyString(max))
-                                 : _chunkMap.lower_bound(_extractKeyString(max));
+        auto it = isMaxInclusive ? _chunkMap.upperBound(_extractKeyString(max))
+                                 : _chunkMap.lowerBound(_extractKeyString(max));
         return it == _chunkMap.end() ? it : ++it;
     }();
 
@@ -423,7 +482,7 @@ std::string RoutingTableHistory::toString() const {
 
     sb << "Chunks:\n";
     for (const auto& chunk : _chunkMap) {
-        sb << "\t" << chunk.second->toString() << '\n';
+        sb << "\t" << chunk->toString() << '\n';
     }
 
     sb << "Shard versions:\n";
@@ -438,13 +497,14 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
     const OID& epoch = _collectionVersion.epoch();
 
     ShardVersionMap shardVersions;
-    ChunkInfoMap::const_iterator current = _chunkMap.cbegin();
+    ChunkMap::const_iterator current = _chunkMap.begin();
 
     boost::optional<BSONObj> firstMin = boost::none;
     boost::optional<BSONObj> lastMax = boost::none;
 
-    while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = current->second;
+    while (current != _chunkMap.end()) {
+        const auto rangeFirst = current;
+        const auto& firstChunkInRange = *rangeFirst;
         const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
 
         // Tracks the max shard version for the shard on which the current range will reside
@@ -454,17 +514,18 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
         }
 
         auto& maxShardVersion = shardVersionIt->second.shardVersion;
+        auto& numChunks = shardVersionIt->second.numChunks;
 
         current =
             std::find_if(current,
-                         _chunkMap.cend(),
-                         [&currentRangeShardId,
-                          &maxShardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
-                             const auto& currentChunk = chunkMapEntry.second;
-
+                         _chunkMap.end(),
+                         [&currentRangeShardId, &maxShardVersion, &numChunks](
+                             const std::shared_ptr<ChunkInfo>& currentChunk) {
                              if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
                                  return true;
 
+                             ++numChunks;
+
                              if (currentChunk->getLastmod() > maxShardVersion)
                                  maxShardVersion = currentChunk->getLastmod();
 
@@ -474,7 +535,7 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
         const auto rangeLast = std::prev(current);
 
         const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->second->getMax();
+        const auto& rangeMax = (*rangeLast)->getMax();
 
         // Check the continuity of the chunks map
         if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
@@ -482,14 +543,14 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
                 uasserted(ErrorCodes::ConflictingOperationInProgress,
                           str::stream()
                               << "Gap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
+                              << (*std::prev(rangeFirst))->getRange().toString() << " and "
+                              << (*rangeLast)->getRange().toString());
             else
                 uasserted(ErrorCodes::ConflictingOperationInProgress,
                           str::stream()
                               << "Overlap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
+                              << (*std::prev(rangeFirst))->getRange().toString() << " and "
+                              << (*rangeLast)->getRange().toString());
         }
 
         if (!firstMin)
@@ -514,10 +575,93 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
     return shardVersions;
 }
 
+boost::optional<ShardVersionMap> RoutingTableHistory::_updateShardVersionMap(
+    const ChunkMap& chunkMap,
+    const std::vector<ChunkMap::Change>& changes,
+    const std::vector<std::shared_ptr<ChunkInfo>>& removedChunks) const {
+    const OID& epoch = _collectionVersion.epoch();
+
+    ShardVersionMap shardVersions;
+    for (const auto& [shardId, targetingInfo] : _shardVersions) {
+        auto& info = shardVersions.emplace(shardId, epoch).first->second;
+        info.shardVersion = targetingInfo.shardVersion;
+        info.numChunks = targetingInfo.numChunks;
+    }
+
+    // Every changed chunk is counted as added here and as removed below if a later change
+    // replaced it, but only those which made it into the routing table can be the newest chunk
+    // of their shard or break its continuity
+    std::set<ShardId> shardsWithNewChunks;
+    for (const auto& change : changes) {
+        const auto& chunk = *change.chunk;
+        const auto& shardId = chunk.getShardIdAt(boost::none);
+        auto& info = shardVersions.emplace(shardId, epoch).first->second;
+        ++info.numChunks;
+
+        const auto it = chunkMap.lowerBound(change.maxKey);
+        if (it == chunkMap.end() || *it != change.chunk)
+            continue;
+
+        if (it == chunkMap.begin()) {
+            checkAllElementsAreOfType(MinKey, chunk.getMin());
+        } else {
+            checkChunksAreAdjacent(**std::prev(it), chunk);
+        }
+
+        const auto next = std::next(it);
+        if (next == chunkMap.end()) {
+            checkAllElementsAreOfType(MaxKey, chunk.getMax());
+        } else {
+            checkChunksAreAdjacent(chunk, **next);
+        }
+
+        if (chunk.getLastmod() > info.shardVersion)
+            info.shardVersion = chunk.getLastmod();
+        shardsWithNewChunks.insert(shardId);
+    }
+
+    // Chunks which were not replaced by a newer one on the same shard may have been the source of
+    // that shard's version. This is not expected to happen, since the donor of a migration always
+    // has its version bumped unless it is left without chunks, but is handled nonetheless.
+    std::set<ShardId> shardsWithStaleVersion;
+    for (const auto& chunk : removedChunks) {
+        const auto& shardId = chunk->getShardIdAt(boost::none);
+        auto& info = shardVersions.at(shardId);
+        invariant(info.numChunks > 0);
+        --info.numChunks;
+
+        if (!shardsWithNewChunks.count(shardId) && chunk->getLastmod() == info.shardVersion)
+            shardsWithStaleVersion.insert(shardId);
+    }
+
+    for (auto it = shardVersions.begin(); it != shardVersions.end();) {
+        if (it->second.numChunks > 0) {
+            if (shardsWithStaleVersion.count(it->first))
+                return boost::none;
+            ++it;
+        } else {
+            it = shardVersions.erase(it);
+        }
+    }
+
+    invariant(!shardVersions.empty());
+    return shardVersions;
+}
+
 std::string RoutingTableHistory::_extractKeyString(const BSONObj& shardKeyValue) const {
     return extractKeyStringInternal(shardKeyValue, _shardKeyOrdering);
 }
 
+std::vector<KeyString::Value> RoutingTableHistory::_extractKeyStrings(
+    const std::vector<BSONObj>& shardKeyValues) const {
+    std::vector<BSONObj> strippedKeyValues;
+    strippedKeyValues.reserve(shardKeyValues.size());
+    for (const auto& shardKeyValue : shardKeyValues) {
+        strippedKeyValues.push_back(stripFieldNames(shardKeyValue));
+    }
+    return KeyString::encodeBatch(KeyString::Version::V1, strippedKeyValues, _shardKeyOrdering);
+}
+
 std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
     NamespaceString nss,
     boost::optional<UUID> uuid,
@@ -525,7 +669,8 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
     std::unique_ptr<CollatorInterface> defaultCollator,
     bool unique,
     OID epoch,
-    const std::vector<ChunkType>& chunks) {
+    const std::vector<ChunkType>& chunks,
+    UpdateStats* stats) {
     return RoutingTableHistory(std::move(nss),
                                std::move(uuid),
                                std::move(shardKeyPattern),
@@ -533,14 +678,16 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
                                std::move(unique),
                                {},
                                {0, 0, epoch})
-        .makeUpdated(chunks);
+        .makeUpdated(chunks, stats);
 }
 
 std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
-    const std::vector<ChunkType>& changedChunks) {
+    const std::vector<ChunkType>& changedChunks, UpdateStats* stats) {
 
     const auto startingCollectionVersion = getVersion();
-    auto chunkMap = _chunkMap;
+
+    std::vector<ChunkMap::Change> changes;
+    changes.reserve(changedChunks.size());
 
     ChunkVersion collectionVersion = startingCollectionVersion;
     for (const auto& chunk : changedChunks) {
@@ -557,44 +704,9 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         invariant(chunkVersion >= collectionVersion);
         collectionVersion = chunkVersion;
 
-        const auto chunkMinKeyString = _extractKeyString(chunk.getMin());
-        const auto chunkMaxKeyString = _extractKeyString(chunk.getMax());
-
-        // Returns the first chunk with a max key that is > min - implies that the chunk overlaps
-        // min
-        const auto low = chunkMap.upper_bound(chunkMinKeyString);
-
-        // Returns the first chunk with a max key that is > max - implies that the next chunk cannot
-        // not overlap max
-        const auto high = chunkMap.upper_bound(chunkMaxKeyString);
-
-        // If we are in the middle of splitting a chunk, for the first few
-        // chunks inserted, low == high, because both lookups will point to the
-        // same chunk (the one being split). If we're inserting the last chunk
-        // for the current chunk being split, low will point to the chunk that
-        // we're splitting, and high will point to the next chunk past the one
-        // we're splitting (which could be chunkMap.end()). In this case,
-        // std::distance(low, high) == 1. Lastly, this does not apply during
-        // the creation of the original routing table, in which case the map is
-        // empty and the first chunk that is inserted will find that low ==
-        // high, but low == chunkMap.end(), and we aren't doing a split in that
-        // case.
-        auto foundSingleChunk =
-            ((low == high || std::distance(low, high) == 1) && low != chunkMap.end());
-
-        auto newChunk = std::make_shared<ChunkInfo>(chunk);
-        if (foundSingleChunk) {
-            auto chunkBeingReplacedBySplit = low->second;
-            auto bytesInReplacedChunk =
-                chunkBeingReplacedBySplit->getWritesTracker()->getBytesWritten();
-            newChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
-        }
-
-        // Erase all chunks from the map, which overlap the chunk we got from the persistent store
-        chunkMap.erase(low, high);
-
-        // Insert only the chunk itself
-        chunkMap.insert(std::make_pair(chunkMaxKeyString, newChunk));
+        changes.push_back({_extractKeyString(chunk.getMin()),
+                           _extractKeyString(chunk.getMax()),
+                           std::make_shared<ChunkInfo>(chunk)});
     }
 
     // If at least one diff was applied, the metadata is correct, but it might not have changed so
@@ -609,6 +721,21 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         return shared_from_this();
     }
 
+    // Each changed chunk replaces all chunks overlapping it. Only the parts of the map the changes
+    // touch are copied, the rest is shared with this routing table.
+    ChunkMap::MergeInfo mergeInfo;
+    auto chunkMap = _chunkMap.createMerged(changes, &mergeInfo);
+
+    // A routing table built from scratch gets its shard versions from a single pass over all chunks
+    boost::optional<ShardVersionMap> shardVersions;
+    if (!_chunkMap.empty()) {
+        shardVersions = _updateShardVersionMap(chunkMap, changes, mergeInfo.removedChunks);
+    }
+
+    if (stats) {
+        stats->bytesAllocated += mergeInfo.bytesAllocated + changes.size() * sizeof(ChunkInfo);
+    }
+
     return std::shared_ptr<RoutingTableHistory>(
         new RoutingTableHistory(_nss,
                                 _uuid,
@@ -616,7 +743,8 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
                                 CollatorInterface::cloneCollator(getDefaultCollator()),
                                 isUnique(),
                                 std::move(chunkMap),
-                                collectionVersion));
+                                collectionVersion,
+                                std::move(shardVersions)));
 }
 
 }  // namespace mongo
@@ -36,7 +36,9 @@
 
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/collation/collator_interface.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/s/chunk.h"
+#include "mongo/s/chunk_map.h"
 #include "mongo/s/chunk_version.h"
 #include "mongo/s/client/shard.h"
 #include "mongo/s/shard_key_pattern.h"
@@ -49,9 +51,6 @@ struct QuerySolutionNode;
 class OperationContext;
 class ChunkManager;
 
-// Ordered map from the max for each chunk to an entry describing the chunk
-using ChunkInfoMap = std::map<std::string, std::shared_ptr<ChunkInfo>>;
-
 struct ShardVersionTargetingInfo {
     // Indicates whether the shard is stale and thus needs a catalog cache refresh. Is false by
     // default.
@@ -60,6 +59,10 @@ struct ShardVersionTargetingInfo {
     // Max chunk version for the shard.
     ChunkVersion shardVersion;
 
+    // Number of chunks owned by the shard, so that refreshes can tell when it no longer has any
+    // without scanning the whole routing table.
+    size_t numChunks{0};
+
     ShardVersionTargetingInfo(const OID& epoch);
 };
 
@@ -76,6 +79,15 @@ class RoutingTableHistory : public std::enable_shared_from_this<RoutingTableHist
     RoutingTableHistory& operator=(const RoutingTableHistory&) = delete;
 
 public:
+    /**
+     * Cost of building a routing table through makeNew() or makeUpdated(), for statistics.
+     */
+    struct UpdateStats {
+        // Approximate number of bytes allocated for the new routing table, excluding everything it
+        // shares with the one it was updated from
+        size_t bytesAllocated{0};
+    };
+
     /**
      * Makes an instance with a routing table for collection "nss", sharded on
      * "shardKeyPattern".
@@ -94,7 +106,8 @@ public:
         std::unique_ptr<CollatorInterface> defaultCollator,
         bool unique,
         OID epoch,
-        const std::vector<ChunkType>& chunks);
+        const std::vector<ChunkType>& chunks,
+        UpdateStats* stats = nullptr);
 
     /**
      * Constructs a new instance with a routing table updated according to the changes described
@@ -102,8 +115,13 @@ public:
      *
      * The changes in "changedChunks" must be sorted in ascending order by chunk version, and adhere
      * to the requirements of the routing table update algorithm.
+     *
+     * The new instance shares all chunks and all parts of the routing table which the changes do
+     * not touch with this one, so the cost of an update is proportional to the number of changed
+     * chunks rather than to the size of the routing table.
      */
-    std::shared_ptr<RoutingTableHistory> makeUpdated(const std::vector<ChunkType>& changedChunks);
+    std::shared_ptr<RoutingTableHistory> makeUpdated(const std::vector<ChunkType>& changedChunks,
+                                                     UpdateStats* stats = nullptr);
 
     /**
      * Returns an increasing number of the reload sequence number of this chunk manager.
@@ -146,7 +164,7 @@ public:
 
     ChunkVersion getVersion(const ShardId& shardId) const;
 
-    const ChunkInfoMap& getChunkMap() const {
+    const ChunkMap& getChunkMap() const {
         return _chunkMap;
     }
 
@@ -175,7 +193,7 @@ public:
         return _uuid;
     }
 
-    std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator> overlappingRanges(
+    std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator> overlappingRanges(
         const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
 
 
@@ -185,16 +203,37 @@ private:
                         KeyPattern shardKeyPattern,
                         std::unique_ptr<CollatorInterface> defaultCollator,
                         bool unique,
-                        ChunkInfoMap chunkMap,
-                        ChunkVersion collectionVersion);
+                        ChunkMap chunkMap,
+                        ChunkVersion collectionVersion,
+                        boost::optional<ShardVersionMap> shardVersions = boost::none);
 
     /**
      * Does a single pass over the chunkMap and constructs the ShardVersionMap object.
      */
     ShardVersionMap _constructShardVersionMap() const;
 
+    /**
+     * Derives the ShardVersionMap for 'chunkMap', which was produced from this routing table's
+     * chunk map by applying 'changes' and removing 'removedChunks', from this routing table's
+     * ShardVersionMap. Only the chunks around the changes are checked for continuity.
+     *
+     * Returns boost::none if a shard lost the chunk that determined its version without receiving
+     * any of the changed chunks, in which case its new version can only be found by a full pass.
+     */
+    boost::optional<ShardVersionMap> _updateShardVersionMap(
+        const ChunkMap& chunkMap,
+        const std::vector<ChunkMap::Change>& changes,
+        const std::vector<std::shared_ptr<ChunkInfo>>& removedChunks) const;
+
     std::string _extractKeyString(const BSONObj& shardKeyValue) const;
 
+    /**
+     * Batch form of _extractKeyString. All the keys follow the shard key pattern, so they are
+     * encoded with one KeyString builder.
+     */
+    std::vector<KeyString::Value> _extractKeyStrings(
+        const std::vector<BSONObj>& shardKeyValues) const;
+
     // The shard versioning mechanism hinges on keeping track of the number of times we reload
     // ChunkManagers.
     const unsigned long long _sequenceNumber;
@@ -218,7 +257,7 @@ private:
 
     // Map from the max for each chunk to an entry describing the chunk. The union of all chunks'
     // ranges must cover the complete space from [MinKey, MaxKey).
-    const ChunkInfoMap _chunkMap;
+    const ChunkMap _chunkMap;
 
     // Max version across all chunks
     const ChunkVersion _collectionVersion;
@@ -240,7 +279,7 @@ public:
     class ConstChunkIterator {
     public:
         ConstChunkIterator() = default;
-        explicit ConstChunkIterator(ChunkInfoMap::const_iterator iter,
+        explicit ConstChunkIterator(ChunkMap::const_iterator iter,
                                     boost::optional<Timestamp> clusterTime)
             : _iter{std::move(iter)}, _clusterTime{std::move(clusterTime)} {}
 
@@ -258,11 +297,11 @@ public:
             return !(*this == other);
         }
         const Chunk operator*() const {
-            return Chunk{*_iter->second, _clusterTime};
+            return Chunk{**_iter, _clusterTime};
         }
 
     private:
-        ChunkInfoMap::const_iterator _iter;
+        ChunkMap::const_iterator _iter;
         boost::optional<Timestamp> _clusterTime;
     };
 
@@ -318,8 +357,8 @@ public:
     }
 
     ConstRangeOfChunks chunks() const {
-        return {ConstChunkIterator{_rt->getChunkMap().cbegin(), _clusterTime},
-                ConstChunkIterator{_rt->getChunkMap().cend(), _clusterTime}};
+        return {ConstChunkIterator{_rt->getChunkMap().begin(), _clusterTime},
+                ConstChunkIterator{_rt->getChunkMap().end(), _clusterTime}};
     }
 
     int numChunks() const {
@@ -359,6 +398,13 @@ public:
      */
     Chunk findIntersectingChunk(const BSONObj& shardKey, const BSONObj& collation) const;
 
+    /**
+     * Batch form of findIntersectingChunk, returning the chunk for each of 'shardKeys' in the same
+     * order. The routing table is walked once in key order rather than searched once per key.
+     */
+    std::vector<Chunk> findIntersectingChunks(const std::vector<BSONObj>& shardKeys,
+                                              const BSONObj& collation) const;
+
     /**
      * Same as findIntersectingChunk, but assumes the simple collation.
      */
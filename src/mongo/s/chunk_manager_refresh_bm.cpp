@@ -247,6 +247,30 @@ void BM_FindIntersectingChunk(benchmark::State& state,
     state.SetItemsProcessed(state.iterations());
 }
 
+template <typename CollectionMetadataBuilderFn>
+void BM_FindIntersectingChunks(benchmark::State& state,
+                               CollectionMetadataBuilderFn makeCollectionMetadata) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+    constexpr size_t kBatchSize = 100;
+
+    auto cm = makeCollectionMetadata(nShards, nChunks);
+    auto keys = makeKeys(nChunks);
+    std::vector<std::vector<BSONObj>> batches;
+    for (size_t i = 0; i + kBatchSize <= keys.size(); i += kBatchSize) {
+        batches.emplace_back(keys.begin() + i, keys.begin() + i + kBatchSize);
+    }
+
+    size_t batchIndex = 0;
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(
+            cm->getChunkManager()->findIntersectingChunks(batches[batchIndex], BSONObj()));
+        batchIndex = (batchIndex + 1) % batches.size();
+    }
+
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
 template <typename CollectionMetadataBuilderFn>
 void BM_GetShardIdsForRange(benchmark::State& state,
                             CollectionMetadataBuilderFn makeCollectionMetadata) {
@@ -329,6 +353,10 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             BM_FindIntersectingChunk, Pessimal, makeChunkManagerWithPessimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
             BM_FindIntersectingChunk, Optimal, makeChunkManagerWithOptimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(
+            BM_FindIntersectingChunks, Pessimal, makeChunkManagerWithPessimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(
+            BM_FindIntersectingChunks, Optimal, makeChunkManagerWithOptimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
             BM_GetShardIdsForRange, Pessimal, makeChunkManagerWithPessimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
@@ -0,0 +1,338 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/chunk_map.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A sorted run of chunks. Max key i is 'prefix' followed by bytes [_suffixEnds[i - 1],
+ * _suffixEnds[i]) of '_suffixes'.
+ */
+class ChunkMap::Segment {
+public:
+    Segment(std::vector<KeyedChunk>::const_iterator first,
+            std::vector<KeyedChunk>::const_iterator last) {
+        invariant(first != last);
+
+        // The keys are sorted, so the prefix common to all of them is that of the first and last
+        const auto& firstKey = first->first;
+        const auto& lastKey = std::prev(last)->first;
+        const auto prefixLen =
+            std::mismatch(firstKey.begin(),
+                          firstKey.begin() + std::min(firstKey.size(), lastKey.size()),
+                          lastKey.begin())
+                .first -
+            firstKey.begin();
+        _prefix = firstKey.substr(0, prefixLen);
+
+        const auto count = std::distance(first, last);
+        _chunks.reserve(count);
+        _suffixEnds.reserve(count);
+        for (auto it = first; it != last; ++it) {
+            _suffixes.append(it->first, prefixLen, std::string::npos);
+            _suffixEnds.push_back(_suffixes.size());
+            _chunks.push_back(it->second);
+        }
+    }
+
+    size_t size() const {
+        return _chunks.size();
+    }
+
+    const std::shared_ptr<ChunkInfo>& chunk(size_t i) const {
+        return _chunks[i];
+    }
+
+    std::string maxKey(size_t i) const {
+        return _prefix + suffix(i).toString();
+    }
+
+    size_t allocatedBytes() const {
+        return sizeof(Segment) + _prefix.capacity() + _suffixes.capacity() +
+            _suffixEnds.capacity() * sizeof(uint32_t) +
+            _chunks.capacity() * sizeof(std::shared_ptr<ChunkInfo>);
+    }
+
+    /**
+     * Index of the first chunk at or after 'from' whose max key sorts after (or, if 'inclusive',
+     * not before) 'key'.
+     */
+    size_t find(StringData key, bool inclusive, size_t from = 0) const {
+        const int prefixCmp = key.substr(0, _prefix.size()).compare(_prefix);
+        if (prefixCmp < 0)
+            return from;
+        if (prefixCmp > 0)
+            return size();
+
+        const auto rest = key.substr(_prefix.size());
+        size_t lo = from;
+        size_t hi = size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            const int cmp = suffix(mid).compare(rest);
+            if (cmp > 0 || (inclusive && cmp == 0)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    }
+
+private:
+    StringData suffix(size_t i) const {
+        const size_t begin = i == 0 ? 0 : _suffixEnds[i - 1];
+        return StringData(_suffixes.data() + begin, _suffixEnds[i] - begin);
+    }
+
+    std::string _prefix;
+    std::string _suffixes;
+    std::vector<uint32_t> _suffixEnds;
+    std::vector<std::shared_ptr<ChunkInfo>> _chunks;
+};
+
+ChunkMap::const_iterator::reference ChunkMap::const_iterator::operator*() const {
+    return _map->_segments[_segment]->chunk(_index);
+}
+
+ChunkMap::const_iterator& ChunkMap::const_iterator::operator++() {
+    if (++_index == _map->_segments[_segment]->size()) {
+        ++_segment;
+        _index = 0;
+    }
+    return *this;
+}
+
+ChunkMap::const_iterator& ChunkMap::const_iterator::operator--() {
+    if (_index == 0) {
+        --_segment;
+        _index = _map->_segments[_segment]->size();
+    }
+    --_index;
+    return *this;
+}
+
+std::string ChunkMap::const_iterator::maxKey() const {
+    return _map->_segments[_segment]->maxKey(_index);
+}
+
+size_t ChunkMap::_findSegment(StringData key, bool inclusive, size_t from) const {
+    const auto begin = _segmentMaxKeys.begin() + from;
+    const auto it = inclusive
+        ? std::lower_bound(begin,
+                           _segmentMaxKeys.end(),
+                           key,
+                           [](const std::string& lhs, StringData rhs) { return lhs < rhs; })
+        : std::upper_bound(begin,
+                           _segmentMaxKeys.end(),
+                           key,
+                           [](StringData lhs, const std::string& rhs) { return lhs < rhs; });
+    return it - _segmentMaxKeys.begin();
+}
+
+ChunkMap::const_iterator ChunkMap::upperBound(StringData key) const {
+    const size_t segment = _findSegment(key, false);
+    if (segment == _segments.size())
+        return end();
+    return {this, segment, _segments[segment]->find(key, false)};
+}
+
+ChunkMap::const_iterator ChunkMap::lowerBound(StringData key) const {
+    const size_t segment = _findSegment(key, true);
+    if (segment == _segments.size())
+        return end();
+    return {this, segment, _segments[segment]->find(key, true)};
+}
+
+std::vector<ChunkMap::const_iterator> ChunkMap::upperBounds(
+    const std::vector<StringData>& keys) const {
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return keys[lhs] < keys[rhs];
+    });
+
+    std::vector<const_iterator> results(keys.size());
+
+    // Both the segment and the position inside of it can only move forward as the keys increase
+    size_t segment = 0;
+    size_t index = 0;
+    for (const auto i : order) {
+        const size_t nextSegment = _findSegment(keys[i], false, segment);
+        if (nextSegment != segment) {
+            segment = nextSegment;
+            index = 0;
+        }
+        if (segment == _segments.size()) {
+            results[i] = end();
+            continue;
+        }
+        index = _segments[segment]->find(keys[i], false, index);
+        results[i] = {this, segment, index};
+    }
+
+    return results;
+}
+
+ChunkMap ChunkMap::createMerged(const std::vector<Change>& changes, MergeInfo* info) const {
+    // The chunks of every segment overlapped by a change, which are then modified like an ordinary
+    // ordered map. Chunks from segments outside of it are never looked at.
+    std::map<std::string, std::shared_ptr<ChunkInfo>> overlay;
+    std::vector<bool> dirty(_segments.size(), false);
+
+    for (const auto& change : changes) {
+        // Segments are searched by the bounds of this map, whose spans the overlay never outgrows,
+        // and the last one searched holds the chunk following the change's range, if any
+        const size_t firstSegment = _findSegment(change.minKey, false);
+        if (firstSegment < _segments.size()) {
+            const size_t lastSegment =
+                std::min(_findSegment(change.maxKey, false), _segments.size() - 1);
+            for (size_t s = firstSegment; s <= lastSegment; ++s) {
+                if (dirty[s])
+                    continue;
+                dirty[s] = true;
+                const auto& segment = *_segments[s];
+                for (size_t i = 0; i < segment.size(); ++i) {
+                    overlay.emplace(segment.maxKey(i), segment.chunk(i));
+                }
+            }
+        }
+
+        // Returns the first chunk with a max key that is > min - implies that the chunk overlaps
+        // min
+        const auto low = overlay.upper_bound(change.minKey);
+
+        // Returns the first chunk with a max key that is > max - implies that the next chunk cannot
+        // not overlap max
+        const auto high = overlay.upper_bound(change.maxKey);
+
+        // If we are in the middle of splitting a chunk, for the first few
+        // chunks inserted, low == high, because both lookups will point to the
+        // same chunk (the one being split). If we're inserting the last chunk
+        // for the current chunk being split, low will point to the chunk that
+        // we're splitting, and high will point to the next chunk past the one
+        // we're splitting (which could be overlay.end()). In this case,
+        // std::distance(low, high) == 1. Lastly, this does not apply during
+        // the creation of the original routing table, in which case the map is
+        // empty and the first chunk that is inserted will find that low ==
+        // high, but low == overlay.end(), and we aren't doing a split in that
+        // case.
+        const bool foundSingleChunk =
+            ((low == high || std::distance(low, high) == 1) && low != overlay.end());
+
+        if (foundSingleChunk) {
+            auto bytesInReplacedChunk = low->second->getWritesTracker()->getBytesWritten();
+            change.chunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
+        }
+
+        // Erase all chunks from the map, which overlap the chunk we got from the persistent store
+        if (info) {
+            for (auto it = low; it != high; ++it) {
+                info->removedChunks.push_back(it->second);
+            }
+        }
+        overlay.erase(low, high);
+
+        // Insert only the chunk itself
+        overlay.emplace(change.maxKey, change.chunk);
+    }
+
+    // Splice the overlay back in between the untouched segments, which sort either entirely
+    // before or entirely after any of its chunks
+    ChunkMap merged;
+    size_t bytesAllocated = 0;
+    std::vector<KeyedChunk> pending;
+    auto it = overlay.begin();
+    for (size_t s = 0; s < _segments.size(); ++s) {
+        if (dirty[s])
+            continue;
+
+        const auto firstMaxKey = _segments[s]->maxKey(0);
+        for (; it != overlay.end() && it->first < firstMaxKey; ++it) {
+            pending.emplace_back(it->first, it->second);
+        }
+        bytesAllocated += merged._appendChunks(pending);
+        pending.clear();
+
+        merged._appendSegment(_segments[s]);
+    }
+    for (; it != overlay.end(); ++it) {
+        pending.emplace_back(it->first, it->second);
+    }
+    bytesAllocated += merged._appendChunks(pending);
+
+    if (info) {
+        info->bytesAllocated += bytesAllocated +
+            merged._segments.capacity() * sizeof(std::shared_ptr<const Segment>) +
+            merged._segmentMaxKeys.capacity() * sizeof(std::string) +
+            std::accumulate(merged._segmentMaxKeys.begin(),
+                            merged._segmentMaxKeys.end(),
+                            size_t(0),
+                            [](size_t sum, const std::string& key) { return sum + key.size(); });
+    }
+
+    return merged;
+}
+
+void ChunkMap::_appendSegment(std::shared_ptr<const Segment> segment) {
+    _segmentMaxKeys.push_back(segment->maxKey(segment->size() - 1));
+    _size += segment->size();
+    _segments.push_back(std::move(segment));
+}
+
+size_t ChunkMap::_appendChunks(const std::vector<KeyedChunk>& chunks) {
+    if (chunks.empty())
+        return 0;
+
+    // Spread the chunks evenly, so that a split at a full segment doesn't leave a tiny one behind
+    const size_t numSegments = (chunks.size() + kMaxSegmentSize - 1) / kMaxSegmentSize;
+    size_t bytesAllocated = 0;
+    auto first = chunks.begin();
+    for (size_t s = 0; s < numSegments; ++s) {
+        const size_t count = (chunks.size() - (first - chunks.begin())) / (numSegments - s);
+        const auto last = first + count;
+        auto segment = std::make_shared<const Segment>(first, last);
+        bytesAllocated += segment->allocatedBytes();
+        _appendSegment(std::move(segment));
+        first = last;
+    }
+    return bytesAllocated;
+}
+
+}  // namespace mongo
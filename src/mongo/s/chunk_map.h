@@ -0,0 +1,214 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/string_data.h"
+#include "mongo/s/chunk.h"
+
+namespace mongo {
+
+/**
+ * The chunks of a sharded collection ordered by the KeyString encoding of their max bound, which
+ * makes the chunk containing a given shard key the first one whose max key sorts after it.
+ *
+ * Chunks are kept in sorted, contiguous segments of at most kMaxSegmentSize entries. Each segment
+ * stores the prefix shared by all of its max keys once and only the remaining suffixes per chunk,
+ * so that lookups binary search over the segments' last keys and then over short suffixes
+ * packed into a single buffer, instead of chasing pointers through tree nodes.
+ *
+ * Segments are immutable and shared between maps: createMerged() rebuilds only the segments the
+ * incoming chunks overlap and reuses all others.
+ */
+class ChunkMap {
+    class Segment;
+
+public:
+    static constexpr size_t kMaxSegmentSize = 1024;
+
+    /**
+     * A chunk that is to replace all chunks overlapping its range.
+     */
+    struct Change {
+        std::string minKey;
+        std::string maxKey;
+        std::shared_ptr<ChunkInfo> chunk;
+    };
+
+    /**
+     * Side results of createMerged().
+     */
+    struct MergeInfo {
+        // Every chunk which was removed, either from this map or because a later change replaced
+        // an earlier one
+        std::vector<std::shared_ptr<ChunkInfo>> removedChunks;
+
+        // Approximate number of bytes allocated for the parts of the new map not shared with this
+        // one, excluding the chunks themselves
+        size_t bytesAllocated{0};
+    };
+
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::shared_ptr<ChunkInfo>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::shared_ptr<ChunkInfo>*;
+        using reference = const std::shared_ptr<ChunkInfo>&;
+
+        const_iterator() = default;
+
+        reference operator*() const;
+        pointer operator->() const {
+            return &operator*();
+        }
+
+        const_iterator& operator++();
+        const_iterator operator++(int) {
+            auto result = *this;
+            operator++();
+            return result;
+        }
+
+        const_iterator& operator--();
+        const_iterator operator--(int) {
+            auto result = *this;
+            operator--();
+            return result;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return _segment == other._segment && _index == other._index;
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+        /**
+         * The KeyString of the max bound of the chunk this iterator points to.
+         */
+        std::string maxKey() const;
+
+    private:
+        friend class ChunkMap;
+
+        const_iterator(const ChunkMap* map, size_t segment, size_t index)
+            : _map(map), _segment(segment), _index(index) {}
+
+        const ChunkMap* _map = nullptr;
+        size_t _segment = 0;
+        size_t _index = 0;
+    };
+
+    ChunkMap() = default;
+
+    const_iterator begin() const {
+        return {this, 0, 0};
+    }
+
+    const_iterator end() const {
+        return {this, _segments.size(), 0};
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * Returns the first chunk whose max key sorts after 'key', which is the chunk containing 'key'
+     * if there is one.
+     */
+    const_iterator upperBound(StringData key) const;
+
+    /**
+     * Returns the first chunk whose max key does not sort before 'key'.
+     */
+    const_iterator lowerBound(StringData key) const;
+
+    /**
+     * Batch form of upperBound(), returning the results in the order of 'keys'. The keys are
+     * visited in sorted order so that the map is walked forward once rather than searched from
+     * scratch for every key.
+     */
+    std::vector<const_iterator> upperBounds(const std::vector<StringData>& keys) const;
+
+    /**
+     * Returns a map in which each of 'changes', applied in order, has replaced the chunks whose max
+     * keys lie in (minKey, maxKey]. Segments none of the changes overlap are shared with this map.
+     *
+     * A chunk that is a piece of a single chunk being split inherits the bytes written to it, for
+     * the benefit of the auto-splitter.
+     *
+     * If 'info' is not null, it is filled in with what the merge removed and allocated.
+     */
+    ChunkMap createMerged(const std::vector<Change>& changes, MergeInfo* info = nullptr) const;
+
+    /**
+     * Number of segments, for testing.
+     */
+    size_t numSegments() const {
+        return _segments.size();
+    }
+
+private:
+    using KeyedChunk = std::pair<std::string, std::shared_ptr<ChunkInfo>>;
+
+    /**
+     * Index of the first segment whose last max key sorts after (or, if 'inclusive', not before)
+     * 'key', or the number of segments if there is none.
+     */
+    size_t _findSegment(StringData key, bool inclusive, size_t from = 0) const;
+
+    void _appendSegment(std::shared_ptr<const Segment> segment);
+
+    /**
+     * Packs 'chunks', which must sort after everything already in the map, into evenly sized new
+     * segments and returns the number of bytes these occupy.
+     */
+    size_t _appendChunks(const std::vector<KeyedChunk>& chunks);
+
+    std::vector<std::shared_ptr<const Segment>> _segments;
+
+    // The last max key of each segment, kept contiguous for the first level of the search.
+    std::vector<std::string> _segmentMaxKeys;
+
+    size_t _size = 0;
+};
+
+}  // namespace mongo
@@ -103,6 +103,22 @@ public:
     virtual StatusWith<ShardEndpoint> targetInsert(OperationContext* opCtx,
                                                    const BSONObj& doc) const = 0;
 
+    /**
+     * Returns the result of targetInsert for each of a batch of documents, in the same order.
+     *
+     * Targeters which can target many documents at once faster than one by one should override
+     * this.
+     */
+    virtual std::vector<StatusWith<ShardEndpoint>> targetInserts(
+        OperationContext* opCtx, const std::vector<BSONObj>& docs) const {
+        std::vector<StatusWith<ShardEndpoint>> endpoints;
+        endpoints.reserve(docs.size());
+        for (const auto& doc : docs) {
+            endpoints.push_back(targetInsert(opCtx, doc));
+        }
+        return endpoints;
+    }
+
     /**
      * Returns a vector of ShardEndpoints for a potentially multi-shard update.
      *
@@ -39,8 +39,10 @@
 #include "mongo/db/query/cursor_response.h"
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/killcursors_request.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -83,6 +85,29 @@ int compareSortKeys(BSONObj leftSortKey, BSONObj rightSortKey, BSONObj sortKeyPa
     return leftSortKey.woCompare(rightSortKey, sortKeyPattern, rules);
 }
 
+/**
+ * Returns the Ordering in which to encode sort keys for 'params', or boost::none if there is no
+ * sort or its pattern has more fields than an Ordering can describe.
+ */
+boost::optional<Ordering> makeSortKeyOrdering(const AsyncResultsMergerParams& params) {
+    if (!params.getSort() || params.getSort()->nFields() > int(Ordering::kMaxCompoundIndexKeys)) {
+        return boost::none;
+    }
+    return Ordering::make(*params.getSort());
+}
+
+/**
+ * Encodes 'sortKey' as a KeyString, such that two encoded sort keys compare with memcmp the same
+ * way as 'compareSortKeys()' compares the sort keys with the sort pattern 'ordering' was made from.
+ */
+std::string encodeSortKey(const BSONObj& sortKey, Ordering ordering) {
+    KeyString::Builder ks(KeyString::Version::V1, ordering);
+    for (auto&& elem : sortKey) {
+        ks.appendBSONElement(elem);
+    }
+    return {ks.getBuffer(), ks.getSize()};
+}
+
 }  // namespace
 
 AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
@@ -95,8 +120,11 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
       // since that is not supported we treat boost::none (unspecified) to mean 'kNormal'.
       _tailableMode(params.getTailableMode().value_or(TailableModeEnum::kNormal)),
       _params(std::move(params)),
-      _mergeQueue(MergingComparator(
-          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey())),
+      _sortKeyOrdering(makeSortKeyOrdering(_params)),
+      _mergeTree(MergingComparator(_remotes,
+                                   _params.getSort().value_or(BSONObj()),
+                                   _params.getCompareWholeSortKey(),
+                                   bool(_sortKeyOrdering))),
       _promisedMinSortKeys(PromisedMinSortKeyComparator(_params.getSort().value_or(BSONObj()))) {
     if (params.getTxnNumber()) {
         invariant(params.getSessionId());
@@ -277,12 +305,12 @@ bool AsyncResultsMerger::_readySorted(WithLock lk) {
 }
 
 bool AsyncResultsMerger::_readySortedTailable(WithLock lk) {
-    if (_mergeQueue.empty()) {
+    const auto smallestRemote = _getSmallestRemote(lk);
+    if (!smallestRemote) {
         return false;
     }
 
-    auto smallestRemote = _mergeQueue.top();
-    auto smallestResult = _remotes[smallestRemote].docBuffer.front();
+    auto smallestResult = _remotes[*smallestRemote].docBuffer.front();
     auto keyWeWantToReturn =
         extractSortKey(*smallestResult.getResult(), _params.getCompareWholeSortKey());
     // We should always have a minPromisedSortKey from every shard in the sorted tailable case.
@@ -325,28 +353,21 @@ StatusWith<ClusterQueryResult> AsyncResultsMerger::nextReady() {
     return _params.getSort() ? _nextReadySorted(lk) : _nextReadyUnsorted(lk);
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock lk) {
     // Tailable non-awaitData cursors cannot have a sort.
     invariant(_tailableMode != TailableModeEnum::kTailable);
 
-    if (_mergeQueue.empty()) {
+    const auto smallestRemote = _getSmallestRemote(lk);
+    if (!smallestRemote) {
         return {};
     }
 
-    size_t smallestRemote = _mergeQueue.top();
-    _mergeQueue.pop();
+    invariant(_remotes[*smallestRemote].status.isOK());
+    ClusterQueryResult front = _popNextResult(lk, *smallestRemote);
 
-    invariant(!_remotes[smallestRemote].docBuffer.empty());
-    invariant(_remotes[smallestRemote].status.isOK());
-
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
-
-    // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
-    // next result.
-    if (!_remotes[smallestRemote].docBuffer.empty()) {
-        _mergeQueue.push(smallestRemote);
-    }
+    // The next result from 'smallestRemote', if it has one, takes the place of the one returned.
+    _mergeTree.replayTop();
+    _prefetchNextBatchIfAllowed(lk, *smallestRemote);
 
     // For sorted tailable awaitData cursors, update the high water mark to the document's sort key.
     if (_tailableMode == TailableModeEnum::kTailableAndAwaitData) {
@@ -357,15 +378,28 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     return front;
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
+boost::optional<size_t> AsyncResultsMerger::_getSmallestRemote(WithLock) {
+    if (_mergeTreeNeedsReset || _mergeTree.size() != _remotes.size()) {
+        _mergeTree.reset(_remotes.size());
+        _mergeTreeNeedsReset = false;
+    }
+
+    // Remotes without buffered results sort last, so if the top one has none, no remote has any.
+    if (_remotes.empty() || !_remotes[_mergeTree.top()].hasNext()) {
+        return boost::none;
+    }
+    return _mergeTree.top();
+}
+
+ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock lk) {
     size_t remotesAttempted = 0;
     while (remotesAttempted < _remotes.size()) {
         // It is illegal to call this method if there is an error received from any shard.
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
-            _remotes[_gettingFromRemote].docBuffer.pop();
+            ClusterQueryResult front = _popNextResult(lk, _gettingFromRemote);
+            _prefetchNextBatchIfAllowed(lk, _gettingFromRemote);
 
             if (_tailableMode == TailableModeEnum::kTailable &&
                 !_remotes[_gettingFromRemote].hasNext()) {
@@ -388,7 +422,22 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
     return {};
 }
 
-Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
+ClusterQueryResult AsyncResultsMerger::_popNextResult(WithLock, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+
+    ClusterQueryResult front = remote.docBuffer.front();
+    remote.docBuffer.pop();
+    if (_sortKeyOrdering) {
+        remote.sortKeyBuffer.pop();
+    }
+
+    const size_t resultBytes = front.getResult()->objsize();
+    remote.bufferedBytes -= resultBytes;
+    _bufferedBytes -= resultBytes;
+    return front;
+}
+
+Status AsyncResultsMerger::_askForNextBatch(WithLock lk, size_t remoteIndex) {
     invariant(_opCtx, "Cannot schedule a getMore without an OperationContext");
     auto& remote = _remotes[remoteIndex];
 
@@ -444,6 +493,11 @@ Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     }
 
     remote.cbHandle = callbackStatus.getValue();
+
+    // Count the batch against the prefetch budget while it is on its way, so that the getMores
+    // in flight to all remotes together stay within it.
+    remote.reservedBytes = _estimateNextBatchBytes(lk, remoteIndex);
+    _reservedBytes += remote.reservedBytes;
     return Status::OK();
 }
 
@@ -473,6 +527,46 @@ Status AsyncResultsMerger::_scheduleGetMores(WithLock lk) {
     return Status::OK();
 }
 
+void AsyncResultsMerger::_prefetchNextBatchIfAllowed(WithLock lk, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+    if (_tailableMode != TailableModeEnum::kNormal || _params.getTxnNumber() || !_opCtx ||
+        _lifecycleState != kAlive || !remote.status.isOK() || remote.exhausted() ||
+        remote.cbHandle.isValid()) {
+        return;
+    }
+
+    // A remote whose buffer has run empty would be asked for its next batch by the next call to
+    // nextEvent() anyway, but there is no need to wait for the other remotes' buffers to run empty
+    // as well before doing so.
+    const auto prefetchBytes = internalQueryAsyncResultsMergerPrefetchBytes.load();
+    if (prefetchBytes <= 0 ||
+        (remote.hasNext() &&
+         _bufferedBytes + _reservedBytes + _estimateNextBatchBytes(lk, remoteIndex) >
+             static_cast<size_t>(prefetchBytes))) {
+        return;
+    }
+
+    remote.status = _askForNextBatch(lk, remoteIndex);
+}
+
+size_t AsyncResultsMerger::_estimateNextBatchBytes(WithLock, size_t remoteIndex) const {
+    const auto& remote = _remotes[remoteIndex];
+
+    // Without a batchSize, the size of the first batch of a cursor says little about the size of
+    // the next ones, which are only limited by the size of a reply.
+    const auto batchSize = _params.getBatchSize();
+    if (!batchSize || remote.lastBatchDocs == 0) {
+        return BSONObjMaxUserSize;
+    }
+
+    const auto averageDocBytes =
+        std::max<size_t>(remote.lastBatchBytes / remote.lastBatchDocs, 1);
+    if (static_cast<size_t>(*batchSize) >= BSONObjMaxUserSize / averageDocBytes) {
+        return BSONObjMaxUserSize;
+    }
+    return averageDocBytes * *batchSize;
+}
+
 /*
  * Note: When nextEvent() is called to do retries, only the remotes with retriable errors will
  * be rescheduled because:
@@ -571,8 +665,12 @@ void AsyncResultsMerger::_updateRemoteMetadata(WithLock,
 void AsyncResultsMerger::_handleBatchResponse(WithLock lk,
                                               CbData const& cbData,
                                               size_t remoteIndex) {
-    // Got a response from remote, so indicate we are no longer waiting for one.
-    _remotes[remoteIndex].cbHandle = executor::TaskExecutor::CallbackHandle();
+    // Got a response from remote, so indicate we are no longer waiting for one, and release the
+    // share of the prefetch budget reserved for it, whatever the outcome.
+    auto& remote = _remotes[remoteIndex];
+    remote.cbHandle = executor::TaskExecutor::CallbackHandle();
+    _reservedBytes -= remote.reservedBytes;
+    remote.reservedBytes = 0;
 
     //  On shutdown, there is no need to process the response.
     if (_lifecycleState != kAlive) {
@@ -618,6 +716,11 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
         remote.partialResultsReturned = (remote.status != ErrorCodes::ExchangePassthrough);
         std::queue<ClusterQueryResult> emptyBuffer;
         std::swap(remote.docBuffer, emptyBuffer);
+        std::queue<std::string> emptySortKeyBuffer;
+        std::swap(remote.sortKeyBuffer, emptySortKeyBuffer);
+        _bufferedBytes -= remote.bufferedBytes;
+        remote.bufferedBytes = 0;
+        _mergeTreeNeedsReset = true;
         remote.status = Status::OK();
         remote.cursorId = 0;
     }
@@ -665,6 +768,10 @@ void AsyncResultsMerger::_processBatchResults(WithLock lk,
         // Be careful only to do this when '_opCtx' is non-null, since it is illegal to schedule a
         // remote command on a user's behalf without a non-null OperationContext.
         remote.status = _askForNextBatch(lk, remoteIndex);
+    } else {
+        // Otherwise, ask for the batch after this one while this one is being consumed, if the
+        // prefetch budget allows for it.
+        _prefetchNextBatchIfAllowed(lk, remoteIndex);
     }
 }
 
@@ -673,6 +780,15 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
                                            const CursorResponse& response) {
     auto& remote = _remotes[remoteIndex];
     _updateRemoteMetadata(lk, remoteIndex, response);
+
+    // If we're doing a sorted merge and this remote had nothing buffered, its first result is new
+    // to the merge tree, which has to be rebuilt to take it into account.
+    if (_params.getSort() && !remote.hasNext() && !response.getBatch().empty()) {
+        _mergeTreeNeedsReset = true;
+    }
+
+    remote.lastBatchBytes = 0;
+    remote.lastBatchDocs = 0;
     for (const auto& obj : response.getBatch()) {
         // If there's a sort, we're expecting the remote node to have given us back a sort key.
         if (_params.getSort()) {
@@ -692,16 +808,21 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
             }
         }
 
+        if (_sortKeyOrdering) {
+            remote.sortKeyBuffer.push(encodeSortKey(
+                extractSortKey(obj, _params.getCompareWholeSortKey()), *_sortKeyOrdering));
+        }
+
         ClusterQueryResult result(obj);
         remote.docBuffer.push(result);
         ++remote.fetchedCount;
-    }
 
-    // If we're doing a sorted merge, then we have to make sure to put this remote onto the merge
-    // queue.
-    if (_params.getSort() && !response.getBatch().empty()) {
-        _mergeQueue.push(remoteIndex);
+        remote.lastBatchBytes += obj.objsize();
+        ++remote.lastBatchDocs;
+        remote.bufferedBytes += obj.objsize();
+        _bufferedBytes += obj.objsize();
     }
+
     return true;
 }
 
@@ -816,13 +937,25 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
 // AsyncResultsMerger::MergingComparator
 //
 
-bool AsyncResultsMerger::MergingComparator::operator()(const size_t& lhs, const size_t& rhs) {
-    const ClusterQueryResult& leftDoc = _remotes[lhs].docBuffer.front();
-    const ClusterQueryResult& rightDoc = _remotes[rhs].docBuffer.front();
+bool AsyncResultsMerger::MergingComparator::operator()(size_t lhs, size_t rhs) const {
+    const auto& leftRemote = _remotes[lhs];
+    const auto& rightRemote = _remotes[rhs];
 
-    return compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
-                           extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
-                           _sort) > 0;
+    if (!leftRemote.hasNext() || !rightRemote.hasNext()) {
+        return leftRemote.hasNext() || (!rightRemote.hasNext() && lhs < rhs);
+    }
+
+    int sortKeyComp;
+    if (_compareEncodedSortKeys) {
+        sortKeyComp = leftRemote.sortKeyBuffer.front().compare(rightRemote.sortKeyBuffer.front());
+    } else {
+        const ClusterQueryResult& leftDoc = leftRemote.docBuffer.front();
+        const ClusterQueryResult& rightDoc = rightRemote.docBuffer.front();
+        sortKeyComp = compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
+                                      extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
+                                      _sort);
+    }
+    return sortKeyComp < 0 || (sortKeyComp == 0 && lhs < rhs);
 }
 
 bool AsyncResultsMerger::PromisedMinSortKeyComparator::operator()(
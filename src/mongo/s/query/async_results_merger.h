@@ -35,11 +35,13 @@
 
 #include "mongo/base/status_with.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/bson/ordering.h"
 #include "mongo/db/cursor_id.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/s/query/async_results_merger_params_gen.h"
 #include "mongo/s/query/cluster_query_result.h"
+#include "mongo/s/query/loser_tree.h"
 #include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/net/hostandport.h"
 #include "mongo/util/time_support.h"
@@ -88,8 +90,8 @@ public:
      * the hosts on which they exist in _remotes.
      *
      * Additionally copies each remote's first batch of results, if one exists, into that remote's
-     * docBuffer. If a sort is specified in the ClusterClientCursorParams, places the remotes with
-     * buffered results onto _mergeQueue.
+     * docBuffer. If a sort is specified in the ClusterClientCursorParams, also encodes the sort
+     * keys of these results into the remote's sortKeyBuffer.
      *
      * The TaskExecutor* must remain valid for the lifetime of the ARM.
      *
@@ -305,6 +307,11 @@ private:
         // The buffer of results that have been retrieved but not yet returned to the caller.
         std::queue<ClusterQueryResult> docBuffer;
 
+        // If there is a sort, the sort keys of the results in 'docBuffer' in the same order, as
+        // KeyStrings which compare with memcmp in the order of the sort pattern. Left empty if the
+        // sort pattern has too many fields to be encoded.
+        std::queue<std::string> sortKeyBuffer;
+
         // Is valid if there is currently a pending request to this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
 
@@ -315,16 +322,36 @@ private:
         // Count of fetched docs during ARM processing of the current batch. Used to reduce the
         // batchSize in getMore when mongod returned less docs than the requested batchSize.
         long long fetchedCount = 0;
+
+        // The total size of the results in 'docBuffer'.
+        size_t bufferedBytes = 0;
+
+        // The size and number of results of the last batch received from this remote, from which
+        // the size of its next batch is estimated.
+        size_t lastBatchBytes = 0;
+        size_t lastBatchDocs = 0;
+
+        // The estimated size of the batch requested by the pending request to this remote, which
+        // is counted against the prefetch budget until the response arrives.
+        size_t reservedBytes = 0;
     };
 
+    /**
+     * Orders remotes by the sort key of the first result in their buffer. Remotes without buffered
+     * results sort after all others and ties are broken by remote index.
+     */
     class MergingComparator {
     public:
         MergingComparator(const std::vector<RemoteCursorData>& remotes,
                           const BSONObj& sort,
-                          bool compareWholeSortKey)
-            : _remotes(remotes), _sort(sort), _compareWholeSortKey(compareWholeSortKey) {}
+                          bool compareWholeSortKey,
+                          bool compareEncodedSortKeys)
+            : _remotes(remotes),
+              _sort(sort),
+              _compareWholeSortKey(compareWholeSortKey),
+              _compareEncodedSortKeys(compareEncodedSortKeys) {}
 
-        bool operator()(const size_t& lhs, const size_t& rhs);
+        bool operator()(size_t lhs, size_t rhs) const;
 
     private:
         const std::vector<RemoteCursorData>& _remotes;
@@ -335,6 +362,10 @@ private:
         // We extract the sort key {$sortKey: <value>}. The sort key pattern '_sort' is verified to
         // be {$sortKey: 1}.
         const bool _compareWholeSortKey;
+
+        // Whether the remotes' sortKeyBuffers are populated, so that the encoded sort keys can be
+        // compared instead of the BSON ones.
+        const bool _compareEncodedSortKeys;
     };
 
     using MinSortKeyRemoteIdPair = std::pair<BSONObj, size_t>;
@@ -390,6 +421,17 @@ private:
     ClusterQueryResult _nextReadySorted(WithLock);
     ClusterQueryResult _nextReadyUnsorted(WithLock);
 
+    /**
+     * Removes the next buffered result of the remote at 'remoteIndex' and returns it.
+     */
+    ClusterQueryResult _popNextResult(WithLock, size_t remoteIndex);
+
+    /**
+     * Returns the index of the remote whose next buffered result comes first in the sort order,
+     * or boost::none if no remote has buffered results. Used only if there is a sort.
+     */
+    boost::optional<size_t> _getSmallestRemote(WithLock);
+
     using CbData = executor::TaskExecutor::RemoteCommandCallbackArgs;
     using CbResponse = executor::TaskExecutor::ResponseStatus;
 
@@ -448,6 +490,24 @@ private:
      */
     Status _scheduleGetMores(WithLock);
 
+    /**
+     * Schedules a getMore on the remote at 'remoteIndex' ahead of its buffer running empty, if
+     * prefetching is enabled and the results buffered by this ARM together with the expected size
+     * of the remote's next batch stay within internalQueryAsyncResultsMergerPrefetchBytes. A
+     * failure to schedule is recorded in the remote's status.
+     *
+     * Prefetching is never done for tailable cursors, whose getMores may wait for new data, or
+     * within a transaction.
+     */
+    void _prefetchNextBatchIfAllowed(WithLock, size_t remoteIndex);
+
+    /**
+     * Returns the expected size of the next batch of the remote at 'remoteIndex': the average size
+     * of the results in its last batch times the getMore batchSize, or the maximum size of a reply
+     * if there is no batchSize or nothing is known about the size of the remote's results.
+     */
+    size_t _estimateNextBatchBytes(WithLock, size_t remoteIndex) const;
+
     /**
      * Schedules a killCursors command to be run on all remote hosts that have open cursors.
      */
@@ -463,15 +523,31 @@ private:
     TailableModeEnum _tailableMode;
     AsyncResultsMergerParams _params;
 
+    // The ordering in which sort keys are encoded into the remotes' sortKeyBuffers. Not set if
+    // there is no sort, or if the sort pattern has too many fields for an Ordering.
+    const boost::optional<Ordering> _sortKeyOrdering;
+
     // Must be acquired before accessing any data members (other than _params, which is read-only).
     mutable Mutex _mutex = MONGO_MAKE_LATCH("AsyncResultsMerger::_mutex");
 
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
-    // The top of this priority queue is the index into '_remotes' for the remote host that has the
-    // next document to return, according to the sort order. Used only if there is a sort.
-    std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
+    // The top of this tree is the index into '_remotes' for the remote host that has the next
+    // document to return, according to the sort order. Used only if there is a sort.
+    //
+    // Consuming the top document only replays the top remote's path through the tree. The tree is
+    // rebuilt, by setting '_mergeTreeNeedsReset', whenever the first buffered document of any other
+    // remote changes, which happens only when a remote with an empty buffer receives a batch or
+    // when a remote's buffer is discarded.
+    LoserTree<MergingComparator> _mergeTree;
+    bool _mergeTreeNeedsReset = true;
+
+    // The total size of the results buffered across all remotes.
+    size_t _bufferedBytes = 0;
+
+    // The total estimated size of the batches requested from all remotes but not yet received.
+    size_t _reservedBytes = 0;
 
     // The index into '_remotes' for the remote from which we are currently retrieving results.
     // Used only if there is *not* a sort.
@@ -41,9 +41,11 @@
 #include "mongo/db/query/query_request.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/s/client/shard_registry.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/s/query/results_merger_test_fixture.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -386,6 +388,123 @@ TEST_F(AsyncResultsMergerTest, MultiShardMultipleGets) {
     ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
 }
 
+TEST_F(AsyncResultsMergerTest, PrefetchesNextBatchWhileBufferIsConsumed) {
+    const auto prefetchBytes = internalQueryAsyncResultsMergerPrefetchBytes.load();
+    internalQueryAsyncResultsMergerPrefetchBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalQueryAsyncResultsMergerPrefetchBytes.store(prefetchBytes); });
+
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), boost::none, 2);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(5), batch1));
+
+    // The ARM asks for the next batch before the first one is consumed.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(networkHasReadyRequests());
+
+    executor()->waitForEvent(readyEvent);
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}")};
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(0), batch2));
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->remotesExhausted());
+
+    // The prefetched batch is returned after the rest of the first one, without another event.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, PrefetchWaitsUntilNextBatchFitsInBudget) {
+    // Allow the ARM to buffer three results, so that a batch of two can only be prefetched once
+    // one result of the previous batch has been consumed.
+    const auto prefetchBytes = internalQueryAsyncResultsMergerPrefetchBytes.load();
+    internalQueryAsyncResultsMergerPrefetchBytes.store(3 * fromjson("{_id: 1}").objsize());
+    ON_BLOCK_EXIT([&] { internalQueryAsyncResultsMergerPrefetchBytes.store(prefetchBytes); });
+
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(
+        makeRemoteCursor(kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, {})));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), boost::none, 2);
+
+    auto readyEvent = unittest::assertGet(arm->nextEvent());
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(5), batch1));
+    ASSERT_TRUE(arm->ready());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    executor()->waitForEvent(readyEvent);
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}"), fromjson("{_id: 4}")};
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(0), batch2));
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 4}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, PrefetchBudgetCountsBatchesInFlightToOtherRemotes) {
+    // Allow the ARM to buffer four results, with getMores asking for batches of two.
+    const auto prefetchBytes = internalQueryAsyncResultsMergerPrefetchBytes.load();
+    internalQueryAsyncResultsMergerPrefetchBytes.store(4 * fromjson("{_id: 1}").objsize());
+    ON_BLOCK_EXIT([&] { internalQueryAsyncResultsMergerPrefetchBytes.store(prefetchBytes); });
+
+    std::vector<RemoteCursor> cursors;
+    std::vector<BSONObj> batch1 = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, batch1)));
+    std::vector<BSONObj> batch2 = {fromjson("{_id: 3}"), fromjson("{_id: 4}")};
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, 6, batch2)));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), boost::none, 2);
+
+    // The first remote is asked for its next batch once its buffer runs empty.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+
+    // One result is buffered and a batch of two is on its way, so prefetching a batch of two from
+    // the second remote would exceed the budget.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+
+    std::vector<BSONObj> batch3 = {fromjson("{_id: 5}"), fromjson("{_id: 6}")};
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(0), batch3));
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 4}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 5}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 6}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(arm->ready());
+
+    scheduleNetworkResponse(CursorResponse(kTestNss, CursorId(0), {}));
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
 TEST_F(AsyncResultsMergerTest, CompoundSortKey) {
     BSONObj findCmd = fromjson("{find: 'testcoll', sort: {a: -1, b: 1}}");
     std::vector<RemoteCursor> cursors;
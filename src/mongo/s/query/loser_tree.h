@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+/**
+ * A tournament tree which tracks which of 'n' sorted streams has the smallest head. Each internal
+ * node remembers the loser of the match played at it, so that after the head of the winning
+ * stream is consumed, the next winner is found by replaying the matches on the path from that
+ * stream's leaf to the root: one comparison per level and no other stream is looked at.
+ *
+ * Streams are identified by their index in [0, n) and compared through 'Less', which is called
+ * with two stream indexes and must return whether the first one's head is to be consumed before
+ * the second one's. A stream without a head should compare after all others and ties should be
+ * broken consistently, e.g. by index.
+ *
+ * Only the head of the winning stream may change between calls to replayTop(). If the head of any
+ * other stream changes, the tree must be rebuilt with reset().
+ */
+template <typename Less>
+class LoserTree {
+public:
+    explicit LoserTree(Less less) : _less(std::move(less)) {}
+
+    /**
+     * Builds the tree over streams [0, numStreams), in O(numStreams) comparisons.
+     */
+    void reset(size_t numStreams) {
+        _numStreams = numStreams;
+        _nodes.assign(numStreams, 0);
+        if (numStreams == 0) {
+            return;
+        }
+
+        // Leaf i is node 'numStreams + i', and the parent of node n is node n / 2.
+        std::vector<size_t> winners(2 * numStreams);
+        for (size_t i = 0; i < numStreams; ++i) {
+            winners[numStreams + i] = i;
+        }
+        for (size_t n = numStreams - 1; n >= 1; --n) {
+            const size_t left = winners[2 * n];
+            const size_t right = winners[2 * n + 1];
+            if (_less(right, left)) {
+                winners[n] = right;
+                _nodes[n] = left;
+            } else {
+                winners[n] = left;
+                _nodes[n] = right;
+            }
+        }
+        _nodes[0] = winners[1];
+    }
+
+    size_t size() const {
+        return _numStreams;
+    }
+
+    /**
+     * Returns the stream with the smallest head.
+     */
+    size_t top() const {
+        invariant(_numStreams > 0);
+        return _nodes[0];
+    }
+
+    /**
+     * Finds the new winner after the head of the stream returned by top() has changed.
+     */
+    void replayTop() {
+        invariant(_numStreams > 0);
+        size_t winner = _nodes[0];
+        for (size_t n = (_numStreams + winner) / 2; n >= 1; n /= 2) {
+            if (_less(_nodes[n], winner)) {
+                std::swap(_nodes[n], winner);
+            }
+        }
+        _nodes[0] = winner;
+    }
+
+private:
+    Less _less;
+
+    size_t _numStreams = 0;
+
+    // Node 0 holds the overall winner and nodes [1, _numStreams) the loser of their match.
+    std::vector<size_t> _nodes;
+};
+
+}  // namespace mongo
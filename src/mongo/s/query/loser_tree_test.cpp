@@ -0,0 +1,128 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/s/query/loser_tree.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "mongo/platform/random.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using Streams = std::vector<std::deque<int>>;
+
+/**
+ * Orders streams by their head, with empty streams last and ties broken by stream index.
+ */
+class StreamLess {
+public:
+    explicit StreamLess(const Streams& streams) : _streams(streams) {}
+
+    bool operator()(size_t lhs, size_t rhs) const {
+        const auto& left = _streams[lhs];
+        const auto& right = _streams[rhs];
+        if (left.empty() || right.empty()) {
+            return !left.empty() || (right.empty() && lhs < rhs);
+        }
+        return left.front() < right.front() || (left.front() == right.front() && lhs < rhs);
+    }
+
+private:
+    const Streams& _streams;
+};
+
+std::vector<int> mergeStreams(Streams streams) {
+    LoserTree<StreamLess> tree{StreamLess(streams)};
+    tree.reset(streams.size());
+
+    std::vector<int> merged;
+    while (tree.size() > 0 && !streams[tree.top()].empty()) {
+        merged.push_back(streams[tree.top()].front());
+        streams[tree.top()].pop_front();
+        tree.replayTop();
+    }
+    return merged;
+}
+
+TEST(LoserTreeTest, NoStreams) {
+    ASSERT(mergeStreams({}).empty());
+}
+
+TEST(LoserTreeTest, SingleStream) {
+    ASSERT(mergeStreams({{1, 2, 2, 5}}) == std::vector<int>({1, 2, 2, 5}));
+}
+
+TEST(LoserTreeTest, EmptyStreamsSortLast) {
+    ASSERT(mergeStreams({{}, {3}, {}, {1, 4}, {}}) == std::vector<int>({1, 3, 4}));
+}
+
+TEST(LoserTreeTest, MergesRandomStreamsInOrder) {
+    PseudoRandom random(42);
+    for (size_t numStreams : {2, 3, 5, 8, 13, 64, 100}) {
+        Streams streams(numStreams);
+        std::vector<int> expected;
+        for (auto&& stream : streams) {
+            const int length = random.nextInt32(50);
+            for (int i = 0; i < length; ++i) {
+                stream.push_back(random.nextInt32(1000));
+            }
+            std::sort(stream.begin(), stream.end());
+            expected.insert(expected.end(), stream.begin(), stream.end());
+        }
+        std::sort(expected.begin(), expected.end());
+
+        ASSERT(mergeStreams(streams) == expected);
+    }
+}
+
+TEST(LoserTreeTest, ResetPicksUpNewHeads) {
+    Streams streams{{5}, {}, {7}};
+    LoserTree<StreamLess> tree{StreamLess(streams)};
+    tree.reset(streams.size());
+    ASSERT_EQ(tree.top(), 0U);
+
+    // A stream other than the winner receives a smaller head, which requires a reset.
+    streams[1].push_back(1);
+    tree.reset(streams.size());
+    ASSERT_EQ(tree.top(), 1U);
+
+    streams[1].pop_front();
+    tree.replayTop();
+    ASSERT_EQ(tree.top(), 0U);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -93,9 +93,7 @@ std::set<ChunkInfo*> getChunksInRange(std::shared_ptr<RoutingTableHistory> rt,
     std::transform(chunksFromSplitIter.first,
                    chunksFromSplitIter.second,
                    std::inserter(chunksFromSplit, chunksFromSplit.begin()),
-                   [](const std::pair<std::string, std::shared_ptr<ChunkInfo>>& pair) {
-                       return pair.second.get();
-                   });
+                   [](const std::shared_ptr<ChunkInfo>& chunkInfo) { return chunkInfo.get(); });
     return chunksFromSplit;
 }
 
@@ -108,7 +106,7 @@ std::shared_ptr<ChunkInfo> getChunkToSplit(std::shared_ptr<RoutingTableHistory>
     invariant(std::distance(chunkToSplitIter.first, chunkToSplitIter.second) <= 1);
     invariant(chunkToSplitIter.first != rt->getChunkMap().end());
 
-    return (*chunkToSplitIter.first).second;
+    return *chunkToSplitIter.first;
 }
 
 /**
@@ -136,8 +134,7 @@ void assertCorrectBytesWritten(std::shared_ptr<RoutingTableHistory> rt,
     auto chunksFromSplit = getChunksInRange(rt, minSplitBoundary, maxSplitBoundary);
     ASSERT_EQ(chunksFromSplit.size(), expectedNumChunksFromSplit);
 
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         if (chunksFromSplit.count(chunkInfo.get()) > 0) {
@@ -170,8 +167,7 @@ public:
 
         ASSERT_EQ(_rt->getChunkMap().size(), 1ull);
         // Should only be one
-        for (auto kv : _rt->getChunkMap()) {
-            auto chunkInfo = kv.second;
+        for (const auto& chunkInfo : _rt->getChunkMap()) {
             auto writesTracker = chunkInfo->getWritesTracker();
             writesTracker->addBytesWritten(_bytesInOriginalChunk);
         }
@@ -234,8 +230,7 @@ TEST_F(RoutingTableHistoryTest, SplittingOnlyChunkCopiesBytesWrittenToAllSubchun
     auto rt = splitChunk(getInitialRoutingTable(), newChunkBoundaryPoints);
 
     ASSERT_EQ(rt->getChunkMap().size(), 3ull);
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         ASSERT_EQ(bytesWritten, getBytesInOriginalChunk());
@@ -318,5 +313,167 @@ TEST_F(RoutingTableHistoryTestThreeInitialChunks,
                               expectedBytesInChunksNotSplit);
 }
 
+TEST_F(RoutingTableHistoryTestThreeInitialChunks, MigrationUpdatesShardVersions) {
+    const ShardId kOtherShard("otherShard");
+    const auto boundaries = getInitialChunkBoundaryPoints();
+    auto version = getInitialRoutingTable()->getVersion();
+
+    // Move the middle chunk away and bump the version of one the donor keeps
+    version.incMajor();
+    ChunkType moved{kNss, ChunkRange{boundaries[1], boundaries[2]}, version, kOtherShard};
+    version.incMinor();
+    ChunkType control{kNss, ChunkRange{boundaries[0], boundaries[1]}, version, kThisShard};
+
+    auto rt = getInitialRoutingTable()->makeUpdated({moved, control});
+    ASSERT_EQ(rt->getNShardsOwningChunks(), 2);
+    ASSERT_EQ(rt->getVersion(kOtherShard), moved.getVersion());
+    ASSERT_EQ(rt->getVersion(kThisShard), control.getVersion());
+
+    // Moving it back leaves the other shard without chunks
+    version.incMajor();
+    ChunkType movedBack{kNss, ChunkRange{boundaries[1], boundaries[2]}, version, kThisShard};
+
+    rt = rt->makeUpdated({movedBack});
+    ASSERT_EQ(rt->getNShardsOwningChunks(), 1);
+    ASSERT_EQ(rt->getVersion(kOtherShard), ChunkVersion(0, 0, version.epoch()));
+    ASSERT_EQ(rt->getVersion(kThisShard), movedBack.getVersion());
+}
+
+TEST_F(RoutingTableHistoryTestThreeInitialChunks, ShardVersionIsRecomputedWhenItsChunkMovesAway) {
+    const ShardId kOtherShard("otherShard");
+    const auto boundaries = getInitialChunkBoundaryPoints();
+    const auto& initialChunkMap = getInitialRoutingTable()->getChunkMap();
+    const auto secondNewestVersion = (*std::next(initialChunkMap.begin()))->getLastmod();
+
+    // The last chunk carries the shard version, and moving it without bumping any of the chunks
+    // left behind makes the shard's version fall back to that of the next newest chunk
+    auto version = getInitialRoutingTable()->getVersion();
+    ASSERT_EQ((*std::prev(initialChunkMap.end()))->getLastmod(), version);
+    version.incMajor();
+    ChunkType moved{kNss, ChunkRange{boundaries[2], boundaries[3]}, version, kOtherShard};
+
+    auto rt = getInitialRoutingTable()->makeUpdated({moved});
+    ASSERT_EQ(rt->getNShardsOwningChunks(), 2);
+    ASSERT_EQ(rt->getVersion(kOtherShard), moved.getVersion());
+    ASSERT_EQ(rt->getVersion(kThisShard), secondNewestVersion);
+}
+
+TEST_F(RoutingTableHistoryTestThreeInitialChunks, InconsistentUpdatedChunksAreDetected) {
+    const auto boundaries = getInitialChunkBoundaryPoints();
+    auto version = getInitialRoutingTable()->getVersion();
+    version.incMajor();
+    ChunkType shrunk{kNss, ChunkRange{boundaries[1], BSON("a" << 15)}, version, kThisShard};
+
+    ASSERT_THROWS_CODE(getInitialRoutingTable()->makeUpdated({shrunk}),
+                       DBException,
+                       ErrorCodes::ConflictingOperationInProgress);
+}
+
+/**
+ * Test fixture for tests that need a routing table large enough to span several segments of the
+ * chunk map, with one chunk for every integer value of 'a' in [0, kNumChunks - 1).
+ */
+class RoutingTableHistoryTestManyChunks : public RoutingTableHistoryTest {
+public:
+    static constexpr int kNumChunks = 3 * ChunkMap::kMaxSegmentSize + 10;
+
+    void setUp() override {
+        RoutingTableHistoryTest::setUp();
+        std::vector<BSONObj> boundaryPoints{getShardKeyPattern().globalMin()};
+        for (int i = 0; i < kNumChunks - 1; ++i) {
+            boundaryPoints.push_back(BSON("a" << i));
+        }
+        boundaryPoints.push_back(getShardKeyPattern().globalMax());
+        _rt = splitChunk(RoutingTableHistoryTest::getInitialRoutingTable(), boundaryPoints);
+        ASSERT_EQ(_rt->getChunkMap().size(), size_t(kNumChunks));
+    }
+
+    const std::shared_ptr<RoutingTableHistory>& getInitialRoutingTable() const {
+        return _rt;
+    }
+
+private:
+    std::shared_ptr<RoutingTableHistory> _rt;
+};
+
+/**
+ * Checks that the chunks of 'rt' are contiguous and that each of them is the one found for its own
+ * min key.
+ */
+void assertChunkMapIsConsistent(const std::shared_ptr<RoutingTableHistory>& rt) {
+    ChunkManager cm(rt, boost::none);
+    boost::optional<BSONObj> lastMax;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
+        if (lastMax) {
+            ASSERT_BSONOBJ_EQ(*lastMax, chunkInfo->getMin());
+        }
+        lastMax = chunkInfo->getMax();
+
+        ASSERT_BSONOBJ_EQ(cm.findIntersectingChunkWithSimpleCollation(chunkInfo->getMin()).getMin(),
+                          chunkInfo->getMin());
+    }
+}
+
+TEST_F(RoutingTableHistoryTestManyChunks, ChunksAreSpreadOverSegments) {
+    const auto& chunkMap = getInitialRoutingTable()->getChunkMap();
+    ASSERT_GT(chunkMap.numSegments(), 1ull);
+    assertChunkMapIsConsistent(getInitialRoutingTable());
+
+    size_t numChunks = 0;
+    for (auto it = chunkMap.end(); it != chunkMap.begin(); --it) {
+        ++numChunks;
+    }
+    ASSERT_EQ(numChunks, chunkMap.size());
+}
+
+TEST_F(RoutingTableHistoryTestManyChunks, SplittingChunkLeavesOtherChunksUntouched) {
+    const auto& oldChunkMap = getInitialRoutingTable()->getChunkMap();
+    const auto minKey = BSON("a" << 1500);
+    const auto maxKey = BSON("a" << 1501);
+
+    auto chunkToSplit = getChunkToSplit(getInitialRoutingTable(), minKey, maxKey);
+    chunkToSplit->getWritesTracker()->addBytesWritten(5ull);
+
+    auto rt = splitChunk(getInitialRoutingTable(), {minKey, BSON("a" << 1500.5), maxKey});
+    const auto& newChunkMap = rt->getChunkMap();
+    ASSERT_EQ(newChunkMap.size(), oldChunkMap.size() + 1);
+    assertChunkMapIsConsistent(rt);
+
+    // Only the chunks around the split have been replaced
+    size_t numShared = 0;
+    auto oldIt = oldChunkMap.begin();
+    for (auto newIt = newChunkMap.begin(); newIt != newChunkMap.end(); ++newIt) {
+        if (*newIt == *oldIt) {
+            ++numShared;
+            ++oldIt;
+        } else if ((*newIt)->getMax().woCompare(maxKey) == 0) {
+            ++oldIt;
+        }
+    }
+    ASSERT_EQ(numShared, oldChunkMap.size() - 1);
+
+    assertCorrectBytesWritten(
+        rt, minKey, maxKey, 2, getBytesInOriginalChunk() + 5ull, getBytesInOriginalChunk());
+}
+
+TEST_F(RoutingTableHistoryTestManyChunks, FindIntersectingChunksMatchesSingleLookups) {
+    ChunkManager cm(getInitialRoutingTable(), boost::none);
+
+    std::vector<BSONObj> shardKeys;
+    for (int i = 0; i < kNumChunks; i += 7) {
+        shardKeys.push_back(BSON("a" << (i * 7919) % kNumChunks - 1));
+    }
+    shardKeys.push_back(BSON("a" << -1000));
+    shardKeys.push_back(BSON("a" << 1000000));
+    shardKeys.push_back(shardKeys.front());
+
+    const auto chunks = cm.findIntersectingChunks(shardKeys, BSONObj());
+    ASSERT_EQ(chunks.size(), shardKeys.size());
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        ASSERT_BSONOBJ_EQ(chunks[i].getMin(),
+                          cm.findIntersectingChunkWithSimpleCollation(shardKeys[i]).getMin());
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -305,6 +305,43 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
 
     const size_t numWriteOps = _clientRequest.sizeWriteOps();
 
+    // Unordered inserts are targeted a slice at a time, so that the targeter can look up a whole
+    // slice in one pass over the routing table. A slice holds at most what fits in a single shard
+    // batch, so a round which stops early because its batches are full has targeted little more
+    // than it sends. Ordered batches stop at the first write which goes to a new shard, so they are
+    // still targeted one write at a time.
+    const bool targetInsertSlices =
+        !ordered && _clientRequest.getBatchType() == BatchedCommandRequest::BatchType_Insert;
+
+    std::vector<boost::optional<StatusWith<ShardEndpoint>>> insertEndpoints;
+    if (targetInsertSlices) {
+        insertEndpoints.resize(numWriteOps);
+    }
+
+    auto targetInsertSlice = [&](size_t first) {
+        std::vector<size_t> sliceWriteOps;
+        std::vector<BSONObj> docs;
+        int sliceSizeBytes = 0;
+        for (size_t i = first; i < numWriteOps && docs.size() < write_ops::kMaxWriteBatchSize &&
+             sliceSizeBytes < BSONObjMaxUserSize;
+             ++i) {
+            if (_writeOps[i].getWriteState() != WriteOpState_Ready) {
+                continue;
+            }
+
+            sliceWriteOps.push_back(i);
+            docs.push_back(_writeOps[i].getWriteItem().getDocument());
+            sliceSizeBytes += docs.back().objsize();
+        }
+
+        auto swEndpoints = targeter.targetInserts(_opCtx, docs);
+        invariant(swEndpoints.size() == docs.size());
+
+        for (size_t j = 0; j < sliceWriteOps.size(); ++j) {
+            insertEndpoints[sliceWriteOps[j]] = std::move(swEndpoints[j]);
+        }
+    };
+
     for (size_t i = 0; i < numWriteOps; ++i) {
         WriteOp& writeOp = _writeOps[i];
 
@@ -320,7 +357,13 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
         OwnedPointerVector<TargetedWrite> writesOwned;
         vector<TargetedWrite*>& writes = writesOwned.mutableVector();
 
-        Status targetStatus = writeOp.targetWrites(_opCtx, targeter, &writes);
+        if (targetInsertSlices && !insertEndpoints[i]) {
+            targetInsertSlice(i);
+        }
+
+        Status targetStatus = targetInsertSlices
+            ? writeOp.targetWrites(_opCtx, std::move(*insertEndpoints[i]), &writes)
+            : writeOp.targetWrites(_opCtx, targeter, &writes);
 
         if (!targetStatus.isOK()) {
             WriteErrorDetail targetError;
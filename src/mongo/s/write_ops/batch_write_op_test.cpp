@@ -518,6 +518,66 @@ TEST_F(BatchWriteOpTest, MultiOpTwoShardsUnordered) {
     ASSERT_EQUALS(clientResponse.getN(), 2);
 }
 
+// Unordered inserts should be targeted with a single call for the whole batch, with the results
+// grouped by shard like those of single document targeting.
+TEST_F(BatchWriteOpTest, MultiOpTwoShardsUnorderedInsertsTargetedAsBatch) {
+    class CountingTargeter : public MockNSTargeter {
+    public:
+        using MockNSTargeter::MockNSTargeter;
+
+        std::vector<StatusWith<ShardEndpoint>> targetInserts(
+            OperationContext* opCtx, const std::vector<BSONObj>& docs) const override {
+            ++numBatchCalls;
+            return MockNSTargeter::targetInserts(opCtx, docs);
+        }
+
+        mutable int numBatchCalls{0};
+    };
+
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA(ShardId("shardA"), ChunkVersion::IGNORED());
+    ShardEndpoint endpointB(ShardId("shardB"), ChunkVersion::IGNORED());
+
+    CountingTargeter targeter(nss,
+                              {MockRange(endpointA, BSON("x" << MINKEY), BSON("x" << 0)),
+                               MockRange(endpointB, BSON("x" << 0), BSON("x" << MAXKEY))});
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase wcb;
+            wcb.setOrdered(false);
+            return wcb;
+        }());
+        insertOp.setDocuments(
+            {BSON("x" << -1), BSON("x" << 1), BSON("x" << -2), BSON("x" << 2), BSON("x" << 3)});
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT_EQUALS(targeter.numBatchCalls, 1);
+    ASSERT_EQUALS(targeted.size(), 2u);
+    verifyTargetedBatches({{endpointA.shardName, 2u}, {endpointB.shardName, 3u}}, targeted);
+
+    BatchedCommandResponse responseA;
+    buildResponse(2, &responseA);
+    batchOp.noteBatchResponse(*targeted[endpointA.shardName], responseA, nullptr);
+
+    BatchedCommandResponse responseB;
+    buildResponse(3, &responseB);
+    batchOp.noteBatchResponse(*targeted[endpointB.shardName], responseB, nullptr);
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 5);
+}
+
 // Multi-op (ordered) targeting test where each op goes to both shards. There should be two sets of
 // two batches to each shard (two for each delete op).
 TEST_F(BatchWriteOpTest, MultiOpTwoShardsEachOrdered) {
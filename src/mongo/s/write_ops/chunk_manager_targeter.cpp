@@ -417,6 +417,60 @@ StatusWith<ShardEndpoint> ChunkManagerTargeter::targetInsert(OperationContext* o
     return Status::OK();
 }
 
+std::vector<StatusWith<ShardEndpoint>> ChunkManagerTargeter::targetInserts(
+    OperationContext* opCtx, const std::vector<BSONObj>& docs) const {
+    if (!_routingInfo->cm()) {
+        return NSTargeter::targetInserts(opCtx, docs);
+    }
+
+    const auto cm = _routingInfo->cm();
+
+    std::vector<BSONObj> shardKeys;
+    shardKeys.reserve(docs.size());
+    for (const auto& doc : docs) {
+        shardKeys.push_back(cm->getShardKeyPattern().extractShardKeyFromDoc(doc));
+        uassert(ErrorCodes::ShardKeyNotFound,
+                "Shard key cannot contain array values or array descendants.",
+                !shardKeys.back().isEmpty());
+    }
+
+    // Looking up a chunk's shard at the transaction's cluster time may also fail
+    std::vector<ShardId> shardIds;
+    shardIds.reserve(docs.size());
+    try {
+        for (const auto& chunk :
+             cm->findIntersectingChunks(shardKeys, CollationSpec::kSimpleSpec)) {
+            shardIds.push_back(chunk.getShardId());
+        }
+    } catch (const DBException&) {
+        // Some document cannot be targeted, so target them one by one to report the error against
+        // the right ones
+        return NSTargeter::targetInserts(opCtx, docs);
+    }
+
+    // A batch normally goes to far fewer shards than it has documents
+    std::map<ShardId, StatusWith<ShardEndpoint>> endpointsByShard;
+
+    std::vector<StatusWith<ShardEndpoint>> endpoints;
+    endpoints.reserve(docs.size());
+    for (const auto& shardId : shardIds) {
+        auto it = endpointsByShard.find(shardId);
+        if (it == endpointsByShard.end()) {
+            auto swEndpoint = [&]() -> StatusWith<ShardEndpoint> {
+                try {
+                    return ShardEndpoint(shardId, cm->getVersion(shardId));
+                } catch (const DBException& ex) {
+                    return ex.toStatus();
+                }
+            }();
+            it = endpointsByShard.emplace(shardId, std::move(swEndpoint)).first;
+        }
+        endpoints.push_back(it->second);
+    }
+
+    return endpoints;
+}
+
 StatusWith<std::vector<ShardEndpoint>> ChunkManagerTargeter::targetUpdate(
     OperationContext* opCtx, const write_ops::UpdateOpEntry& updateDoc) const {
     // If the update is replacement-style:
@@ -82,6 +82,10 @@ public:
     StatusWith<ShardEndpoint> targetInsert(OperationContext* opCtx,
                                            const BSONObj& doc) const override;
 
+    // Looks up the shard keys of all documents in one pass over the routing table.
+    std::vector<StatusWith<ShardEndpoint>> targetInserts(
+        OperationContext* opCtx, const std::vector<BSONObj>& docs) const override;
+
     // Returns ShardKeyNotFound if the update can't be targeted without a shard key.
     StatusWith<std::vector<ShardEndpoint>> targetUpdate(
         OperationContext* opCtx, const write_ops::UpdateOpEntry& updateDoc) const override;
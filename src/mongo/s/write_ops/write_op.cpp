@@ -85,7 +85,26 @@ Status WriteOp::targetWrites(OperationContext* opCtx,
     if (!swEndpoints.isOK())
         return swEndpoints.getStatus();
 
-    auto& endpoints = swEndpoints.getValue();
+    _createChildWrites(opCtx, std::move(swEndpoints.getValue()), targetedWrites);
+    return Status::OK();
+}
+
+Status WriteOp::targetWrites(OperationContext* opCtx,
+                             StatusWith<ShardEndpoint> swEndpoint,
+                             std::vector<TargetedWrite*>* targetedWrites) {
+    invariant(_itemRef.getOpType() == BatchedCommandRequest::BatchType_Insert);
+
+    if (!swEndpoint.isOK())
+        return swEndpoint.getStatus();
+
+    _createChildWrites(opCtx, {std::move(swEndpoint.getValue())}, targetedWrites);
+    return Status::OK();
+}
+
+void WriteOp::_createChildWrites(OperationContext* opCtx,
+                                 std::vector<ShardEndpoint> endpoints,
+                                 std::vector<TargetedWrite*>* targetedWrites) {
+    const bool inTransaction = bool(TransactionRouter::get(opCtx));
 
     for (auto&& endpoint : endpoints) {
         // if the operation was already successfull on that shard, there is no need to repeat the
@@ -110,7 +129,6 @@ Status WriteOp::targetWrites(OperationContext* opCtx,
     }
 
     _state = WriteOpState_Pending;
-    return Status::OK();
 }
 
 size_t WriteOp::getNumTargeted() {
@@ -123,6 +123,14 @@ public:
                         const NSTargeter& targeter,
                         std::vector<TargetedWrite*>* targetedWrites);
 
+    /**
+     * Same as above, but for an insert which has already been targeted as part of a batch, with
+     * 'swEndpoint' as the result.
+     */
+    Status targetWrites(OperationContext* opCtx,
+                        StatusWith<ShardEndpoint> swEndpoint,
+                        std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Returns the number of child writes that were last targeted.
      */
@@ -161,6 +169,13 @@ public:
     void setOpError(const WriteErrorDetail& error);
 
 private:
+    /**
+     * Creates a TargetedWrite for each of 'endpoints' on which the write has not yet succeeded.
+     */
+    void _createChildWrites(OperationContext* opCtx,
+                            std::vector<ShardEndpoint> endpoints,
+                            std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Updates the op state after new information is received.
      */
@@ -616,6 +616,96 @@ TEST_F(ChunkManagerTargeterTest, TargetInsertsWithConstantHashedPrefixAndVarying
     ASSERT_EQUALS(res.getValue().shardName, "1");
 }
 
+TEST_F(ChunkManagerTargeterTest, TargetInsertsBatchMatchesTargetInsertWithHashedShardKey) {
+    // Create 4 chunks and 4 shards such that shardId '0' has chunk [MinKey, -2^62), '1' has chunk
+    // [-2^62, 0), '2' has chunk ['0', 2^62) and '3' has chunk [2^62, MaxKey).
+    std::vector<BSONObj> splitPoints = {
+        BSON("a.b" << -(1LL << 62)), BSON("a.b" << 0LL), BSON("a.b" << (1LL << 62))};
+    auto cmTargeter = prepare(BSON("a.b"
+                                   << "hashed"
+                                   << "c.d" << 1),
+                              splitPoints);
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 1000; i++) {
+        docs.push_back(BSON("a" << BSON("b" << i) << "c" << BSON("d" << 10)));
+    }
+
+    const auto results = cmTargeter.targetInserts(operationContext(), docs);
+    ASSERT_EQUALS(results.size(), docs.size());
+
+    for (size_t i = 0; i < docs.size(); i++) {
+        ASSERT_OK(results[i].getStatus());
+
+        // Verify that the given document is being routed based on hashed value of 'i'.
+        auto chunk = chunkManager->findIntersectingChunkWithSimpleCollation(
+            BSON("a.b" << BSONElementHasher::hash64(docs[i]["a"]["b"],
+                                                    BSONElementHasher::DEFAULT_HASH_SEED)));
+        ASSERT_EQUALS(results[i].getValue().shardName, chunk.getShardId());
+
+        const auto res = cmTargeter.targetInsert(operationContext(), docs[i]);
+        ASSERT_OK(res.getStatus());
+        ASSERT_EQUALS(results[i].getValue().shardName, res.getValue().shardName);
+        ASSERT_EQUALS(results[i].getValue().shardVersion, res.getValue().shardVersion);
+    }
+
+    // Arrays along shard key path are not allowed.
+    docs.push_back(fromjson("{a: [1,2]}"));
+    ASSERT_THROWS_CODE(cmTargeter.targetInserts(operationContext(), docs),
+                       DBException,
+                       ErrorCodes::ShardKeyNotFound);
+}
+
+TEST_F(ChunkManagerTargeterTest, TargetInsertsGivesEachShardItsShardVersion) {
+    // Create 3 chunks and 3 shards such that shardId '0' has chunk [MinKey, 0), '1' has chunk
+    // [0, 100) and '2' has chunk [100, MaxKey).
+    std::vector<BSONObj> splitPoints = {BSON("a" << 0), BSON("a" << 100)};
+    auto cmTargeter = prepare(BSON("a" << 1), splitPoints);
+
+    std::vector<BSONObj> docs;
+    for (int i = -150; i < 150; i++) {
+        docs.push_back(BSON("a" << i));
+    }
+
+    const auto results = cmTargeter.targetInserts(operationContext(), docs);
+    ASSERT_EQUALS(results.size(), docs.size());
+
+    std::set<ShardId> shardIds;
+    for (size_t i = 0; i < docs.size(); i++) {
+        ASSERT_OK(results[i].getStatus());
+
+        const auto& endpoint = results[i].getValue();
+        const int a = docs[i]["a"].numberInt();
+        ASSERT_EQUALS(endpoint.shardName, a < 0 ? "0" : a < 100 ? "1" : "2");
+        ASSERT_EQUALS(endpoint.shardVersion, chunkManager->getVersion(endpoint.shardName));
+        shardIds.insert(endpoint.shardName);
+    }
+    ASSERT_EQUALS(shardIds.size(), 3UL);
+}
+
+TEST_F(ChunkManagerTargeterTest, TargetInsertsTargetsEachDocumentWhenOneCannotBeTargeted) {
+    // Create 2 chunks and 2 shards such that shardId '0' has chunk [MinKey, 0) and '1' has chunk
+    // [0, MaxKey).
+    std::vector<BSONObj> splitPoints = {BSON("a" << 0)};
+    auto cmTargeter = prepare(BSON("a" << 1), splitPoints);
+
+    // No chunk contains the MaxKey shard key, so only that document fails to be targeted.
+    std::vector<BSONObj> docs = {BSON("a" << -5), BSON("a" << MAXKEY), BSON("a" << 5)};
+
+    const auto results = cmTargeter.targetInserts(operationContext(), docs);
+    ASSERT_EQUALS(results.size(), docs.size());
+
+    ASSERT_OK(results[0].getStatus());
+    ASSERT_EQUALS(results[0].getValue().shardName, "0");
+
+    ASSERT_EQUALS(results[1].getStatus(), ErrorCodes::ShardKeyNotFound);
+    ASSERT_EQUALS(results[1].getStatus(),
+                  cmTargeter.targetInsert(operationContext(), docs[1]).getStatus().code());
+
+    ASSERT_OK(results[2].getStatus());
+    ASSERT_EQUALS(results[2].getValue().shardName, "1");
+}
+
 write_ops::UpdateOpEntry buildUpdate(BSONObj query, BSONObj update, bool upsert) {
     write_ops::UpdateOpEntry entry;
     entry.setQ(query);
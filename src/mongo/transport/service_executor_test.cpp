@@ -38,6 +38,7 @@
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
 #include "mongo/util/scopeguard.h"
@@ -167,6 +168,39 @@ protected:
     std::shared_ptr<asio::io_context> asioIOCtx;
 };
 
+struct ThreadPerCoreTestOptions : public ServiceExecutorThreadPerCore::Options {
+    int workerThreads() const final {
+        return 1;
+    }
+
+    Milliseconds pollInterval() const final {
+        return Milliseconds{10};
+    }
+
+    Milliseconds stuckThreadTimeout() const final {
+        return Milliseconds{100};
+    }
+
+    int recursionLimit() const final {
+        return 0;
+    }
+};
+
+class ServiceExecutorThreadPerCoreFixture : public unittest::Test {
+protected:
+    void setUp() override {
+        auto scOwned = ServiceContext::make();
+        setGlobalServiceContext(std::move(scOwned));
+
+        executor = std::make_unique<ServiceExecutorThreadPerCore>(
+            getGlobalServiceContext(),
+            std::make_shared<ASIOReactor>(),
+            std::make_unique<ThreadPerCoreTestOptions>());
+    }
+
+    std::unique_ptr<ServiceExecutorThreadPerCore> executor;
+};
+
 class ServiceExecutorSynchronousFixture : public unittest::Test {
 protected:
     void setUp() override {
@@ -209,6 +243,129 @@ TEST_F(ServiceExecutorAdaptiveFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+TEST_F(ServiceExecutorThreadPerCoreFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, TasksScheduledByTasksAllRun) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    constexpr int kTasks = 1000;
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    int ran = 0;
+
+    // Every task scheduled from inside the first one lands on that worker's local queue.
+    ASSERT_OK(executor->schedule(
+        [&] {
+            for (int i = 0; i < kTasks; ++i) {
+                ASSERT_OK(executor->schedule(
+                    [&] {
+                        stdx::lock_guard<Latch> lk(mutex);
+                        if (++ran == kTasks) {
+                            cond.notify_all();
+                        }
+                    },
+                    ServiceExecutor::kDeferredTask,
+                    ServiceExecutorTaskName::kSSMProcessMessage));
+            }
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMStartSession));
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return ran == kTasks; });
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, BlockedWorkerDoesNotStallOtherTasks) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool blockerRunning = false;
+    bool released = false;
+
+    // Occupy the only pinned worker until the second task has run.
+    ASSERT_OK(executor->schedule(
+        [&] {
+            stdx::unique_lock<Latch> blockerLk(mutex);
+            blockerRunning = true;
+            cond.notify_all();
+            cond.wait(blockerLk, [&] { return released; });
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMProcessMessage));
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return blockerRunning; });
+    lk.unlock();
+
+    ASSERT_OK(executor->schedule(
+        [&] {
+            stdx::lock_guard<Latch> releaseLk(mutex);
+            released = true;
+            cond.notify_all();
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMProcessMessage));
+
+    lk.lock();
+    cond.wait(lk, [&] { return released; });
+    lk.unlock();
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    ASSERT_GTE(bob.obj()["blockingThreadsStarted"].numberLong(), 1);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ChainOfBlockedTasksAllRun) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    constexpr int kTasks = 6;
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool lastRan = false;
+
+    // Each task queues the next one behind itself and then blocks until the last one has run, so
+    // every task but the last needs a thread of its own.
+    std::function<void(int)> runTask = [&](int i) {
+        if (i == kTasks - 1) {
+            stdx::lock_guard<Latch> lk(mutex);
+            lastRan = true;
+            cond.notify_all();
+            return;
+        }
+
+        ASSERT_OK(executor->schedule([&, i] { runTask(i + 1); },
+                                     ServiceExecutor::kDeferredTask,
+                                     ServiceExecutorTaskName::kSSMProcessMessage));
+        stdx::unique_lock<Latch> lk(mutex);
+        cond.wait(lk, [&] { return lastRan; });
+    };
+
+    ASSERT_OK(executor->schedule([&] { runTask(0); },
+                                 ServiceExecutor::kEmptyFlags,
+                                 ServiceExecutorTaskName::kSSMProcessMessage));
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return lastRan; });
+    lk.unlock();
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    ASSERT_GTE(bob.obj()["blockingThreadsStarted"].numberLong(), kTasks - 2);
+}
+
 TEST_F(ServiceExecutorSynchronousFixture, BasicTaskRuns) {
     ASSERT_OK(executor->start());
     auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
@@ -0,0 +1,595 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_thread_per_core.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/logv2/log.h"
+#include "mongo/transport/service_entry_point_utils.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+
+namespace {
+constexpr auto kTotalQueued = "totalQueued"_sd;
+constexpr auto kTotalExecuted = "totalExecuted"_sd;
+constexpr auto kTotalStolen = "totalStolen"_sd;
+constexpr auto kTotalTimeExecutingUs = "totalTimeExecutingMicros"_sd;
+constexpr auto kTotalTimeQueuedUs = "totalTimeQueuedMicros"_sd;
+constexpr auto kThreadsInUse = "threadsInUse"_sd;
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kWorkerThreads = "workerThreads"_sd;
+constexpr auto kBlockingThreadsRunning = "blockingThreadsRunning"_sd;
+constexpr auto kBlockingThreadsStarted = "blockingThreadsStarted"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "threadPerCore"_sd;
+
+int64_t ticksToMicros(TickSource::Tick ticks, TickSource* tickSource) {
+    invariant(tickSource->getTicksPerSecond() >= 1000000);
+    return tickSource->ticksTo<Microseconds>(ticks).count();
+}
+
+struct ServerParameterOptions : public ServiceExecutorThreadPerCore::Options {
+    int workerThreads() const final {
+        int value = threadPerCoreServiceExecutorWorkerThreads.load();
+        if (value == -1) {
+            value = std::max(static_cast<int>(ProcessInfo::getNumAvailableCores()), 1);
+            threadPerCoreServiceExecutorWorkerThreads.store(value);
+            LOGV2(51826,
+                  "No thread count configured for executor. Using number of cores: {value}",
+                  "value"_attr = value);
+        }
+        return value;
+    }
+
+    Milliseconds pollInterval() const final {
+        return Milliseconds{threadPerCoreServiceExecutorPollIntervalMillis.load()};
+    }
+
+    Milliseconds stuckThreadTimeout() const final {
+        return Milliseconds{threadPerCoreServiceExecutorStuckThreadTimeoutMillis.load()};
+    }
+
+    int recursionLimit() const final {
+        return threadPerCoreServiceExecutorRecursionLimit.load();
+    }
+};
+
+/**
+ * Pins the calling thread to the index'th CPU the process is allowed to run on, wrapping around if
+ * there are more workers than CPUs.
+ */
+void pinToCore(size_t index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return;
+    }
+
+    auto target = index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed) || target-- != 0) {
+            continue;
+        }
+
+        cpu_set_t pinned;
+        CPU_ZERO(&pinned);
+        CPU_SET(cpu, &pinned);
+        if (int err = pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned)) {
+            LOGV2_WARNING(51827,
+                          "Unable to pin worker thread to CPU {cpu}: {error}",
+                          "cpu"_attr = cpu,
+                          "error"_attr = errnoWithDescription(err));
+        }
+        return;
+    }
+#endif
+}
+
+}  // namespace
+
+thread_local ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_localWorker =
+    nullptr;
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor)
+    : ServiceExecutorThreadPerCore(
+          ctx, std::move(reactor), std::make_unique<ServerParameterOptions>()) {}
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor,
+                                                           std::unique_ptr<Options> config)
+    : _reactorHandle(reactor), _config(std::move(config)), _tickSource(ctx->getTickSource()) {}
+
+ServiceExecutorThreadPerCore::~ServiceExecutorThreadPerCore() {
+    invariant(!_isRunning.load());
+}
+
+Status ServiceExecutorThreadPerCore::start() {
+    invariant(!_isRunning.load());
+    _isRunning.store(true);
+
+    _numPinnedWorkers = std::max(_config->workerThreads(), 1);
+    for (size_t i = 0; i < _numPinnedWorkers; ++i) {
+        _workers.push_back(std::make_unique<Worker>(this, i, true));
+    }
+
+    for (size_t i = 0; i < _numPinnedWorkers; ++i) {
+        auto status = _launchWorkerThread(_workers[i].get());
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    _controllerThread =
+        stdx::thread(&ServiceExecutorThreadPerCore::_controllerThreadRoutine, this);
+
+    return Status::OK();
+}
+
+Status ServiceExecutorThreadPerCore::shutdown(Milliseconds timeout) {
+    if (!_isRunning.load())
+        return Status::OK();
+
+    LOGV2_DEBUG(51828, 3, "Shutting down thread-per-core executor");
+    _isRunning.store(false);
+
+    {
+        stdx::lock_guard<Latch> lk(_idleMutex);
+        _idleCondition.notify_all();
+    }
+
+    {
+        stdx::lock_guard<Latch> lk(_threadsMutex);
+        _controllerCondition.notify_all();
+    }
+    _controllerThread.join();
+
+    stdx::unique_lock<Latch> lk(_threadsMutex);
+    _reactorHandle->stop();
+    bool result = _deathCondition.wait_for(
+        lk, timeout.toSystemDuration(), [&] { return _threadsRunning == 0; });
+
+    return result
+        ? Status::OK()
+        : Status(ErrorCodes::Error::ExceededTimeLimit,
+                 "thread-per-core executor couldn't shutdown all worker threads within time "
+                 "limit.");
+}
+
+Status ServiceExecutorThreadPerCore::schedule(Task task,
+                                              ScheduleFlags flags,
+                                              ServiceExecutorTaskName taskName) {
+    if (!_isRunning.load()) {
+        return {ErrorCodes::ShutdownInProgress, "Executor is not running"};
+    }
+
+    const auto scheduleTime = _tickSource->getTicks();
+    _totalQueued.addAndFetch(1);
+    Task wrappedTask = [this, task = std::move(task), scheduleTime] {
+        _totalSpentQueued.addAndFetch(_tickSource->getTicks() - scheduleTime);
+        task();
+        _totalExecuted.addAndFetch(1);
+    };
+
+    auto worker = _localWorker;
+    if (worker && worker->executor == this) {
+        // If the task is allowed to recurse and we are not over the depth limit, run it right
+        // away on this worker.
+        if ((flags & kMayRecurse) && (worker->recursionDepth + 1 < _config->recursionLimit())) {
+            _runTask(worker, wrappedTask);
+            return Status::OK();
+        }
+
+        // Work scheduled by a running task stays on this worker, which picks it up as soon as the
+        // current task unwinds.
+        if (worker->recursionDepth > 0) {
+            _enqueue(worker, std::move(wrappedTask));
+            return Status::OK();
+        }
+    }
+
+    // Otherwise hand the task to whichever worker is polling the reactor.
+    _reactorHandle->schedule([this, wrappedTask = std::move(wrappedTask)](Status status) {
+        if (status.isOK()) {
+            _runFromReactor(wrappedTask);
+        }
+    });
+    return Status::OK();
+}
+
+void ServiceExecutorThreadPerCore::appendStats(BSONObjBuilder* bob) const {
+    int threadsRunning;
+    {
+        stdx::lock_guard<Latch> lk(_threadsMutex);
+        threadsRunning = _threadsRunning;
+    }
+
+    *bob << kExecutorLabel << kExecutorName                                              //
+         << kTotalQueued << _totalQueued.load()                                          //
+         << kTotalExecuted << _totalExecuted.load()                                      //
+         << kTotalStolen << _totalStolen.load()                                          //
+         << kThreadsInUse << _threadsInUse.load()                                        //
+         << kTotalTimeExecutingUs                                                        //
+         << ticksToMicros(_totalSpentExecuting.load(), _tickSource)                      //
+         << kTotalTimeQueuedUs << ticksToMicros(_totalSpentQueued.load(), _tickSource)   //
+         << kThreadsRunning << threadsRunning                                            //
+         << kWorkerThreads << static_cast<int>(_numPinnedWorkers)                        //
+         << kBlockingThreadsRunning << _blockingThreadsRunning.load()                    //
+         << kBlockingThreadsStarted << _blockingThreadsStarted.load();
+}
+
+Status ServiceExecutorThreadPerCore::_launchWorkerThread(Worker* worker) {
+    {
+        stdx::lock_guard<Latch> lk(_threadsMutex);
+        ++_threadsRunning;
+    }
+    worker->active.store(true);
+    if (!worker->pinned) {
+        _blockingThreadsRunning.addAndFetch(1);
+        _blockingThreadsStarted.addAndFetch(1);
+    }
+
+    auto status = launchServiceWorkerThread([this, worker] { _workerThreadRoutine(worker); });
+    if (!status.isOK()) {
+        LOGV2_WARNING(
+            51829, "Failed to launch new worker thread: {status}", "status"_attr = status);
+        worker->active.store(false);
+        if (!worker->pinned) {
+            _blockingThreadsRunning.subtractAndFetch(1);
+        }
+
+        stdx::lock_guard<Latch> lk(_threadsMutex);
+        --_threadsRunning;
+        _deathCondition.notify_all();
+    }
+    return status;
+}
+
+void ServiceExecutorThreadPerCore::_workerThreadRoutine(Worker* worker) noexcept {
+    setThreadName(str::stream() << (worker->pinned ? "conn-core" : "conn-blocking") << "-"
+                                << worker->id);
+    if (worker->pinned) {
+        pinToCore(worker->id);
+    }
+
+    _localWorker = worker;
+    ON_BLOCK_EXIT([&] {
+        _localWorker = nullptr;
+        worker->active.store(false);
+        if (!worker->pinned) {
+            _blockingThreadsRunning.subtractAndFetch(1);
+        }
+
+        stdx::lock_guard<Latch> lk(_threadsMutex);
+        --_threadsRunning;
+        _deathCondition.notify_all();
+    });
+
+    auto idleSince = _tickSource->getTicks();
+    while (_isRunning.load()) {
+        const auto wakeGeneration = _wakeGeneration.load();
+
+        Task task;
+        if (_popLocal(worker, &task) || _steal(worker, &task)) {
+            _runTask(worker, task);
+            _drainLocal(worker);
+            idleSince = _tickSource->getTicks();
+            continue;
+        }
+
+        // Blocking threads only exist to keep work moving while the pinned workers are stuck, so
+        // they exit once they've gone a full stuck thread timeout without finding any.
+        if (!worker->pinned &&
+            _tickSource->ticksTo<Milliseconds>(_tickSource->getTicks() - idleSince) >
+                _config->stuckThreadTimeout()) {
+            LOGV2_DEBUG(51830, 1, "Blocking thread {id} is idle, exiting", "id"_attr = worker->id);
+            return;
+        }
+
+        _pollOrWait(worker, wakeGeneration);
+    }
+}
+
+void ServiceExecutorThreadPerCore::_controllerThreadRoutine() {
+    setThreadName("conn-core-controller"_sd);
+
+    stdx::unique_lock<Latch> lk(_threadsMutex);
+    while (_isRunning.load()) {
+        const auto stuckThreadTimeout = _config->stuckThreadTimeout();
+        _controllerCondition.wait_for(
+            lk, stuckThreadTimeout.toSystemDuration(), [&] { return !_isRunning.load(); });
+        if (!_isRunning.load()) {
+            break;
+        }
+
+        // Count the workers that have been running one task for longer than the timeout, and
+        // those of them with tasks queued behind the one they are stuck on.
+        const auto now = _tickSource->getTicks();
+        size_t activeWorkers = 0;
+        size_t stuckWorkers = 0;
+        size_t stuckWorkersWithQueue = 0;
+        auto inspect = [&](Worker* worker) {
+            if (!worker->active.load()) {
+                return;
+            }
+
+            ++activeWorkers;
+            const auto started = worker->taskStarted.load();
+            if (started == 0 ||
+                _tickSource->ticksTo<Milliseconds>(now - started) <= stuckThreadTimeout) {
+                return;
+            }
+
+            ++stuckWorkers;
+            stdx::lock_guard<Latch> workerLk(worker->mutex);
+            if (!worker->queue.empty()) {
+                ++stuckWorkersWithQueue;
+            }
+        };
+        for (auto& worker : _workers) {
+            inspect(worker.get());
+        }
+        for (auto& worker : _blockingWorkers) {
+            inspect(worker.get());
+        }
+
+        // The task a stuck worker is blocked on may only be released by one of the tasks queued
+        // behind it, so each such worker needs another thread to steal its queue. Idle workers
+        // will do so without help. If every worker is stuck, nobody is polling the reactor either.
+        const size_t idleWorkers = std::max(_idleWorkers.load(), 0);
+        size_t threadsToStart =
+            stuckWorkersWithQueue > idleWorkers ? stuckWorkersWithQueue - idleWorkers : 0;
+        if (threadsToStart == 0 && stuckWorkers == activeWorkers) {
+            threadsToStart = 1;
+        }
+
+        if (threadsToStart > 0) {
+            LOGV2_DEBUG(51831,
+                        1,
+                        "{stuckWorkers} of {activeWorkers} worker threads are blocked, starting "
+                        "{threadsToStart} blocking threads",
+                        "stuckWorkers"_attr = stuckWorkers,
+                        "activeWorkers"_attr = activeWorkers,
+                        "threadsToStart"_attr = threadsToStart);
+        }
+
+        for (; threadsToStart > 0 && _isRunning.load(); --threadsToStart) {
+            auto slot = _getBlockingThreadSlot(lk);
+            lk.unlock();
+            auto status = _launchWorkerThread(slot);
+            lk.lock();
+            if (!status.isOK()) {
+                break;
+            }
+        }
+    }
+}
+
+ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_getBlockingThreadSlot(
+    WithLock) {
+    for (auto& worker : _blockingWorkers) {
+        if (!worker->active.load()) {
+            return worker.get();
+        }
+    }
+
+    const auto id = _numPinnedWorkers + _blockingWorkers.size();
+    auto worker = std::make_unique<Worker>(this, id, false);
+    if (_blockingWorkers.empty()) {
+        _firstBlockingWorker.store(worker.get());
+    } else {
+        _blockingWorkers.back()->next.store(worker.get());
+    }
+    _blockingWorkers.push_back(std::move(worker));
+    return _blockingWorkers.back().get();
+}
+
+void ServiceExecutorThreadPerCore::_runTask(Worker* worker, const Task& task) {
+    // A worker can't poll for network events while it runs a task, so make sure an idle worker
+    // takes over polling if nobody else is.
+    if (worker->polling) {
+        worker->polling = false;
+        _pollingWorkers.subtractAndFetch(1);
+    }
+    if (worker->recursionDepth == 0 && _pollingWorkers.load() == 0 && _idleWorkers.load() > 0) {
+        _wakeIdleWorker();
+    }
+
+    if (worker->recursionDepth++ == 0) {
+        worker->taskStarted.store(_tickSource->getTicks());
+        _threadsInUse.addAndFetch(1);
+    }
+    ON_BLOCK_EXIT([&] {
+        if (--worker->recursionDepth == 0) {
+            _totalSpentExecuting.addAndFetch(_tickSource->getTicks() -
+                                             worker->taskStarted.load());
+            worker->taskStarted.store(0);
+            _threadsInUse.subtractAndFetch(1);
+        }
+    });
+
+    task();
+}
+
+void ServiceExecutorThreadPerCore::_runFromReactor(const Task& task) {
+    auto worker = _localWorker;
+    if (!worker || worker->executor != this) {
+        // The transport layer may run the reactor on its own threads as well.
+        task();
+        return;
+    }
+
+    _runTask(worker, task);
+    if (worker->recursionDepth == 0) {
+        _drainLocal(worker);
+    }
+}
+
+void ServiceExecutorThreadPerCore::_drainLocal(Worker* worker) {
+    Task task;
+    while (_popLocal(worker, &task)) {
+        _runTask(worker, task);
+    }
+}
+
+void ServiceExecutorThreadPerCore::_enqueue(Worker* worker, Task task) {
+    size_t queued;
+    {
+        stdx::lock_guard<Latch> lk(worker->mutex);
+        worker->queue.push_back(std::move(task));
+        queued = worker->queue.size();
+    }
+
+    // The first queued task is the worker's own next step. Only a backlog behind it is worth
+    // another worker's attention.
+    if (queued < 2) {
+        return;
+    }
+
+    if (_idleWorkers.load() > 0) {
+        _wakeIdleWorker();
+    } else if (_pollingWorkers.load() > 0 && !_stealRequested.swap(true)) {
+        // Every other worker is either busy or polling the reactor, so ask a polling worker to
+        // come and steal.
+        _reactorHandle->schedule([this](Status status) {
+            _stealRequested.store(false);
+            auto thief = _localWorker;
+            Task stolen;
+            if (status.isOK() && thief && thief->executor == this && _steal(thief, &stolen)) {
+                _runFromReactor(stolen);
+            }
+        });
+    }
+}
+
+bool ServiceExecutorThreadPerCore::_popLocal(Worker* worker, Task* task) {
+    stdx::lock_guard<Latch> lk(worker->mutex);
+    if (worker->queue.empty()) {
+        return false;
+    }
+
+    *task = std::move(worker->queue.front());
+    worker->queue.pop_front();
+    return true;
+}
+
+bool ServiceExecutorThreadPerCore::_steal(Worker* thief, Task* task) {
+    const auto now = _tickSource->getTicks();
+    const auto stuckThreadTimeout = _config->stuckThreadTimeout();
+
+    auto stealFrom = [&](Worker* victim) {
+        if (victim == thief || !victim->active.load()) {
+            return false;
+        }
+
+        stdx::lock_guard<Latch> lk(victim->mutex);
+        if (victim->queue.empty()) {
+            return false;
+        }
+
+        // Leave a worker its next task unless it has been stuck on the current one for a while.
+        const auto started = victim->taskStarted.load();
+        const bool victimStuck = started != 0 &&
+            _tickSource->ticksTo<Milliseconds>(now - started) > stuckThreadTimeout;
+        if (victim->queue.size() < 2 && !victimStuck) {
+            return false;
+        }
+
+        *task = std::move(victim->queue.front());
+        victim->queue.pop_front();
+        _totalStolen.addAndFetch(1);
+        return true;
+    };
+
+    // Start from the pinned worker after the thief so that thieves spread out over their victims.
+    for (size_t i = 1; i <= _workers.size(); ++i) {
+        if (stealFrom(_workers[(thief->id + i) % _workers.size()].get())) {
+            return true;
+        }
+    }
+
+    for (auto victim = _firstBlockingWorker.load(); victim; victim = victim->next.load()) {
+        if (stealFrom(victim)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ServiceExecutorThreadPerCore::_pollOrWait(Worker* worker, uint64_t wakeGeneration) {
+    // One idle worker at a time polls the reactor; the rest sleep until there's something to
+    // steal or the poller hands its role off.
+    if (_pollingWorkers.fetchAndAdd(1) == 0) {
+        worker->polling = true;
+        _reactorHandle->runFor(_config->pollInterval());
+        if (worker->polling) {
+            worker->polling = false;
+            _pollingWorkers.subtractAndFetch(1);
+        }
+        return;
+    }
+    _pollingWorkers.subtractAndFetch(1);
+
+    stdx::unique_lock<Latch> lk(_idleMutex);
+    _idleWorkers.addAndFetch(1);
+    _idleCondition.wait_for(lk, _config->stuckThreadTimeout().toSystemDuration(), [&] {
+        return _wakeGeneration.load() != wakeGeneration || _pollingWorkers.load() == 0 ||
+            !_isRunning.load();
+    });
+    _idleWorkers.subtractAndFetch(1);
+}
+
+void ServiceExecutorThreadPerCore::_wakeIdleWorker() {
+    _wakeGeneration.addAndFetch(1);
+    if (_idleWorkers.load() > 0) {
+        stdx::lock_guard<Latch> lk(_idleMutex);
+        _idleCondition.notify_one();
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
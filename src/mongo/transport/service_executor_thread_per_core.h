@@ -0,0 +1,190 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/tick_source.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A ServiceExecutor that runs a fixed set of worker threads, one per core, each pinned to its core.
+ *
+ * Every worker owns a run queue. A task scheduled while a worker is running a task is queued on
+ * that same worker, so the steps of a client's request stay on one core, and workers with nothing
+ * to do steal queued tasks from busy ones. Idle workers take turns polling the reactor; a worker
+ * that starts running a task from inside the reactor hands polling off to an idle worker.
+ *
+ * A worker that has been running a single task for longer than the stuck thread timeout is
+ * considered blocked. A controller thread starts an unpinned blocking thread for every blocked
+ * worker with tasks queued behind it, and one more if every worker is blocked so that somebody
+ * polls the reactor. Blocking threads steal and poll alongside the pinned workers. There is no cap
+ * on their number: the task a worker is blocked on may only be released by one of the tasks
+ * queued behind it, e.g. a w:majority write waiting on a replication command.
+ */
+class ServiceExecutorThreadPerCore final : public ServiceExecutor {
+public:
+    struct Options {
+        virtual ~Options() = default;
+        // The number of pinned worker threads.
+        virtual int workerThreads() const = 0;
+
+        // How long an idle worker polls the reactor before checking the run queues again.
+        virtual Milliseconds pollInterval() const = 0;
+
+        // How long a worker may run a single task before it is considered blocked.
+        virtual Milliseconds stuckThreadTimeout() const = 0;
+
+        // The maximum allowable depth of recursion for tasks scheduled with the MayRecurse flag
+        // before stack unwinding is forced.
+        virtual int recursionLimit() const = 0;
+    };
+
+    explicit ServiceExecutorThreadPerCore(ServiceContext* ctx, ReactorHandle reactor);
+    explicit ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                          ReactorHandle reactor,
+                                          std::unique_ptr<Options> config);
+
+    ~ServiceExecutorThreadPerCore();
+
+    Status start() final;
+    Status shutdown(Milliseconds timeout) final;
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) final;
+
+    Mode transportMode() const final {
+        return Mode::kAsynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const final;
+
+private:
+    struct Worker {
+        Worker(ServiceExecutorThreadPerCore* executor, size_t id, bool pinned)
+            : executor(executor), id(id), pinned(pinned) {}
+
+        ServiceExecutorThreadPerCore* const executor;
+        const size_t id;
+        const bool pinned;
+
+        // Blocking thread slots are only active while a thread is running in them.
+        AtomicWord<bool> active{false};
+
+        // The next blocking thread slot, so that workers can walk the slots without locks.
+        AtomicWord<Worker*> next{nullptr};
+
+        Mutex mutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::Worker::mutex");
+        std::deque<Task> queue;
+
+        // The tick at which the outermost task currently running on this worker started, or zero
+        // if the worker isn't running a task.
+        AtomicWord<TickSource::Tick> taskStarted{0};
+
+        // Only accessed by the thread running this worker.
+        int recursionDepth = 0;
+        bool polling = false;
+    };
+
+    Status _launchWorkerThread(Worker* worker);
+    void _workerThreadRoutine(Worker* worker) noexcept;
+    void _controllerThreadRoutine();
+    Worker* _getBlockingThreadSlot(WithLock);
+
+    void _runTask(Worker* worker, const Task& task);
+    void _runFromReactor(const Task& task);
+    void _drainLocal(Worker* worker);
+    void _enqueue(Worker* worker, Task task);
+    bool _popLocal(Worker* worker, Task* task);
+    bool _steal(Worker* thief, Task* task);
+    void _pollOrWait(Worker* worker, uint64_t wakeGeneration);
+    void _wakeIdleWorker();
+
+    static thread_local Worker* _localWorker;
+
+    ReactorHandle _reactorHandle;
+    std::unique_ptr<Options> _config;
+    TickSource* const _tickSource;
+
+    // The pinned workers. The vector is sized in start() and never resized afterwards, so workers
+    // can steal from it without locks.
+    std::vector<std::unique_ptr<Worker>> _workers;
+    size_t _numPinnedWorkers = 0;
+
+    // The slots for blocking threads are created on demand and reused once their thread exits.
+    // They are owned by _blockingWorkers, which is guarded by _threadsMutex, and linked together
+    // from _firstBlockingWorker for lock-free stealing.
+    std::vector<std::unique_ptr<Worker>> _blockingWorkers;
+    AtomicWord<Worker*> _firstBlockingWorker{nullptr};
+
+    AtomicWord<bool> _isRunning{false};
+
+    mutable Mutex _threadsMutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::_threadsMutex");
+    stdx::condition_variable _deathCondition;
+    stdx::condition_variable _controllerCondition;
+    stdx::thread _controllerThread;
+    int _threadsRunning = 0;
+
+    mutable Mutex _idleMutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::_idleMutex");
+    stdx::condition_variable _idleCondition;
+    AtomicWord<int> _idleWorkers{0};
+
+    AtomicWord<int> _pollingWorkers{0};
+    AtomicWord<int> _blockingThreadsRunning{0};
+    AtomicWord<bool> _stealRequested{false};
+
+    // Bumped whenever there is new work an idle worker could pick up, so that a worker going idle
+    // can't miss the notification.
+    AtomicWord<uint64_t> _wakeGeneration{0};
+
+    // These counters are only used for reporting in serverStatus.
+    AtomicWord<int> _threadsInUse{0};
+    AtomicWord<int64_t> _totalQueued{0};
+    AtomicWord<int64_t> _totalExecuted{0};
+    AtomicWord<int64_t> _totalStolen{0};
+    AtomicWord<int64_t> _blockingThreadsStarted{0};
+    AtomicWord<TickSource::Tick> _totalSpentQueued{0};
+    AtomicWord<TickSource::Tick> _totalSpentExecuting{0};
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,1267 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <linux/io_uring.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <set>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <utility>
+
+#include "mongo/db/stats/counters.h"
+#include "mongo/logv2/log.h"
+#include "mongo/rpc/message.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/session.h"
+#include "mongo/transport/transport_options_gen.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/functional.h"
+#include "mongo/util/intrusive_counter.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+// Older C libraries don't define the syscall numbers even when the kernel headers have the ring
+// layout. The numbers are the same on every architecture we build for.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+namespace mongo {
+namespace transport {
+namespace {
+
+// Reserved user_data values. Every other user_data is the address of an IoUringOperation, which is
+// always at least 8-byte aligned.
+constexpr uint64_t kIgnoredCompletion = 0;
+constexpr uint64_t kWakeupCompletion = 1;
+
+Status ioUringErrorToStatus(int err) {
+    switch (err) {
+        case ECANCELED:
+            return {ErrorCodes::CallbackCanceled, "Callback was canceled"};
+        case EAGAIN:
+        case ETIME:
+            return {ErrorCodes::NetworkTimeout, "Socket operation timed out"};
+        case ECONNRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by peer"};
+        case ENETRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by network"};
+        default:
+            return {ErrorCodes::SocketException, errnoWithDescription(err)};
+    }
+}
+
+__kernel_timespec toKernelTimespec(Milliseconds duration) {
+    __kernel_timespec ts{};
+    if (duration > Milliseconds(0)) {
+        ts.tv_sec = durationCount<Seconds>(duration);
+        ts.tv_nsec = durationCount<Nanoseconds>(duration - Seconds(ts.tv_sec));
+    }
+    return ts;
+}
+
+/**
+ * A single submission whose completion is still outstanding. The ring holds a reference from the
+ * time the submission is prepared until its completion has been dispatched, so the address stays
+ * valid for io_uring_enter() and for any cancellation that targets it.
+ */
+class IoUringOperation : public RefCountable {
+public:
+    explicit IoUringOperation(unique_function<void(int)> onComplete)
+        : _onComplete(std::move(onComplete)) {}
+
+    void complete(int result) {
+        auto onComplete = std::move(_onComplete);
+        onComplete(result);
+    }
+
+    uint64_t userData() const {
+        return reinterpret_cast<uintptr_t>(this);
+    }
+
+    // Storage for timeouts, which the kernel reads when the submission is consumed.
+    __kernel_timespec timeout{};
+
+private:
+    unique_function<void(int)> _onComplete;
+};
+
+using IoUringOperationHandle = boost::intrusive_ptr<IoUringOperation>;
+
+void prepareSqe(io_uring_sqe* sqe, uint8_t opcode, int fd, const void* addr, uint32_t len) {
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(addr);
+    sqe->len = len;
+}
+
+void prepareSqe(io_uring_sqe* sqe,
+                uint8_t opcode,
+                int fd,
+                const void* addr,
+                uint32_t len,
+                const IoUringOperationHandle& op) {
+    prepareSqe(sqe, opcode, fd, addr, len);
+    intrusive_ptr_add_ref(op.get());
+    sqe->user_data = op->userData();
+}
+
+/**
+ * A minimal io_uring wrapper over the raw system calls. Submission queue entries may be prepared
+ * from any thread; completions are reaped by one thread at a time, which the owning reactor
+ * guarantees.
+ */
+class IoUring {
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params params{};
+        // Size the completion queue well beyond the submission queue so a burst of completions
+        // from many idle connections becoming readable at once doesn't overflow it.
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = entries * 4;
+
+        _fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (_fd < 0) {
+            const auto ewd = errnoWithDescription();
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "Unable to create an io_uring: " << ewd);
+        }
+        auto closeGuard = makeGuard([&] { ::close(_fd); });
+
+        _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+        }
+
+        _sqRing = _map(_sqRingSize, IORING_OFF_SQ_RING);
+        _cqRing = (params.features & IORING_FEAT_SINGLE_MMAP)
+            ? _sqRing
+            : _map(_cqRingSize, IORING_OFF_CQ_RING);
+        _sqes = static_cast<io_uring_sqe*>(
+            _map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+        _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+        auto sqRing = static_cast<char*>(_sqRing);
+        _sqHead = reinterpret_cast<unsigned*>(sqRing + params.sq_off.head);
+        _sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+        _sqMask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+        _sqEntries = params.sq_entries;
+
+        // Submission queue entries are always consumed in order, so the indirection array is the
+        // identity mapping for the lifetime of the ring.
+        auto sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+        for (unsigned i = 0; i < _sqEntries; ++i) {
+            sqArray[i] = i;
+        }
+
+        auto cqRing = static_cast<char*>(_cqRing);
+        _cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+        _cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+        _cqMask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+        _cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+        closeGuard.dismiss();
+    }
+
+    ~IoUring() {
+        ::munmap(_sqes, _sqesSize);
+        if (_cqRing != _sqRing) {
+            ::munmap(_cqRing, _cqRingSize);
+        }
+        ::munmap(_sqRing, _sqRingSize);
+        ::close(_fd);
+    }
+
+    /**
+     * Reserves N consecutive submission queue entries, zeroes them and passes them to 'prepare'.
+     * The entries become visible to the kernel on the next submit().
+     */
+    template <size_t N, typename Prepare>
+    void prepare(Prepare&& prepare) {
+        stdx::lock_guard<Latch> lk(_sqMutex);
+        while (_sqEntries - (_localSqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE)) < N) {
+            _submit(lk);
+        }
+
+        std::array<io_uring_sqe*, N> sqes;
+        for (size_t i = 0; i < N; ++i) {
+            sqes[i] = &_sqes[(_localSqTail + i) & _sqMask];
+            memset(sqes[i], 0, sizeof(io_uring_sqe));
+        }
+        prepare(sqes);
+
+        _localSqTail += N;
+        __atomic_store_n(_sqTail, _localSqTail, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Hands every prepared submission queue entry to the kernel. Returns false if some entries are
+     * left in the queue because the kernel could not accept them yet.
+     */
+    bool submit() {
+        stdx::lock_guard<Latch> lk(_sqMutex);
+        return _submit(lk);
+    }
+
+    /**
+     * Asks the kernel which operations it supports, and returns an error naming the first of
+     * 'opcodes' that it doesn't. Kernels too old to answer are refused as well.
+     */
+    Status probe(std::initializer_list<std::pair<uint8_t, StringData>> opcodes) const {
+        // The kernel requires the probe to be zeroed, and fills in one entry per opcode it knows.
+        constexpr unsigned kMaxOps = 256;
+        std::vector<char> buf(sizeof(io_uring_probe) + kMaxOps * sizeof(io_uring_probe_op));
+        auto probe = reinterpret_cast<io_uring_probe*>(buf.data());
+        if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+            const auto ewd = errnoWithDescription();
+            return {ErrorCodes::InvalidOptions,
+                    str::stream() << "Unable to probe the io_uring operations supported by the "
+                                     "kernel, the io_uring transport layer requires Linux 5.6 or "
+                                     "later: "
+                                  << ewd};
+        }
+
+        for (auto&& [opcode, name] : opcodes) {
+            if (opcode >= probe->ops_len || !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+                return {ErrorCodes::InvalidOptions,
+                        str::stream() << "The kernel does not support the io_uring operation "
+                                      << name << ", which the io_uring transport layer requires"};
+            }
+        }
+        return Status::OK();
+    }
+
+    /**
+     * Blocks until at least one completion is available or the call is interrupted.
+     */
+    void waitForCompletion() {
+        syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    }
+
+    /**
+     * Moves every available completion into 'out'. Must only be called by the reaping thread.
+     */
+    void reap(std::vector<io_uring_cqe>* out) {
+        auto head = *_cqHead;
+        const auto tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            out->push_back(_cqes[head & _cqMask]);
+        }
+        __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* _map(size_t size, off_t offset) {
+        auto addr = ::mmap(
+            nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+        if (addr == MAP_FAILED) {
+            const auto ewd = errnoWithDescription();
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "Unable to map io_uring queues: " << ewd);
+        }
+        return addr;
+    }
+
+    bool _submit(WithLock) {
+        const auto pending = _localSqTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+        if (pending == 0) {
+            return true;
+        }
+
+        const auto submitted = syscall(__NR_io_uring_enter, _fd, pending, 0, 0, nullptr, 0);
+        if (submitted < 0) {
+            // EINTR, EAGAIN and EBUSY leave the entries in the queue; they're picked up by the
+            // next submission or by the reactor before it waits.
+            const auto error = errno;
+            if (error == EINTR || error == EAGAIN || error == EBUSY) {
+                return false;
+            }
+            LOGV2_FATAL(51834,
+                        "Unable to submit to io_uring: {error}",
+                        "error"_attr = errnoWithDescription(error));
+            fassertFailed(51835);
+        }
+        return static_cast<unsigned>(submitted) == pending;
+    }
+
+    int _fd = -1;
+
+    Mutex _sqMutex = MONGO_MAKE_LATCH("IoUring::_sqMutex");
+    unsigned _localSqTail = 0;
+
+    void* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+
+    void* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+};
+
+}  // namespace
+
+/**
+ * A Reactor whose event loop waits on an io_uring. Any number of threads may run the reactor at
+ * once: one of them reaps completions while the others run scheduled tasks or wait for it, and
+ * completion callbacks run outside of the reaping critical section.
+ */
+class TransportLayerIoUring::IoUringReactor final : public Reactor {
+public:
+    IoUringReactor() : _ring(gIoUringQueueDepth) {
+        _eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (_eventFd < 0) {
+            const auto ewd = errnoWithDescription();
+            uasserted(ErrorCodes::InternalError,
+                      str::stream() << "Unable to create io_uring reactor eventfd: " << ewd);
+        }
+        _armWakeup();
+        _ring.submit();
+    }
+
+    ~IoUringReactor() {
+        ::close(_eventFd);
+    }
+
+    /**
+     * Checks that the kernel supports every operation the reactor, its timers and the sessions
+     * submit.
+     */
+    Status checkKernelSupport() const {
+        return _ring.probe({{IORING_OP_READ, "READ"_sd},
+                            {IORING_OP_TIMEOUT, "TIMEOUT"_sd},
+                            {IORING_OP_TIMEOUT_REMOVE, "TIMEOUT_REMOVE"_sd},
+                            {IORING_OP_ASYNC_CANCEL, "ASYNC_CANCEL"_sd},
+                            {IORING_OP_LINK_TIMEOUT, "LINK_TIMEOUT"_sd},
+                            {IORING_OP_ACCEPT, "ACCEPT"_sd},
+                            {IORING_OP_SEND, "SEND"_sd},
+                            {IORING_OP_RECV, "RECV"_sd}});
+    }
+
+    void run() noexcept override {
+        ThreadIdGuard threadIdGuard(this);
+        while (!_stopped.load()) {
+            _runOnce(Date_t::max());
+        }
+    }
+
+    void runFor(Milliseconds time) noexcept override {
+        ThreadIdGuard threadIdGuard(this);
+        const auto deadline = now() + time;
+        while (!_stopped.load() && now() < deadline) {
+            _runOnce(deadline);
+        }
+    }
+
+    void stop() override {
+        _stopped.store(true);
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _cv.notify_all();
+        }
+        _wakeup();
+    }
+
+    void drain() override {
+        ThreadIdGuard threadIdGuard(this);
+        _stopped.store(false);
+        while (_runOnce(Date_t::min())) {
+            LOGV2_DEBUG(51810, 2, "Draining remaining work in reactor.");
+        }
+        _stopped.store(true);
+    }
+
+    std::unique_ptr<ReactorTimer> makeTimer() override;
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+    void schedule(Task task) override {
+        bool needsWakeup;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _tasks.push_back(std::move(task));
+            needsWakeup = _reaping;
+            _cv.notify_one();
+        }
+
+        if (needsWakeup) {
+            _wakeup();
+        }
+    }
+
+    void dispatch(Task task) override {
+        if (onReactorThread()) {
+            task(Status::OK());
+            return;
+        }
+        schedule(std::move(task));
+    }
+
+    bool onReactorThread() const override {
+        return this == _reactorForThread;
+    }
+
+    /**
+     * Prepares N submission queue entries and submits them, unless this thread is dispatching a
+     * batch of completions for this reactor, in which case the submission is deferred to the end
+     * of the batch so that all of the follow-up I/O is handed to the kernel at once.
+     */
+    template <size_t N, typename Prepare>
+    void startOperation(Prepare&& prepare) {
+        _ring.prepare<N>(std::forward<Prepare>(prepare));
+        if (_batchingReactorForThread != this) {
+            _ring.submit();
+        }
+    }
+
+private:
+    class ThreadIdGuard {
+    public:
+        ThreadIdGuard(IoUringReactor* reactor) {
+            invariant(!_reactorForThread);
+            _reactorForThread = reactor;
+        }
+
+        ~ThreadIdGuard() {
+            invariant(_reactorForThread);
+            _reactorForThread = nullptr;
+        }
+    };
+
+    /**
+     * Runs one scheduled task or reaps and dispatches one batch of completions, waiting no longer
+     * than 'deadline' for either. Returns whether any work was done.
+     */
+    bool _runOnce(Date_t deadline) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (!_tasks.empty()) {
+            auto task = std::move(_tasks.front());
+            _tasks.pop_front();
+            lk.unlock();
+
+            task(Status::OK());
+            return true;
+        }
+
+        const bool block = deadline > now();
+        if (_reaping) {
+            // Another thread owns the completion queue. Wait for it to finish so that this thread
+            // can either pick up a task or take over reaping.
+            auto ready = [&] { return !_tasks.empty() || !_reaping || _stopped.load(); };
+            if (deadline == Date_t::max()) {
+                _cv.wait(lk, ready);
+            } else if (block) {
+                _cv.wait_until(lk, deadline.toSystemTimePoint(), ready);
+            }
+            return false;
+        }
+
+        _reaping = true;
+        lk.unlock();
+
+        std::vector<io_uring_cqe> completions;
+        _ring.submit();
+        _ring.reap(&completions);
+        if (completions.empty() && block && !_stopped.load()) {
+            bool canWait = true;
+            if (deadline != Date_t::max()) {
+                // A timeout with a completion count of one fires at the deadline or as soon as
+                // any other completion is posted, whichever comes first. The kernel reads the
+                // timespec whenever it consumes the entry, so it lives in the operation, which the
+                // ring keeps alive until the timeout completes.
+                auto timeoutOp = make_intrusive<IoUringOperation>([](int) {});
+                timeoutOp->timeout = toKernelTimespec(deadline - now());
+                _ring.prepare<1>([&](auto& sqes) {
+                    prepareSqe(sqes[0], IORING_OP_TIMEOUT, -1, &timeoutOp->timeout, 1, timeoutOp);
+                    sqes[0]->off = 1;
+                });
+
+                // Until the kernel has the timeout, waiting could outlast the deadline.
+                canWait = _ring.submit();
+            }
+            if (canWait) {
+                _ring.waitForCompletion();
+            }
+            _ring.reap(&completions);
+        }
+
+        lk.lock();
+        _reaping = false;
+        _cv.notify_all();
+        lk.unlock();
+
+        bool didWork = false;
+        {
+            _batchingReactorForThread = this;
+            ON_BLOCK_EXIT([&] { _batchingReactorForThread = nullptr; });
+
+            for (const auto& cqe : completions) {
+                if (cqe.user_data == kIgnoredCompletion) {
+                    continue;
+                }
+                if (cqe.user_data == kWakeupCompletion) {
+                    _armWakeup();
+                    continue;
+                }
+
+                IoUringOperationHandle op(reinterpret_cast<IoUringOperation*>(cqe.user_data),
+                                          false /* adopt the ring's reference */);
+                op->complete(cqe.res);
+                didWork = true;
+            }
+        }
+        _ring.submit();
+
+        return didWork;
+    }
+
+    void _armWakeup() {
+        _ring.prepare<1>([&](auto& sqes) {
+            prepareSqe(sqes[0], IORING_OP_READ, _eventFd, &_wakeupBuffer, sizeof(_wakeupBuffer));
+            sqes[0]->user_data = kWakeupCompletion;
+        });
+    }
+
+    void _wakeup() {
+        uint64_t one = 1;
+        // A failed write means the counter is already non-zero, so the reactor will wake anyway.
+        MONGO_COMPILER_VARIABLE_UNUSED auto written = ::write(_eventFd, &one, sizeof(one));
+    }
+
+    static thread_local IoUringReactor* _reactorForThread;
+    static thread_local IoUringReactor* _batchingReactorForThread;
+
+    IoUring _ring;
+
+    int _eventFd = -1;
+    uint64_t _wakeupBuffer = 0;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("IoUringReactor::_mutex");
+    stdx::condition_variable _cv;
+    std::deque<Task> _tasks;
+    bool _reaping = false;
+
+    AtomicWord<bool> _stopped{false};
+};
+
+thread_local TransportLayerIoUring::IoUringReactor*
+    TransportLayerIoUring::IoUringReactor::_reactorForThread = nullptr;
+thread_local TransportLayerIoUring::IoUringReactor*
+    TransportLayerIoUring::IoUringReactor::_batchingReactorForThread = nullptr;
+
+class TransportLayerIoUring::IoUringReactorTimer final : public ReactorTimer {
+public:
+    explicit IoUringReactorTimer(IoUringReactor* reactor) : _reactor(reactor) {}
+
+    ~IoUringReactorTimer() {
+        // Make sure the promise of an outstanding wait gets filled.
+        cancel();
+    }
+
+    void cancel(const BatonHandle& baton = nullptr) override {
+        auto op = [&] {
+            stdx::lock_guard<Latch> lk(_mutex);
+            return std::exchange(_op, {});
+        }();
+        if (!op) {
+            return;
+        }
+
+        // Removing a timeout that already fired fails with ENOENT, which is harmless. The
+        // reference held here keeps the address from being reused until then.
+        _reactor->startOperation<1>([&](auto& sqes) {
+            prepareSqe(sqes[0], IORING_OP_TIMEOUT_REMOVE, -1, nullptr, 0);
+            sqes[0]->addr = op->userData();
+            sqes[0]->user_data = kIgnoredCompletion;
+        });
+    }
+
+    Future<void> waitUntil(Date_t deadline, const BatonHandle& baton = nullptr) override {
+        cancel(baton);
+
+        auto pf = makePromiseFuture<void>();
+        auto op = make_intrusive<IoUringOperation>([p = std::move(pf.promise)](int res) mutable {
+            // A timeout that expires completes with ETIME rather than success.
+            if (res == -ETIME || res >= 0) {
+                p.emplaceValue();
+            } else {
+                p.setError(ioUringErrorToStatus(-res));
+            }
+        });
+        op->timeout = toKernelTimespec(deadline - _reactor->now());
+
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _op = op;
+        }
+        _reactor->startOperation<1>([&](auto& sqes) {
+            prepareSqe(sqes[0], IORING_OP_TIMEOUT, -1, &op->timeout, 1, op);
+        });
+
+        return std::move(pf.future);
+    }
+
+private:
+    IoUringReactor* const _reactor;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("IoUringReactorTimer::_mutex");
+    IoUringOperationHandle _op;
+};
+
+std::unique_ptr<ReactorTimer> TransportLayerIoUring::IoUringReactor::makeTimer() {
+    return std::make_unique<IoUringReactorTimer>(this);
+}
+
+class TransportLayerIoUring::IoUringSession final : public Session {
+public:
+    IoUringSession(TransportLayerIoUring* tl,
+                   std::shared_ptr<IoUringReactor> reactor,
+                   int fd,
+                   SockAddr remoteAddr)
+        : _tl(tl), _reactor(std::move(reactor)), _fd(fd), _remoteAddr(std::move(remoteAddr)) {
+        auto closeGuard = makeGuard([&] { ::close(_fd); });
+
+        sockaddr_storage local;
+        socklen_t localLen = sizeof(local);
+        if (::getsockname(_fd, reinterpret_cast<sockaddr*>(&local), &localLen) != 0) {
+            const auto ewd = errnoWithDescription();
+            uasserted(ErrorCodes::SocketException,
+                      str::stream() << "Unable to get local address of new connection: " << ewd);
+        }
+        _localAddr = SockAddr(reinterpret_cast<sockaddr*>(&local), localLen);
+
+        if (_remoteAddr.getType() == AF_INET || _remoteAddr.getType() == AF_INET6) {
+            int on = 1;
+            ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            ::setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+            setSocketKeepAliveParams(_fd);
+        }
+
+        _remote = HostAndPort(_remoteAddr.toString(true));
+        _local = HostAndPort(_localAddr.toString(true));
+        closeGuard.dismiss();
+    }
+
+    ~IoUringSession() {
+        end();
+        ::close(_fd);
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    void end() override {
+        if (!_ended.swap(true)) {
+            // Shutting the socket down completes any outstanding receive with end-of-file, which
+            // closing the descriptor would not while the ring still holds a reference to it.
+            ::shutdown(_fd, SHUT_RDWR);
+        }
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        return _sourceMessageImpl().getNoThrow();
+    }
+
+    Future<Message> asyncSourceMessage(const BatonHandle& baton = nullptr) override {
+        return _sourceMessageImpl();
+    }
+
+    Status sinkMessage(Message message) override {
+        return asyncSinkMessage(std::move(message)).getNoThrow();
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
+        auto buf = message.buf();
+        auto size = message.size();
+        return _write(buf, size).then([message /*keep the buffer alive*/] {
+            networkCounter.hitPhysicalOut(message.size());
+        });
+    }
+
+    void cancelAsyncOperations(const BatonHandle& baton = nullptr) override {
+        LOGV2_DEBUG(51811,
+                    3,
+                    "Cancelling outstanding I/O operations on connection to {remote}",
+                    "remote"_attr = _remote);
+
+        std::vector<IoUringOperationHandle> ops;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _canceled = true;
+            for (auto& op : _inflight) {
+                if (op) {
+                    ops.push_back(op);
+                }
+            }
+        }
+
+        for (auto& op : ops) {
+            _reactor->startOperation<1>([&](auto& sqes) {
+                prepareSqe(sqes[0], IORING_OP_ASYNC_CANCEL, -1, nullptr, 0);
+                sqes[0]->addr = op->userData();
+                sqes[0]->user_data = kIgnoredCompletion;
+            });
+        }
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        invariant(!timeout || timeout->count() > 0);
+        stdx::lock_guard<Latch> lk(_mutex);
+        _configuredTimeout = timeout;
+    }
+
+    bool isConnected() override {
+        if (_ended.load()) {
+            return false;
+        }
+
+        pollfd pfd{_fd, POLLIN, 0};
+        const auto ret = ::poll(&pfd, 1, 0);
+        if (ret == 0) {
+            return true;
+        } else if (ret < 0 || (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+            return false;
+        }
+
+        // The socket is readable; it's only still connected if that isn't an end-of-file.
+        char testByte;
+        return ::recv(_fd, &testByte, sizeof(testByte), MSG_PEEK | MSG_DONTWAIT) > 0;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    const SockAddr& remoteAddr() const override {
+        return _remoteAddr;
+    }
+
+    const SockAddr& localAddr() const override {
+        return _localAddr;
+    }
+
+private:
+    enum Direction { kRead = 0, kWrite = 1 };
+
+    Future<Message> _sourceMessageImpl() {
+        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+        auto headerBuffer = SharedBuffer::allocate(kHeaderSize);
+        auto ptr = headerBuffer.get();
+        return _read(ptr, kHeaderSize)
+            .then([headerBuffer = std::move(headerBuffer), this]() mutable {
+                const auto msgLen = size_t(MSGHEADER::View(headerBuffer.get()).getMessageLength());
+                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                    StringBuilder sb;
+                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                    const auto str = sb.str();
+                    LOGV2(51812, "{str}", "str"_attr = str);
+
+                    return Future<Message>::makeReady(Status(ErrorCodes::ProtocolError, str));
+                }
+
+                if (msgLen == kHeaderSize) {
+                    networkCounter.hitPhysicalIn(msgLen);
+                    return Future<Message>::makeReady(Message(std::move(headerBuffer)));
+                }
+
+                auto buffer = SharedBuffer::allocate(msgLen);
+                memcpy(buffer.get(), headerBuffer.get(), kHeaderSize);
+
+                MsgData::View msgView(buffer.get());
+                return _read(msgView.data(), msgView.dataLen())
+                    .then([buffer = std::move(buffer), msgLen]() mutable {
+                        networkCounter.hitPhysicalIn(msgLen);
+                        return Message(std::move(buffer));
+                    });
+            });
+    }
+
+    Future<void> _read(char* data, size_t size) {
+        return _submit(kRead, IORING_OP_RECV, data, size)
+            .then([this, self = shared_from_this(), data, size](int bytes) {
+                if (bytes == 0) {
+                    return Future<void>::makeReady(
+                        Status(ErrorCodes::HostUnreachable, "Connection closed by peer"));
+                }
+                if (size_t(bytes) < size) {
+                    return _read(data + bytes, size - bytes);
+                }
+                return Future<void>::makeReady();
+            });
+    }
+
+    Future<void> _write(const char* data, size_t size) {
+        return _submit(kWrite, IORING_OP_SEND, data, size)
+            .then([this, self = shared_from_this(), data, size](int bytes) {
+                if (size_t(bytes) < size) {
+                    return _write(data + bytes, size - bytes);
+                }
+                return Future<void>::makeReady();
+            });
+    }
+
+    /**
+     * Submits a single receive or send and returns the number of bytes transferred. If a timeout
+     * is configured, the operation is linked to a timeout so that the kernel cancels it when the
+     * timeout expires.
+     */
+    Future<int> _submit(Direction direction, uint8_t opcode, const char* data, size_t size) {
+        auto pf = makePromiseFuture<int>();
+        auto op = make_intrusive<IoUringOperation>(
+            [this, self = shared_from_this(), direction, p = std::move(pf.promise)](
+                int res) mutable {
+                bool timedOut;
+                {
+                    stdx::lock_guard<Latch> lk(_mutex);
+                    _inflight[direction].reset();
+                    timedOut = _configuredTimeout && !_canceled;
+                }
+
+                if (res >= 0) {
+                    p.emplaceValue(res);
+                } else if (res == -ECANCELED && timedOut) {
+                    p.setError({ErrorCodes::NetworkTimeout, "Socket operation timed out"});
+                } else {
+                    p.setError(ioUringErrorToStatus(-res));
+                }
+            });
+
+        boost::optional<Milliseconds> timeout;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _canceled = false;
+            _inflight[direction] = op;
+            timeout = _configuredTimeout;
+        }
+
+        // Clamp to what a single submission can describe; the loops in _read() and _write()
+        // pick up the remainder.
+        const auto len = static_cast<uint32_t>(std::min<size_t>(size, INT32_MAX));
+        auto prepareIo = [&](io_uring_sqe* sqe) {
+            prepareSqe(sqe, opcode, _fd, data, len, op);
+            if (opcode == IORING_OP_SEND) {
+                sqe->msg_flags = MSG_NOSIGNAL;
+            }
+        };
+
+        if (!timeout) {
+            _reactor->startOperation<1>([&](auto& sqes) { prepareIo(sqes[0]); });
+        } else {
+            op->timeout = toKernelTimespec(*timeout);
+            _reactor->startOperation<2>([&](auto& sqes) {
+                prepareIo(sqes[0]);
+                sqes[0]->flags |= IOSQE_IO_LINK;
+                prepareSqe(sqes[1], IORING_OP_LINK_TIMEOUT, -1, &op->timeout, 1);
+                sqes[1]->user_data = kIgnoredCompletion;
+            });
+        }
+
+        return std::move(pf.future);
+    }
+
+    TransportLayerIoUring* const _tl;
+    const std::shared_ptr<IoUringReactor> _reactor;
+    const int _fd;
+
+    AtomicWord<bool> _ended{false};
+
+    Mutex _mutex = MONGO_MAKE_LATCH("IoUringSession::_mutex");
+    std::array<IoUringOperationHandle, 2> _inflight;
+    boost::optional<Milliseconds> _configuredTimeout;
+    bool _canceled = false;
+
+    HostAndPort _remote;
+    HostAndPort _local;
+    SockAddr _remoteAddr;
+    SockAddr _localAddr;
+};
+
+TransportLayerIoUring::Options::Options(const ServerGlobalParams* params)
+    : port(params->port),
+      ipList(params->bind_ips),
+      useUnixSockets(!params->noUnixSocket),
+      enableIPv6(params->enableIPv6) {}
+
+TransportLayerIoUring::TransportLayerIoUring(const Options& opts, ServiceEntryPoint* sep)
+    : _reactor(std::make_shared<IoUringReactor>()), _sep(sep), _listenerOptions(opts) {}
+
+TransportLayerIoUring::~TransportLayerIoUring() {
+    shutdown();
+
+    // Sessions may outlive shutdown() and still need the reactor to complete their I/O, so the
+    // listener thread keeps running it until the transport layer itself goes away.
+    if (_listenerThread.thread.joinable()) {
+        _reactor->stop();
+        _listenerThread.thread.join();
+    }
+}
+
+StatusWith<SessionHandle> TransportLayerIoUring::connect(HostAndPort peer,
+                                                         ConnectSSLMode sslMode,
+                                                         Milliseconds timeout) {
+    return {ErrorCodes::NotImplemented,
+            "The io_uring transport layer does not support egress connections"};
+}
+
+Future<SessionHandle> TransportLayerIoUring::asyncConnect(HostAndPort peer,
+                                                          ConnectSSLMode sslMode,
+                                                          const ReactorHandle& reactor,
+                                                          Milliseconds timeout) {
+    return Status(ErrorCodes::NotImplemented,
+                  "The io_uring transport layer does not support egress connections");
+}
+
+Status TransportLayerIoUring::setup() {
+#ifdef MONGO_CONFIG_SSL
+    if (getSSLGlobalParams().sslMode.load() != SSLParams::SSLMode_disabled) {
+        return {ErrorCodes::InvalidOptions,
+                "The io_uring transport layer does not support TLS connections"};
+    }
+#endif
+
+    auto status = _reactor->checkKernelSupport();
+    if (!status.isOK()) {
+        return status;
+    }
+
+    std::vector<std::string> listenAddrs = _listenerOptions.ipList;
+    if (listenAddrs.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_listenerOptions.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    }
+    if (_listenerOptions.useUnixSockets) {
+        listenAddrs.emplace_back(makeUnixSockPath(_listenerOptions.port));
+    }
+
+    _listenerPort = _listenerOptions.port;
+
+    // Self-deduplicating list of unique endpoint addresses.
+    std::set<SockAddr> endpoints;
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            LOGV2_WARNING(51813, "Skipping empty bind address");
+            continue;
+        }
+
+        auto addrs = SockAddr::createAll(
+            ip, _listenerPort, _listenerOptions.enableIPv6 ? AF_UNSPEC : AF_INET);
+        if (addrs.empty()) {
+            LOGV2_WARNING(51814, "Found no addresses for {ip}", "ip"_attr = ip);
+            continue;
+        }
+        endpoints.insert(addrs.begin(), addrs.end());
+    }
+
+    for (auto& addr : endpoints) {
+        if (addr.getType() == AF_UNIX) {
+            if (::unlink(addr.getAddr().c_str()) == -1 && errno != ENOENT) {
+                const auto ewd = errnoWithDescription();
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to unlink socket file " << addr.getAddr() << " "
+                                      << ewd};
+            }
+        }
+
+        int fd = ::socket(addr.getType(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return {ErrorCodes::SocketException, errnoWithDescription()};
+        }
+        auto closeGuard = makeGuard([&] { ::close(fd); });
+
+        int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef TCP_FASTOPEN
+        if (gTCPFastOpenServer && (addr.getType() == AF_INET || addr.getType() == AF_INET6)) {
+            int queueSize = gTCPFastOpenQueueSize;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_FASTOPEN, &queueSize, sizeof(queueSize));
+        }
+#endif
+        if (addr.getType() == AF_INET6) {
+            ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+        }
+
+        if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+            const auto ewd = errnoWithDescription();
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to bind to " << addr.toString() << ": " << ewd};
+        }
+
+        if (addr.getType() == AF_UNIX) {
+            if (::chmod(addr.getAddr().c_str(), serverGlobalParams.unixSocketPermissions) == -1) {
+                const auto ewd = errnoWithDescription();
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to chmod socket file " << addr.getAddr() << " "
+                                      << ewd};
+            }
+        }
+
+        if (_listenerOptions.port == 0 &&
+            (addr.getType() == AF_INET || addr.getType() == AF_INET6)) {
+            if (_listenerPort != _listenerOptions.port) {
+                return Status(ErrorCodes::BadValue,
+                              "Port 0 (ephemeral port) is not allowed when"
+                              " listening on multiple IP interfaces");
+            }
+
+            sockaddr_storage bound;
+            socklen_t boundLen = sizeof(bound);
+            if (::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &boundLen) != 0) {
+                return {ErrorCodes::SocketException, errnoWithDescription()};
+            }
+            _listenerPort = SockAddr(reinterpret_cast<sockaddr*>(&bound), boundLen).getPort();
+        }
+
+        closeGuard.dismiss();
+        _listeners.push_back({addr, fd});
+    }
+
+    if (_listeners.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    return Status::OK();
+}
+
+ReactorHandle TransportLayerIoUring::getReactor(WhichReactor which) {
+    invariant(which == TransportLayer::kIngress);
+    return _reactor;
+}
+
+Status TransportLayerIoUring::start() {
+    stdx::unique_lock lk(_mutex);
+
+    // Make sure we haven't shutdown already
+    invariant(!_isShutdown);
+
+    _listenerThread.thread = stdx::thread([this] { _runListener(); });
+    _listenerThread.cv.wait(lk, [&] { return _isShutdown || _listenerThread.active; });
+    return Status::OK();
+}
+
+void TransportLayerIoUring::shutdown() {
+    stdx::lock_guard lk(_mutex);
+
+    if (std::exchange(_isShutdown, true)) {
+        // We were already stopped
+        return;
+    }
+
+    // Shutting down the listening sockets fails their outstanding accepts, which then see
+    // _isShutdown and stop re-arming.
+    for (auto& listener : _listeners) {
+        ::shutdown(listener.fd, SHUT_RDWR);
+
+        auto& addr = listener.addr;
+        if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
+            auto path = addr.getAddr();
+            LOGV2(51815, "removing socket file: {path}", "path"_attr = path);
+            if (::unlink(path.c_str()) != 0) {
+                const auto ewd = errnoWithDescription();
+                LOGV2_WARNING(51816,
+                              "Unable to remove UNIX socket {path}: {ewd}",
+                              "path"_attr = path,
+                              "ewd"_attr = ewd);
+            }
+        }
+    }
+}
+
+void TransportLayerIoUring::_runListener() noexcept {
+    setThreadName("listener");
+
+    {
+        stdx::lock_guard lk(_mutex);
+        if (_isShutdown) {
+            return;
+        }
+
+        for (auto& listener : _listeners) {
+            if (::listen(listener.fd, serverGlobalParams.listenBacklog) != 0) {
+                const auto ewd = errnoWithDescription();
+                LOGV2_FATAL(51817,
+                            "Error listening for new connections on {addr}: {error}",
+                            "addr"_attr = listener.addr,
+                            "error"_attr = ewd);
+                fassertFailed(51818);
+            }
+
+            _acceptConnection(listener.fd);
+            LOGV2(51819, "Listening on {addr}", "addr"_attr = listener.addr.getAddr());
+        }
+
+        LOGV2(51820,
+              "waiting for connections on port {listenerPort} using io_uring",
+              "listenerPort"_attr = _listenerPort);
+
+        _listenerThread.active = true;
+        _listenerThread.cv.notify_all();
+    }
+
+    _reactor->run();
+
+    for (auto& listener : _listeners) {
+        ::close(listener.fd);
+    }
+
+    stdx::lock_guard lk(_mutex);
+    _listenerThread.active = false;
+    _listenerThread.cv.notify_all();
+}
+
+void TransportLayerIoUring::_logAcceptError(int error) {
+    size_t numSuppressed;
+    {
+        stdx::lock_guard lk(_mutex);
+        const auto now = Date_t::now();
+        if (now - _lastAcceptErrorLogTime < Seconds(1)) {
+            ++_numSuppressedAcceptErrors;
+            return;
+        }
+        _lastAcceptErrorLogTime = now;
+        numSuppressed = std::exchange(_numSuppressedAcceptErrors, 0);
+    }
+
+    LOGV2(51821,
+          "Error accepting new connection: {error}",
+          "error"_attr = errnoWithDescription(error),
+          "numSuppressed"_attr = numSuppressed);
+}
+
+void TransportLayerIoUring::_acceptConnection(int listenFd, Milliseconds backoff) {
+    struct PeerAddress {
+        sockaddr_storage addr;
+        socklen_t len = sizeof(sockaddr_storage);
+    };
+    auto peer = std::make_shared<PeerAddress>();
+
+    auto op = make_intrusive<IoUringOperation>([this, listenFd, peer, backoff](int res) {
+        if (auto lk = stdx::lock_guard(_mutex); _isShutdown) {
+            if (res >= 0) {
+                ::close(res);
+            }
+            return;
+        }
+
+        if (res < 0) {
+            _logAcceptError(-res);
+
+            // Running out of file descriptors or memory is not resolved by accepting again right
+            // away, so back off exponentially until a connection is accepted.
+            if (res == -EMFILE || res == -ENFILE || res == -ENOBUFS || res == -ENOMEM) {
+                const auto nextBackoff =
+                    std::min(std::max(backoff * 2, Milliseconds(1)), Milliseconds(1000));
+                std::shared_ptr<ReactorTimer> timer = _reactor->makeTimer();
+                timer->waitUntil(_reactor->now() + nextBackoff)
+                    .getAsync([this, listenFd, nextBackoff, timer](Status status) {
+                        if (!status.isOK()) {
+                            return;
+                        }
+                        _acceptConnection(listenFd, nextBackoff);
+                    });
+                return;
+            }
+
+            _acceptConnection(listenFd);
+            return;
+        }
+
+        try {
+            auto session = std::make_shared<IoUringSession>(
+                this,
+                _reactor,
+                res,
+                SockAddr(reinterpret_cast<const sockaddr*>(&peer->addr), peer->len));
+            _sep->startSession(std::move(session));
+        } catch (const DBException& e) {
+            LOGV2_WARNING(51822, "Error accepting new connection {e}", "e"_attr = e);
+        }
+
+        _acceptConnection(listenFd);
+    });
+
+    _reactor->startOperation<1>([&](auto& sqes) {
+        prepareSqe(sqes[0], IORING_OP_ACCEPT, listenFd, &peer->addr, 0, op);
+        sqes[0]->addr2 = reinterpret_cast<uintptr_t>(&peer->len);
+        sqes[0]->accept_flags = SOCK_CLOEXEC;
+    });
+}
+
+}  // namespace transport
+}  // namespace mongo
+
+#endif  // MONGO_CONFIG_HAVE_IO_URING
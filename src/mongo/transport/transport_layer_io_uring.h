@@ -0,0 +1,161 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/config.h"
+
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/db/server_options.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/transport/transport_mode.h"
+#include "mongo/util/net/sockaddr.h"
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+/**
+ * An ingress-only TransportLayer that performs all socket I/O for accepted connections through a
+ * Linux io_uring instead of epoll readiness notifications. Accepts, receives and sends are
+ * submitted to a single ring owned by the ingress reactor, and submissions made while completions
+ * are being processed are flushed with a single io_uring_enter() call.
+ *
+ * TLS and outgoing connections are not supported; this transport layer is meant to run alongside
+ * a TransportLayerASIO configured for egress only. See TransportLayerManager::createWithConfig().
+ */
+class TransportLayerIoUring final : public TransportLayer {
+    TransportLayerIoUring(const TransportLayerIoUring&) = delete;
+    TransportLayerIoUring& operator=(const TransportLayerIoUring&) = delete;
+
+public:
+    struct Options {
+        explicit Options(const ServerGlobalParams* params);
+        Options() = default;
+
+        int port = ServerGlobalParams::DefaultDBPort;  // port to bind to
+        std::vector<std::string> ipList;               // addresses to bind to
+        bool useUnixSockets = true;                    // whether to allow UNIX sockets in ipList
+        bool enableIPv6 = false;                       // whether to allow IPv6 sockets in ipList
+        Mode transportMode = Mode::kSynchronous;       // whether sessions are driven by the
+                                                       // adaptive executor or by their own thread
+    };
+
+    TransportLayerIoUring(const Options& opts, ServiceEntryPoint* sep);
+
+    ~TransportLayerIoUring();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) final;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) final;
+
+    Status setup() final;
+
+    ReactorHandle getReactor(WhichReactor which) final;
+
+    Status start() final;
+
+    void shutdown() final;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class IoUringReactor;
+    class IoUringReactorTimer;
+    class IoUringSession;
+
+    /**
+     * Accepts the next connection on 'listenFd'. 'backoff' is how long the previous attempt waited
+     * after running out of file descriptors or memory, and is zero if it didn't.
+     */
+    void _acceptConnection(int listenFd, Milliseconds backoff = Milliseconds(0));
+
+    /**
+     * Logs an error accepting a connection, at most once per second. The number of errors which
+     * were not logged in between is reported with the next one which is.
+     */
+    void _logAcceptError(int error);
+
+    void _runListener() noexcept;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("TransportLayerIoUring::_mutex");
+
+    // All accepted sessions and the listening sockets share this reactor. The listener thread
+    // runs it for the lifetime of the transport layer; in asynchronous mode the adaptive service
+    // executor's worker threads run it as well.
+    std::shared_ptr<IoUringReactor> _reactor;
+
+    struct Listener {
+        SockAddr addr;
+        int fd;
+    };
+    std::vector<Listener> _listeners;
+
+    struct ListenerThread {
+        stdx::thread thread;
+        stdx::condition_variable cv;
+        bool active = false;
+    };
+    ListenerThread _listenerThread;
+
+    ServiceEntryPoint* const _sep = nullptr;
+
+    Options _listenerOptions;
+    // The real incoming port in case of _listenerOptions.port==0 (ephemeral).
+    int _listenerPort = 0;
+
+    bool _isShutdown = false;
+
+    // Rate limits the logging of accept errors.
+    Date_t _lastAcceptErrorLogTime;
+    size_t _numSuppressedAcceptErrors = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
+
+#endif  // MONGO_CONFIG_HAVE_IO_URING
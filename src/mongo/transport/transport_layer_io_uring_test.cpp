@@ -0,0 +1,211 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kTest
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+
+#include "mongo/db/server_options.h"
+#include "mongo/logv2/log.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/net/sock.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Runs every accepted session on its own thread and echoes each message back to the client until
+ * the client disconnects.
+ */
+class EchoServiceEntryPoint : public ServiceEntryPoint {
+public:
+    ~EchoServiceEntryPoint() override {
+        shutdown(Milliseconds::max());
+    }
+
+    void startSession(transport::SessionHandle session) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        ++_sessionsStarted;
+        _cv.notify_all();
+        _workerThreads.emplace_back([session = std::move(session)] {
+            while (true) {
+                auto swMessage = session->sourceMessage();
+                if (!swMessage.isOK()) {
+                    LOGV2(51823, "session ended: {status}", "status"_attr = swMessage.getStatus());
+                    return;
+                }
+                auto status = session->sinkMessage(swMessage.getValue());
+                if (!status.isOK()) {
+                    LOGV2(51825, "session ended: {status}", "status"_attr = status);
+                    return;
+                }
+            }
+        });
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {}
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        for (auto& thread : _workerThreads) {
+            thread.join();
+        }
+        _workerThreads.clear();
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    void waitForSessions(size_t count) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cv.wait(lk, [&] { return _sessionsStarted >= count; });
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("EchoServiceEntryPoint::_mutex");
+    stdx::condition_variable _cv;
+    size_t _sessionsStarted = 0;
+    std::vector<stdx::thread> _workerThreads;
+};
+
+/**
+ * Creates and sets up a transport layer listening on an ephemeral port, or returns nullptr if the
+ * kernel running the test doesn't allow creating an io_uring or lacks an operation it needs.
+ */
+std::unique_ptr<transport::TransportLayerIoUring> makeTransportLayer(ServiceEntryPoint* sep) {
+    ServerGlobalParams params;
+    params.noUnixSocket = true;
+    transport::TransportLayerIoUring::Options opts(&params);
+    opts.port = 0;
+
+    std::unique_ptr<transport::TransportLayerIoUring> tl;
+    try {
+        tl = std::make_unique<transport::TransportLayerIoUring>(opts, sep);
+    } catch (const DBException& ex) {
+        LOGV2(51824, "Skipping test, io_uring is unavailable: {ex}", "ex"_attr = ex);
+        return nullptr;
+    }
+
+    // setup() refuses kernels which lack any of the io_uring operations the transport layer uses.
+    auto status = tl->setup();
+    if (status == ErrorCodes::InvalidOptions) {
+        LOGV2(51836, "Skipping test, io_uring is unsupported: {status}", "status"_attr = status);
+        return nullptr;
+    }
+    ASSERT_OK(status);
+    return tl;
+}
+
+TEST(TransportLayerIoUring, EchoRoundTrip) {
+    EchoServiceEntryPoint sep;
+    auto tl = makeTransportLayer(&sep);
+    if (!tl) {
+        return;
+    }
+
+    ASSERT_OK(tl->start());
+    ASSERT_GT(tl->listenerPort(), 0);
+
+    {
+        Socket s;
+        SockAddr sa{"localhost", tl->listenerPort(), AF_INET};
+        ASSERT_TRUE(s.connect(sa));
+        sep.waitForSessions(1);
+
+        // Large enough that the kernel is likely to split both the send and the receive.
+        std::string payload(4 * 1024 * 1024, 'x');
+        for (int i = 0; i < 3; ++i) {
+            auto body = BSON("ping" << 1 << "iteration" << i << "payload" << payload);
+            auto request = OpMsgRequest::fromDBAndBody("admin", body).serialize();
+            s.send(request.buf(), request.size(), "echo request");
+
+            std::string response(request.size(), '\0');
+            s.recv(&response[0], response.size());
+            ASSERT_EQ(0, memcmp(request.buf(), response.data(), response.size()));
+        }
+    }
+
+    sep.shutdown(Milliseconds::max());
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, ReactorRunsTasksAndTimers) {
+    EchoServiceEntryPoint sep;
+    auto tl = makeTransportLayer(&sep);
+    if (!tl) {
+        return;
+    }
+
+    ASSERT_OK(tl->start());
+
+    auto reactor = tl->getReactor(transport::TransportLayer::kIngress);
+
+    auto pf = makePromiseFuture<bool>();
+    reactor->schedule([&, promise = std::move(pf.promise)](Status status) mutable {
+        ASSERT_OK(status);
+        promise.emplaceValue(reactor->onReactorThread());
+    });
+    ASSERT_TRUE(std::move(pf.future).get());
+
+    auto timer = reactor->makeTimer();
+    const auto start = reactor->now();
+    ASSERT_OK(timer->waitUntil(start + Milliseconds(20)).getNoThrow());
+    ASSERT_GTE(reactor->now() - start, Milliseconds(19));
+
+    // A canceled wait is filled with an error rather than left outstanding.
+    auto canceled = timer->waitUntil(reactor->now() + Hours(1));
+    timer->cancel();
+    ASSERT_EQ(ErrorCodes::CallbackCanceled, canceled.getNoThrow());
+
+    tl->shutdown();
+}
+
+}  // namespace
+}  // namespace mongo
+
+#endif  // MONGO_CONFIG_HAVE_IO_URING
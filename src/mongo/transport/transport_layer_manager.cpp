@@ -36,12 +36,15 @@
 #include <memory>
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_layer_io_uring.h"
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 
@@ -134,7 +137,7 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     auto sep = ctx->getServiceEntryPoint();
 
     transport::TransportLayerASIO::Options opts(config);
-    if (config->serviceExecutor == "adaptive") {
+    if (config->serviceExecutor == "adaptive" || config->serviceExecutor == "threadPerCore") {
         opts.transportMode = transport::Mode::kAsynchronous;
     } else if (config->serviceExecutor == "synchronous") {
         opts.transportMode = transport::Mode::kSynchronous;
@@ -142,11 +145,48 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
         MONGO_UNREACHABLE;
     }
 
+#ifdef MONGO_CONFIG_HAVE_IO_URING
+    if (config->transportLayer == "io_uring") {
+        // Ingress connections are served by io_uring while ASIO stays responsible for outgoing
+        // connections. The egress layer goes first so that connect() and getReactor() reach it.
+        opts.mode = transport::TransportLayerASIO::Options::kEgress;
+        opts.ipList.clear();
+        opts.useUnixSockets = false;
+        auto transportLayerASIO = std::make_unique<transport::TransportLayerASIO>(opts, sep);
+
+        transport::TransportLayerIoUring::Options ioUringOpts(config);
+        ioUringOpts.transportMode = opts.transportMode;
+        auto transportLayerIoUring =
+            std::make_unique<transport::TransportLayerIoUring>(ioUringOpts, sep);
+
+        if (config->serviceExecutor == "adaptive") {
+            auto reactor = transportLayerIoUring->getReactor(TransportLayer::kIngress);
+            ctx->setServiceExecutor(
+                std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+        } else if (config->serviceExecutor == "threadPerCore") {
+            auto reactor = transportLayerIoUring->getReactor(TransportLayer::kIngress);
+            ctx->setServiceExecutor(
+                std::make_unique<ServiceExecutorThreadPerCore>(ctx, std::move(reactor)));
+        } else if (config->serviceExecutor == "synchronous") {
+            ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
+        }
+
+        std::vector<std::unique_ptr<TransportLayer>> retVector;
+        retVector.emplace_back(std::move(transportLayerASIO));
+        retVector.emplace_back(std::move(transportLayerIoUring));
+        return std::make_unique<TransportLayerManager>(std::move(retVector));
+    }
+#endif
+
     auto transportLayerASIO = std::make_unique<transport::TransportLayerASIO>(opts, sep);
 
     if (config->serviceExecutor == "adaptive") {
         auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+    } else if (config->serviceExecutor == "threadPerCore") {
+        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(
+            std::make_unique<ServiceExecutorThreadPerCore>(ctx, std::move(reactor)));
     } else if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
     }
@@ -33,14 +33,36 @@
 
 #include "mongo/util/concurrency/ticketholder.h"
 
-#include <iostream>
+#include <algorithm>
 
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/logv2/log.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
 
+StringData AdmissionContext::priorityName(Priority priority) {
+    switch (priority) {
+        case Priority::kReplication:
+            return "replication"_sd;
+        case Priority::kInternal:
+            return "internal"_sd;
+        case Priority::kInteractive:
+            return "interactive"_sd;
+        case Priority::kBatch:
+            return "batch"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
+void TicketHolder::appendStats(BSONObjBuilder& b) const {
+    b.append("out", used());
+    b.append("available", available());
+    b.append("totalTickets", outof());
+}
+
 #if defined(__linux__)
 namespace {
 
@@ -73,15 +95,15 @@ void tsFromDate(const Date_t& deadline, struct timespec& ts) {
 }
 }  // namespace
 
-TicketHolder::TicketHolder(int num) : _outof(num) {
+SemaphoreTicketHolder::SemaphoreTicketHolder(int num) : _outof(num) {
     check(sem_init(&_sem, 0, num));
 }
 
-TicketHolder::~TicketHolder() {
+SemaphoreTicketHolder::~SemaphoreTicketHolder() {
     check(sem_destroy(&_sem));
 }
 
-bool TicketHolder::tryAcquire() {
+bool SemaphoreTicketHolder::_tryAcquire(const AdmissionContext& admCtx) {
     while (0 != sem_trywait(&_sem)) {
         if (errno == EAGAIN)
             return false;
@@ -91,11 +113,9 @@ bool TicketHolder::tryAcquire() {
     return true;
 }
 
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
-    waitForTicketUntil(opCtx, Date_t::max());
-}
-
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
+bool SemaphoreTicketHolder::_waitForTicketUntil(OperationContext* opCtx,
+                                                const AdmissionContext& admCtx,
+                                                Date_t until) {
     const Milliseconds intervalMs(500);
     struct timespec ts;
 
@@ -126,11 +146,18 @@ bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
     return true;
 }
 
-void TicketHolder::release() {
+void SemaphoreTicketHolder::_release() {
+    // Swallow the ticket if a shrinking resize is still owed one.
+    auto pending = _pendingShrink.load();
+    while (pending > 0) {
+        if (_pendingShrink.compareAndSwap(&pending, pending - 1)) {
+            return;
+        }
+    }
     check(sem_post(&_sem));
 }
 
-Status TicketHolder::resize(int newSize) {
+Status SemaphoreTicketHolder::resize(int newSize) {
     stdx::lock_guard<Latch> lk(_resizeMutex);
 
     if (newSize < 5)
@@ -142,68 +169,74 @@ Status TicketHolder::resize(int newSize) {
                       str::stream() << "Maximum value for semaphore is " << SEM_VALUE_MAX
                                     << "; given " << newSize);
 
-    while (_outof.load() < newSize) {
-        release();
-        _outof.fetchAndAdd(1);
+    // Go through the private methods so that resizing does not count towards the statistics.
+    // Growing first cancels whatever an earlier shrink is still waiting for.
+    for (int i = _outof.load(); i < newSize; ++i) {
+        _release();
     }
 
-    while (_outof.load() > newSize) {
-        waitForTicket();
-        _outof.subtractAndFetch(1);
+    // Shrinking takes the available tickets right away, and the rest as outstanding tickets are
+    // released rather than by blocking here.
+    for (int i = newSize; i < _outof.load(); ++i) {
+        if (!_tryAcquire(AdmissionContext())) {
+            _pendingShrink.fetchAndAdd(1);
+        }
     }
 
-    invariant(_outof.load() == newSize);
+    _outof.store(newSize);
     return Status::OK();
 }
 
-int TicketHolder::available() const {
+int SemaphoreTicketHolder::available() const {
     int val = 0;
     check(sem_getvalue(&_sem, &val));
     return val;
 }
 
-int TicketHolder::used() const {
-    return outof() - available();
+int SemaphoreTicketHolder::used() const {
+    return outof() + _pendingShrink.load() - available();
 }
 
-int TicketHolder::outof() const {
+int SemaphoreTicketHolder::outof() const {
     return _outof.load();
 }
 
 #else
 
-TicketHolder::TicketHolder(int num) : _outof(num), _num(num) {}
+SemaphoreTicketHolder::SemaphoreTicketHolder(int num) : _outof(num), _num(num) {}
 
-TicketHolder::~TicketHolder() = default;
+SemaphoreTicketHolder::~SemaphoreTicketHolder() = default;
 
-bool TicketHolder::tryAcquire() {
+bool SemaphoreTicketHolder::_tryAcquire(const AdmissionContext& admCtx) {
     stdx::lock_guard<Latch> lk(_mutex);
-    return _tryAcquire();
+    return _tryAcquireLocked();
 }
 
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
+bool SemaphoreTicketHolder::_waitForTicketUntil(OperationContext* opCtx,
+                                                const AdmissionContext& admCtx,
+                                                Date_t until) {
     stdx::unique_lock<Latch> lk(_mutex);
 
-    if (opCtx) {
-        opCtx->waitForConditionOrInterrupt(_newTicket, lk, [this] { return _tryAcquire(); });
-    } else {
-        _newTicket.wait(lk, [this] { return _tryAcquire(); });
+    if (until == Date_t::max()) {
+        if (opCtx) {
+            opCtx->waitForConditionOrInterrupt(
+                _newTicket, lk, [this] { return _tryAcquireLocked(); });
+        } else {
+            _newTicket.wait(lk, [this] { return _tryAcquireLocked(); });
+        }
+        return true;
     }
-}
-
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
-    stdx::unique_lock<Latch> lk(_mutex);
 
     if (opCtx) {
         return opCtx->waitForConditionOrInterruptUntil(
-            _newTicket, lk, until, [this] { return _tryAcquire(); });
+            _newTicket, lk, until, [this] { return _tryAcquireLocked(); });
     } else {
         return _newTicket.wait_until(
-            lk, until.toSystemTimePoint(), [this] { return _tryAcquire(); });
+            lk, until.toSystemTimePoint(), [this] { return _tryAcquireLocked(); });
     }
 }
 
-void TicketHolder::release() {
+void SemaphoreTicketHolder::_release() {
     {
         stdx::lock_guard<Latch> lk(_mutex);
         _num++;
@@ -211,49 +244,257 @@ void TicketHolder::release() {
     _newTicket.notify_one();
 }
 
-Status TicketHolder::resize(int newSize) {
+Status SemaphoreTicketHolder::resize(int newSize) {
     stdx::lock_guard<Latch> lk(_mutex);
 
-    int used = _outof.load() - _num;
-    if (used > newSize) {
-        std::stringstream ss;
-        ss << "can't resize since we're using (" << used << ") "
-           << "more than newSize(" << newSize << ")";
-
-        std::string errmsg = ss.str();
-        LOGV2(23120, "{errmsg}", "errmsg"_attr = errmsg);
-        return Status(ErrorCodes::BadValue, errmsg);
-    }
-
+    // Shrinking below the number of tickets in use takes effect as they are released.
+    _num += newSize - _outof.load();
     _outof.store(newSize);
-    _num = _outof.load() - used;
 
     // Potentially wasteful, but easier to see is correct
     _newTicket.notify_all();
     return Status::OK();
 }
 
-int TicketHolder::available() const {
-    return _num;
+int SemaphoreTicketHolder::available() const {
+    return std::max(_num, 0);
 }
 
-int TicketHolder::used() const {
+int SemaphoreTicketHolder::used() const {
     return outof() - _num;
 }
 
-int TicketHolder::outof() const {
+int SemaphoreTicketHolder::outof() const {
     return _outof.load();
 }
 
-bool TicketHolder::_tryAcquire() {
+bool SemaphoreTicketHolder::_tryAcquireLocked() {
     if (_num <= 0) {
-        if (_num < 0) {
-            std::cerr << "DISASTER! in TicketHolder" << std::endl;
-        }
         return false;
     }
     _num--;
     return true;
 }
 #endif
+
+const std::array<long long, PriorityTicketHolder::kNumQueueTimeBuckets - 1>
+    PriorityTicketHolder::kQueueTimeBucketBounds = {
+        100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000};
+
+PriorityTicketHolder::PriorityTicketHolder(int num, Milliseconds starvationLimit)
+    : _starvationLimit(starvationLimit), _outof(num), _available(num) {}
+
+PriorityTicketHolder::~PriorityTicketHolder() {
+    invariant(_numQueued == 0);
+}
+
+bool PriorityTicketHolder::_tryAcquire(const AdmissionContext& admCtx) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_available <= 0 || _numQueued > 0) {
+        return false;
+    }
+    _available--;
+    _recordAdmission(lk, _queueFor(admCtx), Microseconds(0));
+    return true;
+}
+
+bool PriorityTicketHolder::_waitForTicketUntil(OperationContext* opCtx,
+                                               const AdmissionContext& admCtx,
+                                               Date_t until) {
+    stdx::unique_lock<Latch> lk(_mutex);
+    auto& queue = _queueFor(admCtx);
+
+    // Only bypass the queue when nobody is in it, otherwise a steady stream of new arrivals could
+    // keep taking the tickets meant for the operations already waiting.
+    if (_available > 0 && _numQueued == 0) {
+        _available--;
+        _recordAdmission(lk, queue, Microseconds(0));
+        return true;
+    }
+
+    Waiter waiter;
+    waiter.enqueued = Date_t::now();
+    _enqueue(lk, admCtx, &waiter);
+
+    // An interrupted waiter must leave the queue, and pass on a ticket it was granted meanwhile.
+    auto leaveQueueOnError = makeGuard([&] {
+        if (waiter.granted) {
+            _available++;
+            _grantTickets(lk);
+        } else {
+            _dequeue(lk, admCtx, &waiter);
+        }
+    });
+
+    auto isGranted = [&] { return waiter.granted; };
+    if (opCtx) {
+        opCtx->waitForConditionOrInterruptUntil(waiter.cv, lk, until, isGranted);
+    } else if (until == Date_t::max()) {
+        waiter.cv.wait(lk, isGranted);
+    } else {
+        waiter.cv.wait_until(lk, until.toSystemTimePoint(), isGranted);
+    }
+    leaveQueueOnError.dismiss();
+
+    if (!waiter.granted) {
+        _dequeue(lk, admCtx, &waiter);
+        queue.timedOut++;
+        return false;
+    }
+
+    _recordAdmission(lk, queue, waiter.queueTimer.elapsed());
+    return true;
+}
+
+void PriorityTicketHolder::_release() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _available++;
+    _grantTickets(lk);
+}
+
+Status PriorityTicketHolder::resize(int newSize) {
+    if (newSize < 5)
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Minimum value for tickets is 5; given " << newSize);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    // Shrinking takes effect as outstanding tickets are released rather than by blocking here.
+    _available += newSize - _outof.load();
+    _outof.store(newSize);
+    _grantTickets(lk);
+    return Status::OK();
+}
+
+int PriorityTicketHolder::available() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return std::max(_available, 0);
+}
+
+int PriorityTicketHolder::used() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _outof.load() - _available;
+}
+
+int PriorityTicketHolder::outof() const {
+    return _outof.load();
+}
+
+int PriorityTicketHolder::queued() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _numQueued;
+}
+
+void PriorityTicketHolder::appendStats(BSONObjBuilder& b) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    b.append("out", _outof.load() - _available);
+    b.append("available", std::max(_available, 0));
+    b.append("totalTickets", _outof.load());
+    b.append("queued", _numQueued);
+
+    BSONObjBuilder priorities(b.subobjStart("priorities"));
+    for (int i = 0; i < AdmissionContext::kNumPriorities; ++i) {
+        const auto& queue = _queues[i];
+        BSONObjBuilder bb(priorities.subobjStart(
+            AdmissionContext::priorityName(static_cast<AdmissionContext::Priority>(i))));
+        bb.append("queued", queue.queued);
+        bb.append("tenantsQueued", static_cast<long long>(queue.tenants.size()));
+        bb.append("admitted", queue.admitted);
+        bb.append("timedOut", queue.timedOut);
+        bb.append("totalQueueTimeMicros", queue.queueTimeMicros);
+
+        BSONArrayBuilder histogram(bb.subarrayStart("queueTimeHistogram"));
+        for (int bucket = 0; bucket < kNumQueueTimeBuckets; ++bucket) {
+            BSONObjBuilder entry(histogram.subobjStart());
+            entry.append("micros", bucket == 0 ? 0LL : kQueueTimeBucketBounds[bucket - 1]);
+            entry.append("count", queue.queueTimeHistogram[bucket]);
+        }
+    }
+}
+
+void PriorityTicketHolder::_enqueue(WithLock, const AdmissionContext& admCtx, Waiter* waiter) {
+    auto& queue = _queueFor(admCtx);
+    auto it = queue.tenantIndex.find(admCtx.tenant);
+    if (it == queue.tenantIndex.end()) {
+        // A tenant joining the queue goes to the back of the rotation.
+        auto tenantIt =
+            queue.tenants.insert(queue.tenants.end(), TenantQueue{admCtx.tenant.toString(), {}});
+        it = queue.tenantIndex.emplace(admCtx.tenant.toString(), tenantIt).first;
+    }
+    it->second->waiters.push_back(waiter);
+    queue.queued++;
+    _numQueued++;
+}
+
+void PriorityTicketHolder::_dequeue(WithLock, const AdmissionContext& admCtx, Waiter* waiter) {
+    auto& queue = _queueFor(admCtx);
+    auto it = queue.tenantIndex.find(admCtx.tenant);
+    invariant(it != queue.tenantIndex.end());
+
+    auto& waiters = it->second->waiters;
+    auto waiterIt = std::find(waiters.begin(), waiters.end(), waiter);
+    invariant(waiterIt != waiters.end());
+    waiters.erase(waiterIt);
+    if (waiters.empty()) {
+        queue.tenants.erase(it->second);
+        queue.tenantIndex.erase(it);
+    }
+    queue.queued--;
+    _numQueued--;
+}
+
+void PriorityTicketHolder::_grantTickets(WithLock) {
+    if (_available <= 0 || _numQueued == 0) {
+        return;
+    }
+
+    const auto now = Date_t::now();
+    while (_available > 0 && _numQueued > 0) {
+        // Serve the most urgent class with waiters, unless a less urgent class has been starved.
+        PriorityQueue* next = nullptr;
+        for (auto& queue : _queues) {
+            if (queue.tenants.empty()) {
+                continue;
+            }
+            if (!next) {
+                next = &queue;
+            } else if (queue.tenants.front().waiters.front()->enqueued + _starvationLimit <= now) {
+                next = &queue;
+                break;
+            }
+        }
+        invariant(next);
+
+        // Take the first waiter of the tenant at the head of the rotation, then move that tenant
+        // to the back if it has more waiters.
+        auto tenantIt = next->tenants.begin();
+        Waiter* waiter = tenantIt->waiters.front();
+        tenantIt->waiters.pop_front();
+        if (tenantIt->waiters.empty()) {
+            next->tenantIndex.erase(tenantIt->tenant);
+            next->tenants.erase(tenantIt);
+        } else {
+            next->tenants.splice(next->tenants.end(), next->tenants, tenantIt);
+        }
+        next->queued--;
+        _numQueued--;
+
+        _available--;
+        waiter->granted = true;
+        waiter->cv.notify_one();
+    }
+}
+
+void PriorityTicketHolder::_recordAdmission(WithLock,
+                                            PriorityQueue& queue,
+                                            Microseconds queueTime) {
+    const auto micros = durationCount<Microseconds>(queueTime);
+    queue.admitted++;
+    queue.queueTimeMicros += micros;
+
+    auto bound = std::upper_bound(
+        kQueueTimeBucketBounds.begin(), kQueueTimeBucketBounds.end(), micros);
+    queue.queueTimeHistogram[bound - kQueueTimeBucketBounds.begin()]++;
+}
+
 }  // namespace mongo
@@ -32,31 +32,77 @@
 #include <semaphore.h>
 #endif
 
+#include <array>
+#include <deque>
+#include <list>
+#include <string>
+
 #include "mongo/db/operation_context.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/hierarchical_acquisition.h"
+#include "mongo/util/string_map.h"
 #include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
+
+/**
+ * Describes who is asking a TicketHolder for a ticket. Holders that order their waiters use it to
+ * decide who is admitted next; FIFO holders ignore it.
+ */
+struct AdmissionContext {
+    /**
+     * Admission classes, from the most to the least urgent.
+     */
+    enum class Priority {
+        kReplication,
+        kInternal,
+        kInteractive,
+        kBatch,
+    };
+    static constexpr int kNumPriorities = 4;
+
+    static StringData priorityName(Priority priority);
+
+    AdmissionContext() = default;
+    AdmissionContext(Priority priority, StringData tenant) : priority(priority), tenant(tenant) {}
+
+    Priority priority = Priority::kInteractive;
+
+    // Waiters of the same priority are admitted round-robin across tenants. The empty tenant is
+    // shared by everything that is not attributed to an authenticated user.
+    StringData tenant;
+};
+
+/**
+ * A pool of tickets limiting how many operations may proceed concurrently. Implementations decide
+ * in which order blocked callers are admitted.
+ */
 class TicketHolder {
     TicketHolder(const TicketHolder&) = delete;
     TicketHolder& operator=(const TicketHolder&) = delete;
 
 public:
-    explicit TicketHolder(int num);
-    ~TicketHolder();
+    virtual ~TicketHolder() = default;
 
-    bool tryAcquire();
+    bool tryAcquire(const AdmissionContext& admCtx = AdmissionContext()) {
+        return _tryAcquire(admCtx);
+    }
 
     /**
      * Attempts to acquire a ticket. Blocks until a ticket is acquired or the OperationContext
      * 'opCtx' is killed, throwing an AssertionException.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    void waitForTicket(OperationContext* opCtx);
+    void waitForTicket(OperationContext* opCtx,
+                       const AdmissionContext& admCtx = AdmissionContext()) {
+        invariant(waitForTicketUntil(opCtx, Date_t::max(), admCtx));
+    }
     void waitForTicket() {
         waitForTicket(nullptr);
     }
@@ -68,38 +114,222 @@ public:
      * proceed.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    bool waitForTicketUntil(OperationContext* opCtx, Date_t until);
+    bool waitForTicketUntil(OperationContext* opCtx,
+                            Date_t until,
+                            const AdmissionContext& admCtx = AdmissionContext()) {
+        if (_tryAcquire(admCtx)) {
+            return true;
+        }
+        _numWaited.fetchAndAdd(1);
+        return _waitForTicketUntil(opCtx, admCtx, until);
+    }
     bool waitForTicketUntil(Date_t until) {
         return waitForTicketUntil(nullptr, until);
     }
-    void release();
 
-    Status resize(int newSize);
+    void release() {
+        _numReleased.fetchAndAdd(1);
+        _release();
+    }
+
+    virtual Status resize(int newSize) = 0;
+
+    virtual int available() const = 0;
 
-    int available() const;
+    virtual int used() const = 0;
 
-    int used() const;
+    virtual int outof() const = 0;
 
-    int outof() const;
+    /**
+     * Number of tickets released since this holder was created. Sampled over time, this is the
+     * throughput of whatever the tickets guard.
+     */
+    long long numReleased() const {
+        return _numReleased.load();
+    }
+
+    /**
+     * Number of acquisitions that found no ticket available and had to wait for one.
+     */
+    long long numWaited() const {
+        return _numWaited.load();
+    }
+
+    /**
+     * Appends the ticket counts, plus whatever queueing statistics the implementation keeps.
+     */
+    virtual void appendStats(BSONObjBuilder& b) const;
+
+protected:
+    TicketHolder() = default;
 
 private:
+    virtual bool _tryAcquire(const AdmissionContext& admCtx) = 0;
+
+    virtual void _release() = 0;
+
+    /**
+     * Waits until 'until', which may be Date_t::max(), for a ticket.
+     */
+    virtual bool _waitForTicketUntil(OperationContext* opCtx,
+                                     const AdmissionContext& admCtx,
+                                     Date_t until) = 0;
+
+    AtomicWord<long long> _numReleased{0};
+    AtomicWord<long long> _numWaited{0};
+};
+
+/**
+ * Hands out tickets first-come-first-served, using a counting semaphore where the platform has one.
+ */
+class SemaphoreTicketHolder final : public TicketHolder {
+public:
+    explicit SemaphoreTicketHolder(int num);
+    ~SemaphoreTicketHolder() override;
+
+    Status resize(int newSize) override;
+
+    int available() const override;
+
+    int used() const override;
+
+    int outof() const override;
+
+private:
+    bool _tryAcquire(const AdmissionContext& admCtx) override;
+
+    void _release() override;
+
+    bool _waitForTicketUntil(OperationContext* opCtx,
+                             const AdmissionContext& admCtx,
+                             Date_t until) override;
+
 #if defined(__linux__)
     mutable sem_t _sem;
 
     // You can read _outof without a lock, but have to hold _resizeMutex to change.
     AtomicWord<int> _outof;
+
+    // Tickets a shrinking resize could not take from the semaphore right away. Released tickets
+    // are swallowed instead of being posted until this drops back to zero.
+    AtomicWord<int> _pendingShrink{0};
     Mutex _resizeMutex =
         MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "TicketHolder::_resizeMutex");
 #else
-    bool _tryAcquire();
+    bool _tryAcquireLocked();
 
     AtomicWord<int> _outof;
+    // May drop below zero while a shrinking resize waits for tickets to be released.
     int _num;
     Mutex _mutex = MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "TicketHolder::_mutex");
     stdx::condition_variable _newTicket;
 #endif
 };
 
+/**
+ * Admits waiters by priority class and, within a class, round-robin across tenants, so that a
+ * tenant with many queued operations cannot crowd out one with few. A ticket is only taken without
+ * queueing when nobody is waiting.
+ *
+ * Classes are served strictly in order, except that a lower class whose next waiter has been queued
+ * for longer than 'starvationLimit' is admitted ahead of the higher classes. This bounds how long
+ * batch work can be held back by a steady stream of interactive operations.
+ */
+class PriorityTicketHolder final : public TicketHolder {
+public:
+    static constexpr Milliseconds kDefaultStarvationLimit{1000};
+
+    explicit PriorityTicketHolder(int num,
+                                  Milliseconds starvationLimit = kDefaultStarvationLimit);
+    ~PriorityTicketHolder() override;
+
+    Status resize(int newSize) override;
+
+    int available() const override;
+
+    int used() const override;
+
+    int outof() const override;
+
+    /**
+     * Also appends, per priority class, the number of queued and admitted operations and a
+     * histogram of the time spent queued.
+     */
+    void appendStats(BSONObjBuilder& b) const override;
+
+    /**
+     * Number of operations currently queued for a ticket.
+     */
+    int queued() const;
+
+private:
+    // Upper bounds, in microseconds, of all but the last bucket of the queue time histograms.
+    static constexpr int kNumQueueTimeBuckets = 7;
+    static const std::array<long long, kNumQueueTimeBuckets - 1> kQueueTimeBucketBounds;
+
+    struct Waiter {
+        stdx::condition_variable cv;
+        Date_t enqueued;
+        Timer queueTimer;
+        bool granted = false;
+    };
+
+    struct TenantQueue {
+        std::string tenant;
+        std::deque<Waiter*> waiters;
+    };
+
+    struct PriorityQueue {
+        // Tenants with queued waiters, in the order they will next be served.
+        std::list<TenantQueue> tenants;
+        StringMap<std::list<TenantQueue>::iterator> tenantIndex;
+
+        long long queued = 0;
+        long long admitted = 0;
+        long long timedOut = 0;
+        long long queueTimeMicros = 0;
+        std::array<long long, kNumQueueTimeBuckets> queueTimeHistogram{};
+    };
+
+    bool _tryAcquire(const AdmissionContext& admCtx) override;
+
+    void _release() override;
+
+    bool _waitForTicketUntil(OperationContext* opCtx,
+                             const AdmissionContext& admCtx,
+                             Date_t until) override;
+
+    PriorityQueue& _queueFor(const AdmissionContext& admCtx) {
+        return _queues[static_cast<int>(admCtx.priority)];
+    }
+
+    void _enqueue(WithLock, const AdmissionContext& admCtx, Waiter* waiter);
+
+    /**
+     * Removes a waiter that gave up before being granted a ticket.
+     */
+    void _dequeue(WithLock, const AdmissionContext& admCtx, Waiter* waiter);
+
+    /**
+     * Hands out available tickets to queued waiters in admission order.
+     */
+    void _grantTickets(WithLock);
+
+    void _recordAdmission(WithLock, PriorityQueue& queue, Microseconds queueTime);
+
+    const Milliseconds _starvationLimit;
+
+    mutable Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "PriorityTicketHolder::_mutex");
+
+    AtomicWord<int> _outof;
+
+    // May drop below zero while a resize is waiting for tickets to be released.
+    int _available;
+    int _numQueued = 0;
+    std::array<PriorityQueue, AdmissionContext::kNumPriorities> _queues;
+};
+
 class ScopedTicket {
 public:
     ScopedTicket(TicketHolder* holder) : _holder(holder) {
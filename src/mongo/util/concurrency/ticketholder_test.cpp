@@ -32,6 +32,11 @@
 
 #include "mongo/platform/basic.h"
 
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/ticketholder.h"
 
@@ -39,7 +44,7 @@ namespace {
 using namespace mongo;
 
 TEST(TicketholderTest, BasicTimeout) {
-    TicketHolder holder(1);
+    SemaphoreTicketHolder holder(1);
     ASSERT_EQ(holder.used(), 0);
     ASSERT_EQ(holder.available(), 1);
     ASSERT_EQ(holder.outof(), 1);
@@ -72,4 +77,204 @@ TEST(TicketholderTest, BasicTimeout) {
     holder.release();
     ASSERT_EQ(holder.used(), 0);
 }
+
+TEST(TicketholderTest, ShrinkDoesNotWaitForOutstandingTickets) {
+    SemaphoreTicketHolder holder(10);
+    for (int i = 0; i < 8; ++i) {
+        ASSERT(holder.tryAcquire());
+    }
+
+    // Only two tickets are available, so the other three are taken as they are released.
+    ASSERT_OK(holder.resize(5));
+    ASSERT_EQ(holder.outof(), 5);
+    ASSERT_EQ(holder.used(), 8);
+    ASSERT_EQ(holder.available(), 0);
+    ASSERT_FALSE(holder.tryAcquire());
+
+    for (int i = 0; i < 3; ++i) {
+        holder.release();
+    }
+    ASSERT_EQ(holder.used(), 5);
+    ASSERT_EQ(holder.available(), 0);
+
+    holder.release();
+    ASSERT_EQ(holder.used(), 4);
+    ASSERT_EQ(holder.available(), 1);
+
+    // Growing again before the shrink has completed cancels what it is still waiting for.
+    for (int i = 0; i < 4; ++i) {
+        holder.release();
+    }
+    ASSERT_OK(holder.resize(10));
+    for (int i = 0; i < 8; ++i) {
+        ASSERT(holder.tryAcquire());
+    }
+    ASSERT_OK(holder.resize(5));
+    ASSERT_OK(holder.resize(7));
+    ASSERT_EQ(holder.used(), 8);
+    ASSERT_EQ(holder.available(), 0);
+
+    for (int i = 0; i < 8; ++i) {
+        holder.release();
+    }
+    ASSERT_EQ(holder.used(), 0);
+    ASSERT_EQ(holder.available(), 7);
+}
+
+using Priority = AdmissionContext::Priority;
+
+/**
+ * Starts threads that each wait for a ticket from a PriorityTicketHolder and record the order in
+ * which they are admitted. Waiters are started one at a time so that they queue in a known order.
+ */
+class AdmissionRecorder {
+public:
+    explicit AdmissionRecorder(PriorityTicketHolder* holder) : _holder(holder) {}
+
+    ~AdmissionRecorder() {
+        for (auto& thread : _threads) {
+            thread.join();
+        }
+    }
+
+    void startWaiter(int id, Priority priority, std::string tenant = "") {
+        const int queuedBefore = _holder->queued();
+        _threads.emplace_back([this, id, priority, tenant] {
+            _holder->waitForTicket(nullptr, AdmissionContext(priority, tenant));
+            stdx::lock_guard<Latch> lk(_mutex);
+            _admitted.push_back(id);
+        });
+        while (_holder->queued() == queuedBefore) {
+            sleepmillis(1);
+        }
+    }
+
+    /**
+     * Releases one ticket and returns the id of the waiter it went to.
+     */
+    int releaseOne() {
+        const auto admittedBefore = _numAdmitted();
+        _holder->release();
+        while (_numAdmitted() == admittedBefore) {
+            sleepmillis(1);
+        }
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _admitted.back();
+    }
+
+private:
+    size_t _numAdmitted() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _admitted.size();
+    }
+
+    PriorityTicketHolder* _holder;
+    std::vector<stdx::thread> _threads;
+    Mutex _mutex = MONGO_MAKE_LATCH("AdmissionRecorder::_mutex");
+    std::vector<int> _admitted;
+};
+
+TEST(PriorityTicketHolderTest, AdmitsHigherPriorityClassesFirst) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    {
+        AdmissionRecorder recorder(&holder);
+        recorder.startWaiter(0, Priority::kBatch);
+        recorder.startWaiter(1, Priority::kInteractive);
+        recorder.startWaiter(2, Priority::kReplication);
+
+        ASSERT_EQ(recorder.releaseOne(), 2);
+        ASSERT_EQ(recorder.releaseOne(), 1);
+        ASSERT_EQ(recorder.releaseOne(), 0);
+    }
+
+    ASSERT_EQ(holder.used(), 1);
+    ASSERT_EQ(holder.queued(), 0);
+    holder.release();
+}
+
+TEST(PriorityTicketHolderTest, SharesTicketsRoundRobinBetweenTenants) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    {
+        AdmissionRecorder recorder(&holder);
+        recorder.startWaiter(0, Priority::kInteractive, "etl");
+        recorder.startWaiter(1, Priority::kInteractive, "etl");
+        recorder.startWaiter(2, Priority::kInteractive, "etl");
+        recorder.startWaiter(3, Priority::kInteractive, "app");
+
+        ASSERT_EQ(recorder.releaseOne(), 0);
+        ASSERT_EQ(recorder.releaseOne(), 3);
+        ASSERT_EQ(recorder.releaseOne(), 1);
+        ASSERT_EQ(recorder.releaseOne(), 2);
+    }
+
+    holder.release();
+}
+
+TEST(PriorityTicketHolderTest, StarvedLowerClassIsAdmitted) {
+    PriorityTicketHolder holder(1, Milliseconds(0));
+    ASSERT(holder.tryAcquire());
+
+    {
+        AdmissionRecorder recorder(&holder);
+        recorder.startWaiter(0, Priority::kBatch);
+        recorder.startWaiter(1, Priority::kInteractive);
+
+        ASSERT_EQ(recorder.releaseOne(), 0);
+        ASSERT_EQ(recorder.releaseOne(), 1);
+    }
+
+    holder.release();
+}
+
+TEST(PriorityTicketHolderTest, TimedOutWaiterLeavesQueue) {
+    PriorityTicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    const AdmissionContext admCtx(Priority::kBatch, "etl");
+    ASSERT_FALSE(holder.tryAcquire(admCtx));
+    ASSERT_FALSE(holder.waitForTicketUntil(nullptr, Date_t::now() + Milliseconds(10), admCtx));
+    ASSERT_EQ(holder.queued(), 0);
+
+    holder.release();
+    ASSERT(holder.waitForTicketUntil(nullptr, Date_t::now(), admCtx));
+    holder.release();
+
+    BSONObjBuilder bob;
+    holder.appendStats(bob);
+    auto stats = bob.obj();
+    ASSERT_EQ(stats["out"].numberInt(), 0);
+    ASSERT_EQ(stats["totalTickets"].numberInt(), 1);
+
+    auto batch = stats["priorities"]["batch"].Obj();
+    ASSERT_EQ(batch["admitted"].numberLong(), 1);
+    ASSERT_EQ(batch["timedOut"].numberLong(), 1);
+    ASSERT_EQ(batch["queued"].numberLong(), 0);
+}
+
+TEST(PriorityTicketHolderTest, ResizeAppliesToQueuedWaiters) {
+    PriorityTicketHolder holder(5);
+    for (int i = 0; i < 5; ++i) {
+        ASSERT(holder.tryAcquire());
+    }
+
+    {
+        AdmissionRecorder recorder(&holder);
+        recorder.startWaiter(0, Priority::kInteractive);
+        ASSERT_OK(holder.resize(6));
+        ASSERT_EQ(holder.queued(), 0);
+    }
+
+    ASSERT_EQ(holder.used(), 6);
+    ASSERT_OK(holder.resize(5));
+    ASSERT_EQ(holder.available(), 0);
+    for (int i = 0; i < 6; ++i) {
+        holder.release();
+    }
+    ASSERT_EQ(holder.available(), 5);
+    ASSERT_EQ(holder.used(), 0);
+}
 }  // namespace